@@ -0,0 +1,288 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <esp_log.h>
+#include "general.h"
+#include "platform.h"
+#include "exception.h"
+#include "swd.h"
+#include "target.h"
+#include "target_internal.h"
+#include "adiv5.h"
+#include "cortex.h"
+#include "adiv5-queue.h"
+
+#define TAG "adiv5-queue"
+
+/* TAR auto-increment is only guaranteed inside a 1 KiB block */
+#define ADIV5_QUEUE_BLOCK 0x400U
+
+/* Same WAIT budget per access as low_access() in adiv5_swd.c */
+#define ADIV5_QUEUE_WAIT_TIMEOUT_MS 250U
+
+/*
+ * Batched memory accesses for SWD DPs, in the spirit of CMSIS-DAP
+ * DAP_Transfer. The stock adiv5_swd.c path runs every DRW access through
+ * low_access(), which arms a timeout, retries WAIT/FAULT and checks parity
+ * per word, and clocks 8 idle cycles after every write. Here CSW/TAR are set
+ * up once per 1 KiB block and DRW accesses are issued back to back straight
+ * on swd_proc (reads posted, collected from RDBUFF at the end). WAIT is
+ * retried on the same access, as DAP_Transfer does. Any other non-OK ACK or
+ * a read parity error ends the batch, clears the DP and hands the rest of
+ * the block, from the first word not acknowledged, to the stock accessor,
+ * so no word is written twice and errors are reported exactly as before.
+ */
+
+typedef void (*adiv5_mem_read_fn)(adiv5_access_port_s *ap, void *dest, target_addr_t src, size_t len);
+typedef void (*adiv5_mem_write_fn)(
+    adiv5_access_port_s *ap, target_addr_t dest, const void *src, size_t len, align_e align);
+
+typedef struct
+{
+    bool enabled;
+    adiv5_mem_read_fn mem_read;
+    adiv5_mem_write_fn mem_write;
+    uint8_t ack; /* ACK that ended the last failed batch */
+    uint32_t batches;
+    uint32_t fallbacks;
+} ADIv5Queue;
+
+static ADIv5Queue adiv5_queue = {
+#ifdef CONFIG_BMP_ADIV5_QUEUE
+    .enabled = true,
+#endif
+};
+
+static inline uint32_t adiv5_queue_parity(uint32_t value)
+{
+    value ^= value >> 16U;
+    value ^= value >> 8U;
+    value ^= value >> 4U;
+    return (0x6996U >> (value & 0xfU)) & 1U;
+}
+
+/* Start, APnDP, RnW, A[3:2], parity, stop, park */
+static inline uint32_t adiv5_queue_request(uint16_t addr, bool read)
+{
+    uint32_t request = 0x81U;
+    if (addr & ADIV5_APnDP)
+        request |= 0x02U;
+    if (read)
+        request |= 0x04U;
+    request |= (addr & 0x0cU) << 1U;
+    return request | (adiv5_queue_parity(request & 0x1eU) << 5U);
+}
+
+/* Send a request until it is answered with something other than WAIT */
+static uint8_t adiv5_queue_request_ack(uint32_t request)
+{
+    swd_proc.seq_out(request, 8U);
+    uint8_t ack = (uint8_t)swd_proc.seq_in(3U);
+    if (ack != SWDP_ACK_WAIT)
+        return ack;
+
+    platform_timeout_s timeout;
+    platform_timeout_set(&timeout, ADIV5_QUEUE_WAIT_TIMEOUT_MS);
+    do
+    {
+        swd_proc.seq_out(request, 8U);
+        ack = (uint8_t)swd_proc.seq_in(3U);
+    } while (ack == SWDP_ACK_WAIT && !platform_timeout_is_expired(&timeout));
+    return ack;
+}
+
+static inline bool adiv5_queue_read_raw(uint32_t request, uint32_t *value)
+{
+    adiv5_queue.ack = adiv5_queue_request_ack(request);
+    if (adiv5_queue.ack != SWDP_ACK_OK)
+        return false;
+    return !swd_proc.seq_in_parity(value, 32U);
+}
+
+static inline bool adiv5_queue_write_raw(uint32_t request, uint32_t value)
+{
+    adiv5_queue.ack = adiv5_queue_request_ack(request);
+    if (adiv5_queue.ack != SWDP_ACK_OK)
+        return false;
+    swd_proc.seq_out_parity(value, 32U);
+    return true;
+}
+
+/* CSW and SELECT go through the stock path, which also handles WAIT and faults */
+static bool adiv5_queue_setup(adiv5_access_port_s *ap, target_addr_t addr)
+{
+    bool ok = true;
+    TRY (EXCEPTION_ALL)
+    {
+        adiv5_ap_write(ap, ADIV5_AP_CSW, ap->csw | ADIV5_AP_CSW_SIZE_WORD | ADIV5_AP_CSW_ADDRINC_SINGLE);
+        adiv5_ap_write(ap, ADIV5_AP_TAR, addr);
+        ok = ap->dp->fault == 0;
+    }
+    CATCH ()
+    {
+    default:
+        ok = false;
+    }
+    adiv5_queue.ack = SWDP_ACK_OK;
+    return ok;
+}
+
+/**
+ * @return size_t words read into dest, count if the batch completed
+ */
+static size_t adiv5_queue_read_block(adiv5_access_port_s *ap, uint32_t *dest, target_addr_t src, size_t count)
+{
+    if (!adiv5_queue_setup(ap, src))
+        return 0;
+
+    const uint32_t drw = adiv5_queue_request(ADIV5_AP_DRW, true);
+    uint32_t value;
+
+    /* The first read only posts, each next one returns the previous word */
+    if (!adiv5_queue_read_raw(drw, &value))
+        return 0;
+    for (size_t i = 0; i + 1U < count; i++)
+    {
+        if (!adiv5_queue_read_raw(drw, &value))
+            return i;
+        dest[i] = value;
+    }
+    if (!adiv5_queue_read_raw(adiv5_queue_request(ADIV5_DP_RDBUFF, true), &value))
+        return count - 1U;
+    dest[count - 1U] = value;
+    return count;
+}
+
+/**
+ * @return size_t words acknowledged by the target, count if the batch completed
+ */
+static size_t adiv5_queue_write_block(adiv5_access_port_s *ap, target_addr_t dest, const uint32_t *src, size_t count)
+{
+    if (!adiv5_queue_setup(ap, dest))
+        return 0;
+
+    const uint32_t drw = adiv5_queue_request(ADIV5_AP_DRW, false);
+
+    /* Back to back requests, the idle cycles are only needed after the last write */
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!adiv5_queue_write_raw(drw, src[i]))
+            return i;
+    }
+    swd_proc.seq_out(0, 8U);
+    return count;
+}
+
+static void adiv5_queue_recover(adiv5_debug_port_s *dp)
+{
+    adiv5_queue.fallbacks++;
+    TRY (EXCEPTION_ALL)
+    {
+        /* An access still stalled after the timeout is cancelled as low_access() does */
+        if (adiv5_queue.ack == SWDP_ACK_WAIT)
+            dp->abort(dp, ADIV5_DP_ABORT_DAPABORT);
+        dp->error(dp, true);
+    }
+    CATCH ()
+    {
+    default:
+        break;
+    }
+    dp->fault = 0;
+}
+
+static inline size_t adiv5_queue_block_len(target_addr_t addr, size_t len)
+{
+    const size_t block_left = ADIV5_QUEUE_BLOCK - (addr & (ADIV5_QUEUE_BLOCK - 1U));
+    return len < block_left ? len : block_left;
+}
+
+static void adiv5_queue_mem_read(adiv5_access_port_s *ap, void *dest, target_addr_t src, size_t len)
+{
+    if (!adiv5_queue.enabled || ((src | len | (uintptr_t)dest) & 3U) || len == 0)
+    {
+        adiv5_queue.mem_read(ap, dest, src, len);
+        return;
+    }
+
+    uint8_t *data = dest;
+    while (len)
+    {
+        const size_t block = adiv5_queue_block_len(src, len);
+        const size_t done = adiv5_queue_read_block(ap, (uint32_t *)data, src, block / 4U) * 4U;
+        if (done == block)
+            adiv5_queue.batches++;
+        else
+        {
+            adiv5_queue_recover(ap->dp);
+            adiv5_queue.mem_read(ap, data + done, src + done, block - done);
+            if (ap->dp->fault)
+                return;
+        }
+        data += block;
+        src += block;
+        len -= block;
+    }
+}
+
+static void adiv5_queue_mem_write(
+    adiv5_access_port_s *ap, target_addr_t dest, const void *src, size_t len, align_e align)
+{
+    if (!adiv5_queue.enabled || align != ALIGN_32BIT || ((dest | len | (uintptr_t)src) & 3U) || len == 0)
+    {
+        adiv5_queue.mem_write(ap, dest, src, len, align);
+        return;
+    }
+
+    const uint8_t *data = src;
+    while (len)
+    {
+        const size_t block = adiv5_queue_block_len(dest, len);
+        const size_t done = adiv5_queue_write_block(ap, dest, (const uint32_t *)data, block / 4U) * 4U;
+        if (done == block)
+            adiv5_queue.batches++;
+        else
+        {
+            adiv5_queue_recover(ap->dp);
+            adiv5_queue.mem_write(ap, dest + done, data + done, block - done, align);
+            if (ap->dp->fault)
+                return;
+        }
+        data += block;
+        dest += block;
+        len -= block;
+    }
+}
+
+void adiv5_queue_attach(void)
+{
+    for (target_s *target = target_list; target != NULL; target = target->next)
+    {
+        adiv5_access_port_s *ap = cortex_ap(target);
+        if (ap == NULL || ap->dp == NULL || ap->dp->mem_read == adiv5_queue_mem_read)
+            continue;
+
+        /* Every SWD DP gets the same stock accessors from adiv5_dp_init() */
+        adiv5_queue.mem_read = ap->dp->mem_read;
+        adiv5_queue.mem_write = ap->dp->mem_write;
+        ap->dp->mem_read = adiv5_queue_mem_read;
+        ap->dp->mem_write = adiv5_queue_mem_write;
+    }
+}
+
+void adiv5_queue_set_enabled(bool enable)
+{
+    adiv5_queue.enabled = enable;
+}
+
+bool adiv5_queue_enabled(void)
+{
+    return adiv5_queue.enabled;
+}
+
+void adiv5_queue_get_stats(uint32_t *batches, uint32_t *fallbacks)
+{
+    *batches = adiv5_queue.batches;
+    *fallbacks = adiv5_queue.fallbacks;
+}
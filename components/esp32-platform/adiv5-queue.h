@@ -0,0 +1,26 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Route word-aligned memory accesses of every scanned SWD DP through the batched engine
+ */
+void adiv5_queue_attach(void);
+
+/**
+ * Enable or disable the batched engine, takes effect immediately
+ * @param enable
+ */
+void adiv5_queue_set_enabled(bool enable);
+
+/**
+ * @return bool batched engine enabled
+ */
+bool adiv5_queue_enabled(void);
+
+/**
+ * Get engine counters
+ * @param batches batches completed without error
+ * @param fallbacks batches handed back to the stock accessors
+ */
+void adiv5_queue_get_stats(uint32_t *batches, uint32_t *fallbacks);
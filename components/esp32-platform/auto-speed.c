@@ -0,0 +1,232 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <esp_log.h>
+#include "general.h"
+#include "platform.h"
+#include "exception.h"
+#include "target.h"
+#include "target_internal.h"
+#include "adiv5.h"
+#include "cortex.h"
+#include "platform-freq.h"
+#include "auto-speed.h"
+#include "adiv5-queue.h"
+
+#define TAG "auto-speed"
+#define AUTO_SPEED_ROUNDS 32U
+
+/*
+ * Clock negotiation ("turbo probe"). adiv5_swd_scan() and jtag_scan() are
+ * linked with --wrap: scans always run at the requested frequency, then the
+ * clock is ramped up the ladder below while repeated DP DPIDR and AP CSW
+ * reads return exactly the values seen at the scan speed, patterns written
+ * to AP TAR (0xaaaaaaaa, 0x55555555 and a one walking through all 32 bits
+ * over the rounds) read back unchanged, and no sticky error or exception is
+ * raised. The result is the highest passing clock minus the configured
+ * margin.
+ */
+
+typedef struct
+{
+    bool enabled;
+    uint32_t margin;
+    uint32_t result;
+} AutoSpeed;
+
+typedef struct
+{
+    uint32_t dpidr;
+    uint32_t csw;
+    uint32_t tar; /* restored after the patterns */
+} AutoSpeedReference;
+
+static AutoSpeed auto_speed = {
+#ifdef CONFIG_BMP_AUTO_SPEED
+    .enabled = true,
+#endif
+    .margin = CONFIG_BMP_AUTO_SPEED_MARGIN,
+};
+
+/* Ascending, 0 selects the fastest setting of the tap */
+static const uint32_t auto_speed_ladder[] = {
+    250000U, 500000U, 1000000U, 2000000U, 4000000U, 6000000U, 8000000U,
+    12000000U, 16000000U, 20000000U, 26000000U, 32000000U, 40000000U, 0U};
+
+static bool auto_speed_read_reference(adiv5_access_port_s *ap, AutoSpeedReference *reference)
+{
+    bool ok = true;
+    TRY (EXCEPTION_ALL)
+    {
+        reference->dpidr = adiv5_dp_read(ap->dp, ADIV5_DP_DPIDR);
+        reference->csw = adiv5_ap_read(ap, ADIV5_AP_CSW);
+        reference->tar = adiv5_ap_read(ap, ADIV5_AP_TAR);
+        ok = adiv5_dp_error(ap->dp) == 0;
+    }
+    CATCH ()
+    {
+    default:
+        ok = false;
+    }
+    return ok;
+}
+
+/* A constant read back from a register that holds it, data bits driven both ways */
+static bool auto_speed_pattern(adiv5_access_port_s *ap, const uint32_t pattern)
+{
+    adiv5_ap_write(ap, ADIV5_AP_TAR, pattern);
+    return adiv5_ap_read(ap, ADIV5_AP_TAR) == pattern;
+}
+
+static bool auto_speed_validate(adiv5_access_port_s *ap, const AutoSpeedReference *reference)
+{
+    bool ok = true;
+    TRY (EXCEPTION_ALL)
+    {
+        for (uint32_t round = 0; round < AUTO_SPEED_ROUNDS && ok; round++)
+        {
+            ok = adiv5_dp_read(ap->dp, ADIV5_DP_DPIDR) == reference->dpidr &&
+                 adiv5_ap_read(ap, ADIV5_AP_CSW) == reference->csw &&
+                 auto_speed_pattern(ap, 0xaaaaaaaaU) &&
+                 auto_speed_pattern(ap, 0x55555555U) &&
+                 auto_speed_pattern(ap, 1U << (round % 32U)) &&
+                 ap->dp->fault == 0;
+        }
+        if (adiv5_dp_error(ap->dp) != 0)
+            ok = false;
+        if (ok)
+            adiv5_ap_write(ap, ADIV5_AP_TAR, reference->tar);
+    }
+    CATCH ()
+    {
+    default:
+        ok = false;
+    }
+    return ok;
+}
+
+static void auto_speed_recover(adiv5_access_port_s *ap)
+{
+    TRY (EXCEPTION_ALL)
+    {
+        ap->dp->error(ap->dp, true);
+    }
+    CATCH ()
+    {
+    default:
+        break;
+    }
+}
+
+bool auto_speed_run(void)
+{
+    auto_speed.result = 0;
+
+    /* Every target driver built here sits on an ADIv5 Cortex AP */
+    if (target_list == NULL)
+        return false;
+    adiv5_access_port_s *ap = cortex_ap(target_list);
+    if (ap == NULL || ap->dp == NULL)
+        return false;
+
+    platform_freq_clear_tuned();
+
+    AutoSpeedReference reference;
+    if (!auto_speed_read_reference(ap, &reference))
+    {
+        ESP_LOGW(TAG, "Unable to read reference at %lu Hz", platform_max_frequency_get());
+        return false;
+    }
+
+    uint32_t best = platform_max_frequency_get();
+    uint32_t best_setting = platform_freq_get_requested();
+
+    for (size_t i = 0; i < sizeof(auto_speed_ladder) / sizeof(auto_speed_ladder[0]); i++)
+    {
+        platform_freq_set_tuned(auto_speed_ladder[i]);
+        const uint32_t actual = platform_max_frequency_get();
+        if (actual <= best)
+            continue;
+
+        if (!auto_speed_validate(ap, &reference))
+        {
+            ESP_LOGI(TAG, "Failed at %lu Hz", actual);
+            platform_freq_set_tuned(best_setting);
+            auto_speed_recover(ap);
+            break;
+        }
+
+        best = actual;
+        best_setting = auto_speed_ladder[i];
+    }
+
+    if (auto_speed.margin > 0)
+        platform_freq_set_tuned(best - (uint32_t)(((uint64_t)best * auto_speed.margin) / 100U));
+    else
+        platform_freq_set_tuned(best_setting);
+
+    if (!auto_speed_validate(ap, &reference))
+    {
+        ESP_LOGW(TAG, "Margin setting failed, back to requested frequency");
+        platform_freq_clear_tuned();
+        auto_speed_recover(ap);
+        return false;
+    }
+
+    auto_speed.result = platform_max_frequency_get();
+    ESP_LOGI(TAG, "Highest passing %lu Hz, running at %lu Hz (%lu%% margin)",
+             best, auto_speed.result, auto_speed.margin);
+    return true;
+}
+
+bool __real_adiv5_swd_scan(void);
+bool __real_jtag_scan(void);
+
+bool __wrap_adiv5_swd_scan(void)
+{
+    platform_freq_clear_tuned();
+    auto_speed.result = 0;
+
+    const bool result = __real_adiv5_swd_scan();
+    if (result)
+        adiv5_queue_attach();
+    if (result && auto_speed.enabled)
+        auto_speed_run();
+    return result;
+}
+
+bool __wrap_jtag_scan(void)
+{
+    platform_freq_clear_tuned();
+    auto_speed.result = 0;
+
+    const bool result = __real_jtag_scan();
+    if (result && auto_speed.enabled)
+        auto_speed_run();
+    return result;
+}
+
+void auto_speed_set_enabled(bool enable)
+{
+    auto_speed.enabled = enable;
+}
+
+bool auto_speed_enabled(void)
+{
+    return auto_speed.enabled;
+}
+
+void auto_speed_set_margin(uint32_t percent)
+{
+    auto_speed.margin = percent > 90U ? 90U : percent;
+}
+
+uint32_t auto_speed_get_margin(void)
+{
+    return auto_speed.margin;
+}
+
+uint32_t auto_speed_get_result(void)
+{
+    return auto_speed.result;
+}
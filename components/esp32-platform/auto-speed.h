@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Enable or disable clock negotiation after successful scans
+ * @param enable
+ */
+void auto_speed_set_enabled(bool enable);
+
+/**
+ * @return bool negotiation enabled
+ */
+bool auto_speed_enabled(void);
+
+/**
+ * Set safety margin below the highest passing clock
+ * @param percent 0..90
+ */
+void auto_speed_set_margin(uint32_t percent);
+
+/**
+ * @return uint32_t margin in percent
+ */
+uint32_t auto_speed_get_margin(void);
+
+/**
+ * Negotiate the interface clock against the first scanned target
+ * @return bool true if a clock was validated
+ */
+bool auto_speed_run(void);
+
+/**
+ * Get negotiated clock
+ * @return uint32_t Hz, 0 if no negotiation succeeded since the last scan
+ */
+uint32_t auto_speed_get_result(void);
@@ -0,0 +1,228 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "general.h"
+#include "target.h"
+#include "gdb_main.h"
+#include "gdb_packet.h"
+#include "hex_utils.h"
+#include "gdb-packet-tx.h"
+#include "gdb-rle.h"
+#include "gdb-glue.h"
+#include "target-cache.h"
+#include "gdb-stats.h"
+#include "gdb-trace.h"
+
+/*
+ * Packets answered on the platform before gdb_main(), so their replies go
+ * out through gdb_packet_tx_send() as one iovec list instead of through
+ * gdb_if_putchar(), and reads are served from target-cache.c. Anything
+ * malformed or out of range is passed on, and gdb_main() produces the
+ * usual error reply. Every packet passed on, apart from plain queries,
+ * drops the cache first.
+ */
+
+void __real_gdb_main(const gdb_packet_s *packet);
+
+typedef struct
+{
+    uint8_t mem[GDB_PACKET_BUFFER_SIZE / 2U];
+    char reply[GDB_PACKET_BUFFER_SIZE + 1U];
+} GDBDispatch;
+
+static GDBDispatch gdb_dispatch;
+
+static void gdb_dispatch_start_hex(const void *data, size_t len)
+{
+    hexify(gdb_dispatch.reply, data, len);
+    size_t size = len * 2U;
+    if (gdb_rle_enabled())
+        size = gdb_rle_encode((uint8_t *)gdb_dispatch.reply, size);
+    gdb_packet_tx_start(gdb_dispatch.reply, size, false);
+}
+
+static void gdb_dispatch_send_hex(const void *data, size_t len)
+{
+    gdb_dispatch_start_hex(data, len);
+    gdb_packet_tx_finish();
+}
+
+/* 'm addr,len': hex memory read */
+static bool gdb_dispatch_read_memory(const gdb_packet_s *packet)
+{
+    uint32_t addr;
+    uint32_t len;
+    if (sscanf(packet->data, "m%" SCNx32 ",%" SCNx32, &addr, &len) != 2 || len > sizeof(gdb_dispatch.mem))
+        return false;
+    /* Answered here as well, the stock handler would alloca() the length first */
+    if (cur_target == NULL)
+    {
+        gdb_packet_tx_send("EFF", 3, false);
+        return true;
+    }
+
+    if (target_cache_mem_read(cur_target, gdb_dispatch.mem, addr, len))
+        gdb_packet_tx_send("E01", 3, false);
+    else
+    {
+        /* Prefetch while the reply and its ack are on the network */
+        gdb_dispatch_start_hex(gdb_dispatch.mem, len);
+        target_cache_read_ahead(cur_target);
+        gdb_packet_tx_finish();
+    }
+    return true;
+}
+
+/*
+ * 'M addr,len:hex': hex memory write. The stock handler unhexifies into an
+ * alloca() of up to half a packet, more than the gdb thread stack holds
+ * with large packets, so the data goes through the static buffer instead.
+ */
+static bool gdb_dispatch_write_memory(const gdb_packet_s *packet)
+{
+    uint32_t addr;
+    uint32_t len;
+    int offset = 0;
+    if (sscanf(packet->data, "M%" SCNx32 ",%" SCNx32 ":%n", &addr, &len, &offset) != 2 || offset == 0 ||
+        len > sizeof(gdb_dispatch.mem) || packet->size - (size_t)offset < len * 2U)
+        return false;
+    if (cur_target == NULL)
+    {
+        gdb_packet_tx_send("EFF", 3, false);
+        return true;
+    }
+
+    target_cache_invalidate();
+    unhexify(gdb_dispatch.mem, packet->data + offset, len);
+    if (target_mem32_write(cur_target, addr, gdb_dispatch.mem, len))
+        gdb_packet_tx_send("E01", 3, false);
+    else
+        gdb_packet_tx_send("OK", 2, false);
+    return true;
+}
+
+/*
+ * 'x addr,len': binary memory read, reply "b" and the escaped bytes. The
+ * target is read straight into the reply after the "b", longer requests
+ * are cut to the buffer and gdb asks again for the rest.
+ */
+static bool gdb_dispatch_read_binary(const gdb_packet_s *packet)
+{
+    uint32_t addr;
+    uint32_t len;
+    if (sscanf(packet->data, "x%" SCNx32 ",%" SCNx32, &addr, &len) != 2)
+        return false;
+    if (cur_target == NULL)
+    {
+        gdb_packet_tx_send("EFF", 3, false);
+        return true;
+    }
+    if (len > sizeof(gdb_dispatch.reply) - 1U)
+        len = sizeof(gdb_dispatch.reply) - 1U;
+
+    gdb_dispatch.reply[0] = 'b';
+    if (target_cache_mem_read(cur_target, gdb_dispatch.reply + 1U, addr, len))
+        gdb_packet_tx_send("E01", 3, false);
+    else
+    {
+        gdb_packet_tx_start(gdb_dispatch.reply, len + 1U, true);
+        target_cache_read_ahead(cur_target);
+        gdb_packet_tx_finish();
+    }
+    return true;
+}
+
+/* 'g': all registers */
+static bool gdb_dispatch_read_registers(void)
+{
+    if (cur_target == NULL)
+        return false;
+    const size_t size = target_regs_size(cur_target);
+    if (size == 0 || size > sizeof(gdb_dispatch.mem))
+        return false;
+
+    target_cache_regs_read(cur_target, gdb_dispatch.mem, size);
+    gdb_dispatch_send_hex(gdb_dispatch.mem, size);
+    return true;
+}
+
+/* 'p n': one register */
+static bool gdb_dispatch_read_register(const gdb_packet_s *packet)
+{
+    uint32_t reg;
+    if (cur_target == NULL || sscanf(packet->data, "p%" SCNx32, &reg) != 1)
+        return false;
+
+    uint8_t value[8];
+    const size_t size = target_cache_reg_read(cur_target, reg, value, sizeof(value));
+    if (size > 0)
+        gdb_dispatch_send_hex(value, size);
+    else
+        gdb_packet_tx_send("EFF", 3, false);
+    return true;
+}
+
+/* Packets that cannot resume the target or change its state */
+static bool gdb_dispatch_read_only(const gdb_packet_s *packet)
+{
+    switch (packet->data[0])
+    {
+    case '?':
+    case 'H':
+    case 'T':
+        return true;
+    case 'q':
+        return strncmp(packet->data, "qRcmd", 5) != 0;
+    default:
+        return false;
+    }
+}
+
+static void gdb_dispatch_packet(const gdb_packet_s *packet)
+{
+    switch (packet->data[0])
+    {
+    case 'm':
+        if (gdb_dispatch_read_memory(packet))
+            return;
+        break;
+    case 'M':
+        if (gdb_dispatch_write_memory(packet))
+            return;
+        break;
+    case 'x':
+        if (gdb_dispatch_read_binary(packet))
+            return;
+        break;
+    case 'g':
+        if (gdb_dispatch_read_registers())
+            return;
+        break;
+    case 'p':
+        if (gdb_dispatch_read_register(packet))
+            return;
+        break;
+    case 'q':
+        /* Stock reply plus the features answered here */
+        if (strncmp(packet->data, "qSupported", 10) == 0)
+            gdb_glue_tx_append(";binary-upload+");
+        break;
+    default:
+        break;
+    }
+
+    if (!gdb_dispatch_read_only(packet))
+        target_cache_invalidate();
+    __real_gdb_main(packet);
+}
+
+void __wrap_gdb_main(const gdb_packet_s *packet)
+{
+    gdb_trace_record(GDB_TRACE_IN, packet->data, packet->size);
+    gdb_stats_packet_begin(packet->data, packet->size);
+    gdb_dispatch_packet(packet);
+    gdb_stats_packet_end();
+}
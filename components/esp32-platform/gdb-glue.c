@@ -1,22 +1,63 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <sys/param.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <freertos/stream_buffer.h>
+#include <freertos/semphr.h>
 #include <driver/gpio.h>
+#include "gdb_packet.h"
+#include "gdb-glue.h"
+#include "gdb-rle.h"
+#include "gdb-stats.h"
+#include "gdb-trace.h"
 
-#define GDB_TX_BUFFER_SIZE 4096
-#define GDB_RX_BUFFER_SIZE 4096
-#define GDB_RX_PACKET_MAX_SIZE 64
+#define GDB_RX_PACKET_MAX_SIZE 1024
+/* "$", payload with 1/8 escaped bytes, "#xx"; denser escaping goes to the stock parser */
+#define GDB_RX_SPAN_SIZE (GDB_PACKET_BUFFER_SIZE + GDB_PACKET_BUFFER_SIZE / 8U + 4U)
+/* A whole packet goes out in one send, and queues in rx with room for the next recv() */
+#define GDB_TX_BUFFER_SIZE MAX(4096U, GDB_RX_SPAN_SIZE)
+#define GDB_RX_BUFFER_SIZE MAX(4096U, GDB_RX_SPAN_SIZE + GDB_RX_PACKET_MAX_SIZE)
+
+_Static_assert(GDB_RX_SPAN_SIZE + GDB_RX_PACKET_MAX_SIZE <= GDB_RX_BUFFER_SIZE,
+               "rx stream must hold a full span and one more recv()");
+_Static_assert(GDB_RX_SPAN_SIZE <= GDB_TX_BUFFER_SIZE, "tx buffer must hold a full packet");
 #define TAG "gdb-glue"
 
+typedef enum
+{
+    GDB_GLUE_TX_RAW,
+    GDB_GLUE_TX_PAYLOAD,
+    GDB_GLUE_TX_CHECKSUM,
+} gdb_glue_tx_state_e;
+
 typedef struct
 {
     StreamBufferHandle_t rx_stream;
-    bool rx_stream_full;
+    TaskHandle_t rx_writer;
+    volatile bool rx_discard;
+    volatile uint32_t rx_arrival_us;
+    uint8_t rx_span[GDB_RX_SPAN_SIZE];
+    size_t rx_span_start;
+    size_t rx_span_end;
     uint8_t tx_buffer[GDB_TX_BUFFER_SIZE];
     size_t tx_buffer_index;
+    gdb_glue_tx_state_e tx_state;
+    GDBRle tx_rle;
+    uint8_t tx_checksum;
+    size_t tx_checksum_digits;
+    size_t tx_payload_raw;
+    size_t tx_payload_encoded;
+    const char *tx_append;
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+    SemaphoreHandle_t target_lock;
 } GDBGlue;
 
 static GDBGlue gdb_glue;
@@ -24,6 +65,7 @@ static GDBGlue gdb_glue;
 /* GDB socket */
 bool network_gdb_connected(void);
 void network_gdb_send(uint8_t *buffer, size_t size);
+void network_gdb_sendv(struct iovec *iov, size_t count);
 
 /* USB-CDC */
 void usb_gdb_tx_char(uint8_t c, bool flush);
@@ -33,25 +75,122 @@ size_t gdb_glue_get_free_size(void)
     return xStreamBufferSpacesAvailable(gdb_glue.rx_stream);
 }
 
+/*
+ * Arrival time of the oldest byte the gdb thread has not read, for the
+ * receive time in gdb-stats.c; 0 while nothing is buffered. Both tasks
+ * only set it when it is 0, and the 32-bit store is atomic. The network
+ * task stamps before it queues the bytes, so a stamp never outlives them;
+ * a race the other way loses one sample, which then counts as 0.
+ */
+static void gdb_glue_rx_stamp(void)
+{
+    if (gdb_glue.rx_arrival_us == 0)
+    {
+        gdb_glue.rx_arrival_us = (uint32_t)esp_timer_get_time() | 1U;
+    }
+}
+
+static bool gdb_glue_rx_buffered(void)
+{
+    return gdb_glue.rx_span_end > gdb_glue.rx_span_start || xStreamBufferBytesAvailable(gdb_glue.rx_stream) > 0;
+}
+
+/* Clear the stamp, then stamp again if bytes are left or arrived meanwhile */
+static void gdb_glue_rx_restamp(void)
+{
+    gdb_glue.rx_arrival_us = 0;
+    if (gdb_glue_rx_buffered())
+    {
+        gdb_glue_rx_stamp();
+    }
+}
+
 void gdb_glue_receive(uint8_t *buffer, size_t size)
 {
+    if (gdb_stats_enabled())
+    {
+        gdb_glue_rx_stamp();
+    }
     size_t ret = xStreamBufferSend(gdb_glue.rx_stream, buffer, size, portMAX_DELAY);
     ESP_ERROR_CHECK(ret != size);
+    gdb_glue.rx_bytes += size;
+}
+
+void gdb_glue_rx_packet_start(void)
+{
+    // Acks and interrupts read since the last packet leave a stale stamp
+    if (gdb_glue.rx_arrival_us != 0 && !gdb_glue_rx_buffered())
+    {
+        gdb_glue_rx_restamp();
+    }
+}
+
+uint32_t gdb_glue_rx_arrival(void)
+{
+    const uint32_t arrival = gdb_glue.rx_arrival_us;
+    gdb_glue_rx_restamp();
+    return arrival;
 }
 
-bool gdb_glue_can_receive()
+/*
+ * Socket task backpressure: while the rx stream is short of space the
+ * writer may sleep up to timeout on a task notification, which the gdb
+ * thread gives once it has drained GDB_RX_PACKET_MAX_SIZE bytes of space.
+ * The network reactor asks with no timeout and checks again on its next
+ * pass. Not calling recv() in the meantime lets the TCP window close
+ * towards gdb.
+ */
+size_t gdb_glue_wait_free(uint32_t timeout)
 {
-    uint16_t max_len = xStreamBufferSpacesAvailable(gdb_glue.rx_stream);
-    bool can_receive = true;
+    size_t space = gdb_glue.rx_discard ? 0 : xStreamBufferSpacesAvailable(gdb_glue.rx_stream);
+    if (space >= GDB_RX_PACKET_MAX_SIZE)
+    {
+        return space;
+    }
 
-    if (max_len <= 0)
+    // Publish the waiter before the re-check, so a drain in between still notifies
+    gdb_glue.rx_writer = xTaskGetCurrentTaskHandle();
+    space = gdb_glue.rx_discard ? 0 : xStreamBufferSpacesAvailable(gdb_glue.rx_stream);
+    if (space < GDB_RX_PACKET_MAX_SIZE)
     {
-        gdb_glue.rx_stream_full = true;
-        ESP_LOGE(TAG, "Stream is full");
-        can_receive = false;
-    };
+        ulTaskNotifyTake(pdTRUE, timeout);
+        space = gdb_glue.rx_discard ? 0 : xStreamBufferSpacesAvailable(gdb_glue.rx_stream);
+    }
+    gdb_glue.rx_writer = NULL;
 
-    return can_receive;
+    return space;
+}
+
+/*
+ * Input of a dropped owner must not reach the next one. The network task
+ * asks for a discard and stops feeding the stream; the gdb thread, the
+ * only reader, empties the span and the stream on its next read and then
+ * lets the writer go on. A reader asleep on the empty stream is woken with
+ * one filler byte, which is discarded with the rest.
+ */
+void gdb_glue_rx_discard(void)
+{
+    gdb_glue.rx_discard = true;
+    if (xStreamBufferBytesAvailable(gdb_glue.rx_stream) == 0)
+    {
+        const uint8_t filler = 0;
+        xStreamBufferSend(gdb_glue.rx_stream, &filler, 1, 0);
+    }
+}
+
+static void gdb_glue_rx_drop(void)
+{
+    gdb_glue.rx_span_start = 0;
+    gdb_glue.rx_span_end = 0;
+    xStreamBufferReset(gdb_glue.rx_stream);
+    gdb_glue.rx_discard = false;
+
+    TaskHandle_t writer = gdb_glue.rx_writer;
+    if (writer != NULL)
+    {
+        gdb_glue.rx_writer = NULL;
+        xTaskNotifyGive(writer);
+    }
 }
 
 size_t gdb_glue_get_packet_size()
@@ -67,28 +206,98 @@ const char *gdb_glue_get_bm_version()
 void gdb_glue_init(void)
 {
     gdb_glue.rx_stream = xStreamBufferCreate(GDB_RX_BUFFER_SIZE, 1);
-    gdb_glue.rx_stream_full = false;
-    gdb_glue.tx_buffer_index = 0;
+    gdb_glue.rx_writer = NULL;
+    gdb_glue.rx_discard = false;
+    gdb_glue.rx_arrival_us = 0;
+    gdb_glue.rx_span_start = 0;
+    gdb_glue.rx_span_end = 0;
+    gdb_glue_session_reset();
+    gdb_glue.target_lock = xSemaphoreCreateMutex();
+#ifdef CONFIG_BMP_GDB_TRACE
+    gdb_trace_set_enabled(true);
+#endif
 }
 
-unsigned char gdb_if_getchar_to(int timeout)
+/*
+ * Target access lock. The gdb thread holds it while it handles a packet or
+ * polls a running target, observer sessions (network task) take it around
+ * each read. Observers only try the lock, the gdb thread may be waiting
+ * for an ack that only the network task can deliver.
+ */
+bool gdb_glue_target_lock(uint32_t timeout)
+{
+    return xSemaphoreTake(gdb_glue.target_lock, timeout) == pdTRUE;
+}
+
+void gdb_glue_target_unlock(void)
 {
-    uint8_t data;
-    size_t received = xStreamBufferReceive(gdb_glue.rx_stream, &data, sizeof(uint8_t), timeout);
+    xSemaphoreGive(gdb_glue.target_lock);
+}
 
-    if (received == 0)
+/*
+ * RX bytes leave the stream buffer in spans: one xStreamBufferReceive pulls
+ * everything the socket task has queued into rx_span, and readers index
+ * into it. The packet framer (gdb-packet-rx.c) parses whole packets in
+ * place, gdb_if_getchar_to() takes one byte at a time from the same span.
+ */
+const uint8_t *gdb_glue_rx_span(size_t *size, size_t want, uint32_t timeout)
+{
+    if (gdb_glue.rx_discard)
     {
-        return -1;
+        gdb_glue_rx_drop();
     }
 
-    if (gdb_glue.rx_stream_full &&
-        xStreamBufferSpacesAvailable(gdb_glue.rx_stream) >= GDB_RX_PACKET_MAX_SIZE)
+    size_t available = gdb_glue.rx_span_end - gdb_glue.rx_span_start;
+
+    if (available < want)
     {
-        gdb_glue.rx_stream_full = false;
-        ESP_LOGW(TAG, "Stream freed");
+        if (gdb_glue.rx_span_start > 0)
+        {
+            memmove(gdb_glue.rx_span, gdb_glue.rx_span + gdb_glue.rx_span_start, available);
+            gdb_glue.rx_span_start = 0;
+            gdb_glue.rx_span_end = available;
+        }
+
+        if (gdb_glue.rx_span_end < GDB_RX_SPAN_SIZE)
+        {
+            gdb_glue.rx_span_end += xStreamBufferReceive(gdb_glue.rx_stream, gdb_glue.rx_span + gdb_glue.rx_span_end,
+                GDB_RX_SPAN_SIZE - gdb_glue.rx_span_end, timeout);
+
+            TaskHandle_t writer = gdb_glue.rx_writer;
+            if (writer != NULL && xStreamBufferSpacesAvailable(gdb_glue.rx_stream) >= GDB_RX_PACKET_MAX_SIZE)
+            {
+                gdb_glue.rx_writer = NULL;
+                xTaskNotifyGive(writer);
+            }
+        }
     }
 
-    return data;
+    *size = gdb_glue.rx_span_end - gdb_glue.rx_span_start;
+    return gdb_glue.rx_span + gdb_glue.rx_span_start;
+}
+
+void gdb_glue_rx_consume(size_t size)
+{
+    gdb_glue.rx_span_start += size;
+}
+
+size_t gdb_glue_rx_span_capacity(void)
+{
+    return GDB_RX_SPAN_SIZE;
+}
+
+unsigned char gdb_if_getchar_to(int timeout)
+{
+    size_t size;
+    const uint8_t *span = gdb_glue_rx_span(&size, 1, timeout);
+
+    if (size == 0)
+    {
+        return -1;
+    }
+
+    gdb_glue.rx_span_start++;
+    return span[0];
 }
 
 unsigned char gdb_if_getchar(void)
@@ -96,20 +305,161 @@ unsigned char gdb_if_getchar(void)
     return gdb_if_getchar_to(portMAX_DELAY);
 }
 
+static void gdb_glue_tx_flush(void)
+{
+    if (gdb_glue.tx_buffer_index > 0)
+    {
+        gdb_trace_record(GDB_TRACE_OUT, gdb_glue.tx_buffer, gdb_glue.tx_buffer_index);
+        network_gdb_send(gdb_glue.tx_buffer, gdb_glue.tx_buffer_index);
+        gdb_glue.tx_bytes += gdb_glue.tx_buffer_index;
+        gdb_glue.tx_buffer_index = 0;
+    }
+}
+
+static void gdb_glue_tx_put(const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        gdb_glue.tx_buffer[gdb_glue.tx_buffer_index] = data[i];
+        gdb_glue.tx_buffer_index++;
+
+        if (gdb_glue.tx_buffer_index == GDB_TX_BUFFER_SIZE)
+        {
+            gdb_glue_tx_flush();
+        }
+    }
+}
+
+static void gdb_glue_tx_payload(const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        gdb_glue.tx_checksum += data[i];
+    }
+    gdb_glue.tx_payload_encoded += size;
+    gdb_glue_tx_put(data, size);
+}
+
+/*
+ * Rewrite "$" packets on their way out: run-length encode the payload
+ * and/or append a pending suffix. gdb_packet.c has already escaped the
+ * payload and computed its checksum, so the two checksum digits are
+ * replaced with the checksum of what was actually sent. Everything outside
+ * "$...#xx" (acks, notifications, remote protocol replies) passes through
+ * unchanged.
+ */
+static void gdb_glue_tx_encode(uint8_t c)
+{
+    uint8_t out[GDB_RLE_OUT_MAX];
+
+    switch (gdb_glue.tx_state)
+    {
+    case GDB_GLUE_TX_RAW:
+        if (c == '$' && (gdb_rle_enabled() || gdb_glue.tx_append != NULL))
+        {
+            gdb_rle_init(&gdb_glue.tx_rle);
+            gdb_glue.tx_checksum = 0;
+            gdb_glue.tx_payload_raw = 0;
+            gdb_glue.tx_payload_encoded = 0;
+            gdb_glue.tx_state = GDB_GLUE_TX_PAYLOAD;
+        }
+        gdb_glue_tx_put(&c, 1);
+        break;
+    case GDB_GLUE_TX_PAYLOAD:
+        if (c == '#')
+        {
+            gdb_glue_tx_payload(out, gdb_rle_flush(&gdb_glue.tx_rle, out));
+            gdb_rle_count(gdb_glue.tx_payload_raw, gdb_glue.tx_payload_encoded);
+            if (gdb_glue.tx_append != NULL)
+            {
+                gdb_glue_tx_payload((const uint8_t *)gdb_glue.tx_append, strlen(gdb_glue.tx_append));
+                gdb_glue.tx_append = NULL;
+            }
+            gdb_glue_tx_put(&c, 1);
+            gdb_glue.tx_checksum_digits = 0;
+            gdb_glue.tx_state = GDB_GLUE_TX_CHECKSUM;
+        }
+        else if (gdb_rle_enabled())
+        {
+            gdb_glue.tx_payload_raw++;
+            gdb_glue_tx_payload(out, gdb_rle_push(&gdb_glue.tx_rle, c, out));
+        }
+        else
+        {
+            gdb_glue_tx_payload(&c, 1);
+        }
+        break;
+    case GDB_GLUE_TX_CHECKSUM:
+        gdb_glue.tx_checksum_digits++;
+        if (gdb_glue.tx_checksum_digits == 2)
+        {
+            char digits[3];
+            snprintf(digits, sizeof(digits), "%02x", gdb_glue.tx_checksum);
+            gdb_glue_tx_put((const uint8_t *)digits, 2);
+            gdb_glue.tx_state = GDB_GLUE_TX_RAW;
+        }
+        break;
+    }
+}
+
 void gdb_if_putchar(unsigned char c, int flush)
 {
     if (network_gdb_connected())
     {
-        gdb_glue.tx_buffer[gdb_glue.tx_buffer_index] = c;
-        gdb_glue.tx_buffer_index++;
+        gdb_glue_tx_encode(c);
 
-        if (gdb_glue.tx_buffer_index == GDB_TX_BUFFER_SIZE || flush)
+        if (flush)
         {
-            network_gdb_send(gdb_glue.tx_buffer, gdb_glue.tx_buffer_index);
-            gdb_glue.tx_buffer_index = 0;
+            gdb_glue_tx_flush();
         }
     }
     else
     {
     }
-}
\ No newline at end of file
+}
+
+void gdb_glue_tx_append(const char *suffix)
+{
+    gdb_glue.tx_append = suffix;
+}
+
+void gdb_glue_session_reset(void)
+{
+    gdb_glue.tx_buffer_index = 0;
+    gdb_glue.tx_state = GDB_GLUE_TX_RAW;
+    gdb_glue.tx_checksum_digits = 0;
+    gdb_glue.tx_append = NULL;
+    gdb_rle_init(&gdb_glue.tx_rle);
+    /* A new client starts in ack mode, whatever the last one negotiated */
+    gdb_set_noackmode(false);
+}
+
+void gdb_glue_sendv(struct iovec *iov, size_t count)
+{
+    if (!network_gdb_connected())
+    {
+        return;
+    }
+
+    // Keep byte order with anything gdb_if_putchar() still holds
+    gdb_glue_tx_flush();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        gdb_glue.tx_bytes += iov[i].iov_len;
+    }
+    gdb_trace_record_iov(GDB_TRACE_OUT, iov, count);
+    network_gdb_sendv(iov, count);
+}
+
+void gdb_glue_get_stats(uint64_t *rx_bytes, uint64_t *tx_bytes)
+{
+    *rx_bytes = gdb_glue.rx_bytes;
+    *tx_bytes = gdb_glue.tx_bytes;
+}
+
+void gdb_glue_reset_stats(void)
+{
+    gdb_glue.rx_bytes = 0;
+    gdb_glue.tx_bytes = 0;
+}
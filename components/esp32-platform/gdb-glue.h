@@ -1,12 +1,26 @@
 #pragma once
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <sys/uio.h>
 
 /**
  * Init gdb stream glue
  */
 void gdb_glue_init(void);
 
+/**
+ * Take the target access lock, shared by the gdb thread and observer sessions
+ * @param timeout ticks
+ * @return bool true if taken
+ */
+bool gdb_glue_target_lock(uint32_t timeout);
+
+/**
+ * Release the target access lock
+ */
+void gdb_glue_target_unlock(void);
+
 /**
  * Get free size of rx stream
  * @return size_t 
@@ -21,13 +35,14 @@ size_t gdb_glue_get_free_size(void);
 void gdb_glue_receive(uint8_t* buffer, size_t size);
 
 /**
- * 
- * @return bool 
+ * Wait until the rx stream can take a full socket read
+ * @param timeout ticks
+ * @return size_t free size of rx stream, may be short after a timeout
  */
-bool gdb_glue_can_receive();
+size_t gdb_glue_wait_free(uint32_t timeout);
 
 /**
- * Get gdb packet size
+ * Get max size of one socket read
  * @return size_t 
  */
 size_t gdb_glue_get_packet_size();
@@ -36,4 +51,78 @@ size_t gdb_glue_get_packet_size();
  * Get blackmagic version
  * @return const char* 
  */
-const char* gdb_glue_get_bm_version();
\ No newline at end of file
+const char* gdb_glue_get_bm_version();
+
+/**
+ * Get buffered rx bytes as one contiguous span. If fewer than want bytes
+ * are buffered, pulls everything queued in the rx stream, waiting up to
+ * timeout for at least one byte.
+ * @param size bytes in the span
+ * @param want bytes the caller needs
+ * @param timeout ticks
+ * @return const uint8_t* span, valid until the next call
+ */
+const uint8_t *gdb_glue_rx_span(size_t *size, size_t want, uint32_t timeout);
+
+/**
+ * Drop bytes from the start of the rx span
+ * @param size
+ */
+void gdb_glue_rx_consume(size_t size);
+
+/**
+ * Get rx span size limit
+ * @return size_t
+ */
+size_t gdb_glue_rx_span_capacity(void);
+
+/**
+ * Append text to the payload of the next packet sent through gdb_if_putchar()
+ * @param suffix static string, not escaped
+ */
+void gdb_glue_tx_append(const char *suffix);
+
+/**
+ * The gdb thread starts reading a packet: with nothing buffered, the
+ * packet is timed from its first byte to arrive
+ */
+void gdb_glue_rx_packet_start(void);
+
+/**
+ * Take the arrival time of the oldest unread byte, while stats are enabled
+ * @return low 32 bits of esp_timer_get_time() when it arrived, 0 if not known
+ */
+uint32_t gdb_glue_rx_arrival(void);
+
+/**
+ * Throw away everything received from the previous owner that the gdb
+ * thread has not read yet. Called from the network task when the owner is
+ * dropped; no new input is taken until the gdb thread has done it.
+ */
+void gdb_glue_rx_discard(void);
+
+/**
+ * Forget the reply encoder state of the previous session: a packet cut off
+ * by a disconnect, its pending suffix and unsent bytes. Called before a new
+ * owner is marked connected, so the gdb thread is not writing.
+ */
+void gdb_glue_session_reset(void);
+
+/**
+ * Send an iovec list to the GDB client after any buffered gdb_if_putchar() bytes
+ * @param iov iovec list, adjusted while sending
+ * @param count iovec count
+ */
+void gdb_glue_sendv(struct iovec *iov, size_t count);
+
+/**
+ * Get bytes moved between the GDB client and the glue
+ * @param rx_bytes received from the client
+ * @param tx_bytes sent to the client
+ */
+void gdb_glue_get_stats(uint64_t *rx_bytes, uint64_t *tx_bytes);
+
+/**
+ * Clear byte counters
+ */
+void gdb_glue_reset_stats(void);
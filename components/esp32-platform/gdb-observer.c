@@ -0,0 +1,357 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "general.h"
+#include "target.h"
+#include "gdb_main.h"
+#include "hex_utils.h"
+#include "gdb-glue.h"
+#include "target-cache.h"
+#include "gdb-observer.h"
+
+/*
+ * Read-only RSP sessions next to the one gdb_main() serves. Observers get
+ * memory (m/x) and registers (g/p) of the owner's current target through
+ * target-cache.c, so while the target is halted they share the owner's
+ * cached view, and while it runs they read live memory. The target
+ * description and memory map (qXfer) are served as well, so gdb knows the
+ * register layout and the regions. Registers are only readable while the
+ * target is halted, and '?' answers "OK", the non-stop reply for no
+ * stopped thread, instead of a stale stop reply while it runs. Anything that could resume, step, write or run a monitor
+ * command is answered with an error, and observers cannot attach targets
+ * themselves.
+ *
+ * All observers are served from the network task, one packet at a time,
+ * so the packet, payload and reply buffers are shared.
+ */
+
+typedef struct
+{
+    char packet[GDB_OBSERVER_PACKET_SIZE + 1U];
+    uint8_t mem[GDB_OBSERVER_PACKET_SIZE / 2U];
+    char map[GDB_OBSERVER_PACKET_SIZE];
+    char payload[GDB_OBSERVER_PACKET_SIZE + 1U];
+    uint8_t reply[GDB_OBSERVER_SEND_MAX - 1U];
+} GDBObserverBuffers;
+
+static GDBObserverBuffers gdb_observer_buffers;
+
+void gdb_observer_init(GDBObserver *observer)
+{
+    observer->rx_size = 0;
+    observer->noack = false;
+    observer->packets = 0;
+}
+
+uint8_t *gdb_observer_rx_buffer(GDBObserver *observer, size_t *space)
+{
+    *space = sizeof(observer->rx) - observer->rx_size;
+    return observer->rx + observer->rx_size;
+}
+
+void gdb_observer_rx_commit(GDBObserver *observer, size_t size)
+{
+    observer->rx_size += size;
+}
+
+static const uint8_t *gdb_observer_packet_end(const GDBObserver *observer)
+{
+    const uint8_t *start = memchr(observer->rx, '$', observer->rx_size);
+    if (start == NULL)
+        return NULL;
+    const uint8_t *end = observer->rx + observer->rx_size;
+    const uint8_t *hash = memchr(start, '#', end - start);
+    if (hash == NULL || end - hash < 3)
+        return NULL;
+    return hash + 3;
+}
+
+bool gdb_observer_pending(const GDBObserver *observer)
+{
+    return gdb_observer_packet_end(observer) != NULL;
+}
+
+static void gdb_observer_consume(GDBObserver *observer, size_t size)
+{
+    observer->rx_size -= size;
+    memmove(observer->rx, observer->rx + size, observer->rx_size);
+}
+
+static void gdb_observer_reply(
+    gdb_observer_send_fn send, void *context, const void *data, size_t size, bool binary)
+{
+    static const char digits[] = "0123456789abcdef";
+    uint8_t *out = gdb_observer_buffers.reply;
+    const uint8_t *in = data;
+    uint8_t checksum = 0;
+
+    *out++ = '$';
+    for (size_t i = 0; i < size; i++)
+    {
+        uint8_t c = in[i];
+        if (binary && (c == '$' || c == '#' || c == '}' || c == '*'))
+        {
+            *out++ = '}';
+            checksum += '}';
+            c ^= 0x20U;
+        }
+        *out++ = c;
+        checksum += c;
+    }
+    *out++ = '#';
+    *out++ = digits[checksum >> 4U];
+    *out++ = digits[checksum & 0xfU];
+    send(context, gdb_observer_buffers.reply, out - gdb_observer_buffers.reply);
+}
+
+static void gdb_observer_reply_str(gdb_observer_send_fn send, void *context, const char *str)
+{
+    gdb_observer_reply(send, context, str, strlen(str), false);
+}
+
+static void gdb_observer_reply_hex(gdb_observer_send_fn send, void *context, const void *data, size_t size)
+{
+    hexify(gdb_observer_buffers.payload, data, size);
+    gdb_observer_reply(send, context, gdb_observer_buffers.payload, size * 2U, false);
+}
+
+#define GDB_OBSERVER_XFER_FEATURES "qXfer:features:read:target.xml:"
+#define GDB_OBSERVER_XFER_MEMORY_MAP "qXfer:memory-map:read::"
+
+/* Packets that touch the target and need the lock */
+static bool gdb_observer_reads_target(const char *packet)
+{
+    return packet[0] == 'm' || packet[0] == 'x' || packet[0] == 'g' || packet[0] == 'p' ||
+           strncmp(packet, GDB_OBSERVER_XFER_FEATURES, strlen(GDB_OBSERVER_XFER_FEATURES)) == 0 ||
+           strncmp(packet, GDB_OBSERVER_XFER_MEMORY_MAP, strlen(GDB_OBSERVER_XFER_MEMORY_MAP)) == 0;
+}
+
+/* Packets reserved for the owner */
+static bool gdb_observer_owner_only(const char *packet)
+{
+    if (strchr("cCsSiIMXGPZzRA!", packet[0]) != NULL)
+        return true;
+    return strncmp(packet, "vCont;", 6) == 0 || strncmp(packet, "vFlash", 6) == 0 ||
+           strncmp(packet, "vRun", 4) == 0 || strncmp(packet, "vAttach", 7) == 0 ||
+           strncmp(packet, "vKill", 5) == 0 || strncmp(packet, "qRcmd", 5) == 0;
+}
+
+/* One "offset,length" window of a qXfer document, 'l' marking the last */
+static void gdb_observer_xfer_reply(
+    const char *document, const char *window, gdb_observer_send_fn send, void *context)
+{
+    uint32_t offset;
+    uint32_t len;
+    const size_t size = document != NULL ? strlen(document) : 0;
+    if (sscanf(window, "%" SCNx32 ",%" SCNx32, &offset, &len) != 2 || offset > size)
+    {
+        gdb_observer_reply_str(send, context, "E01");
+        return;
+    }
+
+    len = MIN(len, sizeof(gdb_observer_buffers.payload) - 1U);
+    len = MIN(len, size - offset);
+    gdb_observer_buffers.payload[0] = offset + len == size ? 'l' : 'm';
+    memcpy(gdb_observer_buffers.payload + 1U, document + offset, len);
+    gdb_observer_reply(send, context, gdb_observer_buffers.payload, len + 1U, true);
+}
+
+static void gdb_observer_xfer(const char *packet, gdb_observer_send_fn send, void *context)
+{
+    if (strncmp(packet, GDB_OBSERVER_XFER_FEATURES, strlen(GDB_OBSERVER_XFER_FEATURES)) == 0)
+    {
+        const char *description = target_regs_description(cur_target);
+        gdb_observer_xfer_reply(description, packet + strlen(GDB_OBSERVER_XFER_FEATURES), send, context);
+        free((void *)description);
+    }
+    else
+    {
+        if (!target_mem_map(cur_target, gdb_observer_buffers.map, sizeof(gdb_observer_buffers.map)))
+            gdb_observer_reply_str(send, context, "E01");
+        else
+            gdb_observer_xfer_reply(
+                gdb_observer_buffers.map, packet + strlen(GDB_OBSERVER_XFER_MEMORY_MAP), send, context);
+    }
+}
+
+static void gdb_observer_read(const char *packet, gdb_observer_send_fn send, void *context)
+{
+    uint32_t addr;
+    uint32_t len;
+
+    if (cur_target == NULL)
+    {
+        gdb_observer_reply_str(send, context, "EFF");
+        return;
+    }
+
+    switch (packet[0])
+    {
+    case 'm':
+        if (sscanf(packet, "m%" SCNx32 ",%" SCNx32, &addr, &len) != 2 || len > sizeof(gdb_observer_buffers.mem) ||
+            target_cache_mem_read(cur_target, gdb_observer_buffers.mem, addr, len))
+            gdb_observer_reply_str(send, context, "E01");
+        else
+            gdb_observer_reply_hex(send, context, gdb_observer_buffers.mem, len);
+        break;
+    case 'x':
+        /* Cut to the buffer, gdb asks again for the rest */
+        if (sscanf(packet, "x%" SCNx32 ",%" SCNx32, &addr, &len) != 2)
+        {
+            gdb_observer_reply_str(send, context, "E01");
+            break;
+        }
+        if (len > sizeof(gdb_observer_buffers.payload) - 1U)
+            len = sizeof(gdb_observer_buffers.payload) - 1U;
+        gdb_observer_buffers.payload[0] = 'b';
+        if (target_cache_mem_read(cur_target, gdb_observer_buffers.payload + 1U, addr, len))
+            gdb_observer_reply_str(send, context, "E01");
+        else
+            gdb_observer_reply(send, context, gdb_observer_buffers.payload, len + 1U, true);
+        break;
+    case 'g':
+    {
+        if (gdb_target_running)
+        {
+            gdb_observer_reply_str(send, context, "E01");
+            break;
+        }
+        const size_t size = target_regs_size(cur_target);
+        if (size == 0 || size > sizeof(gdb_observer_buffers.mem))
+            gdb_observer_reply_str(send, context, "E01");
+        else
+        {
+            target_cache_regs_read(cur_target, gdb_observer_buffers.mem, size);
+            gdb_observer_reply_hex(send, context, gdb_observer_buffers.mem, size);
+        }
+        break;
+    }
+    case 'p':
+    {
+        uint8_t value[8];
+        size_t size = 0;
+        if (!gdb_target_running && sscanf(packet, "p%" SCNx32, &addr) == 1)
+            size = target_cache_reg_read(cur_target, addr, value, sizeof(value));
+        if (size > 0)
+            gdb_observer_reply_hex(send, context, value, size);
+        else
+            gdb_observer_reply_str(send, context, "EFF");
+        break;
+    }
+    case 'q':
+        gdb_observer_xfer(packet, send, context);
+        break;
+    default:
+        break;
+    }
+}
+
+static gdb_observer_result_e gdb_observer_handle(
+    GDBObserver *observer, const char *packet, gdb_observer_send_fn send, void *context)
+{
+    char reply[128];
+
+    if (gdb_observer_reads_target(packet))
+        gdb_observer_read(packet, send, context);
+    else if (gdb_observer_owner_only(packet))
+        gdb_observer_reply_str(send, context, "E01");
+    else if (strncmp(packet, "qSupported", 10) == 0)
+    {
+        snprintf(reply, sizeof(reply), "PacketSize=%x;QStartNoAckMode+;binary-upload+;qXfer:features:read+;qXfer:memory-map:read+",
+                 (unsigned)GDB_OBSERVER_PACKET_SIZE);
+        gdb_observer_reply_str(send, context, reply);
+    }
+    else if (strcmp(packet, "QStartNoAckMode") == 0)
+    {
+        gdb_observer_reply_str(send, context, "OK");
+        observer->noack = true;
+    }
+    else if (packet[0] == '?')
+        gdb_observer_reply_str(send, context, cur_target == NULL ? "W00" : gdb_target_running ? "OK" : "S05");
+    else if (packet[0] == 'H' || packet[0] == 'T')
+        gdb_observer_reply_str(send, context, "OK");
+    else if (strcmp(packet, "qAttached") == 0)
+        gdb_observer_reply_str(send, context, "1");
+    else if (strcmp(packet, "qC") == 0)
+        gdb_observer_reply_str(send, context, "QC1");
+    else if (strcmp(packet, "qfThreadInfo") == 0)
+        gdb_observer_reply_str(send, context, "m1");
+    else if (strcmp(packet, "qsThreadInfo") == 0)
+        gdb_observer_reply_str(send, context, "l");
+    else if (packet[0] == 'D')
+    {
+        gdb_observer_reply_str(send, context, "OK");
+        return GDB_OBSERVER_DETACH;
+    }
+    else if (packet[0] == 'k')
+        return GDB_OBSERVER_DETACH;
+    else
+        gdb_observer_reply_str(send, context, "");
+    return GDB_OBSERVER_DONE;
+}
+
+gdb_observer_result_e gdb_observer_service(GDBObserver *observer, gdb_observer_send_fn send, void *context)
+{
+    /* Drop acks, ^C and noise before the packet */
+    const uint8_t *start = memchr(observer->rx, '$', observer->rx_size);
+    if (start == NULL)
+    {
+        observer->rx_size = 0;
+        return GDB_OBSERVER_IDLE;
+    }
+    gdb_observer_consume(observer, start - observer->rx);
+
+    const uint8_t *end = gdb_observer_packet_end(observer);
+    if (end == NULL)
+    {
+        /* Longer than the PacketSize we offered */
+        if (observer->rx_size == sizeof(observer->rx))
+            observer->rx_size = 0;
+        return GDB_OBSERVER_IDLE;
+    }
+
+    const size_t packet_size = end - observer->rx;
+    const uint8_t *payload = observer->rx + 1U;
+    const size_t payload_size = packet_size - 4U;
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < payload_size; i++)
+        checksum += payload[i];
+
+    uint8_t expected;
+    unhexify(&expected, (const char *)end - 2U, 1);
+    if (checksum != expected && !observer->noack)
+    {
+        gdb_observer_consume(observer, packet_size);
+        send(context, "-", 1);
+        return GDB_OBSERVER_DONE;
+    }
+
+    char *packet = gdb_observer_buffers.packet;
+    size_t size = 0;
+    for (size_t i = 0; i < payload_size; i++)
+    {
+        if (payload[i] == '}' && i + 1U < payload_size)
+            packet[size++] = (char)(payload[++i] ^ 0x20U);
+        else
+            packet[size++] = (char)payload[i];
+    }
+    packet[size] = '\0';
+
+    const bool locked = gdb_observer_reads_target(packet);
+    if (locked && !gdb_glue_target_lock(0))
+        return GDB_OBSERVER_BUSY;
+
+    gdb_observer_consume(observer, packet_size);
+    if (!observer->noack)
+        send(context, "+", 1);
+    observer->packets++;
+
+    const gdb_observer_result_e result = gdb_observer_handle(observer, packet, send, context);
+    if (locked)
+        gdb_glue_target_unlock();
+    return result;
+}
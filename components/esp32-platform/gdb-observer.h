@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* PacketSize offered to observer sessions */
+#define GDB_OBSERVER_PACKET_SIZE 1024U
+/* Most one gdb_observer_service() call sends: the ack and a reply with every byte escaped */
+#define GDB_OBSERVER_SEND_MAX (1U + GDB_OBSERVER_PACKET_SIZE * 2U + 4U)
+
+typedef enum
+{
+    GDB_OBSERVER_IDLE,   /* no complete packet buffered */
+    GDB_OBSERVER_DONE,   /* one packet answered */
+    GDB_OBSERVER_BUSY,   /* target locked by the owner, packet kept for later */
+    GDB_OBSERVER_DETACH, /* client detached, close the session */
+} gdb_observer_result_e;
+
+typedef void (*gdb_observer_send_fn)(void *context, const void *data, size_t size);
+
+typedef struct
+{
+    uint8_t rx[GDB_OBSERVER_PACKET_SIZE + 4U]; /* "$", payload, "#xx" */
+    size_t rx_size;
+    bool noack;
+    uint32_t packets;
+} GDBObserver;
+
+/**
+ * Start an observer session
+ * @param observer
+ */
+void gdb_observer_init(GDBObserver *observer);
+
+/**
+ * Get room for received bytes
+ * @param observer
+ * @param space free bytes
+ * @return uint8_t* where to receive to
+ */
+uint8_t *gdb_observer_rx_buffer(GDBObserver *observer, size_t *space);
+
+/**
+ * Account bytes received into gdb_observer_rx_buffer()
+ * @param observer
+ * @param size
+ */
+void gdb_observer_rx_commit(GDBObserver *observer, size_t size);
+
+/**
+ * @param observer
+ * @return bool a complete packet is buffered
+ */
+bool gdb_observer_pending(const GDBObserver *observer);
+
+/**
+ * Answer the first buffered packet. Reads take the target lock without
+ * waiting, if the owner holds it the packet stays buffered.
+ * @param observer
+ * @param send reply output
+ * @param context passed to send
+ * @return gdb_observer_result_e
+ */
+gdb_observer_result_e gdb_observer_service(GDBObserver *observer, gdb_observer_send_fn send, void *context);
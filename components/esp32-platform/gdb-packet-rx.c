@@ -0,0 +1,183 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <esp_cpu.h>
+#include <freertos/FreeRTOS.h>
+#include "general.h"
+#include "gdb_if.h"
+#include "gdb_packet.h"
+#include "gdb-glue.h"
+#include "gdb-packet-rx.h"
+
+/*
+ * Packet framer in front of gdb_packet_receive(). A well formed "$...#xx"
+ * packet is parsed in place in the glue rx span: '#' and '}' are found a
+ * word at a time, the payload is copied in runs between escapes. Anything
+ * else (acks, interrupts, remote protocol, bad checksums, packets larger
+ * than the span) is left in the span for the stock byte-wise parser.
+ */
+
+#define GDB_PACKET_START '$'
+#define GDB_PACKET_END '#'
+#define GDB_PACKET_ESCAPE '}'
+#define GDB_PACKET_ACK '+'
+
+gdb_packet_s *__real_gdb_packet_receive(void);
+void __real_gdb_set_noackmode(bool enable);
+
+typedef struct
+{
+    bool noackmode;
+    gdb_packet_s packet;
+    GDBPacketRxStats stats;
+} GDBPacketRx;
+
+static GDBPacketRx gdb_packet_rx;
+
+/* Offset of the first c in data, or size */
+static size_t gdb_packet_rx_find(const uint8_t *data, size_t size, uint8_t c)
+{
+    size_t offset = 0;
+    for (; offset < size && ((uintptr_t)(data + offset) & 3U) != 0; offset++)
+    {
+        if (data[offset] == c)
+            return offset;
+    }
+
+    const uint32_t pattern = 0x01010101U * c;
+    for (; offset + 4U <= size; offset += 4U)
+    {
+        uint32_t word;
+        memcpy(&word, data + offset, sizeof(word));
+        word ^= pattern;
+        /* Non-zero if any byte of word is zero, i.e. matched c */
+        if ((word - 0x01010101U) & ~word & 0x80808080U)
+            break;
+    }
+
+    for (; offset < size; offset++)
+    {
+        if (data[offset] == c)
+            return offset;
+    }
+    return size;
+}
+
+static int gdb_packet_rx_hex(uint8_t c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/* Unescape the payload of a complete frame into the packet, false if it has to go to the stock parser */
+static bool gdb_packet_rx_decode(const uint8_t *payload, size_t size, const uint8_t *checksum)
+{
+    uint8_t sum = 0;
+    for (size_t i = 0; i < size; i++)
+        sum += payload[i];
+
+    const int upper = gdb_packet_rx_hex(checksum[0]);
+    const int lower = gdb_packet_rx_hex(checksum[1]);
+    if (upper < 0 || lower < 0 || sum != (uint8_t)((upper << 4) | lower))
+        return false;
+
+    char *const out = gdb_packet_rx.packet.data;
+    size_t length = 0;
+    size_t offset = 0;
+    while (offset < size)
+    {
+        const size_t run = gdb_packet_rx_find(payload + offset, size - offset, GDB_PACKET_ESCAPE);
+        if (length + run > GDB_PACKET_BUFFER_SIZE)
+            return false;
+        memcpy(out + length, payload + offset, run);
+        length += run;
+        offset += run;
+
+        if (offset == size)
+            break;
+        /* Escape with nothing after it, or no room for the escaped byte */
+        if (offset + 1U == size || length == GDB_PACKET_BUFFER_SIZE)
+            return false;
+        out[length++] = (char)(payload[offset + 1U] ^ 0x20U);
+        offset += 2U;
+    }
+
+    out[length] = '\0';
+    gdb_packet_rx.packet.size = length;
+    gdb_packet_rx.packet.notification = false;
+    return true;
+}
+
+gdb_packet_s *__wrap_gdb_packet_receive(void)
+{
+    size_t size;
+    gdb_glue_rx_packet_start();
+    const uint8_t *span = gdb_glue_rx_span(&size, 1, portMAX_DELAY);
+    if (size == 0 || span[0] != GDB_PACKET_START)
+    {
+        gdb_packet_rx.stats.fallback_packets++;
+        return __real_gdb_packet_receive();
+    }
+
+    /* Gather the frame up to and including both checksum digits */
+    size_t end = 1;
+    while (true)
+    {
+        end += gdb_packet_rx_find(span + end, size - end, GDB_PACKET_END);
+        if (end + 2U < size)
+            break;
+
+        const size_t buffered = size;
+        span = gdb_glue_rx_span(&size, size + 1U, portMAX_DELAY);
+        if (size <= buffered)
+        {
+            /* Frame does not fit in the span */
+            gdb_packet_rx.stats.fallback_packets++;
+            return __real_gdb_packet_receive();
+        }
+    }
+
+    const uint32_t start = esp_cpu_get_cycle_count();
+    if (!gdb_packet_rx_decode(span + 1U, end - 1U, span + end + 1U))
+    {
+        gdb_packet_rx.stats.fallback_packets++;
+        return __real_gdb_packet_receive();
+    }
+    gdb_glue_rx_consume(end + 3U);
+
+    gdb_packet_rx.stats.fast_cycles += esp_cpu_get_cycle_count() - start;
+    gdb_packet_rx.stats.fast_bytes += end + 3U;
+    gdb_packet_rx.stats.fast_packets++;
+
+    if (!gdb_packet_rx.noackmode)
+        gdb_if_putchar(GDB_PACKET_ACK, 1);
+    return &gdb_packet_rx.packet;
+}
+
+/* Track no-ack mode, the flag itself is private to gdb_packet.c */
+void __wrap_gdb_set_noackmode(bool enable)
+{
+    gdb_packet_rx.noackmode = enable;
+    __real_gdb_set_noackmode(enable);
+}
+
+bool gdb_packet_rx_noackmode(void)
+{
+    return gdb_packet_rx.noackmode;
+}
+
+void gdb_packet_rx_get_stats(GDBPacketRxStats *stats)
+{
+    *stats = gdb_packet_rx.stats;
+}
+
+void gdb_packet_rx_reset_stats(void)
+{
+    memset(&gdb_packet_rx.stats, 0, sizeof(gdb_packet_rx.stats));
+}
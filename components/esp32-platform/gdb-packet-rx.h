@@ -0,0 +1,27 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct
+{
+    uint32_t fast_packets;     /* framed in place from the rx span */
+    uint32_t fallback_packets; /* left to the stock gdb_packet.c parser */
+    uint64_t fast_bytes;       /* wire bytes of fast packets */
+    uint64_t fast_cycles;      /* CPU cycles spent checking and copying them */
+} GDBPacketRxStats;
+
+/**
+ * @return bool GDB switched acks off with QStartNoAckMode
+ */
+bool gdb_packet_rx_noackmode(void);
+
+/**
+ * Get packet receive counters
+ * @param stats
+ */
+void gdb_packet_rx_get_stats(GDBPacketRxStats *stats);
+
+/**
+ * Clear packet receive counters
+ */
+void gdb_packet_rx_reset_stats(void);
@@ -0,0 +1,124 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <sys/uio.h>
+#include <freertos/FreeRTOS.h>
+#include "general.h"
+#include "gdb_if.h"
+#include "gdb-glue.h"
+#include "gdb-packet-rx.h"
+#include "gdb-packet-tx.h"
+
+/*
+ * Packet sender for replies built on the platform side. The "$" header,
+ * payload runs and "#xx" trailer go to the socket as one iovec list, so
+ * the payload is neither copied into the glue tx buffer nor passed
+ * through gdb_if_putchar() a byte at a time. Binary payloads are split
+ * around bytes that need escaping, each escape being a 2-byte iovec.
+ */
+
+#define GDB_PACKET_TX_IOV_MAX 16U
+#define GDB_PACKET_TX_ACK_TIMEOUT_MS 2000U
+#define GDB_PACKET_TX_RETRIES 3U
+
+typedef struct
+{
+    struct iovec iov[GDB_PACKET_TX_IOV_MAX];
+    size_t count;
+    uint8_t escapes[GDB_PACKET_TX_IOV_MAX][2];
+    uint8_t checksum;
+    char trailer[4];
+    const uint8_t *data;
+    size_t size;
+    bool binary;
+} GDBPacketTx;
+
+static GDBPacketTx gdb_packet_tx;
+
+static const char gdb_packet_tx_header = '$';
+
+static inline bool gdb_packet_tx_needs_escape(uint8_t c)
+{
+    return c == '$' || c == '#' || c == '}' || c == '*';
+}
+
+/* Send a full list, so iov[count] and escapes[count] are free */
+static void gdb_packet_tx_reserve(void)
+{
+    if (gdb_packet_tx.count == GDB_PACKET_TX_IOV_MAX)
+    {
+        gdb_glue_sendv(gdb_packet_tx.iov, gdb_packet_tx.count);
+        gdb_packet_tx.count = 0;
+    }
+}
+
+static void gdb_packet_tx_push(const void *data, size_t size)
+{
+    gdb_packet_tx_reserve();
+    gdb_packet_tx.iov[gdb_packet_tx.count].iov_base = (void *)data;
+    gdb_packet_tx.iov[gdb_packet_tx.count].iov_len = size;
+    gdb_packet_tx.count++;
+}
+
+static void gdb_packet_tx_payload(const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        gdb_packet_tx.checksum += data[i];
+    gdb_packet_tx_push(data, size);
+}
+
+static void gdb_packet_tx_emit(const uint8_t *data, size_t size, bool binary)
+{
+    gdb_packet_tx.count = 0;
+    gdb_packet_tx.checksum = 0;
+    gdb_packet_tx_push(&gdb_packet_tx_header, 1);
+
+    size_t run = 0;
+    for (size_t i = 0; binary && i < size; i++)
+    {
+        if (!gdb_packet_tx_needs_escape(data[i]))
+            continue;
+        if (i > run)
+            gdb_packet_tx_payload(data + run, i - run);
+
+        /* The escape lives in the slot of the iovec pointing at it */
+        gdb_packet_tx_reserve();
+        uint8_t *const escape = gdb_packet_tx.escapes[gdb_packet_tx.count];
+        escape[0] = '}';
+        escape[1] = data[i] ^ 0x20U;
+        gdb_packet_tx_payload(escape, 2);
+        run = i + 1U;
+    }
+    if (size > run)
+        gdb_packet_tx_payload(data + run, size - run);
+
+    snprintf(gdb_packet_tx.trailer, sizeof(gdb_packet_tx.trailer), "#%02x", gdb_packet_tx.checksum);
+    gdb_packet_tx_push(gdb_packet_tx.trailer, 3);
+    gdb_glue_sendv(gdb_packet_tx.iov, gdb_packet_tx.count);
+}
+
+void gdb_packet_tx_start(const void *data, size_t size, bool binary)
+{
+    gdb_packet_tx.data = data;
+    gdb_packet_tx.size = size;
+    gdb_packet_tx.binary = binary;
+    gdb_packet_tx_emit(data, size, binary);
+}
+
+/* The first copy went out in gdb_packet_tx_start(), retransmit on a missing ack */
+void gdb_packet_tx_finish(void)
+{
+    for (size_t tries = 1; !gdb_packet_rx_noackmode(); tries++)
+    {
+        if (gdb_if_getchar_to(pdMS_TO_TICKS(GDB_PACKET_TX_ACK_TIMEOUT_MS)) == '+' || tries == GDB_PACKET_TX_RETRIES)
+            break;
+        gdb_packet_tx_emit(gdb_packet_tx.data, gdb_packet_tx.size, gdb_packet_tx.binary);
+    }
+}
+
+void gdb_packet_tx_send(const void *data, size_t size, bool binary)
+{
+    gdb_packet_tx_start(data, size, binary);
+    gdb_packet_tx_finish();
+}
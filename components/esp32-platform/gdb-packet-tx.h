@@ -0,0 +1,26 @@
+#pragma once
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * Send a complete RSP packet as an iovec list, waiting for the ack unless in no-ack mode
+ * @param data payload, referenced until the send returns
+ * @param size payload size
+ * @param binary escape '$', '#', '}' and '*' in the payload
+ */
+void gdb_packet_tx_send(const void *data, size_t size, bool binary);
+
+/**
+ * Send a complete RSP packet without waiting for the ack, so the caller can
+ * work while it is in flight; gdb_packet_tx_finish() must follow
+ * @param data payload, referenced until gdb_packet_tx_finish() returns
+ * @param size payload size
+ * @param binary escape '$', '#', '}' and '*' in the payload
+ */
+void gdb_packet_tx_start(const void *data, size_t size, bool binary);
+
+/**
+ * Wait for the ack of the packet from gdb_packet_tx_start() unless in no-ack
+ * mode, retransmitting it on a missing or negative ack
+ */
+void gdb_packet_tx_finish(void);
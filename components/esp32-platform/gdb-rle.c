@@ -0,0 +1,122 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <sdkconfig.h>
+#include "gdb-rle.h"
+
+/*
+ * RSP run-length encoding of reply payloads: "c*n" stands for c followed
+ * by n - 29 more copies of c. Runs shorter than 4 stay literal, repeat
+ * counts 6 and 7 would encode as '#' and '$' and are avoided, and escape
+ * sequences ("}x") and bare '*' are never part of a run. The encoder never
+ * outputs more than it was given, so it can also work in place.
+ */
+
+#define GDB_RLE_ESCAPE '}'
+#define GDB_RLE_MARKER '*'
+#define GDB_RLE_BIAS 29U
+#define GDB_RLE_MIN_RUN 4U
+#define GDB_RLE_MAX_REPEAT 97U /* '~' */
+
+typedef struct
+{
+    bool enabled;
+    GDBRleStats stats;
+} GDBRleState;
+
+static GDBRleState gdb_rle_state = {
+#ifdef CONFIG_BMP_GDB_RLE
+    .enabled = true,
+#endif
+};
+
+void gdb_rle_init(GDBRle *rle)
+{
+    rle->run_length = 0;
+    rle->escape = false;
+}
+
+size_t gdb_rle_flush(GDBRle *rle, uint8_t *out)
+{
+    size_t written = 0;
+    size_t length = rle->run_length;
+    const uint8_t c = rle->run_char;
+
+    if (length >= GDB_RLE_MIN_RUN)
+    {
+        size_t repeat = length - 1U;
+        if (repeat > GDB_RLE_MAX_REPEAT)
+            repeat = GDB_RLE_MAX_REPEAT;
+        if (repeat == 6U || repeat == 7U)
+            repeat = 5U;
+        out[written++] = c;
+        out[written++] = GDB_RLE_MARKER;
+        out[written++] = (uint8_t)(repeat + GDB_RLE_BIAS);
+        length -= repeat + 1U;
+    }
+    while (length-- > 0)
+        out[written++] = c;
+
+    rle->run_length = 0;
+    return written;
+}
+
+size_t gdb_rle_push(GDBRle *rle, uint8_t c, uint8_t *out)
+{
+    size_t written = 0;
+
+    if (rle->escape || c == GDB_RLE_ESCAPE || c == GDB_RLE_MARKER)
+    {
+        written = gdb_rle_flush(rle, out);
+        out[written++] = c;
+        rle->escape = c == GDB_RLE_ESCAPE && !rle->escape;
+        return written;
+    }
+
+    if (rle->run_length > 0 && (c != rle->run_char || rle->run_length == GDB_RLE_MAX_REPEAT + 1U))
+        written = gdb_rle_flush(rle, out);
+    rle->run_char = c;
+    rle->run_length++;
+    return written;
+}
+
+size_t gdb_rle_encode(uint8_t *data, size_t size)
+{
+    GDBRle rle;
+    size_t written = 0;
+
+    gdb_rle_init(&rle);
+    for (size_t i = 0; i < size; i++)
+        written += gdb_rle_push(&rle, data[i], data + written);
+    written += gdb_rle_flush(&rle, data + written);
+
+    gdb_rle_count(size, written);
+    return written;
+}
+
+void gdb_rle_count(size_t raw, size_t encoded)
+{
+    gdb_rle_state.stats.raw_bytes += raw;
+    gdb_rle_state.stats.encoded_bytes += encoded;
+}
+
+void gdb_rle_set_enabled(bool enable)
+{
+    gdb_rle_state.enabled = enable;
+}
+
+bool gdb_rle_enabled(void)
+{
+    return gdb_rle_state.enabled;
+}
+
+void gdb_rle_get_stats(GDBRleStats *stats)
+{
+    *stats = gdb_rle_state.stats;
+}
+
+void gdb_rle_reset_stats(void)
+{
+    gdb_rle_state.stats.raw_bytes = 0;
+    gdb_rle_state.stats.encoded_bytes = 0;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Most bytes one gdb_rle_push() or gdb_rle_flush() call writes */
+#define GDB_RLE_OUT_MAX 6U
+
+typedef struct
+{
+    uint8_t run_char;
+    size_t run_length;
+    bool escape;
+} GDBRle;
+
+typedef struct
+{
+    uint64_t raw_bytes;     /* payload bytes before encoding */
+    uint64_t encoded_bytes; /* payload bytes on the wire */
+} GDBRleStats;
+
+/**
+ * Start encoding a packet payload
+ * @param rle
+ */
+void gdb_rle_init(GDBRle *rle);
+
+/**
+ * Feed one payload byte
+ * @param rle
+ * @param c
+ * @param out room for GDB_RLE_OUT_MAX bytes
+ * @return size_t bytes written to out
+ */
+size_t gdb_rle_push(GDBRle *rle, uint8_t c, uint8_t *out);
+
+/**
+ * End of payload, write the pending run
+ * @param rle
+ * @param out room for GDB_RLE_OUT_MAX bytes
+ * @return size_t bytes written to out
+ */
+size_t gdb_rle_flush(GDBRle *rle, uint8_t *out);
+
+/**
+ * Encode a whole payload in place
+ * @param data
+ * @param size
+ * @return size_t encoded size
+ */
+size_t gdb_rle_encode(uint8_t *data, size_t size);
+
+/**
+ * Add to the saving counters
+ * @param raw payload bytes before encoding
+ * @param encoded payload bytes after encoding
+ */
+void gdb_rle_count(size_t raw, size_t encoded);
+
+/**
+ * Enable or disable run-length encoding of replies
+ * @param enable
+ */
+void gdb_rle_set_enabled(bool enable);
+
+/**
+ * @return bool run-length encoding enabled
+ */
+bool gdb_rle_enabled(void);
+
+/**
+ * Get saving counters
+ * @param stats
+ */
+void gdb_rle_get_stats(GDBRleStats *stats);
+
+/**
+ * Clear saving counters
+ */
+void gdb_rle_reset_stats(void);
@@ -0,0 +1,162 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <esp_timer.h>
+#include "general.h"
+#include "gdb-glue.h"
+#include "tap-stats.h"
+#include "gdb-stats.h"
+
+/*
+ * Per packet type counters and latency histograms for the GDB server, to
+ * tell Wi-Fi, packet handling and SWD time apart. Receive time runs from
+ * the network task handing over the first byte of a packet (gdb-glue.c)
+ * to the framed packet, so it covers a packet arriving in pieces and
+ * waiting behind the previous one, whichever path frames it. Processing
+ * time is gdb_main() (gdb-dispatch.c) less the SWD time that tap-stats.c
+ * measured meanwhile. Histograms have log2 buckets from 32 us. When
+ * disabled, each hook is one branch.
+ */
+
+#define GDB_STATS_BUCKET_MIN_US 32U
+
+/* Typed by the first character, the last entry takes the rest */
+static const char *const gdb_stats_names[] = {
+    "?", "c", "D", "g", "G", "H", "k", "m", "M", "p", "P",
+    "q", "Q", "s", "T", "v", "x", "X", "z", "Z", "other",
+};
+#define GDB_STATS_TYPES (sizeof(gdb_stats_names) / sizeof(gdb_stats_names[0]))
+
+typedef struct
+{
+    bool enabled;
+    int64_t receive_us;
+    int64_t process_start;
+    uint64_t tap_cycles;
+    uint64_t tx_bytes;
+    size_t current;
+    GDBStatsType types[GDB_STATS_TYPES];
+} GDBStats;
+
+static GDBStats gdb_stats = {
+#ifdef CONFIG_BMP_GDB_STATS
+    .enabled = true,
+#endif
+};
+
+static size_t gdb_stats_type(char c)
+{
+    size_t index = 0;
+    while (index < GDB_STATS_TYPES - 1U && gdb_stats_names[index][0] != c)
+        index++;
+    return index;
+}
+
+static void gdb_stats_record(GDBStatsType *type, gdb_stats_phase_e phase, uint64_t us)
+{
+    size_t bucket = 0;
+    while (bucket < GDB_STATS_BUCKETS - 1U && us >= gdb_stats_bucket_us(bucket))
+        bucket++;
+    type->histogram[phase][bucket]++;
+    type->total_us[phase] += us;
+}
+
+void gdb_stats_packet_begin(const char *data, size_t size)
+{
+    if (!gdb_stats.enabled)
+        return;
+
+    const uint32_t arrival = gdb_glue_rx_arrival();
+    const int64_t now = esp_timer_get_time();
+    gdb_stats.current = gdb_stats_type(data[0]);
+    gdb_stats.receive_us = arrival ? (uint32_t)now - arrival : 0;
+    gdb_stats.types[gdb_stats.current].rx_bytes += size;
+
+    TapStats tap;
+    tap_stats_get(&tap);
+    uint64_t rx_bytes;
+    gdb_glue_get_stats(&rx_bytes, &gdb_stats.tx_bytes);
+    gdb_stats.tap_cycles = tap.tap_cycles;
+    gdb_stats.process_start = esp_timer_get_time();
+}
+
+void gdb_stats_packet_end(void)
+{
+    if (!gdb_stats.enabled || gdb_stats.process_start == 0)
+        return;
+
+    const uint64_t total_us = esp_timer_get_time() - gdb_stats.process_start;
+    gdb_stats.process_start = 0;
+
+    TapStats tap;
+    tap_stats_get(&tap);
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+    gdb_glue_get_stats(&rx_bytes, &tx_bytes);
+
+    /* tap_stats_reset() in between makes the counter go back */
+    uint64_t swd_us = 0;
+    if (tap.tap_cycles >= gdb_stats.tap_cycles)
+        swd_us = MIN(tap_stats_cycles_to_us(tap.tap_cycles - gdb_stats.tap_cycles), total_us);
+
+    GDBStatsType *type = &gdb_stats.types[gdb_stats.current];
+    type->count++;
+    if (tx_bytes >= gdb_stats.tx_bytes)
+        type->tx_bytes += tx_bytes - gdb_stats.tx_bytes;
+    gdb_stats_record(type, GDB_STATS_RECEIVE, gdb_stats.receive_us);
+    gdb_stats_record(type, GDB_STATS_PROCESS, total_us - swd_us);
+    gdb_stats_record(type, GDB_STATS_SWD, swd_us);
+}
+
+void gdb_stats_set_enabled(bool enable)
+{
+    gdb_stats.enabled = enable;
+    gdb_stats.process_start = 0;
+}
+
+bool gdb_stats_enabled(void)
+{
+    return gdb_stats.enabled;
+}
+
+void gdb_stats_reset(void)
+{
+    memset(gdb_stats.types, 0, sizeof(gdb_stats.types));
+}
+
+size_t gdb_stats_types(void)
+{
+    return GDB_STATS_TYPES;
+}
+
+const char *gdb_stats_get(size_t index, GDBStatsType *stats)
+{
+    *stats = gdb_stats.types[index];
+    return gdb_stats_names[index];
+}
+
+uint32_t gdb_stats_bucket_us(size_t bucket)
+{
+    if (bucket >= GDB_STATS_BUCKETS - 1U)
+        return UINT32_MAX;
+    return GDB_STATS_BUCKET_MIN_US << bucket;
+}
+
+uint32_t gdb_stats_percentile_us(const uint32_t *histogram, uint32_t percent)
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < GDB_STATS_BUCKETS; i++)
+        total += histogram[i];
+    if (total == 0)
+        return 0;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < GDB_STATS_BUCKETS; i++)
+    {
+        seen += histogram[i];
+        if (seen * 100U >= total * percent)
+            return gdb_stats_bucket_us(i);
+    }
+    return UINT32_MAX;
+}
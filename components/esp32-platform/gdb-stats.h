@@ -0,0 +1,79 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Histogram bucket i counts times below gdb_stats_bucket_us(i), the last one the rest */
+#define GDB_STATS_BUCKETS 12U
+
+typedef enum
+{
+    GDB_STATS_RECEIVE, /* first byte of the packet handed over by the network task to the packet framed */
+    GDB_STATS_PROCESS, /* gdb_main() without SWD time, includes sending the reply */
+    GDB_STATS_SWD,     /* clocking SWD/JTAG, needs tap counting (monitor tap_stats) */
+    GDB_STATS_PHASES,
+} gdb_stats_phase_e;
+
+typedef struct
+{
+    uint32_t count;
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+    uint64_t total_us[GDB_STATS_PHASES];
+    uint32_t histogram[GDB_STATS_PHASES][GDB_STATS_BUCKETS];
+} GDBStatsType;
+
+/**
+ * gdb_main() starts on a packet
+ * @param data packet
+ * @param size packet size
+ */
+void gdb_stats_packet_begin(const char *data, size_t size);
+
+/**
+ * gdb_main() is done with the packet
+ */
+void gdb_stats_packet_end(void);
+
+/**
+ * Enable or disable recording
+ * @param enable
+ */
+void gdb_stats_set_enabled(bool enable);
+
+/**
+ * @return bool recording enabled
+ */
+bool gdb_stats_enabled(void);
+
+/**
+ * Clear all counters
+ */
+void gdb_stats_reset(void);
+
+/**
+ * @return size_t number of packet types
+ */
+size_t gdb_stats_types(void);
+
+/**
+ * Get counters of one packet type
+ * @param index below gdb_stats_types()
+ * @param stats
+ * @return const char* packet type name
+ */
+const char *gdb_stats_get(size_t index, GDBStatsType *stats);
+
+/**
+ * @param bucket
+ * @return uint32_t upper bound of the bucket in us, UINT32_MAX for the last
+ */
+uint32_t gdb_stats_bucket_us(size_t bucket);
+
+/**
+ * Estimate a percentile from a histogram
+ * @param histogram GDB_STATS_BUCKETS counts
+ * @param percent
+ * @return uint32_t upper bound in us of the bucket holding the percentile
+ */
+uint32_t gdb_stats_percentile_us(const uint32_t *histogram, uint32_t percent);
@@ -0,0 +1,202 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <esp_timer.h>
+#include "general.h"
+#include "gdb-trace.h"
+
+/*
+ * Trace of the GDB session for offline analysis and replay
+ * (tools/rsp_replay.py). Inbound packets are recorded as gdb_main() gets
+ * them, so without framing, escapes and acks; outbound records are the
+ * raw socket writes, cut after GDB_TRACE_OUT_MAX bytes but counting every
+ * '$', which only starts a packet (replies escape it, RLE never emits it).
+ * Records go into a byte ring that drops the oldest ones when full. The
+ * ring is allocated on first enable, disabled tracing is one branch.
+ */
+
+#define GDB_TRACE_SIZE (CONFIG_BMP_GDB_TRACE_SIZE * 1024U)
+#define GDB_TRACE_OUT_MAX 256U
+
+typedef struct
+{
+    bool enabled;
+    bool frozen;
+    uint8_t *ring;
+    size_t head; /* oldest record */
+    size_t used;
+    uint32_t records;
+    uint32_t dropped;
+    int64_t start;
+    SemaphoreHandle_t lock;
+} GDBTrace;
+
+static GDBTrace gdb_trace;
+
+static void gdb_trace_copy_out(size_t offset, void *data, size_t size)
+{
+    const size_t index = (gdb_trace.head + offset) % GDB_TRACE_SIZE;
+    const size_t first = MIN(size, GDB_TRACE_SIZE - index);
+    memcpy(data, gdb_trace.ring + index, first);
+    memcpy((uint8_t *)data + first, gdb_trace.ring, size - first);
+}
+
+static void gdb_trace_copy_in(const void *data, size_t size)
+{
+    const size_t index = (gdb_trace.head + gdb_trace.used) % GDB_TRACE_SIZE;
+    const size_t first = MIN(size, GDB_TRACE_SIZE - index);
+    memcpy(gdb_trace.ring + index, data, first);
+    memcpy(gdb_trace.ring, (const uint8_t *)data + first, size - first);
+    gdb_trace.used += size;
+}
+
+static void gdb_trace_make_room(size_t size)
+{
+    while (gdb_trace.used + size > GDB_TRACE_SIZE)
+    {
+        GDBTraceRecord oldest;
+        gdb_trace_copy_out(0, &oldest, sizeof(oldest));
+        const size_t skip = sizeof(oldest) + oldest.length;
+        gdb_trace.head = (gdb_trace.head + skip) % GDB_TRACE_SIZE;
+        gdb_trace.used -= skip;
+        gdb_trace.records--;
+        gdb_trace.dropped++;
+    }
+}
+
+static uint8_t gdb_trace_count_packets(const void *data, size_t size)
+{
+    const uint8_t *start = data;
+    size_t count = 0;
+    for (const uint8_t *dollar = memchr(start, '$', size); dollar != NULL;
+         dollar = memchr(dollar + 1, '$', size - (size_t)(dollar + 1 - start)))
+        count++;
+    return MIN(count, UINT8_MAX);
+}
+
+static size_t gdb_trace_limit(gdb_trace_direction_e direction)
+{
+    /* Inbound packets are kept whole for replay, up to a quarter of the ring */
+    if (direction == GDB_TRACE_OUT)
+        return GDB_TRACE_OUT_MAX;
+    return MIN(GDB_TRACE_SIZE / 4U, UINT16_MAX);
+}
+
+void gdb_trace_record_iov(gdb_trace_direction_e direction, const struct iovec *iov, size_t count)
+{
+    if (!gdb_trace.enabled || gdb_trace.frozen)
+        return;
+
+    GDBTraceRecord record = {
+        .direction = direction,
+    };
+    size_t packets = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        record.size += iov[i].iov_len;
+        if (direction == GDB_TRACE_OUT)
+            packets += gdb_trace_count_packets(iov[i].iov_base, iov[i].iov_len);
+    }
+    record.packets = MIN(packets, UINT8_MAX);
+    record.length = MIN(record.size, gdb_trace_limit(direction));
+
+    xSemaphoreTake(gdb_trace.lock, portMAX_DELAY);
+    if (!gdb_trace.frozen)
+    {
+        record.time_us = (uint32_t)(esp_timer_get_time() - gdb_trace.start);
+        gdb_trace_make_room(sizeof(record) + record.length);
+        gdb_trace_copy_in(&record, sizeof(record));
+
+        size_t left = record.length;
+        for (size_t i = 0; i < count && left > 0; i++)
+        {
+            const size_t size = MIN(iov[i].iov_len, left);
+            gdb_trace_copy_in(iov[i].iov_base, size);
+            left -= size;
+        }
+        gdb_trace.records++;
+    }
+    xSemaphoreGive(gdb_trace.lock);
+}
+
+void gdb_trace_record(gdb_trace_direction_e direction, const void *data, size_t size)
+{
+    const struct iovec iov = {
+        .iov_base = (void *)data,
+        .iov_len = size,
+    };
+    gdb_trace_record_iov(direction, &iov, 1);
+}
+
+bool gdb_trace_set_enabled(bool enable)
+{
+    if (enable && gdb_trace.ring == NULL)
+    {
+        gdb_trace.lock = xSemaphoreCreateMutex();
+        gdb_trace.ring = malloc(GDB_TRACE_SIZE);
+        if (gdb_trace.lock == NULL || gdb_trace.ring == NULL)
+        {
+            if (gdb_trace.lock != NULL)
+                vSemaphoreDelete(gdb_trace.lock);
+            free(gdb_trace.ring);
+            gdb_trace.lock = NULL;
+            gdb_trace.ring = NULL;
+            return false;
+        }
+        gdb_trace.start = esp_timer_get_time();
+    }
+    gdb_trace.enabled = enable;
+    return true;
+}
+
+bool gdb_trace_enabled(void)
+{
+    return gdb_trace.enabled;
+}
+
+void gdb_trace_clear(void)
+{
+    if (gdb_trace.ring == NULL)
+        return;
+
+    xSemaphoreTake(gdb_trace.lock, portMAX_DELAY);
+    gdb_trace.head = 0;
+    gdb_trace.used = 0;
+    gdb_trace.records = 0;
+    gdb_trace.dropped = 0;
+    gdb_trace.start = esp_timer_get_time();
+    xSemaphoreGive(gdb_trace.lock);
+}
+
+void gdb_trace_freeze(bool freeze)
+{
+    if (gdb_trace.ring == NULL)
+        return;
+
+    /* Waits for a record in progress, so the reader sees whole records */
+    xSemaphoreTake(gdb_trace.lock, portMAX_DELAY);
+    gdb_trace.frozen = freeze;
+    xSemaphoreGive(gdb_trace.lock);
+}
+
+size_t gdb_trace_read(size_t offset, void *data, size_t size)
+{
+    if (gdb_trace.ring == NULL || offset >= gdb_trace.used)
+        return 0;
+
+    size = MIN(size, gdb_trace.used - offset);
+    gdb_trace_copy_out(offset, data, size);
+    return size;
+}
+
+void gdb_trace_get_stats(uint32_t *records, size_t *used, size_t *capacity, uint32_t *dropped)
+{
+    *records = gdb_trace.records;
+    *used = gdb_trace.used;
+    *capacity = gdb_trace.ring != NULL ? GDB_TRACE_SIZE : 0;
+    *dropped = gdb_trace.dropped;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/uio.h>
+
+#define GDB_TRACE_MAGIC "RSPT"
+#define GDB_TRACE_VERSION 1U
+
+typedef enum
+{
+    GDB_TRACE_IN,        /* packet payload passed to gdb_main() */
+    GDB_TRACE_OUT,       /* bytes written to the GDB socket */
+    GDB_TRACE_INTERRUPT, /* ^C while the target runs */
+} gdb_trace_direction_e;
+
+/* Little-endian record header, followed by length bytes */
+typedef struct __attribute__((packed))
+{
+    uint32_t time_us; /* since the trace was started, wraps after 71 minutes */
+    uint32_t size;    /* bytes before truncation */
+    uint16_t length;  /* bytes stored */
+    uint8_t direction;
+    uint8_t packets; /* GDB_TRACE_OUT: '$' packet starts in all size bytes */
+} GDBTraceRecord;
+
+/* Little-endian download header, followed by the records oldest first */
+typedef struct __attribute__((packed))
+{
+    char magic[4]; /* GDB_TRACE_MAGIC */
+    uint32_t version;
+    uint32_t records;
+    uint32_t dropped;
+} GDBTraceHeader;
+
+/**
+ * Record a packet or a socket write
+ * @param direction
+ * @param data
+ * @param size
+ */
+void gdb_trace_record(gdb_trace_direction_e direction, const void *data, size_t size);
+
+/**
+ * Record a socket write from an iovec list
+ * @param direction
+ * @param iov
+ * @param count
+ */
+void gdb_trace_record_iov(gdb_trace_direction_e direction, const struct iovec *iov, size_t count);
+
+/**
+ * Enable or disable recording, the ring is allocated on first enable
+ * @param enable
+ * @return bool false if the ring could not be allocated
+ */
+bool gdb_trace_set_enabled(bool enable);
+
+/**
+ * @return bool recording enabled
+ */
+bool gdb_trace_enabled(void);
+
+/**
+ * Drop all records and restart the clock
+ */
+void gdb_trace_clear(void);
+
+/**
+ * Stop recording while the ring is read, keeps enabled state
+ * @param freeze
+ */
+void gdb_trace_freeze(bool freeze);
+
+/**
+ * Read the frozen ring, oldest record first
+ * @param offset byte offset into the records
+ * @param data
+ * @param size
+ * @return size_t bytes copied, 0 at the end
+ */
+size_t gdb_trace_read(size_t offset, void *data, size_t size);
+
+/**
+ * Get fill state
+ * @param records records held
+ * @param used bytes held
+ * @param capacity ring size
+ * @param dropped records overwritten since the last clear
+ */
+void gdb_trace_get_stats(uint32_t *records, size_t *used, size_t *capacity, uint32_t *dropped);
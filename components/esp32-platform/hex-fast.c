@@ -0,0 +1,73 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "hex_utils.h"
+
+/*
+ * Table driven replacements for hexify()/unhexify() from hex_utils.c,
+ * hooked in with --wrap so the m/M/g/p packet paths in gdb_main.c and
+ * the platform 'm' reply use them. Encode turns 4 bytes into 8 digits per
+ * iteration through a 256-entry digit pair table, decode turns 8 digits
+ * into 4 bytes through a 256-entry nibble table. Both tables are constant,
+ * so they live in .rodata (DRAM with CONFIG_BMP_IRAM_HOT_PATH). The nibble
+ * table uses the same arithmetic as unhex_digit() in hex_utils.c, so
+ * invalid digits decode to the same bytes as before.
+ */
+
+#define HEX_FAST_DIGIT(n) ((n) < 10U ? '0' + (n) : 'a' + (n) - 10U)
+/* Two lowercase digits, first digit in the low byte */
+#define HEX_FAST_PAIR(b) ((uint16_t)(HEX_FAST_DIGIT((b) >> 4U) | (HEX_FAST_DIGIT((b) & 0xfU) << 8U)))
+
+/* unhex_digit(): subtract '0', then 'A' - '0' - 10 above 9, then 'a' - 'A' above 16, in uint8_t */
+#define HEX_FAST_NIBBLE_0(c) ((uint8_t)((c) - '0'))
+#define HEX_FAST_NIBBLE_1(c) \
+    (HEX_FAST_NIBBLE_0(c) > 9U ? (uint8_t)(HEX_FAST_NIBBLE_0(c) - ('A' - '0' - 10)) : HEX_FAST_NIBBLE_0(c))
+#define HEX_FAST_NIBBLE(c) \
+    (HEX_FAST_NIBBLE_1(c) > 16U ? (uint8_t)(HEX_FAST_NIBBLE_1(c) - ('a' - 'A')) : HEX_FAST_NIBBLE_1(c))
+
+#define HEX_FAST_4(f, n) f(n), f((n) + 1U), f((n) + 2U), f((n) + 3U)
+#define HEX_FAST_16(f, n) HEX_FAST_4(f, n), HEX_FAST_4(f, (n) + 4U), HEX_FAST_4(f, (n) + 8U), HEX_FAST_4(f, (n) + 12U)
+#define HEX_FAST_64(f, n) \
+    HEX_FAST_16(f, n), HEX_FAST_16(f, (n) + 16U), HEX_FAST_16(f, (n) + 32U), HEX_FAST_16(f, (n) + 48U)
+#define HEX_FAST_256(f) HEX_FAST_64(f, 0U), HEX_FAST_64(f, 64U), HEX_FAST_64(f, 128U), HEX_FAST_64(f, 192U)
+
+static const uint16_t hex_fast_pairs[256] = {HEX_FAST_256(HEX_FAST_PAIR)};
+static const uint8_t hex_fast_nibbles[256] = {HEX_FAST_256(HEX_FAST_NIBBLE)};
+
+char *__wrap_hexify(char *hex, const void *buf, size_t size)
+{
+    const uint8_t *in = buf;
+    char *out = hex;
+    for (; size >= 4U; size -= 4U, in += 4U, out += 8U)
+    {
+        const uint32_t low = hex_fast_pairs[in[0]] | ((uint32_t)hex_fast_pairs[in[1]] << 16U);
+        const uint32_t high = hex_fast_pairs[in[2]] | ((uint32_t)hex_fast_pairs[in[3]] << 16U);
+        memcpy(out, &low, sizeof(low));
+        memcpy(out + 4U, &high, sizeof(high));
+    }
+    for (; size > 0; size--, in++, out += 2U)
+        memcpy(out, &hex_fast_pairs[*in], 2U);
+
+    *out = '\0';
+    return hex;
+}
+
+static inline uint8_t hex_fast_byte(const char *hex)
+{
+    return (uint8_t)((hex_fast_nibbles[(uint8_t)hex[0]] << 4U) | hex_fast_nibbles[(uint8_t)hex[1]]);
+}
+
+char *__wrap_unhexify(void *buf, const char *hex, size_t size)
+{
+    uint8_t *out = buf;
+    for (; size >= 4U; size -= 4U, hex += 8U, out += 4U)
+    {
+        const uint32_t word = hex_fast_byte(hex) | ((uint32_t)hex_fast_byte(hex + 2U) << 8U) |
+                              ((uint32_t)hex_fast_byte(hex + 4U) << 16U) | ((uint32_t)hex_fast_byte(hex + 6U) << 24U);
+        memcpy(out, &word, sizeof(word));
+    }
+    for (; size > 0; size--, hex += 2U)
+        *out++ = hex_fast_byte(hex);
+
+    return buf;
+}
@@ -0,0 +1,208 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <esp_log.h>
+#include <soc/gpio_struct.h>
+#include "general.h"
+#include "platform.h"
+#include "timing.h"
+#include "jtagtap.h"
+#include "jtag-tap.h"
+
+#define TAG "jtag-gpio-tap"
+
+/*
+ * Bit-bang JTAG kernels working a 32-bit word per outer loop. Pin masks are
+ * resolved once per jtagtap_init() and every edge is a single store to the
+ * GPIO set/clear registers, instead of a call per pin through gpio_set_val()
+ * and gpio_get(). Edge order and TMS handling follow jtagtap.c: TMS/TDI
+ * change while TCK is low, TDO is sampled while TCK is high. Placed in IRAM
+ * by linker.lf with the rest of the hot path.
+ */
+
+typedef struct
+{
+    uint32_t tck;
+    uint32_t tms;
+    uint32_t tdi;
+    uint32_t tdo_shift;
+} JTAGGPIOTap;
+
+static JTAGGPIOTap jtag_gpio;
+
+static inline __attribute__((always_inline)) void jtag_gpio_delay(const uint32_t divider)
+{
+    for (volatile uint32_t counter = divider; counter > 0; --counter)
+        continue;
+}
+
+static inline __attribute__((always_inline)) void jtag_gpio_write(const uint32_t mask, const bool level)
+{
+    volatile uint32_t *const reg = level ? &GPIO.out_w1ts.val : &GPIO.out_w1tc.val;
+    *reg = mask;
+}
+
+/* Clock up to 32 bits of TDI out, optionally sampling TDO */
+static inline __attribute__((always_inline)) uint32_t
+jtag_gpio_shift_word(uint32_t tdi_bits, const size_t bits, const bool capture, const bool use_delay)
+{
+    const uint32_t tck = jtag_gpio.tck;
+    const uint32_t tdi = jtag_gpio.tdi;
+    const uint32_t tdo_shift = jtag_gpio.tdo_shift;
+    const uint32_t divider = target_clk_divider;
+    uint32_t tdo_bits = 0;
+
+#pragma GCC unroll 4
+    for (size_t bit = 0; bit < bits; ++bit)
+    {
+        jtag_gpio_write(tdi, tdi_bits & 1U);
+        tdi_bits >>= 1U;
+        GPIO.out_w1ts.val = tck;
+        if (use_delay)
+            jtag_gpio_delay(divider);
+        if (capture)
+            tdo_bits |= ((GPIO.in.val >> tdo_shift) & 1U) << bit;
+        GPIO.out_w1tc.val = tck;
+        if (use_delay)
+            jtag_gpio_delay(divider);
+    }
+    return tdo_bits;
+}
+
+static inline __attribute__((always_inline)) void jtag_gpio_seq(uint8_t *data_out, const bool final_tms,
+    const uint8_t *data_in, const size_t clock_cycles, const bool capture, const bool use_delay)
+{
+    GPIO.out_w1tc.val = jtag_gpio.tms;
+
+    for (size_t offset = 0; offset < clock_cycles; offset += 32U)
+    {
+        const size_t remaining = clock_cycles - offset;
+        const size_t bits = remaining > 32U ? 32U : remaining;
+        const size_t bytes = (bits + 7U) / 8U;
+        const bool last = bits == remaining;
+
+        uint32_t tdi_bits = 0;
+        if (data_in != NULL)
+        {
+            for (size_t i = 0; i < bytes; i++)
+                tdi_bits |= (uint32_t)data_in[offset / 8U + i] << (i * 8U);
+        }
+
+        uint32_t tdo_bits = jtag_gpio_shift_word(tdi_bits, last ? bits - 1U : bits, capture, use_delay);
+        if (last)
+        {
+            /* Final bit carries the exit TMS */
+            jtag_gpio_write(jtag_gpio.tms, final_tms);
+            tdo_bits |= jtag_gpio_shift_word(tdi_bits >> (bits - 1U), 1U, capture, use_delay) << (bits - 1U);
+        }
+
+        if (capture)
+        {
+            for (size_t i = 0; i < bytes; i++)
+                data_out[offset / 8U + i] = (uint8_t)(tdo_bits >> (i * 8U));
+        }
+    }
+}
+
+static void jtag_gpio_tdi_tdo_seq(
+    uint8_t *data_out, bool final_tms, const uint8_t *data_in, size_t clock_cycles)
+{
+    if (clock_cycles == 0)
+        return;
+    if (data_out == NULL)
+    {
+        if (target_clk_divider != UINT32_MAX)
+            jtag_gpio_seq(NULL, final_tms, data_in, clock_cycles, false, true);
+        else
+            jtag_gpio_seq(NULL, final_tms, data_in, clock_cycles, false, false);
+    }
+    else if (target_clk_divider != UINT32_MAX)
+        jtag_gpio_seq(data_out, final_tms, data_in, clock_cycles, true, true);
+    else
+        jtag_gpio_seq(data_out, final_tms, data_in, clock_cycles, true, false);
+}
+
+static void jtag_gpio_tdi_seq(bool final_tms, const uint8_t *data_in, size_t clock_cycles)
+{
+    if (clock_cycles == 0)
+        return;
+    if (target_clk_divider != UINT32_MAX)
+        jtag_gpio_seq(NULL, final_tms, data_in, clock_cycles, false, true);
+    else
+        jtag_gpio_seq(NULL, final_tms, data_in, clock_cycles, false, false);
+}
+
+static inline __attribute__((always_inline)) void
+jtag_gpio_tms_word(uint32_t tms_states, const size_t clock_cycles, const bool use_delay)
+{
+    const uint32_t tck = jtag_gpio.tck;
+    const uint32_t tms = jtag_gpio.tms;
+    const uint32_t divider = target_clk_divider;
+
+    for (size_t cycle = 0; cycle < clock_cycles; ++cycle)
+    {
+        jtag_gpio_write(tms, tms_states & 1U);
+        tms_states >>= 1U;
+        GPIO.out_w1ts.val = tck;
+        if (use_delay)
+            jtag_gpio_delay(divider);
+        GPIO.out_w1tc.val = tck;
+        if (use_delay)
+            jtag_gpio_delay(divider);
+    }
+}
+
+static void jtag_gpio_tms_seq(uint32_t tms_states, size_t clock_cycles)
+{
+    /* TDI idles high during state moves, as in jtagtap.c */
+    GPIO.out_w1ts.val = jtag_gpio.tdi;
+    if (target_clk_divider != UINT32_MAX)
+        jtag_gpio_tms_word(tms_states, clock_cycles, true);
+    else
+        jtag_gpio_tms_word(tms_states, clock_cycles, false);
+}
+
+static bool jtag_gpio_next(bool tms, bool tdi)
+{
+    jtag_gpio_write(jtag_gpio.tms, tms);
+    if (target_clk_divider != UINT32_MAX)
+        return jtag_gpio_shift_word(tdi, 1U, true, true);
+    return jtag_gpio_shift_word(tdi, 1U, true, false);
+}
+
+static void jtag_gpio_cycle(bool tms, bool tdi, size_t clock_cycles)
+{
+    const uint32_t tck = jtag_gpio.tck;
+    const uint32_t divider = target_clk_divider;
+
+    jtag_gpio_write(jtag_gpio.tms, tms);
+    jtag_gpio_write(jtag_gpio.tdi, tdi);
+    for (size_t cycle = 0; cycle < clock_cycles; ++cycle)
+    {
+        GPIO.out_w1ts.val = tck;
+        jtag_gpio_delay(divider + 1U);
+        GPIO.out_w1tc.val = tck;
+        jtag_gpio_delay(divider + 1U);
+    }
+}
+
+bool jtag_gpio_tap_init(void)
+{
+    if (TCK_PIN < 0 || TMS_PIN < 0 || TDI_PIN < 0 || TDO_PIN < 0)
+    {
+        ESP_LOGW(TAG, "JTAG pins not assigned, keeping jtagtap.c");
+        return false;
+    }
+
+    jtag_gpio.tck = 1U << TCK_PIN;
+    jtag_gpio.tms = 1U << TMS_PIN;
+    jtag_gpio.tdi = 1U << TDI_PIN;
+    jtag_gpio.tdo_shift = TDO_PIN;
+
+    jtag_proc.jtagtap_next = jtag_gpio_next;
+    jtag_proc.jtagtap_tms_seq = jtag_gpio_tms_seq;
+    jtag_proc.jtagtap_tdi_tdo_seq = jtag_gpio_tdi_tdo_seq;
+    jtag_proc.jtagtap_tdi_seq = jtag_gpio_tdi_seq;
+    jtag_proc.jtagtap_cycle = jtag_gpio_cycle;
+    return true;
+}
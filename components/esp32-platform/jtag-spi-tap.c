@@ -0,0 +1,257 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_attr.h>
+#include <esp_rom_gpio.h>
+#include <driver/spi_master.h>
+#include <soc/spi_periph.h>
+#include "general.h"
+#include "platform.h"
+#include "jtagtap.h"
+#include "jtag-tap.h"
+
+#define TAG "jtag-spi-tap"
+#define JTAG_SPI_HOST SPI2_HOST
+#define JTAG_SPI_CHUNK 512U
+#define JTAG_SPI_MAX_FREQ 20000000U
+
+/*
+ * Long DR/IR shifts on the GP-SPI peripheral in full-duplex mode 0: TCK is
+ * SCLK, TDI is MOSI and TDO is MISO, so TDI changes and TDO is sampled on the
+ * same edges as jtagtap.c. All bits but the last are shifted by DMA with TMS
+ * held low, the last one goes through the stock jtagtap_next() with the
+ * final TMS. TCK/TDI are only routed to the SPI signals for the duration of
+ * a shift, TMS moves and short sequences stay on the stock bit-bang procs.
+ */
+
+typedef struct
+{
+    bool enabled;
+    spi_device_handle_t device;
+    bool bus_ready;
+    uint32_t frequency;
+    jtag_proc_s stock;
+} JTAGSPITap;
+
+static JTAGSPITap jtag_spi = {
+#ifdef CONFIG_BMP_JTAG_SPI
+    .enabled = true,
+#endif
+    .frequency = CONFIG_BMP_INTERFACE_FREQ_KHZ * 1000U,
+};
+
+static WORD_ALIGNED_ATTR DMA_ATTR uint8_t jtag_spi_tx[JTAG_SPI_CHUNK];
+static WORD_ALIGNED_ATTR DMA_ATTR uint8_t jtag_spi_rx[JTAG_SPI_CHUNK];
+
+static void jtag_spi_route(bool spi)
+{
+    if (spi)
+    {
+        esp_rom_gpio_connect_out_signal(TCK_PIN, spi_periph_signal[JTAG_SPI_HOST].spiclk_out, false, false);
+        esp_rom_gpio_connect_out_signal(TDI_PIN, spi_periph_signal[JTAG_SPI_HOST].spid_out, false, false);
+    }
+    else
+    {
+        /* SCLK idles low like TCK in jtagtap.c, so the handover has no edge */
+        esp_rom_gpio_connect_out_signal(TCK_PIN, SIG_GPIO_OUT_IDX, false, false);
+        esp_rom_gpio_connect_out_signal(TDI_PIN, SIG_GPIO_OUT_IDX, false, false);
+    }
+}
+
+/* Shift bits LSB first, data_in NULL shifts zeros, data_out NULL discards TDO */
+static void jtag_spi_shift(uint8_t *data_out, const uint8_t *data_in, size_t bits)
+{
+    jtag_spi_route(true);
+
+    for (size_t offset = 0; bits > 0;)
+    {
+        const size_t chunk = bits > JTAG_SPI_CHUNK * 8U ? JTAG_SPI_CHUNK * 8U : bits;
+        const size_t bytes = (chunk + 7U) / 8U;
+
+        if (data_in != NULL)
+            memcpy(jtag_spi_tx, data_in + offset, bytes);
+        else
+            memset(jtag_spi_tx, 0, bytes);
+
+        spi_transaction_t transaction = {
+            .length = chunk,
+            .tx_buffer = jtag_spi_tx,
+            .rx_buffer = data_out != NULL ? jtag_spi_rx : NULL,
+        };
+        esp_err_t err = spi_device_polling_transmit(jtag_spi.device, &transaction);
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Transfer failed: %s", esp_err_to_name(err));
+            break;
+        }
+
+        if (data_out != NULL)
+            memcpy(data_out + offset, jtag_spi_rx, bytes);
+        offset += bytes;
+        bits -= chunk;
+    }
+
+    jtag_spi_route(false);
+}
+
+static void jtag_spi_tdi_tdo_seq(uint8_t *data_out, bool final_tms, const uint8_t *data_in, size_t clock_cycles)
+{
+    if (clock_cycles < CONFIG_BMP_JTAG_SPI_MIN_BITS || jtag_spi.device == NULL)
+    {
+        jtag_spi.stock.jtagtap_tdi_tdo_seq(data_out, final_tms, data_in, clock_cycles);
+        return;
+    }
+
+    gpio_set_val(TMS_PORT, TMS_PIN, false);
+    const size_t bulk = clock_cycles - 1U;
+    jtag_spi_shift(data_out, data_in, bulk);
+
+    const size_t byte = bulk / 8U;
+    const uint8_t bit = bulk % 8U;
+    const bool tdi = data_in != NULL && ((data_in[byte] >> bit) & 1U);
+    const bool tdo = jtag_spi.stock.jtagtap_next(final_tms, tdi);
+    if (data_out != NULL)
+        data_out[byte] = (data_out[byte] & ((1U << bit) - 1U)) | ((uint8_t)tdo << bit);
+}
+
+static void jtag_spi_tdi_seq(bool final_tms, const uint8_t *data_in, size_t clock_cycles)
+{
+    if (clock_cycles < CONFIG_BMP_JTAG_SPI_MIN_BITS || jtag_spi.device == NULL)
+    {
+        jtag_spi.stock.jtagtap_tdi_seq(final_tms, data_in, clock_cycles);
+        return;
+    }
+
+    gpio_set_val(TMS_PORT, TMS_PIN, false);
+    const size_t bulk = clock_cycles - 1U;
+    jtag_spi_shift(NULL, data_in, bulk);
+
+    const bool tdi = data_in != NULL && ((data_in[bulk / 8U] >> (bulk % 8U)) & 1U);
+    jtag_spi.stock.jtagtap_next(final_tms, tdi);
+}
+
+static esp_err_t jtag_spi_add_device(void)
+{
+    spi_device_interface_config_t device = {
+        .mode = 0,
+        .clock_speed_hz = jtag_spi.frequency,
+        .spics_io_num = -1,
+        .queue_size = 1,
+        .flags = SPI_DEVICE_BIT_LSBFIRST,
+    };
+
+    esp_err_t err = spi_bus_add_device(JTAG_SPI_HOST, &device, &jtag_spi.device);
+    if (err != ESP_OK)
+    {
+        jtag_spi.device = NULL;
+        return err;
+    }
+
+    /* Keep the bus for back-to-back polling transactions */
+    return spi_device_acquire_bus(jtag_spi.device, portMAX_DELAY);
+}
+
+static void jtag_spi_remove_device(void)
+{
+    if (jtag_spi.device != NULL)
+    {
+        spi_device_release_bus(jtag_spi.device);
+        spi_bus_remove_device(jtag_spi.device);
+        jtag_spi.device = NULL;
+    }
+}
+
+bool jtag_spi_tap_init(void)
+{
+    jtag_spi_tap_deinit();
+
+    if (!jtag_spi.enabled || TDI_PIN < 0 || TDO_PIN < 0 || TCK_PIN < 0)
+        return false;
+
+    spi_bus_config_t bus = {
+        .mosi_io_num = TDI_PIN,
+        .miso_io_num = TDO_PIN,
+        .sclk_io_num = TCK_PIN,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = JTAG_SPI_CHUNK,
+        /* GPIO matrix only, so TCK/TDI can be handed back to GPIO between shifts */
+        .flags = SPICOMMON_BUSFLAG_MASTER | SPICOMMON_BUSFLAG_GPIO_PINS,
+    };
+
+    esp_err_t err = spi_bus_initialize(JTAG_SPI_HOST, &bus, SPI_DMA_CH_AUTO);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Unable to init SPI bus: %s", esp_err_to_name(err));
+        return false;
+    }
+    jtag_spi.bus_ready = true;
+
+    err = jtag_spi_add_device();
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Unable to add SPI device: %s", esp_err_to_name(err));
+        jtag_spi_tap_deinit();
+        return false;
+    }
+
+    jtag_spi_route(false);
+
+    jtag_spi.stock = jtag_proc;
+    jtag_proc.jtagtap_tdi_tdo_seq = jtag_spi_tdi_tdo_seq;
+    jtag_proc.jtagtap_tdi_seq = jtag_spi_tdi_seq;
+
+    ESP_LOGI(TAG, "TCK=%ld TDI=%ld TDO=%ld, shifts of %u+ bits at %lu Hz", (long)TCK_PIN, (long)TDI_PIN,
+             (long)TDO_PIN, CONFIG_BMP_JTAG_SPI_MIN_BITS, jtag_spi.frequency);
+    return true;
+}
+
+void jtag_spi_tap_deinit(void)
+{
+    if (jtag_proc.jtagtap_tdi_tdo_seq == jtag_spi_tdi_tdo_seq)
+    {
+        jtag_proc.jtagtap_tdi_tdo_seq = jtag_spi.stock.jtagtap_tdi_tdo_seq;
+        jtag_proc.jtagtap_tdi_seq = jtag_spi.stock.jtagtap_tdi_seq;
+    }
+
+    jtag_spi_remove_device();
+
+    if (jtag_spi.bus_ready)
+    {
+        spi_bus_free(JTAG_SPI_HOST);
+        jtag_spi.bus_ready = false;
+    }
+}
+
+uint32_t jtag_spi_tap_set_frequency(uint32_t freq)
+{
+    if (freq == 0 || freq > JTAG_SPI_MAX_FREQ)
+        freq = JTAG_SPI_MAX_FREQ;
+
+    if (freq != jtag_spi.frequency && jtag_spi.device != NULL)
+    {
+        jtag_spi.frequency = freq;
+        jtag_spi_remove_device();
+        esp_err_t err = jtag_spi_add_device();
+        if (err != ESP_OK)
+            ESP_LOGE(TAG, "Unable to re-add SPI device: %s", esp_err_to_name(err));
+    }
+    jtag_spi.frequency = freq;
+
+    int freq_khz = 0;
+    if (jtag_spi.device != NULL && spi_device_get_actual_freq(jtag_spi.device, &freq_khz) == ESP_OK)
+        return (uint32_t)freq_khz * 1000U;
+    return jtag_spi.frequency;
+}
+
+void jtag_spi_tap_set_enabled(bool enable)
+{
+    jtag_spi.enabled = enable;
+}
+
+bool jtag_spi_tap_enabled(void)
+{
+    return jtag_spi.enabled;
+}
@@ -0,0 +1,43 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <esp_log.h>
+#include "general.h"
+#include "platform.h"
+#include "jtagtap.h"
+#include "swd-tap.h"
+#include "jtag-tap.h"
+#include "platform-freq.h"
+#include "tap-stats.h"
+
+/*
+ * jtagtap_init() is linked with --wrap (see CMakeLists.txt) so the platform
+ * can adjust the stock jtagtap.c procs on every JTAG scan: bit-banging moves
+ * to the kernels in jtag-gpio-tap.c and long shifts to the GP-SPI engine in
+ * jtag-spi-tap.c, which falls back to the former for short sequences.
+ */
+
+#define TAG "jtag-tap"
+
+void __real_jtagtap_init(void);
+
+void __wrap_jtagtap_init(void)
+{
+    /* TMS/TCK are the SWDIO/SWCLK pads, release any SWD backend first */
+    swd_tap_release();
+
+    __real_jtagtap_init();
+    jtag_gpio_tap_init();
+    if (!jtag_spi_tap_init() && jtag_spi_tap_enabled())
+        ESP_LOGW(TAG, "SPI shift engine unavailable, using bitbang");
+    platform_freq_apply_jtag();
+    tap_stats_install_jtag();
+}
+
+bool jtag_tap_calibration_init(void)
+{
+    swd_tap_release();
+    jtag_spi_tap_deinit();
+    platform_jtag_pins_release();
+    return jtag_gpio_tap_init();
+}
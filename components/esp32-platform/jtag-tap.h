@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Install the GPIO kernels for timing only, with the pads released and
+ * without the SWD-to-JTAG sequence of jtagtap_init(), so a target in SWD
+ * mode stays there
+ * @return true if the kernels are installed
+ */
+bool jtag_tap_calibration_init(void);
+
+/**
+ * Replace the jtagtap.c bit-bang procs with the word-at-a-time GPIO kernels
+ * @return true on success
+ */
+bool jtag_gpio_tap_init(void);
+
+/**
+ * Enable or disable the GP-SPI shift engine, applied on next jtagtap_init()
+ * @param enable
+ */
+void jtag_spi_tap_set_enabled(bool enable);
+
+/**
+ * @return bool GP-SPI shift engine enabled
+ */
+bool jtag_spi_tap_enabled(void);
+
+/**
+ * Claim the GP-SPI peripheral for long TDI/TDO shifts on top of the installed jtag_proc
+ * @return true on success
+ */
+bool jtag_spi_tap_init(void);
+
+/**
+ * Release the GP-SPI peripheral
+ */
+void jtag_spi_tap_deinit(void);
+
+/**
+ * Set TCK frequency of SPI driven shifts, re-adds the device if the engine is active
+ * @param freq requested frequency in Hz, 0 for maximum
+ * @return uint32_t actual frequency in Hz
+ */
+uint32_t jtag_spi_tap_set_frequency(uint32_t freq);
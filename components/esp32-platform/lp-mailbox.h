@@ -0,0 +1,144 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * HP/LP core mailbox for target watching, shared by the LP program in
+ * lp_core/ and lp-offload.c. Plain C without ESP-IDF headers, so the
+ * protocol also builds into a host-side model.
+ *
+ * HP fills the configuration and sets command RUN before starting the LP
+ * core. LP then owns SWCLK/SWDIO until it reports state STOPPED, either on
+ * command STOP or after raising a terminal event (halt or SWD error). RTT
+ * bytes flow LP to HP through a single-producer ring: LP only writes head,
+ * HP only writes tail.
+ */
+
+#define LP_MAILBOX_MAGIC 0x42444d4cU /* "LMDB" */
+#define LP_MAILBOX_RING_SIZE 1024U   /* power of two */
+
+typedef enum
+{
+    LP_MAILBOX_CMD_NONE,
+    LP_MAILBOX_CMD_RUN,
+    LP_MAILBOX_CMD_STOP,
+} lp_mailbox_cmd_e;
+
+typedef enum
+{
+    LP_MAILBOX_STATE_IDLE,
+    LP_MAILBOX_STATE_RUNNING,
+    LP_MAILBOX_STATE_STOPPED,
+} lp_mailbox_state_e;
+
+#define LP_MAILBOX_EVENT_HALT (1U << 0)  /* DHCSR.S_HALT seen */
+#define LP_MAILBOX_EVENT_ERROR (1U << 1) /* SWD ACK or parity error */
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t command; /* HP to LP, lp_mailbox_cmd_e */
+    uint32_t state;   /* LP to HP, lp_mailbox_state_e */
+    uint32_t events;  /* LP to HP, LP_MAILBOX_EVENT_* */
+
+    /* Configuration, written by HP before RUN */
+    uint32_t swclk;
+    uint32_t swdio;
+    uint32_t apsel;
+    uint32_t csw;
+    uint32_t poll_interval_us;
+    uint32_t rtt_enabled;
+    uint32_t rtt_desc;   /* target address of RTT up buffer 0 descriptor */
+    uint32_t rtt_buffer; /* target address of its data */
+    uint32_t rtt_size;
+
+    /* Status, written by LP */
+    uint32_t polls;
+    uint32_t dhcsr;
+    uint32_t last_ack;
+
+    /* RTT up data, LP to HP */
+    uint32_t ring_head;
+    uint32_t ring_tail;
+    uint8_t ring[LP_MAILBOX_RING_SIZE];
+} LPMailbox;
+
+/**
+ * Clear the mailbox and set defaults
+ * @param mailbox
+ */
+static inline void lp_mailbox_reset(volatile LPMailbox *mailbox)
+{
+    volatile uint8_t *bytes = (volatile uint8_t *)mailbox;
+    for (size_t i = 0; i < sizeof(LPMailbox); i++)
+        bytes[i] = 0;
+    mailbox->magic = LP_MAILBOX_MAGIC;
+}
+
+/**
+ * @param mailbox
+ * @return size_t bytes waiting in the ring
+ */
+static inline size_t lp_mailbox_ring_used(const volatile LPMailbox *mailbox)
+{
+    return (mailbox->ring_head - mailbox->ring_tail) & (LP_MAILBOX_RING_SIZE - 1U);
+}
+
+/**
+ * @param mailbox
+ * @return size_t bytes the producer may still push
+ */
+static inline size_t lp_mailbox_ring_free(const volatile LPMailbox *mailbox)
+{
+    return LP_MAILBOX_RING_SIZE - 1U - lp_mailbox_ring_used(mailbox);
+}
+
+/**
+ * Producer (LP) side: append bytes, publishing the new head last
+ * @param mailbox
+ * @param data
+ * @param size
+ * @return size_t bytes appended
+ */
+static inline size_t lp_mailbox_ring_push(volatile LPMailbox *mailbox, const uint8_t *data, size_t size)
+{
+    const size_t space = lp_mailbox_ring_free(mailbox);
+    if (size > space)
+        size = space;
+
+    uint32_t head = mailbox->ring_head;
+    for (size_t i = 0; i < size; i++)
+    {
+        mailbox->ring[head & (LP_MAILBOX_RING_SIZE - 1U)] = data[i];
+        head++;
+    }
+    __sync_synchronize();
+    mailbox->ring_head = head & (LP_MAILBOX_RING_SIZE - 1U);
+    return size;
+}
+
+/**
+ * Consumer (HP) side: take bytes, releasing the space last
+ * @param mailbox
+ * @param data
+ * @param size
+ * @return size_t bytes taken
+ */
+static inline size_t lp_mailbox_ring_pop(volatile LPMailbox *mailbox, uint8_t *data, size_t size)
+{
+    const size_t used = lp_mailbox_ring_used(mailbox);
+    if (size > used)
+        size = used;
+    __sync_synchronize();
+
+    uint32_t tail = mailbox->ring_tail;
+    for (size_t i = 0; i < size; i++)
+    {
+        data[i] = mailbox->ring[tail & (LP_MAILBOX_RING_SIZE - 1U)];
+        tail++;
+    }
+    __sync_synchronize();
+    mailbox->ring_tail = tail & (LP_MAILBOX_RING_SIZE - 1U);
+    return size;
+}
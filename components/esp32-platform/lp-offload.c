@@ -0,0 +1,202 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <driver/rtc_io.h>
+#include <ulp_lp_core.h>
+#include "general.h"
+#include "platform.h"
+#include "target.h"
+#include "adiv5.h"
+#include "cortex.h"
+#include "rtt.h"
+#include "rtt_if.h"
+#include "rtt_if_esp32.h"
+#include "swd-tap.h"
+#include "lp-mailbox.h"
+#include "lp-offload.h"
+#include "lp_swd.h"
+
+#define TAG "lp-offload"
+
+/* Up buffer 0 descriptor follows acID[16], MaxNumUpBuffers and MaxNumDownBuffers */
+#define RTT_CB_UP_DESC 24U
+#define RTT_DESC_SIZE 24U
+#define LP_OFFLOAD_STOP_TIMEOUT_MS 20U
+
+/*
+ * While the target runs and GDB is idle, the LP core program in lp_core/
+ * owns SWCLK/SWDIO: it polls DHCSR and drains RTT into the mailbox, so the
+ * HP core only forwards RTT bytes and otherwise sleeps on the GDB socket.
+ * The LP core can only drive LP IO, so both SWD pins must be LP capable.
+ */
+
+extern const uint8_t lp_swd_bin_start[] asm("_binary_lp_swd_bin_start");
+extern const uint8_t lp_swd_bin_end[] asm("_binary_lp_swd_bin_end");
+
+void swdptap_init(void);
+
+typedef struct
+{
+    bool enabled;
+    bool active;
+    bool pins_warned;
+    uint32_t sessions;
+    uint32_t polls;
+    uint32_t halts;
+} LPOffload;
+
+static LPOffload lp_offload = {
+    .enabled = true,
+};
+
+static inline volatile LPMailbox *lp_offload_mailbox(void)
+{
+    return (volatile LPMailbox *)&ulp_mailbox;
+}
+
+static bool lp_offload_rtt_setup(volatile LPMailbox *mailbox, target_s *target)
+{
+    uint32_t desc[RTT_DESC_SIZE / 4U];
+    const uint32_t desc_addr = rtt_cbaddr + RTT_CB_UP_DESC;
+    if (target_mem32_read(target, desc, desc_addr, sizeof(desc)))
+        return false;
+
+    mailbox->rtt_desc = desc_addr;
+    mailbox->rtt_buffer = desc[1];
+    mailbox->rtt_size = desc[2];
+    mailbox->rtt_enabled = desc[1] != 0 && desc[2] != 0;
+    return true;
+}
+
+bool lp_offload_pins_supported(void)
+{
+    return rtc_gpio_is_valid_gpio(SWCLK_PIN) && rtc_gpio_is_valid_gpio(SWDIO_PIN);
+}
+
+bool lp_offload_start(target_s *target, bool rtt)
+{
+    if (!lp_offload.enabled || lp_offload.active || target == NULL || !swd_tap_in_use())
+        return false;
+    if (!lp_offload_pins_supported())
+    {
+        if (!lp_offload.pins_warned)
+            ESP_LOGW(TAG, "SWCLK %ld / SWDIO %ld not on LP IO, polling stays on the HP core", SWCLK_PIN, SWDIO_PIN);
+        lp_offload.pins_warned = true;
+        return false;
+    }
+
+    adiv5_access_port_s *ap = cortex_ap(target);
+    if (ap == NULL)
+        return false;
+
+    esp_err_t err = ulp_lp_core_load_binary(lp_swd_bin_start, lp_swd_bin_end - lp_swd_bin_start);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Unable to load LP program: %s", esp_err_to_name(err));
+        lp_offload.enabled = false;
+        return false;
+    }
+
+    volatile LPMailbox *mailbox = lp_offload_mailbox();
+    lp_mailbox_reset(mailbox);
+    mailbox->swclk = SWCLK_PIN;
+    mailbox->swdio = SWDIO_PIN;
+    mailbox->apsel = ap->apsel;
+    mailbox->csw = ap->csw;
+    mailbox->poll_interval_us = CONFIG_BMP_LP_OFFLOAD_POLL_US;
+    if (rtt && rtt_found && !lp_offload_rtt_setup(mailbox, target))
+        return false;
+    mailbox->command = LP_MAILBOX_CMD_RUN;
+
+    swd_tap_release();
+    rtc_gpio_init(SWCLK_PIN);
+    rtc_gpio_init(SWDIO_PIN);
+
+    ulp_lp_core_cfg_t config = {
+        .wakeup_source = ULP_LP_CORE_WAKEUP_SOURCE_HP_CPU,
+    };
+    err = ulp_lp_core_run(&config);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Unable to start LP core: %s", esp_err_to_name(err));
+        rtc_gpio_deinit(SWCLK_PIN);
+        rtc_gpio_deinit(SWDIO_PIN);
+        swdptap_init();
+        return false;
+    }
+
+    lp_offload.active = true;
+    lp_offload.sessions++;
+    return true;
+}
+
+static void lp_offload_forward_rtt(volatile LPMailbox *mailbox)
+{
+    uint8_t data[128];
+    size_t size;
+    bool forwarded = false;
+
+    while ((size = lp_mailbox_ring_pop(mailbox, data, sizeof(data))) > 0)
+    {
+        rtt_write(0, (const char *)data, size);
+        forwarded = true;
+    }
+    if (forwarded)
+        rtt_flush();
+}
+
+bool lp_offload_poll(void)
+{
+    if (!lp_offload.active)
+        return true;
+
+    volatile LPMailbox *mailbox = lp_offload_mailbox();
+    lp_offload_forward_rtt(mailbox);
+    return mailbox->events != 0 || mailbox->state == LP_MAILBOX_STATE_STOPPED;
+}
+
+void lp_offload_stop(void)
+{
+    if (!lp_offload.active)
+        return;
+
+    volatile LPMailbox *mailbox = lp_offload_mailbox();
+    mailbox->command = LP_MAILBOX_CMD_STOP;
+    for (uint32_t waited = 0;
+         mailbox->state == LP_MAILBOX_STATE_RUNNING && waited < LP_OFFLOAD_STOP_TIMEOUT_MS;
+         waited++)
+        vTaskDelay(pdMS_TO_TICKS(1));
+    if (mailbox->state == LP_MAILBOX_STATE_RUNNING)
+        ESP_LOGW(TAG, "LP core did not stop, last ACK %lu", mailbox->last_ack);
+    ulp_lp_core_stop();
+
+    lp_offload_forward_rtt(mailbox);
+    lp_offload.polls += mailbox->polls;
+    if (mailbox->events & LP_MAILBOX_EVENT_HALT)
+        lp_offload.halts++;
+
+    rtc_gpio_deinit(SWCLK_PIN);
+    rtc_gpio_deinit(SWDIO_PIN);
+    swdptap_init();
+    lp_offload.active = false;
+}
+
+void lp_offload_set_enabled(bool enable)
+{
+    lp_offload.enabled = enable;
+}
+
+bool lp_offload_enabled(void)
+{
+    return lp_offload.enabled;
+}
+
+void lp_offload_get_stats(uint32_t *sessions, uint32_t *polls, uint32_t *halts)
+{
+    *sessions = lp_offload.sessions;
+    *polls = lp_offload.polls;
+    *halts = lp_offload.halts;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "target.h"
+
+/**
+ * Enable or disable LP core target watching
+ * @param enable
+ */
+void lp_offload_set_enabled(bool enable);
+
+/**
+ * @return bool LP core target watching enabled
+ */
+bool lp_offload_enabled(void);
+
+/**
+ * @return bool SWCLK and SWDIO are both LP IO the LP core can drive
+ */
+bool lp_offload_pins_supported(void);
+
+/**
+ * Hand SWCLK/SWDIO to the LP core, which polls DHCSR and drains RTT up buffer 0
+ * @param target running target
+ * @param rtt drain RTT in the LP core
+ * @return bool true if the LP core took over
+ */
+bool lp_offload_start(target_s *target, bool rtt);
+
+/**
+ * Forward RTT data from the LP core
+ * @return bool true if the HP core has to take over (halt or SWD error)
+ */
+bool lp_offload_poll(void);
+
+/**
+ * Stop the LP core and give SWCLK/SWDIO back to the SWD tap
+ */
+void lp_offload_stop(void);
+
+/**
+ * Get LP core counters
+ * @param sessions hand-overs to the LP core
+ * @param polls DHCSR polls done by the LP core
+ * @param halts halts reported by the LP core
+ */
+void lp_offload_get_stats(uint32_t *sessions, uint32_t *polls, uint32_t *halts);
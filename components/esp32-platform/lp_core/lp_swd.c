@@ -0,0 +1,229 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "ulp_lp_core_utils.h"
+#include "ulp_lp_core_gpio.h"
+#include "../lp-mailbox.h"
+
+/*
+ * LP core program: minimal SWD master on LP IO that polls DHCSR of the
+ * running target and drains RTT up buffer 0 into the mailbox ring. Only
+ * the accesses needed for that are implemented, everything else (attach,
+ * error recovery, halting) stays with Black Magic on the HP core.
+ */
+
+#define SWD_ACK_OK 0x1U
+#define SWD_ACK_PARITY 0x8U /* not a wire value, local parity error */
+
+#define DP_RDBUFF 0xcU
+#define DP_SELECT 0x8U
+#define AP_CSW 0x0U
+#define AP_TAR 0x4U
+#define AP_DRW 0xcU
+#define AP_CSW_SIZE_WORD 0x2U
+
+#define CORTEXM_DHCSR 0xe000edf0U
+#define CORTEXM_DHCSR_S_HALT (1U << 17U)
+
+#define RTT_DESC_WROFF 12U
+#define RTT_DESC_RDOFF 16U
+#define RTT_CHUNK 64U
+
+volatile LPMailbox mailbox;
+
+static lp_io_num_t swclk;
+static lp_io_num_t swdio;
+
+static inline uint32_t swd_parity(uint32_t value)
+{
+    value ^= value >> 16U;
+    value ^= value >> 8U;
+    value ^= value >> 4U;
+    return (0x6996U >> (value & 0xfU)) & 1U;
+}
+
+static inline void swd_clock(void)
+{
+    ulp_lp_core_gpio_set_level(swclk, 1);
+    ulp_lp_core_gpio_set_level(swclk, 0);
+}
+
+static void swd_out(uint32_t value, size_t bits)
+{
+    for (size_t i = 0; i < bits; i++)
+    {
+        ulp_lp_core_gpio_set_level(swdio, value & 1U);
+        value >>= 1U;
+        swd_clock();
+    }
+}
+
+static uint32_t swd_in(size_t bits)
+{
+    uint32_t value = 0;
+    for (size_t i = 0; i < bits; i++)
+    {
+        value |= (uint32_t)(ulp_lp_core_gpio_get_level(swdio) & 1U) << i;
+        swd_clock();
+    }
+    return value;
+}
+
+static inline void swd_drive(bool drive)
+{
+    if (drive)
+        ulp_lp_core_gpio_output_enable(swdio);
+    else
+        ulp_lp_core_gpio_output_disable(swdio);
+}
+
+static uint32_t swd_transfer(bool ap, bool read, uint32_t addr, uint32_t *value)
+{
+    uint32_t request = 0x81U | (ap ? 0x02U : 0) | (read ? 0x04U : 0) | ((addr & 0xcU) << 1U);
+    request |= swd_parity(request & 0x1eU) << 5U;
+
+    swd_out(request, 8U);
+    swd_drive(false);
+    swd_clock();
+    const uint32_t ack = swd_in(3U);
+    mailbox.last_ack = ack;
+
+    if (ack != SWD_ACK_OK)
+    {
+        swd_clock();
+        swd_drive(true);
+        return ack;
+    }
+
+    if (read)
+    {
+        const uint32_t data = swd_in(32U);
+        const uint32_t parity = swd_in(1U);
+        swd_clock();
+        swd_drive(true);
+        if (parity != swd_parity(data))
+            return SWD_ACK_PARITY;
+        *value = data;
+    }
+    else
+    {
+        swd_clock();
+        swd_drive(true);
+        swd_out(*value, 32U);
+        swd_out(swd_parity(*value), 1U);
+    }
+    swd_out(0, 8U);
+    return SWD_ACK_OK;
+}
+
+static bool swd_write(bool ap, uint32_t addr, uint32_t value)
+{
+    return swd_transfer(ap, false, addr, &value) == SWD_ACK_OK;
+}
+
+/* Single word on MEM-AP bank 0, no auto-increment */
+static bool mem_setup(uint32_t addr)
+{
+    return swd_write(false, DP_SELECT, mailbox.apsel << 24U) &&
+           swd_write(true, AP_CSW, (mailbox.csw & ~0x37U) | AP_CSW_SIZE_WORD) && swd_write(true, AP_TAR, addr);
+}
+
+static bool mem_read32(uint32_t addr, uint32_t *value)
+{
+    uint32_t posted;
+    return mem_setup(addr) && swd_transfer(true, true, AP_DRW, &posted) == SWD_ACK_OK &&
+           swd_transfer(false, true, DP_RDBUFF, value) == SWD_ACK_OK;
+}
+
+static bool mem_write32(uint32_t addr, uint32_t value)
+{
+    uint32_t done;
+    /* RDBUFF read waits for the write to complete on the bus */
+    return mem_setup(addr) && swd_write(true, AP_DRW, value) &&
+           swd_transfer(false, true, DP_RDBUFF, &done) == SWD_ACK_OK;
+}
+
+static bool rtt_drain(void)
+{
+    uint32_t write_offset;
+    uint32_t read_offset;
+    if (!mem_read32(mailbox.rtt_desc + RTT_DESC_WROFF, &write_offset) ||
+        !mem_read32(mailbox.rtt_desc + RTT_DESC_RDOFF, &read_offset))
+        return false;
+    if (write_offset == read_offset || write_offset >= mailbox.rtt_size || read_offset >= mailbox.rtt_size)
+        return true;
+
+    size_t available = write_offset > read_offset ? write_offset - read_offset : mailbox.rtt_size - read_offset;
+    const size_t space = lp_mailbox_ring_free(&mailbox);
+    if (available > space)
+        available = space;
+    if (available > RTT_CHUNK)
+        available = RTT_CHUNK;
+    if (available == 0)
+        return true;
+
+    uint8_t data[RTT_CHUNK];
+    const uint32_t start = mailbox.rtt_buffer + read_offset;
+    for (size_t i = 0; i < available;)
+    {
+        const uint32_t addr = (start + i) & ~3U;
+        uint32_t word;
+        if (!mem_read32(addr, &word))
+            return false;
+        for (uint32_t byte = (start + i) & 3U; byte < 4U && i < available; byte++, i++)
+            data[i] = (uint8_t)(word >> (byte * 8U));
+    }
+
+    lp_mailbox_ring_push(&mailbox, data, available);
+    read_offset += available;
+    if (read_offset >= mailbox.rtt_size)
+        read_offset = 0;
+    return mem_write32(mailbox.rtt_desc + RTT_DESC_RDOFF, read_offset);
+}
+
+int main(void)
+{
+    if (mailbox.magic != LP_MAILBOX_MAGIC)
+        return 0;
+
+    swclk = (lp_io_num_t)mailbox.swclk;
+    swdio = (lp_io_num_t)mailbox.swdio;
+    ulp_lp_core_gpio_set_level(swclk, 0);
+    ulp_lp_core_gpio_output_enable(swclk);
+    ulp_lp_core_gpio_input_enable(swdio);
+    swd_drive(true);
+    mailbox.state = LP_MAILBOX_STATE_RUNNING;
+
+    while (mailbox.command == LP_MAILBOX_CMD_RUN)
+    {
+        uint32_t dhcsr;
+        if (!mem_read32(CORTEXM_DHCSR, &dhcsr))
+        {
+            mailbox.events |= LP_MAILBOX_EVENT_ERROR;
+            break;
+        }
+        mailbox.dhcsr = dhcsr;
+        mailbox.polls++;
+
+        if (dhcsr & CORTEXM_DHCSR_S_HALT)
+        {
+            mailbox.events |= LP_MAILBOX_EVENT_HALT;
+            break;
+        }
+
+        if (mailbox.rtt_enabled && !rtt_drain())
+        {
+            mailbox.events |= LP_MAILBOX_EVENT_ERROR;
+            break;
+        }
+
+        ulp_lp_core_delay_us(mailbox.poll_interval_us);
+    }
+
+    /* Same idle state as the HP taps: SWCLK low, SWDIO released */
+    swd_drive(false);
+    mailbox.state = LP_MAILBOX_STATE_STOPPED;
+    if (mailbox.events)
+        ulp_lp_core_wakeup_main_processor();
+    return 0;
+}
@@ -0,0 +1,444 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "general.h"
+#include "platform.h"
+#include "command.h"
+#include "gdb_packet.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "swd-tap.h"
+#include "auto-speed.h"
+#include "adiv5-queue.h"
+#include "tap-stats.h"
+#include "jtag-tap.h"
+#include "gdb-packet-rx.h"
+#include "gdb-glue.h"
+#include "gdb-rle.h"
+#include "target-cache.h"
+#include "poll-sched.h"
+#include "gdb-stats.h"
+#include "gdb-trace.h"
+#ifdef CONFIG_BMP_LP_OFFLOAD
+#include "lp-offload.h"
+#endif
+
+/*
+ * ESP32 platform monitor commands, appended to the Black Magic command
+ * table through PLATFORM_HAS_CUSTOM_COMMANDS.
+ */
+
+static bool cmd_swd_tap(target_s *target, int argc, const char **argv)
+{
+    (void)target;
+
+    if (argc > 1)
+    {
+        swd_tap_e tap;
+        if (!swd_tap_from_name(argv[1], &tap))
+        {
+            gdb_outf("Unknown SWD tap: %s\n", argv[1]);
+            return false;
+        }
+        swd_tap_set(tap);
+    }
+
+    gdb_outf("SWD tap: %s, selected: %s (applied on next scan)\n",
+             swd_tap_name(swd_tap_get()), swd_tap_name(swd_tap_get_selected()));
+    return true;
+}
+
+static bool cmd_jtag_spi(target_s *target, int argc, const char **argv)
+{
+    (void)target;
+
+    if (argc > 1)
+    {
+        if (strcmp(argv[1], "enable") == 0)
+            jtag_spi_tap_set_enabled(true);
+        else if (strcmp(argv[1], "disable") == 0)
+            jtag_spi_tap_set_enabled(false);
+        else
+        {
+            gdb_out("Usage: monitor jtag_spi [enable|disable]\n");
+            return false;
+        }
+    }
+
+    gdb_outf("JTAG SPI shift engine: %s (applied on next scan)\n", jtag_spi_tap_enabled() ? "enabled" : "disabled");
+    return true;
+}
+
+static bool cmd_auto_speed(target_s *target, int argc, const char **argv)
+{
+    (void)target;
+
+    if (argc > 1)
+    {
+        if (strcmp(argv[1], "enable") == 0)
+            auto_speed_set_enabled(true);
+        else if (strcmp(argv[1], "disable") == 0)
+            auto_speed_set_enabled(false);
+        else if (strcmp(argv[1], "margin") == 0 && argc > 2)
+            auto_speed_set_margin(strtoul(argv[2], NULL, 0));
+        else if (strcmp(argv[1], "run") == 0)
+        {
+            if (!auto_speed_run())
+                gdb_out("Negotiation failed, scan for a target first\n");
+        }
+        else
+        {
+            gdb_out("Usage: monitor auto_speed [enable|disable|margin <percent>|run]\n");
+            return false;
+        }
+    }
+
+    gdb_outf("Auto speed: %s, margin %lu%%\n",
+             auto_speed_enabled() ? "enabled" : "disabled", auto_speed_get_margin());
+    if (auto_speed_get_result())
+        gdb_outf("Negotiated SWJ freq %luHz\n", auto_speed_get_result());
+    return true;
+}
+
+static bool cmd_adiv5_queue(target_s *target, int argc, const char **argv)
+{
+    (void)target;
+
+    if (argc > 1)
+    {
+        if (strcmp(argv[1], "enable") == 0)
+            adiv5_queue_set_enabled(true);
+        else if (strcmp(argv[1], "disable") == 0)
+            adiv5_queue_set_enabled(false);
+        else
+        {
+            gdb_out("Usage: monitor adiv5_queue [enable|disable]\n");
+            return false;
+        }
+    }
+
+    uint32_t batches = 0;
+    uint32_t fallbacks = 0;
+    adiv5_queue_get_stats(&batches, &fallbacks);
+    gdb_outf("Batched memory access: %s, %lu batches, %lu fallbacks\n",
+             adiv5_queue_enabled() ? "enabled" : "disabled", batches, fallbacks);
+    return true;
+}
+
+static bool cmd_tap_stats(target_s *target, int argc, const char **argv)
+{
+    (void)target;
+
+    if (argc > 1)
+    {
+        if (strcmp(argv[1], "enable") == 0)
+            tap_stats_set_enabled(true);
+        else if (strcmp(argv[1], "disable") == 0)
+            tap_stats_set_enabled(false);
+        else if (strcmp(argv[1], "reset") == 0)
+            tap_stats_reset();
+        else
+        {
+            gdb_out("Usage: monitor tap_stats [enable|disable|reset]\n");
+            return false;
+        }
+        if (strcmp(argv[1], "reset") != 0)
+            gdb_out("Applied on next scan\n");
+        return true;
+    }
+
+    TapStats stats;
+    tap_stats_get(&stats);
+    const uint64_t tap_us = tap_stats_cycles_to_us(stats.tap_cycles);
+    const uint64_t swd_bits = stats.swd_bits_out + stats.swd_bits_in;
+
+    gdb_outf("Tap stats: %s, window %lu ms\n", tap_stats_enabled() ? "enabled" : "disabled",
+             (uint32_t)(stats.window_us / 1000));
+    gdb_outf("SWD: %lu calls, %lu bits out, %lu bits in, %lu turnarounds\n", stats.swd_calls,
+             (uint32_t)stats.swd_bits_out, (uint32_t)stats.swd_bits_in, stats.swd_turnarounds);
+    gdb_outf("JTAG: %lu calls, %lu bits\n", stats.jtag_calls, (uint32_t)stats.jtag_bits);
+    gdb_outf("Clocking: %lu us, %lu kbit/s\n", (uint32_t)tap_us,
+             tap_us ? (uint32_t)((swd_bits + stats.jtag_bits) * 1000U / tap_us) : 0);
+    return true;
+}
+
+#ifdef CONFIG_BMP_LP_OFFLOAD
+static bool cmd_lp_offload(target_s *target, int argc, const char **argv)
+{
+    (void)target;
+
+    if (argc > 1)
+    {
+        if (strcmp(argv[1], "enable") == 0)
+            lp_offload_set_enabled(true);
+        else if (strcmp(argv[1], "disable") == 0)
+            lp_offload_set_enabled(false);
+        else
+        {
+            gdb_out("Usage: monitor lp_offload [enable|disable]\n");
+            return false;
+        }
+    }
+
+    uint32_t sessions = 0;
+    uint32_t polls = 0;
+    uint32_t halts = 0;
+    lp_offload_get_stats(&sessions, &polls, &halts);
+    gdb_outf("LP core offload: %s, %lu sessions, %lu polls, %lu halts\n",
+             lp_offload_enabled() ? "enabled" : "disabled", sessions, polls, halts);
+    if (!lp_offload_pins_supported())
+        gdb_out("SWCLK/SWDIO not on LP IO (GPIO0-7), polling stays on the HP core\n");
+    return true;
+}
+#endif
+
+static bool cmd_gdb_rx(target_s *target, int argc, const char **argv)
+{
+    (void)target;
+
+    if (argc > 1)
+    {
+        if (strcmp(argv[1], "reset") != 0)
+        {
+            gdb_out("Usage: monitor gdb_rx [reset]\n");
+            return false;
+        }
+        gdb_packet_rx_reset_stats();
+        gdb_glue_reset_stats();
+        return true;
+    }
+
+    GDBPacketRxStats stats;
+    gdb_packet_rx_get_stats(&stats);
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+    gdb_glue_get_stats(&rx_bytes, &tx_bytes);
+    const uint32_t round_trips = stats.fast_packets + stats.fallback_packets;
+
+    gdb_outf("Packet size: %lu, %lu round trips, %lu bytes per round trip (%lu in, %lu out)\n",
+             (uint32_t)GDB_PACKET_BUFFER_SIZE, round_trips,
+             round_trips ? (uint32_t)((rx_bytes + tx_bytes) / round_trips) : 0,
+             round_trips ? (uint32_t)(rx_bytes / round_trips) : 0,
+             round_trips ? (uint32_t)(tx_bytes / round_trips) : 0);
+    gdb_outf("GDB rx: %lu framed packets, %lu via stock parser\n", stats.fast_packets, stats.fallback_packets);
+    gdb_outf("Framed: %lu bytes, %lu.%02lu cycles/byte\n", (uint32_t)stats.fast_bytes,
+             stats.fast_bytes ? (uint32_t)(stats.fast_cycles / stats.fast_bytes) : 0,
+             stats.fast_bytes ? (uint32_t)(stats.fast_cycles * 100U / stats.fast_bytes % 100U) : 0);
+    return true;
+}
+
+static bool cmd_rle(target_s *target, int argc, const char **argv)
+{
+    (void)target;
+
+    if (argc > 1)
+    {
+        if (strcmp(argv[1], "enable") == 0)
+            gdb_rle_set_enabled(true);
+        else if (strcmp(argv[1], "disable") == 0)
+            gdb_rle_set_enabled(false);
+        else if (strcmp(argv[1], "reset") == 0)
+            gdb_rle_reset_stats();
+        else
+        {
+            gdb_out("Usage: monitor rle [enable|disable|reset]\n");
+            return false;
+        }
+    }
+
+    GDBRleStats stats;
+    gdb_rle_get_stats(&stats);
+    gdb_outf("Reply RLE: %s, %lu payload bytes sent as %lu (%lu%% saved)\n",
+             gdb_rle_enabled() ? "enabled" : "disabled", (uint32_t)stats.raw_bytes, (uint32_t)stats.encoded_bytes,
+             stats.raw_bytes ? (uint32_t)((stats.raw_bytes - stats.encoded_bytes) * 100U / stats.raw_bytes) : 0);
+    return true;
+}
+
+static bool cmd_target_cache(target_s *target, int argc, const char **argv)
+{
+    (void)target;
+
+    if (argc > 1)
+    {
+        if (strcmp(argv[1], "enable") == 0)
+            target_cache_set_enabled(true);
+        else if (strcmp(argv[1], "disable") == 0)
+            target_cache_set_enabled(false);
+        else if (strcmp(argv[1], "reset") == 0)
+            target_cache_reset_stats();
+        else if (strcmp(argv[1], "window") == 0 && argc == 3)
+            target_cache_set_read_ahead(strtoul(argv[2], NULL, 0));
+        else if (strcmp(argv[1], "volatile") == 0 && argc == 3 && strcmp(argv[2], "clear") == 0)
+            target_cache_clear_volatile();
+        else if (strcmp(argv[1], "volatile") == 0 && argc == 4)
+        {
+            if (!target_cache_add_volatile(strtoul(argv[2], NULL, 0), strtoul(argv[3], NULL, 0)))
+            {
+                gdb_out("Invalid region or region table full\n");
+                return false;
+            }
+        }
+        else
+        {
+            gdb_out("Usage: monitor target_cache [enable|disable|reset|window <bytes>|volatile <start> <end>|volatile clear]\n");
+            return false;
+        }
+    }
+
+    TargetCacheStats stats;
+    target_cache_get_stats(&stats);
+    const uint32_t miss_us = stats.fills ? (uint32_t)(tap_stats_cycles_to_us(stats.miss_cycles) / stats.fills) : 0;
+
+    gdb_outf("Target cache: %s\n", target_cache_enabled() ? "enabled" : "disabled");
+    gdb_outf("Memory: %lu block hits, %lu misses, %lu us per block read, ~%lu ms saved\n", stats.mem_hits,
+             stats.mem_misses, miss_us, stats.mem_hits * miss_us / 1000U);
+    gdb_outf("Registers: %lu hits, %lu misses\n", stats.reg_hits, stats.reg_misses);
+    gdb_outf("Read-ahead: %lu byte window, %lu blocks prefetched, %lu used\n", target_cache_get_read_ahead(),
+             stats.read_ahead_blocks, stats.read_ahead_hits);
+
+    const TargetCacheRegion *regions;
+    const size_t count = target_cache_get_volatile(&regions);
+    for (size_t i = 0; i < count; i++)
+        gdb_outf("Volatile: 0x%08lx-0x%08lx\n", regions[i].start, regions[i].end);
+    return true;
+}
+
+static bool cmd_poll(target_s *target, int argc, const char **argv)
+{
+    (void)target;
+
+    if (argc > 1)
+    {
+        if (strcmp(argv[1], "reset") == 0)
+            poll_sched_reset_stats();
+        else if (strcmp(argv[1], "fast") == 0 && argc == 3)
+            poll_sched_set_fast(strtoul(argv[2], NULL, 0));
+        else if (strcmp(argv[1], "max") == 0 && argc == 3 && strtoul(argv[2], NULL, 0) > 0)
+            poll_sched_set_max(strtoul(argv[2], NULL, 0));
+        else
+        {
+            gdb_out("Usage: monitor poll [reset|fast <ms>|max <ms>]\n");
+            return false;
+        }
+    }
+
+    PollSchedStats stats;
+    poll_sched_get_stats(&stats);
+    const uint64_t busy_us = stats.running_us - MIN(stats.wait_us, stats.running_us);
+
+    gdb_outf("Target poll: %lu ms fast window, %lu ms max interval\n", poll_sched_get_fast(), poll_sched_get_max());
+    gdb_outf("Running: %lu ms, %lu polls, %lu%% CPU\n", (uint32_t)(stats.running_us / 1000U), stats.polls,
+             stats.running_us ? (uint32_t)(busy_us * 100U / stats.running_us) : 0);
+    gdb_outf("Halts: %lu polled, %lu requested, worst-case latency %lu us avg, %lu us max\n", stats.halts,
+             stats.halt_requests, stats.halts ? (uint32_t)(stats.halt_latency_us / stats.halts) : 0,
+             stats.halt_latency_max_us);
+    return true;
+}
+
+/* p90 of a histogram as "<bound" or ">=bound" for the open last bucket */
+static const char *cmd_stats_p90(const uint32_t *histogram, char *buffer, size_t size)
+{
+    const uint32_t bound = gdb_stats_percentile_us(histogram, 90);
+    if (bound == UINT32_MAX)
+        snprintf(buffer, size, ">=%lu", gdb_stats_bucket_us(GDB_STATS_BUCKETS - 2U));
+    else
+        snprintf(buffer, size, "<%lu", bound);
+    return buffer;
+}
+
+static bool cmd_stats(target_s *target, int argc, const char **argv)
+{
+    (void)target;
+
+    if (argc > 1)
+    {
+        if (strcmp(argv[1], "enable") == 0)
+            gdb_stats_set_enabled(true);
+        else if (strcmp(argv[1], "disable") == 0)
+            gdb_stats_set_enabled(false);
+        else if (strcmp(argv[1], "reset") == 0)
+            gdb_stats_reset();
+        else
+        {
+            gdb_out("Usage: monitor stats [enable|disable|reset]\n");
+            return false;
+        }
+    }
+
+    gdb_outf("GDB packet stats: %s, times in us as avg/p90\n", gdb_stats_enabled() ? "enabled" : "disabled");
+    if (!tap_stats_enabled())
+        gdb_out("SWD time needs tap counting, see monitor tap_stats\n");
+
+    for (size_t i = 0; i < gdb_stats_types(); i++)
+    {
+        GDBStatsType stats;
+        const char *name = gdb_stats_get(i, &stats);
+        if (stats.count == 0)
+            continue;
+
+        char p90[GDB_STATS_PHASES][16];
+        for (size_t phase = 0; phase < GDB_STATS_PHASES; phase++)
+            cmd_stats_p90(stats.histogram[phase], p90[phase], sizeof(p90[phase]));
+        gdb_outf("%-5s %lu pkts, %lu B in, %lu B out, receive %lu/%s, process %lu/%s, swd %lu/%s\n", name,
+                 stats.count, (uint32_t)stats.rx_bytes, (uint32_t)stats.tx_bytes,
+                 (uint32_t)(stats.total_us[GDB_STATS_RECEIVE] / stats.count), p90[GDB_STATS_RECEIVE],
+                 (uint32_t)(stats.total_us[GDB_STATS_PROCESS] / stats.count), p90[GDB_STATS_PROCESS],
+                 (uint32_t)(stats.total_us[GDB_STATS_SWD] / stats.count), p90[GDB_STATS_SWD]);
+    }
+    return true;
+}
+
+static bool cmd_trace(target_s *target, int argc, const char **argv)
+{
+    (void)target;
+
+    if (argc > 1)
+    {
+        if (strcmp(argv[1], "enable") == 0)
+        {
+            if (!gdb_trace_set_enabled(true))
+            {
+                gdb_out("No memory for the trace buffer\n");
+                return false;
+            }
+        }
+        else if (strcmp(argv[1], "disable") == 0)
+            gdb_trace_set_enabled(false);
+        else if (strcmp(argv[1], "clear") == 0)
+            gdb_trace_clear();
+        else
+        {
+            gdb_out("Usage: monitor trace [enable|disable|clear]\n");
+            return false;
+        }
+    }
+
+    uint32_t records;
+    size_t used;
+    size_t capacity;
+    uint32_t dropped;
+    gdb_trace_get_stats(&records, &used, &capacity, &dropped);
+    gdb_outf("RSP trace: %s, %lu records, %lu/%lu bytes, %lu dropped, download GET /trace\n",
+             gdb_trace_enabled() ? "enabled" : "disabled", records, (uint32_t)used, (uint32_t)capacity, dropped);
+    return true;
+}
+
+const command_s platform_cmd_list[] = {
+    {"swd_tap", cmd_swd_tap, "Select SWD tap backend: (bitbang|dedic|spi)"},
+    {"jtag_spi", cmd_jtag_spi, "GP-SPI shifts for long JTAG scans: (enable|disable)"},
+    {"auto_speed", cmd_auto_speed, "Negotiate clock after scan: (enable|disable|margin <percent>|run)"},
+    {"adiv5_queue", cmd_adiv5_queue, "Batched SWD memory access: (enable|disable)"},
+    {"tap_stats", cmd_tap_stats, "Tap bit/turnaround/time counters: (enable|disable|reset)"},
+    {"target_cache", cmd_target_cache,
+     "Halted target cache: (enable|disable|reset|window <bytes>|volatile <start> <end>|volatile clear)"},
+    {"rle", cmd_rle, "Run-length encoded replies: (enable|disable|reset)"},
+    {"gdb_rx", cmd_gdb_rx, "GDB packet and round trip counters: (reset)"},
+    {"stats", cmd_stats, "GDB packet counts and latency per type: (enable|disable|reset)"},
+    {"trace", cmd_trace, "Record RSP packets for replay: (enable|disable|clear)"},
+    {"poll", cmd_poll, "Running target poll interval, CPU and halt latency: (reset|fast <ms>|max <ms>)"},
+#ifdef CONFIG_BMP_LP_OFFLOAD
+    {"lp_offload", cmd_lp_offload, "Watch running target from the LP core: (enable|disable)"},
+#endif
+    {NULL, NULL, NULL},
+};
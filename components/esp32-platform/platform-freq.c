@@ -0,0 +1,276 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <esp_log.h>
+#include <esp_cpu.h>
+#include <esp_private/esp_clk.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "general.h"
+#include "platform.h"
+#include "timing.h"
+#include "swd.h"
+#include "jtagtap.h"
+#include "swd-tap.h"
+#include "jtag-tap.h"
+#include "platform-freq.h"
+
+#define TAG "platform-freq"
+
+#define FREQ_CAL_BITS 32U
+#define FREQ_CAL_DIVIDER 64U
+#define FREQ_CAL_ROUNDS 8U
+#define FREQ_SELFTEST_ROUNDS 2048U
+#define FREQ_SELFTEST_YIELD 64U
+/* Cycle counts are kept in 1/256 CPU cycles per bit */
+#define FREQ_FRAC_SHIFT 8U
+
+/*
+ * Linear delay model of a bit-bang tap: one bit costs `fast` cycles with the
+ * delay loops compiled out (divider UINT32_MAX), and `base + divider * step`
+ * cycles otherwise.
+ */
+typedef struct
+{
+    uint32_t fast;
+    uint32_t base;
+    uint32_t step;
+    bool valid;
+} FreqModel;
+
+typedef enum
+{
+    FREQ_IFACE_SWD,
+    FREQ_IFACE_JTAG,
+} FreqInterface;
+
+typedef struct
+{
+    FreqModel swd[SWD_TAP_COUNT];
+    FreqModel jtag;
+    uint32_t requested;
+    uint32_t actual;
+    uint32_t tuned;
+    bool use_tuned;
+    FreqInterface interface;
+    swd_tap_e swd_tap;
+} PlatformFreq;
+
+static PlatformFreq platform_freq = {
+    .requested = CONFIG_BMP_INTERFACE_FREQ_KHZ * 1000U,
+};
+
+void swdptap_init(void);
+
+/* SWDIO high only, the target sees part of a line reset */
+static void platform_freq_clock_swd(void)
+{
+    swd_proc.seq_out(UINT32_MAX, FREQ_CAL_BITS);
+}
+
+/* TMS low, a JTAG target stays in its current stable state */
+static void platform_freq_clock_jtag(void)
+{
+    uint8_t data_in[FREQ_CAL_BITS / 8U] = {0};
+    uint8_t data_out[FREQ_CAL_BITS / 8U];
+    jtag_proc.jtagtap_tdi_tdo_seq(data_out, false, data_in, FREQ_CAL_BITS);
+}
+
+static uint32_t platform_freq_measure(void (*clock)(void), uint32_t divider)
+{
+    uint32_t best = UINT32_MAX;
+    target_clk_divider = divider;
+
+    for (uint32_t round = 0; round < FREQ_CAL_ROUNDS; round++)
+    {
+        const uint32_t start = esp_cpu_get_cycle_count();
+        clock();
+        const uint32_t cycles = esp_cpu_get_cycle_count() - start;
+        if (cycles < best)
+            best = cycles;
+    }
+
+    return (best << FREQ_FRAC_SHIFT) / FREQ_CAL_BITS;
+}
+
+static void platform_freq_calibrate_tap(FreqModel *model, void (*clock)(void))
+{
+    vTaskSuspendAll();
+    model->fast = platform_freq_measure(clock, UINT32_MAX);
+    model->base = platform_freq_measure(clock, 0);
+    const uint32_t slow = platform_freq_measure(clock, FREQ_CAL_DIVIDER);
+    xTaskResumeAll();
+    model->step = slow > model->base ? (slow - model->base) / FREQ_CAL_DIVIDER : 1U;
+    model->valid = true;
+}
+
+static uint32_t platform_freq_from_divider(const FreqModel *model, uint32_t divider)
+{
+    const uint64_t cpu_hz = (uint64_t)esp_clk_cpu_freq() << FREQ_FRAC_SHIFT;
+    const uint64_t cycles = divider == UINT32_MAX ? model->fast : model->base + (uint64_t)divider * model->step;
+    return cycles ? (uint32_t)(cpu_hz / cycles) : 0;
+}
+
+/* Slowest divider that does not exceed the requested frequency */
+static uint32_t platform_freq_to_divider(const FreqModel *model, uint32_t freq)
+{
+    if (!model->valid || freq == 0)
+        return UINT32_MAX;
+
+    const uint64_t cpu_hz = (uint64_t)esp_clk_cpu_freq() << FREQ_FRAC_SHIFT;
+    const uint64_t cycles = cpu_hz / freq;
+    if (cycles <= model->fast)
+        return UINT32_MAX;
+    if (cycles <= model->base)
+        return 0;
+
+    const uint64_t divider = (cycles - model->base + model->step - 1U) / model->step;
+    return divider >= UINT32_MAX ? UINT32_MAX - 1U : (uint32_t)divider;
+}
+
+static uint32_t platform_freq_target(void)
+{
+    return platform_freq.use_tuned ? platform_freq.tuned : platform_freq.requested;
+}
+
+static void platform_freq_apply_model(const FreqModel *model)
+{
+    target_clk_divider = platform_freq_to_divider(model, platform_freq_target());
+    swd_delay_cnt = target_clk_divider;
+    platform_freq.actual = platform_freq_from_divider(model, target_clk_divider);
+}
+
+void platform_freq_calibrate(void)
+{
+    const swd_tap_e selected = swd_tap_get_selected();
+    static const swd_tap_e bitbang_taps[] = {SWD_TAP_BITBANG, SWD_TAP_DEDIC};
+
+    for (size_t i = 0; i < sizeof(bitbang_taps) / sizeof(bitbang_taps[0]); i++)
+    {
+        const swd_tap_e tap = bitbang_taps[i];
+        swd_tap_set(tap);
+        swdptap_init();
+        if (swd_tap_get() != tap)
+            continue;
+
+        platform_freq_calibrate_tap(&platform_freq.swd[tap], platform_freq_clock_swd);
+
+        const FreqModel *model = &platform_freq.swd[tap];
+        ESP_LOGI(TAG, "%s: max %lu Hz, divider 0: %lu Hz, %lu.%02lu cycles per count",
+                 swd_tap_name(tap),
+                 platform_freq_from_divider(model, UINT32_MAX),
+                 platform_freq_from_divider(model, 0),
+                 model->step >> FREQ_FRAC_SHIFT,
+                 ((model->step & 0xffU) * 100U) >> FREQ_FRAC_SHIFT);
+    }
+
+    /* Time the bit-bang kernels on released pads, jtagtap_init() would switch the target to JTAG */
+    if (jtag_tap_calibration_init())
+    {
+        platform_freq_calibrate_tap(&platform_freq.jtag, platform_freq_clock_jtag);
+        ESP_LOGI(TAG, "jtag: max %lu Hz, divider 0: %lu Hz",
+                 platform_freq_from_divider(&platform_freq.jtag, UINT32_MAX),
+                 platform_freq_from_divider(&platform_freq.jtag, 0));
+    }
+
+    swd_tap_set(selected);
+    swdptap_init();
+}
+
+void platform_freq_apply_swd(swd_tap_e tap)
+{
+    platform_freq.interface = FREQ_IFACE_SWD;
+    platform_freq.swd_tap = tap;
+
+    if (tap == SWD_TAP_SPI)
+    {
+        platform_freq.actual = swd_spi_tap_set_frequency(platform_freq_target());
+        return;
+    }
+
+    platform_freq_apply_model(&platform_freq.swd[tap]);
+}
+
+void platform_freq_apply_jtag(void)
+{
+    platform_freq.interface = FREQ_IFACE_JTAG;
+    platform_freq_apply_model(&platform_freq.jtag);
+    /* The reported frequency is the bit-bang one, SPI shifts run at up to the requested clock */
+    jtag_spi_tap_set_frequency(platform_freq_target());
+}
+
+uint32_t platform_freq_get_requested(void)
+{
+    return platform_freq.requested;
+}
+
+static void platform_freq_apply(void)
+{
+    if (platform_freq.interface == FREQ_IFACE_JTAG)
+        platform_freq_apply_jtag();
+    else
+        platform_freq_apply_swd(platform_freq.swd_tap);
+}
+
+void platform_freq_set_tuned(uint32_t freq)
+{
+    platform_freq.tuned = freq;
+    platform_freq.use_tuned = true;
+    platform_freq_apply();
+}
+
+void platform_freq_clear_tuned(void)
+{
+    if (!platform_freq.use_tuned)
+        return;
+    platform_freq.use_tuned = false;
+    platform_freq_apply();
+}
+
+void platform_freq_selftest(void)
+{
+    /* Interrupts and other tasks stay enabled, Wi-Fi and cache refills show up as stalls */
+    uint32_t best = UINT32_MAX;
+    uint32_t worst = 0;
+
+    for (uint32_t round = 0; round < FREQ_SELFTEST_ROUNDS; round++)
+    {
+        if (round % FREQ_SELFTEST_YIELD == 0)
+            vTaskDelay(1);
+
+        const uint32_t start = esp_cpu_get_cycle_count();
+        platform_freq_clock_swd();
+        const uint32_t cycles = esp_cpu_get_cycle_count() - start;
+        if (cycles < best)
+            best = cycles;
+        if (cycles > worst)
+            worst = cycles;
+    }
+
+#ifdef CONFIG_BMP_IRAM_HOT_PATH
+    const char *placement = "IRAM";
+#else
+    const char *placement = "flash";
+#endif
+    const uint32_t cpu_mhz = esp_clk_cpu_freq() / 1000000U;
+    ESP_LOGI(TAG, "%s tap at %lu Hz, hot path in %s: %lu..%lu cycles per %u bits, worst stall %lu ns",
+             swd_tap_name(swd_tap_get()), platform_freq.actual, placement, best, worst, FREQ_CAL_BITS,
+             (worst - best) * 1000U / cpu_mhz);
+}
+
+// set interface freq
+void platform_max_frequency_set(uint32_t freq)
+{
+    platform_freq.requested = freq;
+    platform_freq.use_tuned = false;
+    platform_freq_apply();
+
+    ESP_LOGI(TAG, "Interface frequency: requested %lu Hz, actual %lu Hz",
+             platform_freq.requested, platform_freq.actual);
+}
+
+// get interface freq
+uint32_t platform_max_frequency_get(void)
+{
+    return platform_freq.actual;
+}
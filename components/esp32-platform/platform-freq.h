@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "swd-tap.h"
+
+/**
+ * Measure SWCLK/TCK period per delay count for each bit-bang tap with the
+ * CPU cycle counter. Clocks 32 SWDIO-high bits per measurement.
+ */
+void platform_freq_calibrate(void);
+
+/**
+ * Log best and worst SWCLK burst timing of the active SWD tap with
+ * interrupts and Wi-Fi running, to compare hot path placements
+ */
+void platform_freq_selftest(void);
+
+/**
+ * Apply the requested frequency to a freshly initialised SWD tap
+ * @param tap active backend
+ */
+void platform_freq_apply_swd(swd_tap_e tap);
+
+/**
+ * Apply the requested frequency to the JTAG tap
+ */
+void platform_freq_apply_jtag(void);
+
+/**
+ * Run at a negotiated frequency without changing the requested one,
+ * until platform_freq_clear_tuned() or platform_max_frequency_set()
+ * @param freq frequency in Hz, 0 for the fastest setting
+ */
+void platform_freq_set_tuned(uint32_t freq);
+
+/**
+ * Return to the requested frequency
+ */
+void platform_freq_clear_tuned(void);
+
+/**
+ * Set interface frequency, Black Magic platform API
+ * @param freq requested frequency in Hz, 0 for the fastest setting
+ */
+void platform_max_frequency_set(uint32_t freq);
+
+/**
+ * Get actual interface frequency, Black Magic platform API
+ * @return uint32_t Hz
+ */
+uint32_t platform_max_frequency_get(void);
+
+/**
+ * Get requested interface frequency
+ * @return uint32_t Hz
+ */
+uint32_t platform_freq_get_requested(void);
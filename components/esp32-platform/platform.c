@@ -46,6 +46,20 @@ void platform_jtag_pins_init(void)
     if (TCK_PIN >= 0) esp_rom_gpio_connect_out_signal(TCK_PIN, SIG_GPIO_OUT_IDX, false, false);
 }
 
+// TMS/TDI/TCK back to inputs, GPIO writes no longer reach the target
+void platform_jtag_pins_release(void)
+{
+    uint32_t output_mask = 0;
+
+    if (TMS_PIN >= 0) output_mask |= (1U << TMS_PIN);
+    if (TDI_PIN >= 0) output_mask |= (1U << TDI_PIN);
+    if (TCK_PIN >= 0) output_mask |= (1U << TCK_PIN);
+
+    if (output_mask != 0) {
+        GPIO.enable_w1tc.val = output_mask;
+    }
+}
+
 void __attribute__((always_inline)) platform_swdio_mode_float(void)
 {
     gpio_ll_output_disable(&GPIO, SWDIO_PIN);
@@ -142,17 +156,6 @@ bool platform_timeout_is_expired(const platform_timeout_s *t)
     return platform_time_ms() > t->time;
 }
 
-// set interface freq
-void platform_max_frequency_set(uint32_t freq)
-{
-}
-
-// get interface freq
-uint32_t platform_max_frequency_get(void)
-{
-    return 0;
-}
-
 void platform_nrst_set_val(bool assert)
 {
     (void)assert;
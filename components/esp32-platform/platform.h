@@ -1,4 +1,5 @@
 #pragma once
+#include <sdkconfig.h>
 #include <timing.h>
 #include <stdbool.h>
 
@@ -7,6 +8,7 @@ extern uint32_t swd_delay_cnt;
 void platform_swdio_mode_float(void);
 void platform_swdio_mode_drive(void);
 void platform_jtag_pins_init(void);
+void platform_jtag_pins_release(void);
 void platform_gpio_set_level(int32_t gpio_num, uint32_t value);
 void platform_gpio_set(int32_t gpio_num);
 void platform_gpio_clear(int32_t gpio_num);
@@ -42,6 +44,9 @@ void led_set_blue(uint8_t value);
 
 #undef PLATFORM_HAS_TRACESWO
 
+/* Monitor commands in platform-cmds.c */
+#define PLATFORM_HAS_CUSTOM_COMMANDS
+
 /* Runtime-configurable pin numbers (set before first use, default values in platform.c) */
 extern int32_t g_pin_swdio;
 extern int32_t g_pin_swclk;
@@ -97,6 +102,11 @@ bool gdb_serial_get_dtr(void);
 void debug_serial_run(void);
 uint32_t debug_serial_fifo_send(const char *fifo, uint32_t fifo_begin, uint32_t fifo_end);
 
+#ifdef CONFIG_BMP_GDB_LARGE_PACKETS
+/* Advertised as qSupported PacketSize, also sizes the glue rx span */
+#define GDB_PACKET_BUFFER_SIZE ((unsigned)CONFIG_BMP_GDB_PACKET_SIZE)
+#endif
+
 /* RTT buffer sizes for ESP32 platform */
 #define RTT_UP_BUF_SIZE   (2048U + 8U)
 #define RTT_DOWN_BUF_SIZE 512U
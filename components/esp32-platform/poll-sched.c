@@ -0,0 +1,146 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_timer.h>
+#include "general.h"
+#include "gdb_if.h"
+#include "poll-sched.h"
+
+/*
+ * Poll scheduling for a running target. Between target polls the GDB
+ * thread blocks in gdb_if_getchar_to() on the rx stream, so socket input
+ * (^C) wakes it at once and the HP core is free for lwIP and Wi-Fi while
+ * it waits. Right after resume polls run back to back for the fast
+ * window, which catches breakpoints hit shortly after a step or continue.
+ * After that the wait starts at one tick and doubles on every quiet poll
+ * up to the limit. RTT data or GDB input drops it back to zero.
+ *
+ * Halt latency is measured as the time between the last poll that saw the
+ * target running and the one that saw it halted, the worst case for a
+ * halt in between. Waits are in FreeRTOS ticks, so with CONFIG_FREERTOS_HZ
+ * at 100 the shortest non-zero wait is 10 ms.
+ */
+
+typedef struct
+{
+    uint32_t fast_ms;
+    uint32_t max_ms;
+    uint32_t interval_ms;
+    bool event;
+    bool halt_requested;
+    int64_t resume_us;
+    int64_t poll_us;
+    PollSchedStats stats;
+} PollSched;
+
+static PollSched poll_sched = {
+    .fast_ms = CONFIG_BMP_POLL_FAST_MS,
+    .max_ms = CONFIG_BMP_POLL_MAX_MS,
+};
+
+void poll_sched_resume(void)
+{
+    poll_sched.resume_us = esp_timer_get_time();
+    poll_sched.poll_us = poll_sched.resume_us;
+    poll_sched.interval_ms = 0;
+    poll_sched.event = false;
+    poll_sched.halt_requested = false;
+}
+
+char poll_sched_wait(uint32_t timeout)
+{
+    const int64_t start = esp_timer_get_time();
+    const char c = gdb_if_getchar_to(timeout);
+    poll_sched.stats.wait_us += esp_timer_get_time() - start;
+    return c;
+}
+
+static uint32_t poll_sched_ticks(int64_t now)
+{
+    if (poll_sched.interval_ms == 0 || now - poll_sched.resume_us < (int64_t)poll_sched.fast_ms * 1000)
+        return 0;
+    const uint32_t ticks = pdMS_TO_TICKS(poll_sched.interval_ms);
+    return ticks ? ticks : 1U;
+}
+
+char poll_sched_getchar(void)
+{
+    /* Called right after gdb_poll_target() saw the target still running */
+    const int64_t now = esp_timer_get_time();
+    poll_sched.poll_us = now;
+    poll_sched.stats.polls++;
+
+    if (poll_sched.event)
+    {
+        poll_sched.event = false;
+        poll_sched.interval_ms = 0;
+    }
+
+    const char c = poll_sched_wait(poll_sched_ticks(now));
+    if (c != (char)-1)
+    {
+        poll_sched.interval_ms = 0;
+        if (c == '\x03' || c == '\x04')
+            poll_sched.halt_requested = true;
+    }
+    else if (poll_sched.interval_ms == 0)
+        poll_sched.interval_ms = 1;
+    else if (poll_sched.interval_ms < poll_sched.max_ms)
+        poll_sched.interval_ms = MIN(poll_sched.interval_ms * 2U, poll_sched.max_ms);
+    return c;
+}
+
+void poll_sched_event(void)
+{
+    poll_sched.event = true;
+}
+
+void poll_sched_halted(void)
+{
+    const int64_t now = esp_timer_get_time();
+    poll_sched.stats.running_us += now - poll_sched.resume_us;
+
+    if (poll_sched.halt_requested)
+    {
+        poll_sched.stats.halt_requests++;
+        return;
+    }
+
+    const uint32_t latency = (uint32_t)(now - poll_sched.poll_us);
+    poll_sched.stats.halts++;
+    poll_sched.stats.halt_latency_us += latency;
+    if (latency > poll_sched.stats.halt_latency_max_us)
+        poll_sched.stats.halt_latency_max_us = latency;
+}
+
+void poll_sched_set_fast(uint32_t ms)
+{
+    poll_sched.fast_ms = ms;
+}
+
+uint32_t poll_sched_get_fast(void)
+{
+    return poll_sched.fast_ms;
+}
+
+void poll_sched_set_max(uint32_t ms)
+{
+    poll_sched.max_ms = ms;
+}
+
+uint32_t poll_sched_get_max(void)
+{
+    return poll_sched.max_ms;
+}
+
+void poll_sched_get_stats(PollSchedStats *stats)
+{
+    *stats = poll_sched.stats;
+}
+
+void poll_sched_reset_stats(void)
+{
+    memset(&poll_sched.stats, 0, sizeof(poll_sched.stats));
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct
+{
+    uint64_t running_us;      /* time spent in the running-target loop */
+    uint64_t wait_us;         /* of that, blocked waiting for GDB input */
+    uint32_t polls;           /* target polls */
+    uint32_t halts;           /* halts found by polling */
+    uint32_t halt_requests;   /* halts after ^C from GDB */
+    uint64_t halt_latency_us; /* sum of worst-case detection latencies */
+    uint32_t halt_latency_max_us;
+} PollSchedStats;
+
+/**
+ * Start a running-target loop, polls run back to back for the fast window
+ */
+void poll_sched_resume(void);
+
+/**
+ * Wait for GDB input for the current poll interval, then back off if nothing happened
+ * @return char input byte, -1 on timeout
+ */
+char poll_sched_getchar(void);
+
+/**
+ * Wait for GDB input, counted as idle time
+ * @param timeout ticks
+ * @return char input byte, -1 on timeout
+ */
+char poll_sched_wait(uint32_t timeout);
+
+/**
+ * Something happened while the target runs (RTT data), poll again at once
+ */
+void poll_sched_event(void);
+
+/**
+ * The target stopped, record how long it may have been halted unnoticed
+ */
+void poll_sched_halted(void);
+
+/**
+ * Set the fast window after resume
+ * @param ms
+ */
+void poll_sched_set_fast(uint32_t ms);
+
+/**
+ * @return uint32_t fast window in ms
+ */
+uint32_t poll_sched_get_fast(void);
+
+/**
+ * Set the back-off limit
+ * @param ms
+ */
+void poll_sched_set_max(uint32_t ms);
+
+/**
+ * @return uint32_t back-off limit in ms
+ */
+uint32_t poll_sched_get_max(void);
+
+/**
+ * Get CPU and latency counters
+ * @param stats
+ */
+void poll_sched_get_stats(PollSchedStats *stats);
+
+/**
+ * Clear CPU and latency counters
+ */
+void poll_sched_reset_stats(void);
@@ -10,6 +10,7 @@
 #include "rtt.h"
 #include "rtt_if.h"
 #include "rtt_if_esp32.h"
+#include "poll-sched.h"
 
 #define RTT_RX_BUFFER_SIZE 512
 #define RTT_TX_BUFFER_SIZE 2048
@@ -159,6 +160,9 @@ uint32_t rtt_write(const uint32_t channel, const char *buf, uint32_t len)
 	if (buf == NULL || len == 0)
 		return 0;
 
+	/* More may follow, keep polling the target quickly */
+	poll_sched_event();
+
 	/* Send data over network if connected */
 	if (network_rtt_connected()) {
 		/* Buffer the data */
@@ -0,0 +1,216 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <esp_log.h>
+#include <driver/dedic_gpio.h>
+#include <hal/dedic_gpio_cpu_ll.h>
+#include <soc/gpio_struct.h>
+#include "general.h"
+#include "platform.h"
+#include "timing.h"
+#include "swd.h"
+#include "swd-tap.h"
+
+#define TAG "swd-dedic-tap"
+
+/*
+ * SWD tap on the dedicated GPIO bundle. SWCLK and SWDIO are CPU output
+ * channels, so an edge is a single CSR write instead of a store over the
+ * peripheral bus, and all masks are resolved once when the bundle is built.
+ * Timing and turnaround sequencing follow swdptap.c.
+ */
+
+typedef struct
+{
+    dedic_gpio_bundle_handle_t bundle;
+    uint32_t swclk_out;
+    uint32_t swdio_out;
+    uint32_t swdio_in_shift;
+    uint32_t swdio_oe;
+    bool drive;
+} SWDDedicTap;
+
+static SWDDedicTap swd_dedic;
+
+static uint32_t swd_dedic_seq_in(size_t clock_cycles) __attribute__((optimize(3)));
+static bool swd_dedic_seq_in_parity(uint32_t *ret, size_t clock_cycles) __attribute__((optimize(3)));
+static void swd_dedic_seq_out(uint32_t tms_states, size_t clock_cycles) __attribute__((optimize(3)));
+static void swd_dedic_seq_out_parity(uint32_t tms_states, size_t clock_cycles) __attribute__((optimize(3)));
+
+static inline __attribute__((always_inline)) uint32_t swd_dedic_parity(uint32_t value)
+{
+    value ^= value >> 16U;
+    value ^= value >> 8U;
+    value ^= value >> 4U;
+    return (0x6996U >> (value & 0xfU)) & 1U;
+}
+
+static inline __attribute__((always_inline)) void swd_dedic_delay(const uint32_t divider)
+{
+    for (volatile uint32_t counter = divider; counter > 0; --counter)
+        continue;
+}
+
+static inline __attribute__((always_inline)) uint32_t swd_dedic_swdio_get(void)
+{
+    return (dedic_gpio_cpu_ll_read_in() >> swd_dedic.swdio_in_shift) & 1U;
+}
+
+static void swd_dedic_turnaround(const bool drive)
+{
+    if (drive == swd_dedic.drive)
+        return;
+    swd_dedic.drive = drive;
+
+    if (!drive)
+        GPIO.enable_w1tc.val = swd_dedic.swdio_oe;
+    else
+        dedic_gpio_cpu_ll_write_mask(swd_dedic.swclk_out, 0);
+    swd_dedic_delay(target_clk_divider + 1U);
+    dedic_gpio_cpu_ll_write_mask(swd_dedic.swclk_out, swd_dedic.swclk_out);
+    swd_dedic_delay(target_clk_divider + 1U);
+    if (drive)
+    {
+        dedic_gpio_cpu_ll_write_mask(swd_dedic.swclk_out, 0);
+        GPIO.enable_w1ts.val = swd_dedic.swdio_oe;
+    }
+}
+
+/* Word kernels, specialised by the compiler for the delay and no-delay cases */
+static inline __attribute__((always_inline)) uint32_t
+swd_dedic_seq_in_word(size_t clock_cycles, const bool use_delay)
+{
+    const uint32_t clk = swd_dedic.swclk_out;
+    const uint32_t shift = swd_dedic.swdio_in_shift;
+    const uint32_t divider = target_clk_divider;
+    uint32_t value = 0;
+
+    for (size_t cycle = 0; cycle < clock_cycles; ++cycle)
+    {
+        dedic_gpio_cpu_ll_write_mask(clk, 0);
+        value |= ((dedic_gpio_cpu_ll_read_in() >> shift) & 1U) << cycle;
+        if (use_delay)
+            swd_dedic_delay(divider);
+        dedic_gpio_cpu_ll_write_mask(clk, clk);
+        if (use_delay)
+            swd_dedic_delay(divider);
+    }
+    dedic_gpio_cpu_ll_write_mask(clk, 0);
+    return value;
+}
+
+static inline __attribute__((always_inline)) void
+swd_dedic_seq_out_word(uint32_t value, size_t clock_cycles, const bool use_delay)
+{
+    const uint32_t clk = swd_dedic.swclk_out;
+    const uint32_t dio = swd_dedic.swdio_out;
+    const uint32_t both = clk | dio;
+    const uint32_t divider = target_clk_divider;
+
+    for (size_t cycle = 0; cycle < clock_cycles; ++cycle)
+    {
+        /* SWCLK low and next SWDIO level in the same write */
+        dedic_gpio_cpu_ll_write_mask(both, (0U - (value & 1U)) & dio);
+        if (use_delay)
+            swd_dedic_delay(divider);
+        dedic_gpio_cpu_ll_write_mask(clk, clk);
+        if (use_delay)
+            swd_dedic_delay(divider);
+        value >>= 1U;
+    }
+    dedic_gpio_cpu_ll_write_mask(clk, 0);
+}
+
+static uint32_t swd_dedic_seq_in(size_t clock_cycles)
+{
+    swd_dedic_turnaround(false);
+    if (target_clk_divider != UINT32_MAX)
+        return swd_dedic_seq_in_word(clock_cycles, true);
+    return swd_dedic_seq_in_word(clock_cycles, false);
+}
+
+static bool swd_dedic_seq_in_parity(uint32_t *ret, size_t clock_cycles)
+{
+    const uint32_t result = swd_dedic_seq_in(clock_cycles);
+    swd_dedic_delay(target_clk_divider + 1U);
+    const uint32_t bit = swd_dedic_swdio_get();
+    dedic_gpio_cpu_ll_write_mask(swd_dedic.swclk_out, swd_dedic.swclk_out);
+    swd_dedic_delay(target_clk_divider + 1U);
+    *ret = result;
+    /* Terminate the read cycle now */
+    swd_dedic_turnaround(true);
+    return swd_dedic_parity(result) != bit;
+}
+
+static void swd_dedic_seq_out(uint32_t tms_states, size_t clock_cycles)
+{
+    swd_dedic_turnaround(true);
+    if (target_clk_divider != UINT32_MAX)
+        swd_dedic_seq_out_word(tms_states, clock_cycles, true);
+    else
+        swd_dedic_seq_out_word(tms_states, clock_cycles, false);
+}
+
+static void swd_dedic_seq_out_parity(uint32_t tms_states, size_t clock_cycles)
+{
+    const uint32_t parity = swd_dedic_parity(tms_states);
+    swd_dedic_seq_out(tms_states, clock_cycles);
+    swd_dedic_seq_out_word(parity, 1, target_clk_divider != UINT32_MAX);
+}
+
+bool swd_dedic_tap_init(void)
+{
+    swd_dedic_tap_deinit();
+
+    int gpios[] = {SWCLK_PIN, SWDIO_PIN};
+    dedic_gpio_bundle_config_t config = {
+        .gpio_array = gpios,
+        .array_size = sizeof(gpios) / sizeof(gpios[0]),
+        .flags = {
+            .in_en = 1,
+            .out_en = 1,
+        },
+    };
+
+    esp_err_t err = dedic_gpio_new_bundle(&config, &swd_dedic.bundle);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Unable to create GPIO bundle: %s", esp_err_to_name(err));
+        swd_dedic.bundle = NULL;
+        return false;
+    }
+
+    uint32_t out_offset = 0;
+    uint32_t in_offset = 0;
+    dedic_gpio_get_out_offset(swd_dedic.bundle, &out_offset);
+    dedic_gpio_get_in_offset(swd_dedic.bundle, &in_offset);
+
+    /* Bundle channels follow gpio_array order: SWCLK first, then SWDIO */
+    swd_dedic.swclk_out = 1U << out_offset;
+    swd_dedic.swdio_out = 1U << (out_offset + 1U);
+    swd_dedic.swdio_in_shift = in_offset + 1U;
+    swd_dedic.swdio_oe = 1U << SWDIO_PIN;
+
+    /* Same idle state as swdptap.c: SWCLK low, SWDIO released */
+    dedic_gpio_cpu_ll_write_mask(swd_dedic.swclk_out | swd_dedic.swdio_out, 0);
+    GPIO.enable_w1tc.val = swd_dedic.swdio_oe;
+    swd_dedic.drive = false;
+
+    swd_proc.seq_in = swd_dedic_seq_in;
+    swd_proc.seq_in_parity = swd_dedic_seq_in_parity;
+    swd_proc.seq_out = swd_dedic_seq_out;
+    swd_proc.seq_out_parity = swd_dedic_seq_out_parity;
+
+    ESP_LOGI(TAG, "SWCLK=%ld SWDIO=%ld on dedicated channels out:%lu in:%lu",
+             (long)SWCLK_PIN, (long)SWDIO_PIN, out_offset, in_offset);
+    return true;
+}
+
+void swd_dedic_tap_deinit(void)
+{
+    if (swd_dedic.bundle != NULL)
+    {
+        dedic_gpio_del_bundle(swd_dedic.bundle);
+        swd_dedic.bundle = NULL;
+    }
+}
@@ -0,0 +1,258 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_attr.h>
+#include <driver/spi_master.h>
+#include "general.h"
+#include "platform.h"
+#include "swd.h"
+#include "swd-tap.h"
+
+#define TAG "swd-spi-tap"
+#define SWD_SPI_HOST SPI2_HOST
+#define SWD_SPI_MAX_BITS 64U
+#define SWD_SPI_MAX_FREQ 40000000U
+
+/*
+ * SWD tap on the GP-SPI peripheral in 3-wire half-duplex mode: SWCLK is SCLK
+ * and SWDIO is the bidirectional MOSI line. A request byte is held back and
+ * sent together with the turnaround (one dummy clock) and the ACK read, so
+ * the request/ACK phase is a single transaction. Data phases are one
+ * transaction each; the target-to-host turnaround is a dummy-only transaction.
+ */
+
+typedef struct
+{
+    spi_device_handle_t device;
+    bool bus_ready;
+    bool drive;
+    uint32_t request;
+    bool request_pending;
+    uint32_t frequency;
+} SWDSPITap;
+
+static SWDSPITap swd_spi = {
+    .frequency = CONFIG_BMP_INTERFACE_FREQ_KHZ * 1000U,
+};
+
+static WORD_ALIGNED_ATTR DMA_ATTR uint8_t swd_spi_tx[SWD_SPI_MAX_BITS / 8U];
+static WORD_ALIGNED_ATTR DMA_ATTR uint8_t swd_spi_rx[SWD_SPI_MAX_BITS / 8U];
+
+static inline uint32_t swd_spi_parity(uint32_t value)
+{
+    value ^= value >> 16U;
+    value ^= value >> 8U;
+    value ^= value >> 4U;
+    return (0x6996U >> (value & 0xfU)) & 1U;
+}
+
+/* Start, stop, park and parity bits of an ADIv5 packet request */
+static inline bool swd_spi_is_request(uint32_t value, size_t clock_cycles)
+{
+    if (clock_cycles != 8U || (value & 0xc1U) != 0x81U)
+        return false;
+    return swd_spi_parity(value & 0x1eU) == ((value >> 5U) & 1U);
+}
+
+/* One SPI transaction: out bits, then dummy clocks, then in bits */
+static uint64_t swd_spi_transfer(uint64_t out, size_t out_bits, size_t dummy_bits, size_t in_bits)
+{
+    spi_transaction_ext_t transaction = {
+        .base = {
+            .flags = SPI_TRANS_VARIABLE_DUMMY,
+            .length = out_bits,
+            .rxlength = in_bits,
+            .tx_buffer = out_bits ? swd_spi_tx : NULL,
+            .rx_buffer = in_bits ? swd_spi_rx : NULL,
+        },
+        .dummy_bits = dummy_bits,
+    };
+
+    memcpy(swd_spi_tx, &out, sizeof(swd_spi_tx));
+    esp_err_t err = spi_device_polling_transmit(swd_spi.device, &transaction.base);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Transfer failed: %s", esp_err_to_name(err));
+        return 0;
+    }
+
+    uint64_t in = 0;
+    if (in_bits)
+    {
+        memcpy(&in, swd_spi_rx, sizeof(swd_spi_rx));
+        if (in_bits < 64U)
+            in &= (UINT64_C(1) << in_bits) - 1U;
+    }
+    return in;
+}
+
+static void swd_spi_flush(void)
+{
+    if (swd_spi.request_pending)
+    {
+        swd_spi.request_pending = false;
+        swd_spi_transfer(swd_spi.request, 8U, 0, 0);
+    }
+}
+
+/* Target to host turnaround, host to target is merged into swd_spi_read() */
+static void swd_spi_turnaround_drive(void)
+{
+    if (swd_spi.drive)
+        return;
+    swd_spi.drive = true;
+    swd_spi_transfer(0, 0, 1U, 0);
+}
+
+static uint64_t swd_spi_read(size_t clock_cycles)
+{
+    if (swd_spi.drive)
+    {
+        swd_spi.drive = false;
+        const bool with_request = swd_spi.request_pending;
+        swd_spi.request_pending = false;
+        return swd_spi_transfer(swd_spi.request, with_request ? 8U : 0, 1U, clock_cycles);
+    }
+    return swd_spi_transfer(0, 0, 0, clock_cycles);
+}
+
+static uint32_t swd_spi_seq_in(size_t clock_cycles)
+{
+    return (uint32_t)swd_spi_read(clock_cycles);
+}
+
+static bool swd_spi_seq_in_parity(uint32_t *ret, size_t clock_cycles)
+{
+    const uint64_t value = swd_spi_read(clock_cycles + 1U);
+    *ret = (uint32_t)value;
+    /* Terminate the read cycle now */
+    swd_spi_turnaround_drive();
+    return swd_spi_parity(*ret) != (uint32_t)((value >> clock_cycles) & 1U);
+}
+
+static void swd_spi_seq_out(uint32_t tms_states, size_t clock_cycles)
+{
+    swd_spi_flush();
+    swd_spi_turnaround_drive();
+    if (swd_spi_is_request(tms_states, clock_cycles))
+    {
+        swd_spi.request = tms_states;
+        swd_spi.request_pending = true;
+        return;
+    }
+    swd_spi_transfer(tms_states, clock_cycles, 0, 0);
+}
+
+static void swd_spi_seq_out_parity(uint32_t tms_states, size_t clock_cycles)
+{
+    swd_spi_flush();
+    swd_spi_turnaround_drive();
+    const uint64_t value = (uint64_t)tms_states | ((uint64_t)swd_spi_parity(tms_states) << clock_cycles);
+    swd_spi_transfer(value, clock_cycles + 1U, 0, 0);
+}
+
+static esp_err_t swd_spi_add_device(void)
+{
+    spi_device_interface_config_t device = {
+        .mode = 0,
+        .clock_speed_hz = swd_spi.frequency,
+        .spics_io_num = -1,
+        .queue_size = 1,
+        .flags = SPI_DEVICE_3WIRE | SPI_DEVICE_HALFDUPLEX | SPI_DEVICE_BIT_LSBFIRST,
+    };
+
+    esp_err_t err = spi_bus_add_device(SWD_SPI_HOST, &device, &swd_spi.device);
+    if (err != ESP_OK)
+    {
+        swd_spi.device = NULL;
+        return err;
+    }
+
+    /* Keep the bus for back-to-back polling transactions */
+    return spi_device_acquire_bus(swd_spi.device, portMAX_DELAY);
+}
+
+static void swd_spi_remove_device(void)
+{
+    if (swd_spi.device != NULL)
+    {
+        spi_device_release_bus(swd_spi.device);
+        spi_bus_remove_device(swd_spi.device);
+        swd_spi.device = NULL;
+    }
+}
+
+bool swd_spi_tap_init(void)
+{
+    swd_spi_tap_deinit();
+
+    spi_bus_config_t bus = {
+        .mosi_io_num = SWDIO_PIN,
+        .miso_io_num = -1,
+        .sclk_io_num = SWCLK_PIN,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = SWD_SPI_MAX_BITS / 8U,
+    };
+
+    esp_err_t err = spi_bus_initialize(SWD_SPI_HOST, &bus, SPI_DMA_CH_AUTO);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Unable to init SPI bus: %s", esp_err_to_name(err));
+        return false;
+    }
+    swd_spi.bus_ready = true;
+
+    err = swd_spi_add_device();
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Unable to add SPI device: %s", esp_err_to_name(err));
+        swd_spi_tap_deinit();
+        return false;
+    }
+
+    swd_spi.drive = false;
+    swd_spi.request_pending = false;
+
+    swd_proc.seq_in = swd_spi_seq_in;
+    swd_proc.seq_in_parity = swd_spi_seq_in_parity;
+    swd_proc.seq_out = swd_spi_seq_out;
+    swd_proc.seq_out_parity = swd_spi_seq_out_parity;
+
+    ESP_LOGI(TAG, "SWCLK=%ld SWDIO=%ld at %lu Hz", (long)SWCLK_PIN, (long)SWDIO_PIN, swd_spi.frequency);
+    return true;
+}
+
+void swd_spi_tap_deinit(void)
+{
+    swd_spi_remove_device();
+
+    if (swd_spi.bus_ready)
+    {
+        spi_bus_free(SWD_SPI_HOST);
+        swd_spi.bus_ready = false;
+    }
+}
+
+uint32_t swd_spi_tap_set_frequency(uint32_t freq)
+{
+    if (freq == 0 || freq > SWD_SPI_MAX_FREQ)
+        freq = SWD_SPI_MAX_FREQ;
+
+    if (freq != swd_spi.frequency && swd_spi.device != NULL)
+    {
+        swd_spi.frequency = freq;
+        swd_spi_remove_device();
+        esp_err_t err = swd_spi_add_device();
+        if (err != ESP_OK)
+            ESP_LOGE(TAG, "Unable to re-add SPI device: %s", esp_err_to_name(err));
+    }
+    swd_spi.frequency = freq;
+
+    int freq_khz = 0;
+    if (swd_spi.device != NULL && spi_device_get_actual_freq(swd_spi.device, &freq_khz) == ESP_OK)
+        return (uint32_t)freq_khz * 1000U;
+    return swd_spi.frequency;
+}
@@ -0,0 +1,123 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <esp_log.h>
+#include "general.h"
+#include "platform.h"
+#include "swd.h"
+#include "swd-tap.h"
+#include "jtag-tap.h"
+#include "platform-freq.h"
+#include "tap-stats.h"
+
+#define TAG "swd-tap"
+
+/*
+ * swdptap_init() is linked with --wrap (see CMakeLists.txt), so every SWD
+ * scan first installs the stock swdptap.c procs and then lets the selected
+ * backend replace them.
+ */
+
+#if defined(CONFIG_BMP_SWD_TAP_DEDIC)
+#define SWD_TAP_DEFAULT SWD_TAP_DEDIC
+#elif defined(CONFIG_BMP_SWD_TAP_SPI)
+#define SWD_TAP_DEFAULT SWD_TAP_SPI
+#else
+#define SWD_TAP_DEFAULT SWD_TAP_BITBANG
+#endif
+
+static swd_tap_e swd_tap_selected = SWD_TAP_DEFAULT;
+static swd_tap_e swd_tap_active = SWD_TAP_BITBANG;
+static bool swd_tap_owned = false;
+
+static const char *const swd_tap_names[SWD_TAP_COUNT] = {
+    [SWD_TAP_BITBANG] = "bitbang",
+    [SWD_TAP_DEDIC] = "dedic",
+    [SWD_TAP_SPI] = "spi",
+};
+
+void __real_swdptap_init(void);
+
+void __wrap_swdptap_init(void)
+{
+    __real_swdptap_init();
+
+    /* Backends re-route the pads, so always start from a released state */
+    swd_dedic_tap_deinit();
+    swd_spi_tap_deinit();
+    jtag_spi_tap_deinit();
+
+    swd_tap_active = SWD_TAP_BITBANG;
+    switch (swd_tap_selected)
+    {
+    case SWD_TAP_DEDIC:
+        if (swd_dedic_tap_init())
+            swd_tap_active = SWD_TAP_DEDIC;
+        else
+            ESP_LOGW(TAG, "Dedicated GPIO tap unavailable, using bitbang");
+        break;
+    case SWD_TAP_SPI:
+        if (swd_spi_tap_init())
+            swd_tap_active = SWD_TAP_SPI;
+        else
+            ESP_LOGW(TAG, "SPI tap unavailable, using bitbang");
+        break;
+    default:
+        break;
+    }
+
+    /* Take the pads back for swdptap.c, scans start by driving */
+    if (swd_tap_active == SWD_TAP_BITBANG)
+        platform_swdio_mode_drive();
+
+    platform_freq_apply_swd(swd_tap_active);
+    tap_stats_install_swd();
+    swd_tap_owned = true;
+}
+
+void swd_tap_release(void)
+{
+    swd_dedic_tap_deinit();
+    swd_spi_tap_deinit();
+    swd_tap_owned = false;
+}
+
+bool swd_tap_in_use(void)
+{
+    return swd_tap_owned;
+}
+
+void swd_tap_set(swd_tap_e tap)
+{
+    if (tap < SWD_TAP_COUNT)
+        swd_tap_selected = tap;
+}
+
+swd_tap_e swd_tap_get(void)
+{
+    return swd_tap_active;
+}
+
+swd_tap_e swd_tap_get_selected(void)
+{
+    return swd_tap_selected;
+}
+
+const char *swd_tap_name(swd_tap_e tap)
+{
+    return tap < SWD_TAP_COUNT ? swd_tap_names[tap] : "unknown";
+}
+
+bool swd_tap_from_name(const char *name, swd_tap_e *tap)
+{
+    for (size_t i = 0; i < SWD_TAP_COUNT; i++)
+    {
+        if (strcmp(name, swd_tap_names[i]) == 0)
+        {
+            *tap = (swd_tap_e)i;
+            return true;
+        }
+    }
+    return false;
+}
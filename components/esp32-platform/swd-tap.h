@@ -0,0 +1,85 @@
+#pragma once
+#include <stdbool.h>
+
+/**
+ * SWD tap backends that can drive the SWCLK/SWDIO lines
+ */
+typedef enum
+{
+    SWD_TAP_BITBANG, /* Black Magic swdptap.c over the GPIO matrix */
+    SWD_TAP_DEDIC,   /* Dedicated GPIO bundle (CPU registers) */
+    SWD_TAP_SPI,     /* GP-SPI peripheral, 3-wire half-duplex */
+    SWD_TAP_COUNT,
+} swd_tap_e;
+
+/**
+ * Select SWD tap backend, applied on next swdptap_init()
+ * @param tap backend
+ */
+void swd_tap_set(swd_tap_e tap);
+
+/**
+ * Get active SWD tap backend
+ * @return swd_tap_e
+ */
+swd_tap_e swd_tap_get(void);
+
+/**
+ * Get backend selected for the next swdptap_init()
+ * @return swd_tap_e
+ */
+swd_tap_e swd_tap_get_selected(void);
+
+/**
+ * Release SWCLK/SWDIO from the active backend, until the next swdptap_init()
+ */
+void swd_tap_release(void);
+
+/**
+ * @return bool true if SWD owns the pins, false after release or jtagtap_init()
+ */
+bool swd_tap_in_use(void);
+
+/**
+ * Get SWD tap backend name
+ * @param tap backend
+ * @return const char*
+ */
+const char *swd_tap_name(swd_tap_e tap);
+
+/**
+ * Find SWD tap backend by name
+ * @param name backend name
+ * @param tap found backend
+ * @return true if found
+ */
+bool swd_tap_from_name(const char *name, swd_tap_e *tap);
+
+/**
+ * Claim SWCLK/SWDIO for the dedicated GPIO bundle and install its swd_proc
+ * @return true on success
+ */
+bool swd_dedic_tap_init(void);
+
+/**
+ * Release the dedicated GPIO bundle
+ */
+void swd_dedic_tap_deinit(void);
+
+/**
+ * Claim SWCLK/SWDIO for the GP-SPI peripheral and install its swd_proc
+ * @return true on success
+ */
+bool swd_spi_tap_init(void);
+
+/**
+ * Release the GP-SPI peripheral
+ */
+void swd_spi_tap_deinit(void);
+
+/**
+ * Set SPI tap SWCLK frequency, re-adds the device if the tap is active
+ * @param freq requested frequency in Hz
+ * @return uint32_t actual frequency in Hz
+ */
+uint32_t swd_spi_tap_set_frequency(uint32_t freq);
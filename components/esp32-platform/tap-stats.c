@@ -0,0 +1,195 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <esp_cpu.h>
+#include <esp_timer.h>
+#include <esp_private/esp_clk.h>
+#include "general.h"
+#include "platform.h"
+#include "swd.h"
+#include "jtagtap.h"
+#include "tap-stats.h"
+
+/*
+ * Counting shims around the installed swd_proc/jtag_proc. They sit on top of
+ * whichever backend the last swdptap_init()/jtagtap_init() left in place, so
+ * tap and ADI changes can be compared on the same operation by bits clocked,
+ * line turnarounds and time spent clocking versus wall time.
+ */
+
+typedef struct
+{
+    bool enabled;
+    bool swdio_in;
+    swd_proc_s swd;
+    jtag_proc_s jtag;
+    TapStats stats;
+    int64_t window_start;
+} TapStatsState;
+
+static TapStatsState tap_stats = {
+#ifdef CONFIG_BMP_TAP_STATS
+    .enabled = true,
+#endif
+};
+
+static inline void tap_stats_swd_direction(bool in, size_t bits)
+{
+    if (in != tap_stats.swdio_in)
+    {
+        tap_stats.swdio_in = in;
+        tap_stats.stats.swd_turnarounds++;
+    }
+    if (in)
+        tap_stats.stats.swd_bits_in += bits;
+    else
+        tap_stats.stats.swd_bits_out += bits;
+    tap_stats.stats.swd_calls++;
+}
+
+static uint32_t tap_stats_seq_in(size_t clock_cycles)
+{
+    tap_stats_swd_direction(true, clock_cycles);
+    const uint32_t start = esp_cpu_get_cycle_count();
+    const uint32_t result = tap_stats.swd.seq_in(clock_cycles);
+    tap_stats.stats.tap_cycles += esp_cpu_get_cycle_count() - start;
+    return result;
+}
+
+static bool tap_stats_seq_in_parity(uint32_t *ret, size_t clock_cycles)
+{
+    tap_stats_swd_direction(true, clock_cycles + 1U);
+    const uint32_t start = esp_cpu_get_cycle_count();
+    const bool result = tap_stats.swd.seq_in_parity(ret, clock_cycles);
+    tap_stats.stats.tap_cycles += esp_cpu_get_cycle_count() - start;
+    /* Backends terminate the read cycle and drive again */
+    tap_stats.swdio_in = false;
+    tap_stats.stats.swd_turnarounds++;
+    return result;
+}
+
+static void tap_stats_seq_out(uint32_t tms_states, size_t clock_cycles)
+{
+    tap_stats_swd_direction(false, clock_cycles);
+    const uint32_t start = esp_cpu_get_cycle_count();
+    tap_stats.swd.seq_out(tms_states, clock_cycles);
+    tap_stats.stats.tap_cycles += esp_cpu_get_cycle_count() - start;
+}
+
+static void tap_stats_seq_out_parity(uint32_t tms_states, size_t clock_cycles)
+{
+    tap_stats_swd_direction(false, clock_cycles + 1U);
+    const uint32_t start = esp_cpu_get_cycle_count();
+    tap_stats.swd.seq_out_parity(tms_states, clock_cycles);
+    tap_stats.stats.tap_cycles += esp_cpu_get_cycle_count() - start;
+}
+
+static inline void tap_stats_jtag_count(size_t bits)
+{
+    tap_stats.stats.jtag_bits += bits;
+    tap_stats.stats.jtag_calls++;
+}
+
+static void tap_stats_jtag_reset(void)
+{
+    tap_stats_jtag_count(0);
+    const uint32_t start = esp_cpu_get_cycle_count();
+    tap_stats.jtag.jtagtap_reset();
+    tap_stats.stats.tap_cycles += esp_cpu_get_cycle_count() - start;
+}
+
+static bool tap_stats_jtag_next(bool tms, bool tdi)
+{
+    tap_stats_jtag_count(1U);
+    const uint32_t start = esp_cpu_get_cycle_count();
+    const bool result = tap_stats.jtag.jtagtap_next(tms, tdi);
+    tap_stats.stats.tap_cycles += esp_cpu_get_cycle_count() - start;
+    return result;
+}
+
+static void tap_stats_jtag_tms_seq(uint32_t tms_states, size_t clock_cycles)
+{
+    tap_stats_jtag_count(clock_cycles);
+    const uint32_t start = esp_cpu_get_cycle_count();
+    tap_stats.jtag.jtagtap_tms_seq(tms_states, clock_cycles);
+    tap_stats.stats.tap_cycles += esp_cpu_get_cycle_count() - start;
+}
+
+static void tap_stats_jtag_tdi_tdo_seq(uint8_t *data_out, bool final_tms, const uint8_t *data_in, size_t clock_cycles)
+{
+    tap_stats_jtag_count(clock_cycles);
+    const uint32_t start = esp_cpu_get_cycle_count();
+    tap_stats.jtag.jtagtap_tdi_tdo_seq(data_out, final_tms, data_in, clock_cycles);
+    tap_stats.stats.tap_cycles += esp_cpu_get_cycle_count() - start;
+}
+
+static void tap_stats_jtag_tdi_seq(bool final_tms, const uint8_t *data_in, size_t clock_cycles)
+{
+    tap_stats_jtag_count(clock_cycles);
+    const uint32_t start = esp_cpu_get_cycle_count();
+    tap_stats.jtag.jtagtap_tdi_seq(final_tms, data_in, clock_cycles);
+    tap_stats.stats.tap_cycles += esp_cpu_get_cycle_count() - start;
+}
+
+static void tap_stats_jtag_cycle(bool tms, bool tdi, size_t clock_cycles)
+{
+    tap_stats_jtag_count(clock_cycles);
+    const uint32_t start = esp_cpu_get_cycle_count();
+    tap_stats.jtag.jtagtap_cycle(tms, tdi, clock_cycles);
+    tap_stats.stats.tap_cycles += esp_cpu_get_cycle_count() - start;
+}
+
+void tap_stats_install_swd(void)
+{
+    if (!tap_stats.enabled || swd_proc.seq_in == tap_stats_seq_in)
+        return;
+
+    tap_stats.swd = swd_proc;
+    tap_stats.swdio_in = false;
+    swd_proc.seq_in = tap_stats_seq_in;
+    swd_proc.seq_in_parity = tap_stats_seq_in_parity;
+    swd_proc.seq_out = tap_stats_seq_out;
+    swd_proc.seq_out_parity = tap_stats_seq_out_parity;
+}
+
+void tap_stats_install_jtag(void)
+{
+    if (!tap_stats.enabled || jtag_proc.jtagtap_next == tap_stats_jtag_next)
+        return;
+
+    tap_stats.jtag = jtag_proc;
+    jtag_proc.jtagtap_reset = tap_stats_jtag_reset;
+    jtag_proc.jtagtap_next = tap_stats_jtag_next;
+    jtag_proc.jtagtap_tms_seq = tap_stats_jtag_tms_seq;
+    jtag_proc.jtagtap_tdi_tdo_seq = tap_stats_jtag_tdi_tdo_seq;
+    jtag_proc.jtagtap_tdi_seq = tap_stats_jtag_tdi_seq;
+    jtag_proc.jtagtap_cycle = tap_stats_jtag_cycle;
+}
+
+void tap_stats_set_enabled(bool enable)
+{
+    tap_stats.enabled = enable;
+}
+
+bool tap_stats_enabled(void)
+{
+    return tap_stats.enabled;
+}
+
+void tap_stats_reset(void)
+{
+    memset(&tap_stats.stats, 0, sizeof(tap_stats.stats));
+    tap_stats.window_start = esp_timer_get_time();
+}
+
+void tap_stats_get(TapStats *stats)
+{
+    *stats = tap_stats.stats;
+    stats->window_us = esp_timer_get_time() - tap_stats.window_start;
+}
+
+uint64_t tap_stats_cycles_to_us(uint64_t cycles)
+{
+    return cycles / (esp_clk_cpu_freq() / 1000000U);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Tap counters since the last reset
+ */
+typedef struct
+{
+    uint64_t swd_bits_out;
+    uint64_t swd_bits_in;
+    uint32_t swd_turnarounds;
+    uint32_t swd_calls;
+    uint64_t jtag_bits;
+    uint32_t jtag_calls;
+    uint64_t tap_cycles; /* CPU cycles spent inside tap procs */
+    int64_t window_us;   /* wall time since the last reset */
+} TapStats;
+
+/**
+ * Enable or disable counting, applied on the next swdptap_init()/jtagtap_init()
+ * @param enable
+ */
+void tap_stats_set_enabled(bool enable);
+
+/**
+ * @return bool counting enabled
+ */
+bool tap_stats_enabled(void);
+
+/**
+ * Wrap the installed swd_proc with counting shims
+ */
+void tap_stats_install_swd(void);
+
+/**
+ * Wrap the installed jtag_proc with counting shims
+ */
+void tap_stats_install_jtag(void);
+
+/**
+ * Clear counters and start a new window
+ */
+void tap_stats_reset(void);
+
+/**
+ * Get counters
+ * @param stats
+ */
+void tap_stats_get(TapStats *stats);
+
+/**
+ * Convert CPU cycles to microseconds
+ * @param cycles
+ * @return uint64_t
+ */
+uint64_t tap_stats_cycles_to_us(uint64_t cycles);
@@ -0,0 +1,410 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <esp_cpu.h>
+#include "general.h"
+#include "target.h"
+#include "target_internal.h"
+#include "gdb_main.h"
+#include "target-cache.h"
+
+/*
+ * Halted-target cache for the GDB server. Memory is cached in aligned
+ * blocks filled with one target_mem32_read() each, registers as the whole
+ * 'g' block plus single 'p' values. Only reads answered in gdb-dispatch.c
+ * go through here, and the dispatcher drops everything before any packet
+ * that may resume, step, write or run a monitor command. While the target
+ * runs the cache is bypassed. Only blocks inside one of the target's RAM
+ * or flash regions are cached or prefetched, so peripherals and device
+ * memory of any architecture are read live. Volatile regions set by the
+ * user exclude further ranges, such as DMA buffers in RAM.
+ *
+ * Read-ahead: once a request starts where the previous one ended, the
+ * dispatcher calls target_cache_read_ahead() as soon as the reply is on the
+ * socket, before it waits for the ack. The missing blocks in the window
+ * after the last request are read with one auto-incrementing MEM-AP
+ * transfer while gdb is still receiving the reply, then split into cache
+ * blocks. Filling stops at the first block outside the memory map or
+ * volatile; if the long read fails, blocks are filled one by one up to the
+ * unreadable one.
+ */
+
+#define TARGET_CACHE_BLOCK_SIZE 256U
+#define TARGET_CACHE_REGS_MAX 1024U
+#define TARGET_CACHE_REG_ENTRIES 32U
+#define TARGET_CACHE_REG_SIZE 8U
+#define TARGET_CACHE_VOLATILE_MAX 8U
+/* Half the cache, plus the partly requested block the window starts in */
+#define TARGET_CACHE_AHEAD_BLOCKS (CONFIG_BMP_TARGET_CACHE_BLOCKS / 2U + 1U)
+
+typedef struct
+{
+    bool valid;
+    bool prefetched;
+    uint32_t addr;
+    uint32_t used;
+    uint8_t data[TARGET_CACHE_BLOCK_SIZE];
+} TargetCacheBlock;
+
+typedef struct
+{
+    bool valid;
+    uint32_t reg;
+    size_t size;
+    uint8_t value[TARGET_CACHE_REG_SIZE];
+} TargetCacheReg;
+
+typedef struct
+{
+    bool enabled;
+    target_s *target;
+    uint32_t tick;
+    TargetCacheBlock blocks[CONFIG_BMP_TARGET_CACHE_BLOCKS];
+    bool regs_valid;
+    size_t regs_size;
+    uint8_t regs[TARGET_CACHE_REGS_MAX];
+    TargetCacheReg reg[TARGET_CACHE_REG_ENTRIES];
+    size_t reg_next;
+    TargetCacheRegion volatile_regions[TARGET_CACHE_VOLATILE_MAX];
+    size_t volatile_count;
+    uint32_t read_ahead_window;
+    uint32_t read_ahead_next;
+    uint32_t read_ahead_streak;
+    uint8_t read_ahead_buffer[TARGET_CACHE_AHEAD_BLOCKS * TARGET_CACHE_BLOCK_SIZE];
+    TargetCacheStats stats;
+} TargetCache;
+
+static TargetCache target_cache = {
+#ifdef CONFIG_BMP_TARGET_CACHE
+    .enabled = true,
+#endif
+    .read_ahead_window = CONFIG_BMP_TARGET_READ_AHEAD,
+};
+
+void target_cache_invalidate(void)
+{
+    for (size_t i = 0; i < CONFIG_BMP_TARGET_CACHE_BLOCKS; i++)
+        target_cache.blocks[i].valid = false;
+    for (size_t i = 0; i < TARGET_CACHE_REG_ENTRIES; i++)
+        target_cache.reg[i].valid = false;
+    target_cache.regs_valid = false;
+    target_cache.read_ahead_streak = 0;
+}
+
+static bool target_cache_usable(target_s *target)
+{
+    if (!target_cache.enabled || gdb_target_running)
+        return false;
+    if (target != target_cache.target)
+    {
+        target_cache_invalidate();
+        target_cache.target = target;
+    }
+    return true;
+}
+
+bool target_cache_is_volatile(uint32_t addr, size_t len)
+{
+    const uint32_t last = addr + (uint32_t)len - 1U;
+    if (len == 0)
+        return false;
+    if (last < addr)
+        return true;
+    for (size_t i = 0; i < target_cache.volatile_count; i++)
+    {
+        const TargetCacheRegion *region = &target_cache.volatile_regions[i];
+        if (addr <= region->end && last >= region->start)
+            return true;
+    }
+    return false;
+}
+
+/* Inside a single RAM or flash region of the target and no volatile region */
+static bool target_cache_cacheable(target_s *target, uint32_t addr, size_t len)
+{
+    if (target_cache_is_volatile(addr, len))
+        return false;
+    const uint32_t last = addr + (uint32_t)len - 1U;
+    for (const target_ram_s *ram = target->ram; ram != NULL; ram = ram->next)
+    {
+        if (addr >= ram->start && last <= ram->start + (uint32_t)ram->length - 1U)
+            return true;
+    }
+    for (const target_flash_s *flash = target->flash; flash != NULL; flash = flash->next)
+    {
+        if (addr >= flash->start && last <= flash->start + (uint32_t)flash->length - 1U)
+            return true;
+    }
+    return false;
+}
+
+static TargetCacheBlock *target_cache_lookup(uint32_t base)
+{
+    for (size_t i = 0; i < CONFIG_BMP_TARGET_CACHE_BLOCKS; i++)
+    {
+        TargetCacheBlock *block = &target_cache.blocks[i];
+        if (block->valid && block->addr == base)
+        {
+            block->used = ++target_cache.tick;
+            return block;
+        }
+    }
+    return NULL;
+}
+
+static TargetCacheBlock *target_cache_victim(void)
+{
+    TargetCacheBlock *victim = &target_cache.blocks[0];
+    for (size_t i = 0; i < CONFIG_BMP_TARGET_CACHE_BLOCKS; i++)
+    {
+        TargetCacheBlock *block = &target_cache.blocks[i];
+        if (!block->valid)
+            return block;
+        if (block->used < victim->used)
+            victim = block;
+    }
+    return victim;
+}
+
+bool target_cache_fill(target_s *target, uint32_t base)
+{
+    if (!target_cache_usable(target) || !target_cache_cacheable(target, base, TARGET_CACHE_BLOCK_SIZE))
+        return false;
+    if (target_cache_lookup(base) != NULL)
+        return true;
+
+    TargetCacheBlock *block = target_cache_victim();
+    const uint32_t start = esp_cpu_get_cycle_count();
+    block->valid = false;
+    if (target_mem32_read(target, block->data, base, TARGET_CACHE_BLOCK_SIZE))
+        return false;
+
+    target_cache.stats.miss_cycles += esp_cpu_get_cycle_count() - start;
+    target_cache.stats.fills++;
+    block->valid = true;
+    block->prefetched = false;
+    block->addr = base;
+    block->used = ++target_cache.tick;
+    return true;
+}
+
+bool target_cache_mem_read(target_s *target, void *dest, uint32_t src, size_t len)
+{
+    if (!target_cache_usable(target))
+        return target_mem32_read(target, dest, src, len);
+
+    if (src == target_cache.read_ahead_next)
+        target_cache.read_ahead_streak++;
+    else
+        target_cache.read_ahead_streak = 0;
+    target_cache.read_ahead_next = src + (uint32_t)len;
+
+    uint8_t *out = dest;
+    while (len > 0)
+    {
+        const uint32_t base = src & ~(TARGET_CACHE_BLOCK_SIZE - 1U);
+        const size_t offset = src - base;
+        size_t chunk = TARGET_CACHE_BLOCK_SIZE - offset;
+        if (chunk > len)
+            chunk = len;
+
+        TargetCacheBlock *block = target_cache_lookup(base);
+        if (block != NULL)
+        {
+            target_cache.stats.mem_hits++;
+            if (block->prefetched)
+            {
+                target_cache.stats.read_ahead_hits++;
+                block->prefetched = false;
+            }
+        }
+        else if (target_cache_cacheable(target, base, TARGET_CACHE_BLOCK_SIZE))
+        {
+            target_cache.stats.mem_misses++;
+            if (target_cache_fill(target, base))
+                block = target_cache_lookup(base);
+        }
+
+        /* Outside the memory map, volatile, or not readable as a whole: read just what was asked */
+        if (block == NULL)
+        {
+            if (target_mem32_read(target, out, src, chunk))
+                return true;
+        }
+        else
+            memcpy(out, block->data + offset, chunk);
+
+        out += chunk;
+        src += chunk;
+        len -= chunk;
+    }
+    return false;
+}
+
+void target_cache_read_ahead(target_s *target)
+{
+    if (target_cache.read_ahead_streak == 0 || target_cache.read_ahead_window == 0 ||
+        !target_cache_usable(target))
+        return;
+
+    /* Keep at least half of the cache for what gdb already asked for */
+    uint32_t window = target_cache.read_ahead_window;
+    if (window > CONFIG_BMP_TARGET_CACHE_BLOCKS / 2U * TARGET_CACHE_BLOCK_SIZE)
+        window = CONFIG_BMP_TARGET_CACHE_BLOCKS / 2U * TARGET_CACHE_BLOCK_SIZE;
+
+    const uint32_t first = target_cache.read_ahead_next & ~(TARGET_CACHE_BLOCK_SIZE - 1U);
+    const uint32_t end = target_cache.read_ahead_next + window;
+    uint32_t base = first;
+    while (base < end && base >= first)
+    {
+        if (target_cache_lookup(base) != NULL)
+        {
+            base += TARGET_CACHE_BLOCK_SIZE;
+            continue;
+        }
+
+        /* Run of missing blocks up to the next cached or uncacheable one */
+        size_t count = 0;
+        for (uint32_t next = base; next < end && next >= first && count < TARGET_CACHE_AHEAD_BLOCKS;
+             next += TARGET_CACHE_BLOCK_SIZE, count++)
+        {
+            if (count > 0 && target_cache_lookup(next) != NULL)
+                break;
+            if (!target_cache_cacheable(target, next, TARGET_CACHE_BLOCK_SIZE))
+                break;
+        }
+        if (count == 0)
+            return;
+
+        const uint32_t start = esp_cpu_get_cycle_count();
+        if (target_mem32_read(target, target_cache.read_ahead_buffer, base, count * TARGET_CACHE_BLOCK_SIZE))
+        {
+            for (; count > 0 && target_cache_fill(target, base); count--, base += TARGET_CACHE_BLOCK_SIZE)
+            {
+                target_cache_lookup(base)->prefetched = true;
+                target_cache.stats.read_ahead_blocks++;
+            }
+            return;
+        }
+        target_cache.stats.miss_cycles += esp_cpu_get_cycle_count() - start;
+        target_cache.stats.fills += count;
+
+        for (size_t i = 0; i < count; i++, base += TARGET_CACHE_BLOCK_SIZE)
+        {
+            TargetCacheBlock *block = target_cache_victim();
+            memcpy(block->data, target_cache.read_ahead_buffer + i * TARGET_CACHE_BLOCK_SIZE, TARGET_CACHE_BLOCK_SIZE);
+            block->valid = true;
+            block->prefetched = true;
+            block->addr = base;
+            block->used = ++target_cache.tick;
+            target_cache.stats.read_ahead_blocks++;
+        }
+    }
+}
+
+void target_cache_set_read_ahead(uint32_t window)
+{
+    target_cache.read_ahead_window = window;
+}
+
+uint32_t target_cache_get_read_ahead(void)
+{
+    return target_cache.read_ahead_window;
+}
+
+bool target_cache_regs_read(target_s *target, void *data, size_t size)
+{
+    if (!target_cache_usable(target) || size > TARGET_CACHE_REGS_MAX)
+    {
+        target_regs_read(target, data);
+        return false;
+    }
+
+    if (target_cache.regs_valid && target_cache.regs_size == size)
+    {
+        target_cache.stats.reg_hits++;
+        memcpy(data, target_cache.regs, size);
+        return true;
+    }
+
+    target_cache.stats.reg_misses++;
+    target_regs_read(target, target_cache.regs);
+    target_cache.regs_size = size;
+    target_cache.regs_valid = true;
+    memcpy(data, target_cache.regs, size);
+    return false;
+}
+
+size_t target_cache_reg_read(target_s *target, uint32_t reg, void *data, size_t max)
+{
+    if (!target_cache_usable(target))
+        return target_reg_read(target, reg, data, max);
+
+    for (size_t i = 0; i < TARGET_CACHE_REG_ENTRIES; i++)
+    {
+        const TargetCacheReg *entry = &target_cache.reg[i];
+        if (entry->valid && entry->reg == reg && entry->size <= max)
+        {
+            target_cache.stats.reg_hits++;
+            memcpy(data, entry->value, entry->size);
+            return entry->size;
+        }
+    }
+
+    target_cache.stats.reg_misses++;
+    const size_t size = target_reg_read(target, reg, data, max);
+    if (size > 0 && size <= TARGET_CACHE_REG_SIZE)
+    {
+        TargetCacheReg *entry = &target_cache.reg[target_cache.reg_next];
+        target_cache.reg_next = (target_cache.reg_next + 1U) % TARGET_CACHE_REG_ENTRIES;
+        entry->reg = reg;
+        entry->size = size;
+        memcpy(entry->value, data, size);
+        entry->valid = true;
+    }
+    return size;
+}
+
+bool target_cache_add_volatile(uint32_t start, uint32_t end)
+{
+    if (end < start || target_cache.volatile_count == TARGET_CACHE_VOLATILE_MAX)
+        return false;
+    target_cache.volatile_regions[target_cache.volatile_count].start = start;
+    target_cache.volatile_regions[target_cache.volatile_count].end = end;
+    target_cache.volatile_count++;
+    target_cache_invalidate();
+    return true;
+}
+
+void target_cache_clear_volatile(void)
+{
+    target_cache.volatile_count = 0;
+}
+
+size_t target_cache_get_volatile(const TargetCacheRegion **regions)
+{
+    *regions = target_cache.volatile_regions;
+    return target_cache.volatile_count;
+}
+
+void target_cache_set_enabled(bool enable)
+{
+    target_cache.enabled = enable;
+    target_cache_invalidate();
+}
+
+bool target_cache_enabled(void)
+{
+    return target_cache.enabled;
+}
+
+void target_cache_get_stats(TargetCacheStats *stats)
+{
+    *stats = target_cache.stats;
+}
+
+void target_cache_reset_stats(void)
+{
+    memset(&target_cache.stats, 0, sizeof(target_cache.stats));
+}
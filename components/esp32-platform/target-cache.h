@@ -0,0 +1,132 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "target.h"
+
+typedef struct
+{
+    uint32_t start;
+    uint32_t end; /* inclusive */
+} TargetCacheRegion;
+
+typedef struct
+{
+    uint32_t mem_hits;          /* blocks served from the cache */
+    uint32_t mem_misses;        /* blocks read from the target */
+    uint32_t reg_hits;
+    uint32_t reg_misses;
+    uint32_t read_ahead_blocks; /* blocks filled ahead of a sequential read */
+    uint32_t read_ahead_hits;   /* of those, later used */
+    uint32_t fills;             /* successful block reads */
+    uint64_t miss_cycles;       /* CPU cycles spent in them */
+} TargetCacheStats;
+
+/**
+ * Drop all cached memory and registers
+ */
+void target_cache_invalidate(void);
+
+/**
+ * Read target memory through the block cache
+ * @param target
+ * @param dest
+ * @param src
+ * @param len
+ * @return bool true on error, as target_mem32_read()
+ */
+bool target_cache_mem_read(target_s *target, void *dest, uint32_t src, size_t len);
+
+/**
+ * Read a block from the target into the cache unless present
+ * @param target
+ * @param base block aligned address
+ * @return bool true if the block is cached
+ */
+bool target_cache_fill(target_s *target, uint32_t base);
+
+/**
+ * Prefetch the read-ahead window after the last request if reads are sequential
+ * @param target
+ */
+void target_cache_read_ahead(target_s *target);
+
+/**
+ * Set the read-ahead window
+ * @param window bytes, 0 disables read-ahead
+ */
+void target_cache_set_read_ahead(uint32_t window);
+
+/**
+ * @return uint32_t read-ahead window in bytes
+ */
+uint32_t target_cache_get_read_ahead(void);
+
+/**
+ * Read all registers ('g' layout) through the cache
+ * @param target
+ * @param data
+ * @param size target_regs_size()
+ * @return bool true on a cache hit
+ */
+bool target_cache_regs_read(target_s *target, void *data, size_t size);
+
+/**
+ * Read one register through the cache, as target_reg_read()
+ * @param target
+ * @param reg
+ * @param data
+ * @param max
+ * @return size_t register size, 0 on error
+ */
+size_t target_cache_reg_read(target_s *target, uint32_t reg, void *data, size_t max);
+
+/**
+ * @param addr
+ * @param len
+ * @return bool range touches a volatile region and must not be cached or prefetched,
+ * on top of everything outside the target's RAM and flash regions
+ */
+bool target_cache_is_volatile(uint32_t addr, size_t len);
+
+/**
+ * Add a volatile region, excluded from caching although it is RAM or flash
+ * @param start
+ * @param end inclusive
+ * @return bool false if the table is full or the range is empty
+ */
+bool target_cache_add_volatile(uint32_t start, uint32_t end);
+
+/**
+ * Remove all volatile regions
+ */
+void target_cache_clear_volatile(void);
+
+/**
+ * Get volatile regions
+ * @param regions
+ * @return size_t region count
+ */
+size_t target_cache_get_volatile(const TargetCacheRegion **regions);
+
+/**
+ * Enable or disable the cache
+ * @param enable
+ */
+void target_cache_set_enabled(bool enable);
+
+/**
+ * @return bool cache enabled
+ */
+bool target_cache_enabled(void);
+
+/**
+ * Get hit/miss counters
+ * @param stats
+ */
+void target_cache_get_stats(TargetCacheStats *stats);
+
+/**
+ * Clear hit/miss counters
+ */
+void target_cache_reset_stats(void);
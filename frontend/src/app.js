@@ -344,6 +344,13 @@ async function loadPins() {
         document.getElementById('pinTdi').value   = data.tdi;
         document.getElementById('pinTdo').value   = data.tdo;
         document.getElementById('pinTrst').value  = data.trst;
+        document.getElementById('pinFreq').value  = Math.round(data.freq / 1000);
+        document.getElementById('pinFreqActual').textContent =
+            'actual: ' + (data.freqActual / 1000).toFixed(1) + ' kHz';
+        document.getElementById('pinAutoSpeed').checked = data.autoSpeed;
+        document.getElementById('pinAutoSpeedFreq').textContent = data.autoSpeedFreq
+            ? 'negotiated: ' + (data.autoSpeedFreq / 1000).toFixed(1) + ' kHz'
+            : '';
     } catch (error) {
         console.error('Error loading pins:', error);
     }
@@ -364,6 +371,8 @@ pinsForm.addEventListener('submit', async (e) => {
             tdi:   document.getElementById('pinTdi').value,
             tdo:   document.getElementById('pinTdo').value,
             trst:  document.getElementById('pinTrst').value,
+            freq:  document.getElementById('pinFreq').value * 1000,
+            autoSpeed: document.getElementById('pinAutoSpeed').checked ? 1 : 0,
         });
 
         const response = await fetch('/pins', {
@@ -378,6 +387,7 @@ pinsForm.addEventListener('submit', async (e) => {
         if (result.success) {
             pinsStatus.textContent = '✓ Pins saved successfully!';
             pinsStatus.className = 'success';
+            loadPins();
         } else {
             pinsStatus.textContent = '✗ ' + (result.error || 'Failed to save pins');
             pinsStatus.className = 'error';
@@ -9,6 +9,7 @@
 #include "network.h"
 #include "network-gdb.h"
 #include "network-http.h"
+#include "network-reactor.h"
 
 #include "lwip/err.h"
 #include "lwip/sys.h"
@@ -18,6 +19,12 @@
 #include "platform.h"
 #include "gdb-glue.h"
 #include "nvs-config.h"
+#include "platform-freq.h"
+#include "poll-sched.h"
+#include "gdb-trace.h"
+#ifdef CONFIG_BMP_LP_OFFLOAD
+#include "lp-offload.h"
+#endif
 
 #ifdef ENABLE_RTT
 #include "network-rtt.h"
@@ -25,28 +32,97 @@
 #include "rtt_if_esp32.h"
 #endif
 
+#ifdef CONFIG_BMP_LP_OFFLOAD
+/* Let the LP core watch the running target until GDB, RTT input or the target need the HP core */
+static void gdb_lp_offload_wait(void)
+{
+    bool rtt = false;
+#ifdef ENABLE_RTT
+    rtt = rtt_enabled;
+#endif
+    // The LP core owns the pins, observers would clash with it
+    if (network_gdb_observers() > 0 || !lp_offload_start(cur_target, rtt))
+        return;
+
+    while (1)
+    {
+        char c = poll_sched_wait(pdMS_TO_TICKS(CONFIG_BMP_LP_OFFLOAD_CHECK_MS));
+        const bool event = lp_offload_poll();
+
+        if (network_gdb_observers() > 0)
+            break;
+
+        if (c == '\x03' || c == '\x04')
+        {
+            gdb_trace_record(GDB_TRACE_INTERRUPT, &c, 1);
+            lp_offload_stop();
+            target_halt_request(cur_target);
+            return;
+        }
+#ifdef ENABLE_RTT
+        if (rtt && !rtt_nodata(0))
+            break;
+#endif
+        if (event)
+            break;
+    }
+    lp_offload_stop();
+}
+#endif
+
+/* Interface frequency last written to NVS */
+static uint32_t gdb_frequency_stored;
+
+/* `monitor frequency` is handled by Black Magic's command.c, store what it set */
+static void gdb_store_frequency(void)
+{
+    const uint32_t frequency = platform_freq_get_requested();
+    if (frequency == gdb_frequency_stored)
+        return;
+    gdb_frequency_stored = frequency;
+    nvs_config_set_frequency(frequency);
+}
+
 void gdb_application_thread(void *pvParameters)
 {
     while (1)
     {
         SET_IDLE_STATE(false);
+        if (gdb_target_running && cur_target)
+            poll_sched_resume();
         while (gdb_target_running && cur_target)
         {
+            // Observer sessions read the target between polls
+            gdb_glue_target_lock(portMAX_DELAY);
             gdb_poll_target();
 
             // Check again, as `gdb_poll_target()` may
             // alter these variables.
             if (!gdb_target_running || !cur_target)
+            {
+                gdb_glue_target_unlock();
+                poll_sched_halted();
                 break;
-            char c = gdb_if_getchar_to(0);
+            }
+#ifdef CONFIG_BMP_LP_OFFLOAD
+            gdb_lp_offload_wait();
+#endif
+            gdb_glue_target_unlock();
+
+            // Blocks for the adaptive poll interval, GDB input wakes it
+            char c = poll_sched_getchar();
 
+            gdb_glue_target_lock(portMAX_DELAY);
             if (c == '\x03' || c == '\x04')
+            {
+                gdb_trace_record(GDB_TRACE_INTERRUPT, &c, 1);
                 target_halt_request(cur_target);
+            }
 #ifdef ENABLE_RTT
             else if (rtt_enabled)
                 poll_rtt(cur_target);
 #endif
-            // platform_pace_poll();
+            gdb_glue_target_unlock();
         }
 
         SET_IDLE_STATE(true);
@@ -54,7 +130,10 @@ void gdb_application_thread(void *pvParameters)
         // If port closed and target detached, stay idle
         if (packet->data[0] != '\x04' || cur_target)
             SET_IDLE_STATE(false);
+        gdb_glue_target_lock(portMAX_DELAY);
         gdb_main(packet);
+        gdb_glue_target_unlock();
+        gdb_store_frequency();
     }
 }
 
@@ -67,6 +146,13 @@ void app_main(void)
     // Load pin configuration from NVS and apply to platform
     nvs_config_get_pins(&g_pin_swdio, &g_pin_swclk, &g_pin_tdi, &g_pin_tdo, &g_pin_trst);
 
+    // Calibrate tap delays on the configured pins, then apply stored frequency
+    uint32_t frequency;
+    nvs_config_get_frequency(&frequency);
+    platform_freq_calibrate();
+    platform_max_frequency_set(frequency);
+    gdb_frequency_stored = platform_freq_get_requested();
+
     network_init();
     network_gdb_server_init();
     network_http_server_init();
@@ -74,6 +160,13 @@ void app_main(void)
 #ifdef ENABLE_RTT
     network_rtt_server_init();
 #endif
+    network_reactor_start();
+
+#ifdef CONFIG_BMP_TIMING_SELFTEST
+    // Tap timing with Wi-Fi up, see CONFIG_BMP_IRAM_HOT_PATH
+    platform_freq_selftest();
+#endif
 
+    // m and M go through static buffers in gdb-dispatch.c, nothing packet sized lives on this stack
     xTaskCreate(&gdb_application_thread, "gdb_thread", 4096, NULL, 5, NULL);
 }
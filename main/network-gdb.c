@@ -16,174 +16,380 @@
 #include <lwip/netdb.h>
 
 #include "network-gdb.h"
+#include "network-reactor.h"
 #include <gdb-glue.h>
+#include <gdb-observer.h>
 
 #define PORT 2345
-#define KEEPALIVE_IDLE 5
-#define KEEPALIVE_INTERVAL 5
+#define RX_WAIT_MS 100
+#define OBSERVER_RETRY_MS 10
+#define RX_SPACE_RETRY_MS 10
+#define HANDOVER_MS 10
+#define KEEPALIVE_IDLE 2
+#define KEEPALIVE_INTERVAL 1
 #define KEEPALIVE_COUNT 3
 #define TAG "network-gdb"
 
+/*
+ * GDB sessions, served by the network reactor. The first client owns
+ * the session: its bytes go through gdb-glue to gdb_main() and it has run
+ * control. Clients connecting while there is an owner become read-only
+ * observers (gdb-observer.c), up to CONFIG_BMP_GDB_OBSERVERS. The next
+ * client after the owner leaves takes ownership.
+ *
+ * Observer replies are queued per observer and flushed when select()
+ * finds the socket writable, so an observer that stops reading never
+ * holds the reactor, and with it the owner's ^C. Its next packet waits
+ * until the queue has room for a full reply; a queue that makes no
+ * progress for the send stall time drops the observer.
+ */
+
+typedef struct
+{
+    int socket_id;
+    bool failed;
+    uint8_t tx[GDB_OBSERVER_SEND_MAX];
+    size_t tx_size;
+    TickType_t tx_progress;
+    GDBObserver observer;
+} NetworkGDBObserver;
+
 typedef struct
 {
     bool connected;
     int socket_id;
+    int closing_socket;
+    int pending_socket;
+    TickType_t handover_start;
+    NetworkGDBObserver observers[CONFIG_BMP_GDB_OBSERVERS];
+    size_t observer_count;
+    size_t next_observer;
+    size_t owner_space;
+    uint32_t wait_ms;
 } NetworkGDB;
 
 static NetworkGDB network_gdb;
 
-static void delay(uint32_t ms)
-{
-    vTaskDelay(ms / portTICK_PERIOD_MS);
-}
+static const NetworkSocketProfile network_gdb_profile = {
+    .nodelay = true,
+    .keepalive_idle = KEEPALIVE_IDLE,
+    .keepalive_interval = KEEPALIVE_INTERVAL,
+    .keepalive_count = KEEPALIVE_COUNT,
+    .send_stall_ms = CONFIG_BMP_NET_SEND_STALL_MS,
+};
 
 bool network_gdb_connected(void)
 {
     return network_gdb.connected;
 }
 
+/*
+ * A failed or stalled send drops the owner at once, so the gdb thread
+ * stops writing to it; the shutdown wakes the network task, which closes
+ * the socket and frees the owner slot.
+ */
+static void network_gdb_owner_failed(void)
+{
+    if (!network_gdb.connected)
+        return;
+    ESP_LOGW(TAG, "Session owner not reading, dropping it");
+    network_gdb.connected = false;
+    shutdown(network_gdb.socket_id, SHUT_RDWR);
+}
+
 void network_gdb_send(uint8_t *buffer, size_t size)
 {
-    int to_write = size;
-    while (to_write > 0)
-    {
-        int written = send(network_gdb.socket_id, buffer + (size - to_write), to_write, 0);
-        to_write -= written;
-    }
+    if (network_gdb.connected &&
+        !network_reactor_send(network_gdb.socket_id, buffer, size, network_gdb_profile.send_stall_ms))
+        network_gdb_owner_failed();
 };
 
-static void receive_and_send_to_gdb(void)
+void network_gdb_sendv(struct iovec *iov, size_t count)
 {
-    size_t rx_size = SIZE_MAX;
-    size_t gdb_packet_size = gdb_glue_get_packet_size();
-    uint8_t *buffer_rx = malloc(gdb_packet_size);
+    struct msghdr msg = {
+        .msg_iov = iov,
+        .msg_iovlen = count,
+    };
 
-    do
-    {
-        if (gdb_glue_can_receive())
-        {
-            size_t max_len = gdb_glue_get_free_size();
-            if (max_len > gdb_packet_size)
-                max_len = gdb_packet_size;
-            rx_size = recv(network_gdb.socket_id, buffer_rx, max_len, 0);
-            if (rx_size > 0)
-            {
-                gdb_glue_receive(buffer_rx, rx_size);
-            }
-        }
-        else
-        {
-            delay(10);
-        }
-    } while (rx_size > 0);
+    if (network_gdb.connected && !network_reactor_sendmsg(network_gdb.socket_id, &msg, network_gdb_profile.send_stall_ms))
+        network_gdb_owner_failed();
+}
 
-    free(buffer_rx);
+size_t network_gdb_observers(void)
+{
+    return network_gdb.observer_count;
 }
 
-static void network_gdb_server_task(void *pvParameters)
+/*
+ * The gdb thread may still be writing to a leaving owner or using its
+ * session state. The old socket is closed, and the next owner's session
+ * reset, once HANDOVER_MS have passed, on a later pass of the reactor
+ * instead of sleeping in it.
+ * Returns how long select() may wait for the handover, in ms.
+ */
+static uint32_t network_gdb_handover(void)
 {
-    char addr_str[128];
-    int addr_family = (int)pvParameters;
-    int ip_protocol = 0;
-    int keepAlive = 1;
-    int keepIdle = KEEPALIVE_IDLE;
-    int keepInterval = KEEPALIVE_INTERVAL;
-    int keepCount = KEEPALIVE_COUNT;
-    network_gdb.connected = false;
-    struct sockaddr_storage dest_addr;
+    if (network_gdb.closing_socket < 0 && network_gdb.pending_socket < 0)
+        return RX_WAIT_MS;
+
+    const TickType_t elapsed = xTaskGetTickCount() - network_gdb.handover_start;
+    if (elapsed < pdMS_TO_TICKS(HANDOVER_MS))
+        return MAX(1U, pdTICKS_TO_MS(pdMS_TO_TICKS(HANDOVER_MS) - elapsed));
 
-    if (addr_family == AF_INET)
+    if (network_gdb.closing_socket >= 0)
     {
-        struct sockaddr_in *dest_addr_ip4 = (struct sockaddr_in *)&dest_addr;
-        dest_addr_ip4->sin_addr.s_addr = htonl(INADDR_ANY);
-        dest_addr_ip4->sin_family = AF_INET;
-        dest_addr_ip4->sin_port = htons(PORT);
-        ip_protocol = IPPROTO_IP;
+        network_reactor_close(network_gdb.closing_socket);
+        network_gdb.closing_socket = -1;
     }
-
-    int listen_sock = socket(addr_family, SOCK_STREAM, ip_protocol);
-    if (listen_sock < 0)
+    if (network_gdb.pending_socket >= 0)
     {
-        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
-        vTaskDelete(NULL);
-        return;
+        gdb_glue_session_reset();
+        network_gdb.socket_id = network_gdb.pending_socket;
+        network_gdb.pending_socket = -1;
+        network_gdb.connected = true;
     }
-    int opt = 1;
-    setsockopt(listen_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    return RX_WAIT_MS;
+}
 
-    ESP_LOGI(TAG, "Socket created");
+static void network_gdb_owner_close(void)
+{
+    ESP_LOGI(TAG, "Session owner closed");
+    network_gdb.closing_socket = network_gdb.socket_id;
+    network_gdb.handover_start = xTaskGetTickCount();
+    network_gdb.connected = false;
+    network_gdb.socket_id = -1;
+    gdb_glue_rx_discard();
+}
 
-    int err = bind(listen_sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-    if (err != 0)
+static void network_gdb_accept(int sock, const char *addr)
+{
+    // A dropped owner the network task has not closed yet makes way at once
+    if (network_gdb.socket_id >= 0 && !network_gdb.connected)
+        network_gdb_owner_close();
+
+    if (network_gdb.socket_id < 0 && network_gdb.pending_socket < 0)
+    {
+        // Owner once network_gdb_handover() has given the gdb thread time
+        ESP_LOGI(TAG, "Socket accepted ip address: %s, session owner", addr);
+        if (network_gdb.closing_socket < 0)
+            network_gdb.handover_start = xTaskGetTickCount();
+        network_gdb.pending_socket = sock;
+    }
+    else if (network_gdb.observer_count < CONFIG_BMP_GDB_OBSERVERS)
+    {
+        ESP_LOGI(TAG, "Socket accepted ip address: %s, observer", addr);
+        NetworkGDBObserver *observer = &network_gdb.observers[network_gdb.observer_count++];
+        observer->socket_id = sock;
+        observer->failed = false;
+        observer->tx_size = 0;
+        gdb_observer_init(&observer->observer);
+    }
+    else
     {
-        ESP_LOGE(TAG, "Socket unable to bind: errno %d", errno);
-        ESP_LOGE(TAG, "IPPROTO: %d", addr_family);
-        goto CLEAN_UP;
+        ESP_LOGW(TAG, "Socket rejected ip address: %s, all sessions in use", addr);
+        network_reactor_close(sock);
     }
-    ESP_LOGI(TAG, "Socket bound, port %d", PORT);
+}
+
+static void network_gdb_observer_close(size_t index)
+{
+    NetworkGDBObserver *observer = &network_gdb.observers[index];
+    ESP_LOGI(TAG, "Observer closed after %lu packets", observer->observer.packets);
+    network_reactor_close(observer->socket_id);
+
+    // Keep the table dense, the last session takes this slot
+    network_gdb.observer_count--;
+    if (index != network_gdb.observer_count)
+        *observer = network_gdb.observers[network_gdb.observer_count];
+    if (network_gdb.next_observer >= network_gdb.observer_count)
+        network_gdb.next_observer = 0;
+}
+
+static bool network_gdb_observer_tx_room(const NetworkGDBObserver *observer)
+{
+    return sizeof(observer->tx) - observer->tx_size >= GDB_OBSERVER_SEND_MAX;
+}
 
-    err = listen(listen_sock, 1);
-    if (err != 0)
+static void network_gdb_observer_send(void *context, const void *data, size_t size)
+{
+    NetworkGDBObserver *observer = context;
+    if (observer->failed)
+        return;
+    if (size > sizeof(observer->tx) - observer->tx_size)
     {
-        ESP_LOGE(TAG, "Error occurred during listen: errno %d", errno);
-        goto CLEAN_UP;
+        ESP_LOGW(TAG, "Observer tx queue overflow, dropping it");
+        observer->failed = true;
+        return;
     }
+    if (observer->tx_size == 0)
+        observer->tx_progress = xTaskGetTickCount();
+    memcpy(observer->tx + observer->tx_size, data, size);
+    observer->tx_size += size;
+}
+
+/* Send what the socket takes now, never waiting for space */
+static void network_gdb_observer_flush(NetworkGDBObserver *observer)
+{
+    if (observer->failed || observer->tx_size == 0)
+        return;
 
-    while (1)
+    const ssize_t written = send(observer->socket_id, observer->tx, observer->tx_size, MSG_DONTWAIT);
+    if (written < 0)
     {
-        ESP_LOGI(TAG, "Socket listening");
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            observer->failed = true;
+        return;
+    }
+    observer->tx_size -= written;
+    memmove(observer->tx, observer->tx + written, observer->tx_size);
+    observer->tx_progress = xTaskGetTickCount();
+}
 
-        struct sockaddr_storage source_addr; // Large enough for both IPv4 or IPv6
-        socklen_t addr_len = sizeof(source_addr);
-        int sock = accept(listen_sock, (struct sockaddr *)&source_addr, &addr_len);
-        if (sock < 0)
+/*
+ * One packet per observer per pass, starting after the last one served,
+ * so a client streaming reads cannot starve the others.
+ * Returns how long select() may wait before the next pass, in ms.
+ */
+static uint32_t network_gdb_observers_service(void)
+{
+    uint32_t wait_ms = RX_WAIT_MS;
+    const size_t count = network_gdb.observer_count;
+    const size_t first = network_gdb.next_observer;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const size_t index = (first + i) % count;
+        NetworkGDBObserver *observer = &network_gdb.observers[index];
+        if (observer->tx_size > 0 &&
+            xTaskGetTickCount() - observer->tx_progress >= pdMS_TO_TICKS(network_gdb_profile.send_stall_ms))
         {
-            ESP_LOGE(TAG, "Unable to accept connection: errno %d", errno);
-            break;
+            ESP_LOGW(TAG, "Observer not reading, dropping it");
+            observer->failed = true;
         }
+        // A full queue holds the next packet until select() finds the socket writable
+        if (observer->failed || !network_gdb_observer_tx_room(observer))
+            continue;
 
-        // Set tcp keepalive option
-        setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &keepAlive, sizeof(int));
-        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &keepIdle, sizeof(int));
-        setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &keepIdle, sizeof(int));
-        setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &keepInterval, sizeof(int));
-        setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &keepCount, sizeof(int));
-
-        // Convert ip address to string
-        if (source_addr.ss_family == PF_INET)
+        const gdb_observer_result_e result =
+            gdb_observer_service(&observer->observer, network_gdb_observer_send, observer);
+        network_gdb_observer_flush(observer);
+        if (result == GDB_OBSERVER_BUSY)
+            wait_ms = MIN(wait_ms, OBSERVER_RETRY_MS);
+        if (result == GDB_OBSERVER_DETACH)
+            observer->failed = true;
+        if (result == GDB_OBSERVER_DONE)
         {
-            inet_ntoa_r(
-                ((struct sockaddr_in *)&source_addr)->sin_addr, addr_str, sizeof(addr_str) - 1);
+            network_gdb.next_observer = (index + 1U) % count;
+            if (gdb_observer_pending(&observer->observer) && network_gdb_observer_tx_room(observer))
+                wait_ms = 0;
         }
+    }
 
-        ESP_LOGI(TAG, "Socket accepted ip address: %s", addr_str);
+    // Close from the end, so a moved session is not skipped
+    for (size_t i = count; i > 0; i--)
+    {
+        if (network_gdb.observers[i - 1U].failed)
+            network_gdb_observer_close(i - 1U);
+    }
+    return wait_ms;
+}
 
-        delay(10);
+static uint32_t network_gdb_prepare(fd_set *readable, fd_set *writable, int *max_fd)
+{
+    uint32_t wait_ms = MIN(network_gdb.wait_ms, network_gdb_handover());
 
-        network_gdb.socket_id = sock;
-        network_gdb.connected = true;
+    // Read only what the rx stream can take, so gdb_glue_receive() never blocks
+    network_gdb.owner_space = 0;
+    if (network_gdb.socket_id >= 0 && !network_gdb.connected)
+    {
+        // Failed send, close it in network_gdb_process() without waiting
+        FD_SET(network_gdb.socket_id, readable);
+        *max_fd = MAX(*max_fd, network_gdb.socket_id);
+        wait_ms = 0;
+    }
+    else if (network_gdb.connected)
+    {
+        // A full stream is checked again on the next select() timeout
+        network_gdb.owner_space = gdb_glue_wait_free(0);
+        if (network_gdb.owner_space == 0)
+            wait_ms = MIN(wait_ms, RX_SPACE_RETRY_MS);
+        else
+        {
+            FD_SET(network_gdb.socket_id, readable);
+            *max_fd = MAX(*max_fd, network_gdb.socket_id);
+        }
+    }
 
-        receive_and_send_to_gdb();
+    // Stop reading an observer whose packets wait for its queue
+    for (size_t i = 0; i < network_gdb.observer_count; i++)
+    {
+        NetworkGDBObserver *observer = &network_gdb.observers[i];
+        size_t space;
+        gdb_observer_rx_buffer(&observer->observer, &space);
+        if (space > 0)
+            FD_SET(observer->socket_id, readable);
+        if (observer->tx_size > 0)
+            FD_SET(observer->socket_id, writable);
+        *max_fd = MAX(*max_fd, observer->socket_id);
+    }
+    return wait_ms;
+}
+
+static void network_gdb_process(const fd_set *readable, const fd_set *writable)
+{
+    size_t buffer_size;
+    uint8_t *buffer_rx = network_reactor_buffer(&buffer_size);
 
-        network_gdb.connected = false;
-        network_gdb.socket_id = -1;
+    if (network_gdb.socket_id >= 0 && !network_gdb.connected)
+        network_gdb_owner_close();
+    else if (network_gdb.connected && network_gdb.owner_space > 0 && FD_ISSET(network_gdb.socket_id, readable))
+    {
+        size_t max_len = MIN(network_gdb.owner_space, gdb_glue_get_packet_size());
+        ssize_t rx_size = recv(network_gdb.socket_id, buffer_rx, MIN(max_len, buffer_size), 0);
+        if (rx_size <= 0)
+            network_gdb_owner_close();
+        else
+            gdb_glue_receive(buffer_rx, rx_size);
+    }
 
-        delay(10);
+    for (size_t i = 0; i < network_gdb.observer_count; i++)
+    {
+        NetworkGDBObserver *observer = &network_gdb.observers[i];
+        if (FD_ISSET(observer->socket_id, writable))
+            network_gdb_observer_flush(observer);
+        if (!FD_ISSET(observer->socket_id, readable))
+            continue;
 
-        shutdown(sock, 0);
-        close(sock);
+        size_t space;
+        uint8_t *buffer = gdb_observer_rx_buffer(&observer->observer, &space);
+        ssize_t rx_size = recv(observer->socket_id, buffer, space, 0);
+        if (rx_size <= 0)
+            observer->failed = true;
+        else
+            gdb_observer_rx_commit(&observer->observer, rx_size);
     }
 
-CLEAN_UP:
-    close(listen_sock);
-    vTaskDelete(NULL);
+    network_gdb.wait_ms = network_gdb_observers_service();
 }
 
+static const NetworkService network_gdb_service = {
+    .name = "gdb",
+    .port = PORT,
+    .backlog = 1 + CONFIG_BMP_GDB_OBSERVERS,
+    .profile = &network_gdb_profile,
+    .prepare = network_gdb_prepare,
+    .process = network_gdb_process,
+    .accept = network_gdb_accept,
+};
+
 void network_gdb_server_init(void)
 {
     network_gdb.connected = false;
     network_gdb.socket_id = -1;
+    network_gdb.closing_socket = -1;
+    network_gdb.pending_socket = -1;
+    network_gdb.wait_ms = RX_WAIT_MS;
 
     esp_wifi_set_ps(WIFI_PS_NONE);
-    xTaskCreate(network_gdb_server_task, "network_gdb_server", 4096, (void *)AF_INET, 5, NULL);
+    network_reactor_add(&network_gdb_service);
 }
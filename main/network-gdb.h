@@ -1,5 +1,7 @@
 #pragma once
 #include <stdint.h>
+#include <stdbool.h>
+#include <sys/uio.h>
 
 /**
  * Start GDB server
@@ -12,9 +14,22 @@ void network_gdb_server_init(void);
  */
 bool network_gdb_connected(void);
 
+/**
+ * Get connected read-only observer sessions
+ * @return size_t
+ */
+size_t network_gdb_observers(void);
+
 /**
  * Send data
  * @param buffer data
  * @param size data size
  */
 void network_gdb_send(uint8_t* buffer, size_t size);
+
+/**
+ * Send an iovec list with sendmsg, no copy through a tx buffer
+ * @param iov iovec list, adjusted while sending
+ * @param count iovec count
+ */
+void network_gdb_sendv(struct iovec *iov, size_t count);
@@ -14,10 +14,16 @@
 #include "nvs-config.h"
 #include "m-string.h"
 #include "platform.h"
+#include "platform-freq.h"
+#include "auto-speed.h"
+#include "gdb-stats.h"
+#include "gdb-trace.h"
+#include "tap-stats.h"
 
 #define TAG "network-http"
 #define FLASH_CHUNK_SIZE 4096      // Write in 4KB chunks for streaming
 #define FLASH_BASE_ADDR 0x08000000 // Default ARM Cortex-M flash base
+#define PINS_FREQ_LOCK_MS 1000     // Longest wait for the GDB thread to release the target
 
 // Flash parameters structure
 typedef struct
@@ -560,14 +566,112 @@ static esp_err_t pins_get_handler(httpd_req_t *req)
 {
     char resp[256];
     snprintf(resp, sizeof(resp),
-             "{\"swdio\":%ld,\"swclk\":%ld,\"tdi\":%ld,\"tdo\":%ld,\"trst\":%ld}",
+             "{\"swdio\":%ld,\"swclk\":%ld,\"tdi\":%ld,\"tdo\":%ld,\"trst\":%ld,"
+             "\"freq\":%lu,\"freqActual\":%lu,\"autoSpeed\":%s,\"autoSpeedFreq\":%lu}",
              (long)g_pin_swdio, (long)g_pin_swclk,
-             (long)g_pin_tdi, (long)g_pin_tdo, (long)g_pin_trst);
+             (long)g_pin_tdi, (long)g_pin_tdo, (long)g_pin_trst,
+             (unsigned long)platform_freq_get_requested(),
+             (unsigned long)platform_max_frequency_get(),
+             auto_speed_enabled() ? "true" : "false",
+             (unsigned long)auto_speed_get_result());
     httpd_resp_set_type(req, "application/json");
     httpd_resp_send(req, resp, HTTPD_RESP_USE_STRLEN);
     return ESP_OK;
 }
 
+/* GDB packet stats GET handler, one chunk per packet type */
+static esp_err_t stats_get_handler(httpd_req_t *req)
+{
+    static const char *const phases[GDB_STATS_PHASES] = {"receive", "process", "swd"};
+    char resp[768];
+    int len;
+
+    httpd_resp_set_type(req, "application/json");
+
+    len = snprintf(resp, sizeof(resp), "{\"enabled\":%s,\"swdTime\":%s,\"bucketsUs\":[",
+                   gdb_stats_enabled() ? "true" : "false", tap_stats_enabled() ? "true" : "false");
+    for (size_t bucket = 0; bucket < GDB_STATS_BUCKETS - 1U; bucket++)
+        len += snprintf(resp + len, sizeof(resp) - len, "%s%lu", bucket ? "," : "",
+                        (unsigned long)gdb_stats_bucket_us(bucket));
+    len += snprintf(resp + len, sizeof(resp) - len, "],\"packets\":{");
+    httpd_resp_send_chunk(req, resp, len);
+
+    bool first = true;
+    for (size_t i = 0; i < gdb_stats_types(); i++)
+    {
+        GDBStatsType stats;
+        const char *name = gdb_stats_get(i, &stats);
+        if (stats.count == 0)
+            continue;
+
+        len = snprintf(resp, sizeof(resp), "%s\"%s\":{\"count\":%lu,\"rxBytes\":%llu,\"txBytes\":%llu",
+                       first ? "" : ",", name, (unsigned long)stats.count,
+                       (unsigned long long)stats.rx_bytes, (unsigned long long)stats.tx_bytes);
+        for (size_t phase = 0; phase < GDB_STATS_PHASES; phase++)
+        {
+            len += snprintf(resp + len, sizeof(resp) - len, ",\"%s\":{\"totalUs\":%llu,\"histogram\":[",
+                            phases[phase], (unsigned long long)stats.total_us[phase]);
+            for (size_t bucket = 0; bucket < GDB_STATS_BUCKETS; bucket++)
+                len += snprintf(resp + len, sizeof(resp) - len, "%s%lu", bucket ? "," : "",
+                                (unsigned long)stats.histogram[phase][bucket]);
+            len += snprintf(resp + len, sizeof(resp) - len, "]}");
+        }
+        len += snprintf(resp + len, sizeof(resp) - len, "}");
+        httpd_resp_send_chunk(req, resp, len);
+        first = false;
+    }
+
+    httpd_resp_send_chunk(req, "}}", 2);
+    httpd_resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
+}
+
+static const httpd_uri_t stats_get_uri = {
+    .uri = "/stats",
+    .method = HTTP_GET,
+    .handler = stats_get_handler};
+
+/* RSP trace GET handler, recording pauses while the ring is sent */
+static esp_err_t trace_get_handler(httpd_req_t *req)
+{
+    char chunk[512];
+    uint32_t records;
+    size_t used;
+    size_t capacity;
+    uint32_t dropped;
+
+    gdb_trace_freeze(true);
+    gdb_trace_get_stats(&records, &used, &capacity, &dropped);
+    const GDBTraceHeader header = {
+        .magic = GDB_TRACE_MAGIC,
+        .version = GDB_TRACE_VERSION,
+        .records = records,
+        .dropped = dropped,
+    };
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"rsp.trace\"");
+    esp_err_t err = httpd_resp_send_chunk(req, (const char *)&header, sizeof(header));
+
+    size_t offset = 0;
+    size_t size;
+    while (err == ESP_OK && (size = gdb_trace_read(offset, chunk, sizeof(chunk))) > 0)
+    {
+        err = httpd_resp_send_chunk(req, chunk, size);
+        offset += size;
+    }
+    gdb_trace_freeze(false);
+
+    if (err == ESP_OK)
+        httpd_resp_send_chunk(req, NULL, 0);
+    return err;
+}
+
+static const httpd_uri_t trace_get_uri = {
+    .uri = "/trace",
+    .method = HTTP_GET,
+    .handler = trace_get_handler};
+
 /* Pins POST handler */
 static esp_err_t pins_post_handler(httpd_req_t *req)
 {
@@ -583,7 +687,7 @@ static esp_err_t pins_post_handler(httpd_req_t *req)
     }
     content[ret] = '\0';
 
-    char val[8];
+    char val[12];
     int32_t swdio = g_pin_swdio, swclk = g_pin_swclk;
     int32_t tdi = g_pin_tdi, tdo = g_pin_tdo, trst = g_pin_trst;
 
@@ -595,6 +699,9 @@ static esp_err_t pins_post_handler(httpd_req_t *req)
 
     nvs_config_set_pins(swdio, swclk, tdi, tdo, trst);
 
+    if (httpd_query_key_value(content, "autoSpeed", val, sizeof(val)) == ESP_OK)
+        auto_speed_set_enabled(atoi(val) != 0);
+
     // Apply immediately
     g_pin_swdio = swdio;
     g_pin_swclk = swclk;
@@ -605,6 +712,21 @@ static esp_err_t pins_post_handler(httpd_req_t *req)
     ESP_LOGI(TAG, "Pins updated: SWDIO=%ld SWCLK=%ld TDI=%ld TDO=%ld TRST=%ld",
              (long)swdio, (long)swclk, (long)tdi, (long)tdo, (long)trst);
 
+    if (httpd_query_key_value(content, "freq", val, sizeof(val)) == ESP_OK)
+    {
+        uint32_t freq = strtoul(val, NULL, 0);
+        nvs_config_set_frequency(freq);
+
+        // The tap delays are shared with the GDB thread, change them between target accesses
+        if (!gdb_glue_target_lock(pdMS_TO_TICKS(PINS_FREQ_LOCK_MS)))
+        {
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Target busy, frequency applies on next boot");
+            return ESP_FAIL;
+        }
+        platform_max_frequency_set(freq);
+        gdb_glue_target_unlock();
+    }
+
     httpd_resp_set_type(req, "application/json");
     httpd_resp_send(req, "{\"success\":true}", HTTPD_RESP_USE_STRLEN);
     return ESP_OK;
@@ -648,6 +770,8 @@ static httpd_handle_t start_webserver(void)
     httpd_register_uri_handler(server, &reboot_uri);
     httpd_register_uri_handler(server, &pins_get_uri);
     httpd_register_uri_handler(server, &pins_post_uri);
+    httpd_register_uri_handler(server, &stats_get_uri);
+    httpd_register_uri_handler(server, &trace_get_uri);
     return server;
 }
 
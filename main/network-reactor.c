@@ -0,0 +1,242 @@
+#include <string.h>
+#include <sys/param.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_system.h>
+#include <esp_log.h>
+
+#include <lwip/err.h>
+#include <lwip/sockets.h>
+#include <lwip/sys.h>
+#include <lwip/netdb.h>
+
+#include "network-reactor.h"
+
+#define NETWORK_SERVICES_MAX 4
+#define NETWORK_BUFFER_SIZE 1024
+#define NETWORK_WAIT_MAX_MS 100
+#define TAG "network-reactor"
+
+/*
+ * One task serves every TCP port except HTTP (esp_http_server keeps its
+ * own task). Each pass select()s on all listeners and on the client
+ * sockets the services add, accepts with the service's socket profile,
+ * and lets each service handle its readable sockets and flush queued
+ * output to writable ones. Services are handled one after another, so
+ * they share one receive buffer.
+ */
+
+typedef struct
+{
+    const NetworkService *services[NETWORK_SERVICES_MAX];
+    int listen_socks[NETWORK_SERVICES_MAX];
+    size_t service_count;
+    uint8_t buffer[NETWORK_BUFFER_SIZE];
+} NetworkReactor;
+
+static NetworkReactor network_reactor;
+
+void network_reactor_add(const NetworkService *service)
+{
+    if (network_reactor.service_count == NETWORK_SERVICES_MAX)
+    {
+        ESP_LOGE(TAG, "No room for service %s", service->name);
+        return;
+    }
+    network_reactor.services[network_reactor.service_count++] = service;
+}
+
+uint8_t *network_reactor_buffer(size_t *size)
+{
+    *size = sizeof(network_reactor.buffer);
+    return network_reactor.buffer;
+}
+
+void network_reactor_close(int sock)
+{
+    shutdown(sock, 0);
+    close(sock);
+}
+
+static void network_reactor_socket_options(const NetworkService *service, int sock)
+{
+    const NetworkSocketProfile *profile = service->profile;
+    int nodelay = profile->nodelay;
+    int keepAlive = profile->keepalive_idle > 0;
+
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(int));
+    if (profile->sndbuf > 0 && setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &profile->sndbuf, sizeof(int)) != 0)
+        ESP_LOGD(TAG, "%s: SO_SNDBUF not supported: errno %d", service->name, errno);
+
+    // Set tcp keepalive option
+    setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &keepAlive, sizeof(int));
+    if (keepAlive)
+    {
+        setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &profile->keepalive_idle, sizeof(int));
+        setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &profile->keepalive_interval, sizeof(int));
+        setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &profile->keepalive_count, sizeof(int));
+    }
+}
+
+static bool network_reactor_wait_writable(int sock, uint32_t ms)
+{
+    fd_set writable;
+    FD_ZERO(&writable);
+    FD_SET(sock, &writable);
+    struct timeval timeout = {.tv_sec = ms / 1000, .tv_usec = (ms % 1000) * 1000};
+    return select(sock + 1, NULL, &writable, NULL, &timeout) > 0;
+}
+
+/*
+ * Sends never block in lwIP: MSG_DONTWAIT, then a select() for space
+ * bounded by the stall time. Every bit of progress restarts the wait, so
+ * long replies over a slow link pass while a peer that stopped reading
+ * (Wi-Fi gone, gdb killed) fails the send within the stall time instead
+ * of holding the gdb thread.
+ */
+bool network_reactor_sendmsg(int sock, struct msghdr *msg, uint32_t stall_ms)
+{
+    while (msg->msg_iovlen > 0)
+    {
+        ssize_t written = sendmsg(sock, msg, MSG_DONTWAIT);
+        if (written < 0)
+        {
+            if ((errno == EAGAIN || errno == EWOULDBLOCK) && network_reactor_wait_writable(sock, stall_ms))
+                continue;
+            ESP_LOGW(TAG, "Send failed on socket %d: errno %d", sock, errno);
+            return false;
+        }
+
+        // Skip what went out, continue inside a partly sent iovec
+        while (msg->msg_iovlen > 0 && (size_t)written >= msg->msg_iov->iov_len)
+        {
+            written -= msg->msg_iov->iov_len;
+            msg->msg_iov++;
+            msg->msg_iovlen--;
+        }
+        if (msg->msg_iovlen > 0)
+        {
+            msg->msg_iov->iov_base = (uint8_t *)msg->msg_iov->iov_base + written;
+            msg->msg_iov->iov_len -= written;
+        }
+    }
+    return true;
+}
+
+bool network_reactor_send(int sock, const void *data, size_t size, uint32_t stall_ms)
+{
+    struct iovec iov = {
+        .iov_base = (void *)data,
+        .iov_len = size,
+    };
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+    };
+    return network_reactor_sendmsg(sock, &msg, stall_ms);
+}
+
+static int network_reactor_listen(const NetworkService *service)
+{
+    struct sockaddr_in dest_addr = {
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+        .sin_family = AF_INET,
+        .sin_port = htons(service->port),
+    };
+
+    int listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (listen_sock < 0)
+    {
+        ESP_LOGE(TAG, "%s: unable to create socket: errno %d", service->name, errno);
+        return -1;
+    }
+    int opt = 1;
+    setsockopt(listen_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    if (bind(listen_sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr)) != 0)
+    {
+        ESP_LOGE(TAG, "%s: socket unable to bind: errno %d", service->name, errno);
+        close(listen_sock);
+        return -1;
+    }
+
+    if (listen(listen_sock, service->backlog) != 0)
+    {
+        ESP_LOGE(TAG, "%s: error occurred during listen: errno %d", service->name, errno);
+        close(listen_sock);
+        return -1;
+    }
+
+    ESP_LOGI(TAG, "%s: listening, port %d", service->name, service->port);
+    return listen_sock;
+}
+
+static void network_reactor_accept(const NetworkService *service, int listen_sock)
+{
+    char addr_str[128] = "";
+    struct sockaddr_storage source_addr; // Large enough for both IPv4 or IPv6
+    socklen_t addr_len = sizeof(source_addr);
+    int sock = accept(listen_sock, (struct sockaddr *)&source_addr, &addr_len);
+    if (sock < 0)
+    {
+        ESP_LOGE(TAG, "%s: unable to accept connection: errno %d", service->name, errno);
+        return;
+    }
+
+    network_reactor_socket_options(service, sock);
+
+    // Convert ip address to string
+    if (source_addr.ss_family == PF_INET)
+    {
+        inet_ntoa_r(((struct sockaddr_in *)&source_addr)->sin_addr, addr_str, sizeof(addr_str) - 1);
+    }
+
+    service->accept(sock, addr_str);
+}
+
+static void network_reactor_task(void *pvParameters)
+{
+    for (size_t i = 0; i < network_reactor.service_count; i++)
+        network_reactor.listen_socks[i] = network_reactor_listen(network_reactor.services[i]);
+
+    while (1)
+    {
+        fd_set readable;
+        fd_set writable;
+        FD_ZERO(&readable);
+        FD_ZERO(&writable);
+        int max_fd = -1;
+        uint32_t wait_ms = NETWORK_WAIT_MAX_MS;
+
+        for (size_t i = 0; i < network_reactor.service_count; i++)
+        {
+            if (network_reactor.listen_socks[i] >= 0)
+            {
+                FD_SET(network_reactor.listen_socks[i], &readable);
+                max_fd = MAX(max_fd, network_reactor.listen_socks[i]);
+            }
+            wait_ms = MIN(wait_ms, network_reactor.services[i]->prepare(&readable, &writable, &max_fd));
+        }
+
+        struct timeval timeout = {.tv_sec = wait_ms / 1000, .tv_usec = (wait_ms % 1000) * 1000};
+        if (select(max_fd + 1, &readable, &writable, NULL, &timeout) < 0)
+        {
+            ESP_LOGE(TAG, "Error occurred during select: errno %d", errno);
+            vTaskDelay(pdMS_TO_TICKS(NETWORK_WAIT_MAX_MS));
+            continue;
+        }
+
+        for (size_t i = 0; i < network_reactor.service_count; i++)
+        {
+            const NetworkService *service = network_reactor.services[i];
+            service->process(&readable, &writable);
+            if (network_reactor.listen_socks[i] >= 0 && FD_ISSET(network_reactor.listen_socks[i], &readable))
+                network_reactor_accept(service, network_reactor.listen_socks[i]);
+        }
+    }
+}
+
+void network_reactor_start(void)
+{
+    xTaskCreate(network_reactor_task, "network", 4096, NULL, 5, NULL);
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <lwip/sockets.h>
+
+/**
+ * Socket options applied to every client of a service
+ */
+typedef struct
+{
+    bool nodelay;
+    int sndbuf;             /* bytes, 0 keeps the lwIP default */
+    int keepalive_idle;     /* s, 0 disables keepalive */
+    int keepalive_interval; /* s */
+    int keepalive_count;
+    uint32_t send_stall_ms; /* a send that makes no progress this long fails */
+} NetworkSocketProfile;
+
+/**
+ * A TCP port served by the network task. All callbacks run on that task
+ * and must not block for long.
+ */
+typedef struct
+{
+    const char *name;
+    uint16_t port;
+    int backlog;
+    const NetworkSocketProfile *profile;
+
+    /**
+     * Add client sockets to the read set, and those with queued output to the write set
+     * @param readable
+     * @param writable
+     * @param max_fd raised to the highest socket added
+     * @return uint32_t longest select() wait this service allows, ms
+     */
+    uint32_t (*prepare)(fd_set *readable, fd_set *writable, int *max_fd);
+
+    /**
+     * Handle client sockets that select() reported readable or writable
+     * @param readable
+     * @param writable
+     */
+    void (*process)(const fd_set *readable, const fd_set *writable);
+
+    /**
+     * A client connected, socket options are set
+     * @param sock the service owns it from now on
+     * @param addr peer address
+     */
+    void (*accept)(int sock, const char *addr);
+} NetworkService;
+
+/**
+ * Register a service, before network_reactor_start()
+ * @param service static, not copied
+ */
+void network_reactor_add(const NetworkService *service);
+
+/**
+ * Open the listeners and start the network task
+ */
+void network_reactor_start(void);
+
+/**
+ * Receive buffer shared by all services, valid inside one callback
+ * @param size buffer size
+ * @return uint8_t*
+ */
+uint8_t *network_reactor_buffer(size_t *size);
+
+/**
+ * Send all bytes without blocking past the stall time, from any task
+ * @param sock
+ * @param data
+ * @param size
+ * @param stall_ms longest wait for send buffer space
+ * @return bool false if the peer is gone or stalled
+ */
+bool network_reactor_send(int sock, const void *data, size_t size, uint32_t stall_ms);
+
+/**
+ * Send an iovec list without blocking past the stall time, from any task
+ * @param sock
+ * @param msg iovec list, adjusted while sending
+ * @param stall_ms longest wait for send buffer space
+ * @return bool false if the peer is gone or stalled
+ */
+bool network_reactor_sendmsg(int sock, struct msghdr *msg, uint32_t stall_ms);
+
+/**
+ * Shut down and close a client socket
+ * @param sock
+ */
+void network_reactor_close(int sock);
@@ -11,14 +11,15 @@
 #include <lwip/netdb.h>
 
 #include "network-rtt.h"
+#include "network-reactor.h"
 
 #ifdef ENABLE_RTT
 #include "rtt_if_esp32.h"
 #endif
 
 #define RTT_PORT 2346
-#define KEEPALIVE_IDLE 5
-#define KEEPALIVE_INTERVAL 5
+#define KEEPALIVE_IDLE 2
+#define KEEPALIVE_INTERVAL 1
 #define KEEPALIVE_COUNT 3
 #define TAG "network-rtt"
 
@@ -30,6 +31,14 @@ typedef struct
 
 static NetworkRTT network_rtt;
 
+static const NetworkSocketProfile network_rtt_profile = {
+    .nodelay = true,
+    .keepalive_idle = KEEPALIVE_IDLE,
+    .keepalive_interval = KEEPALIVE_INTERVAL,
+    .keepalive_count = KEEPALIVE_COUNT,
+    .send_stall_ms = CONFIG_BMP_NET_SEND_STALL_MS,
+};
+
 bool network_rtt_connected(void)
 {
     return network_rtt.connected;
@@ -40,144 +49,91 @@ void network_rtt_send(uint8_t *buffer, size_t size)
     if (!network_rtt.connected || network_rtt.socket_id < 0)
         return;
 
-    int to_write = size;
-    while (to_write > 0)
+    // Called from the gdb thread while polling RTT, never block it on a dead client
+    if (!network_reactor_send(network_rtt.socket_id, buffer, size, network_rtt_profile.send_stall_ms))
     {
-        int written = send(network_rtt.socket_id, buffer + (size - to_write), to_write, 0);
-        if (written < 0)
-        {
-            ESP_LOGE(TAG, "Error sending data: errno %d", errno);
-            network_rtt.connected = false;
-            break;
-        }
-        to_write -= written;
+        ESP_LOGE(TAG, "Error sending data: errno %d", errno);
+        network_rtt.connected = false;
+        shutdown(network_rtt.socket_id, SHUT_RDWR);
     }
 }
 
-#ifdef ENABLE_RTT
-static void receive_and_send_to_rtt(void)
+static uint32_t network_rtt_prepare(fd_set *readable, fd_set *writable, int *max_fd)
 {
-    uint8_t buffer_rx[128];
-    int rx_size = 0;
-
-    do
+    if (network_rtt.socket_id >= 0)
     {
-        rx_size = recv(network_rtt.socket_id, buffer_rx, sizeof(buffer_rx), 0);
-        if (rx_size > 0)
-        {
-            // Send received data to target via RTT
-            rtt_receive_data(buffer_rx, rx_size);
-        }
-    } while (rx_size > 0);
+        FD_SET(network_rtt.socket_id, readable);
+        *max_fd = MAX(*max_fd, network_rtt.socket_id);
+        // Failed send, close it in network_rtt_process() without waiting
+        if (!network_rtt.connected)
+            return 0;
+    }
+    return UINT32_MAX;
 }
-#endif
 
-static void network_rtt_server_task(void *pvParameters)
+static void network_rtt_close(void)
 {
-    char addr_str[128];
-    int addr_family = (int)pvParameters;
-    int ip_protocol = 0;
-    int keepAlive = 1;
-    int keepIdle = KEEPALIVE_IDLE;
-    int keepInterval = KEEPALIVE_INTERVAL;
-    int keepCount = KEEPALIVE_COUNT;
+    ESP_LOGI(TAG, "Socket closed");
+    network_reactor_close(network_rtt.socket_id);
     network_rtt.connected = false;
     network_rtt.socket_id = -1;
-    struct sockaddr_storage dest_addr;
-
-    if (addr_family == AF_INET)
-    {
-        struct sockaddr_in *dest_addr_ip4 = (struct sockaddr_in *)&dest_addr;
-        dest_addr_ip4->sin_addr.s_addr = htonl(INADDR_ANY);
-        dest_addr_ip4->sin_family = AF_INET;
-        dest_addr_ip4->sin_port = htons(RTT_PORT);
-        ip_protocol = IPPROTO_IP;
-    }
+}
 
-    int listen_sock = socket(addr_family, SOCK_STREAM, ip_protocol);
-    if (listen_sock < 0)
+static void network_rtt_process(const fd_set *readable, const fd_set *writable)
+{
+    // A failed send drops the connection flag, close the socket here
+    if (network_rtt.socket_id >= 0 && !network_rtt.connected)
     {
-        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
-        vTaskDelete(NULL);
+        network_rtt_close();
         return;
     }
-    int opt = 1;
-    setsockopt(listen_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-
-    ESP_LOGI(TAG, "Socket created");
-
-    int err = bind(listen_sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-    if (err != 0)
-    {
-        ESP_LOGE(TAG, "Socket unable to bind: errno %d", errno);
-        ESP_LOGE(TAG, "IPPROTO: %d", addr_family);
-        goto CLEAN_UP;
-    }
-    ESP_LOGI(TAG, "Socket bound, port %d", RTT_PORT);
+    if (network_rtt.socket_id < 0 || !FD_ISSET(network_rtt.socket_id, readable))
+        return;
 
-    err = listen(listen_sock, 1);
-    if (err != 0)
+    size_t buffer_size;
+    uint8_t *buffer_rx = network_reactor_buffer(&buffer_size);
+    int rx_size = recv(network_rtt.socket_id, buffer_rx, buffer_size, 0);
+    if (rx_size <= 0)
     {
-        ESP_LOGE(TAG, "Error occurred during listen: errno %d", errno);
-        goto CLEAN_UP;
+        network_rtt_close();
+        return;
     }
-
-    while (1)
-    {
-        ESP_LOGI(TAG, "Socket listening");
-
-        struct sockaddr_storage source_addr;
-        socklen_t addr_len = sizeof(source_addr);
-        int sock = accept(listen_sock, (struct sockaddr *)&source_addr, &addr_len);
-        if (sock < 0)
-        {
-            ESP_LOGE(TAG, "Unable to accept connection: errno %d", errno);
-            break;
-        }
-
-        // Set tcp keepalive option
-        setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &keepAlive, sizeof(int));
-        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &keepIdle, sizeof(int));
-        setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &keepIdle, sizeof(int));
-        setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &keepInterval, sizeof(int));
-        setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &keepCount, sizeof(int));
-
-        // Convert ip address to string
-        if (source_addr.ss_family == PF_INET)
-        {
-            inet_ntoa_r(((struct sockaddr_in *)&source_addr)->sin_addr, addr_str, sizeof(addr_str) - 1);
-        }
-
-        ESP_LOGI(TAG, "Socket accepted ip address: %s", addr_str);
-
-        network_rtt.connected = true;
-        network_rtt.socket_id = sock;
-
 #ifdef ENABLE_RTT
-        receive_and_send_to_rtt();
-#else
-        // Just wait for disconnect if RTT is not enabled
-        char dummy;
-        while (recv(sock, &dummy, 1, 0) > 0)
-            ;
+    // Send received data to target via RTT
+    rtt_receive_data(buffer_rx, rx_size);
 #endif
+}
 
-        ESP_LOGI(TAG, "Socket closed");
-        network_rtt.connected = false;
-        network_rtt.socket_id = -1;
-        shutdown(sock, 0);
-        close(sock);
+static void network_rtt_accept(int sock, const char *addr)
+{
+    if (network_rtt.socket_id >= 0)
+    {
+        ESP_LOGW(TAG, "Socket rejected ip address: %s, already connected", addr);
+        network_reactor_close(sock);
+        return;
     }
 
-CLEAN_UP:
-    close(listen_sock);
-    vTaskDelete(NULL);
+    ESP_LOGI(TAG, "Socket accepted ip address: %s", addr);
+    network_rtt.socket_id = sock;
+    network_rtt.connected = true;
 }
 
+static const NetworkService network_rtt_service = {
+    .name = "rtt",
+    .port = RTT_PORT,
+    .backlog = 1,
+    .profile = &network_rtt_profile,
+    .prepare = network_rtt_prepare,
+    .process = network_rtt_process,
+    .accept = network_rtt_accept,
+};
+
 void network_rtt_server_init(void)
 {
+    network_rtt.connected = false;
+    network_rtt.socket_id = -1;
 #ifdef ENABLE_RTT
     rtt_if_init();
 #endif
-    xTaskCreate(network_rtt_server_task, "rtt_server", 4096, (void *)AF_INET, 5, NULL);
+    network_reactor_add(&network_rtt_service);
 }
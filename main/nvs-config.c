@@ -11,6 +11,7 @@
 #define PIN_TDI_KEY   "pin_tdi"
 #define PIN_TDO_KEY   "pin_tdo"
 #define PIN_TRST_KEY  "pin_trst"
+#define IFACE_FREQ_KEY "iface_freq"
 
 #define DEFAULT_PIN_SWDIO 23
 #define DEFAULT_PIN_SWCLK 24
@@ -18,6 +19,8 @@
 #define DEFAULT_PIN_TDO   27
 #define DEFAULT_PIN_TRST  25
 
+#define DEFAULT_IFACE_FREQ (CONFIG_BMP_INTERFACE_FREQ_KHZ * 1000)
+
 #define ESP_WIFI_DEFAULT_SSID CONFIG_ESP_WIFI_SSID
 #define ESP_WIFI_DEFAULT_PASS CONFIG_ESP_WIFI_PASSWORD
 #define ESP_WIFI_DEFAULT_HOSTNAME "blackmagic"
@@ -99,3 +102,19 @@ esp_err_t nvs_config_get_pins(int32_t *swdio, int32_t *swclk, int32_t *tdi, int3
     if(nvs_load_i32(PIN_TRST_KEY,  trst)  != ESP_OK) *trst  = DEFAULT_PIN_TRST;
     return ESP_OK;
 }
+
+esp_err_t nvs_config_set_frequency(uint32_t frequency) {
+    return nvs_save_i32(IFACE_FREQ_KEY, (int32_t)frequency);
+}
+
+esp_err_t nvs_config_get_frequency(uint32_t *frequency) {
+    int32_t value;
+    esp_err_t err = nvs_load_i32(IFACE_FREQ_KEY, &value);
+
+    if(err != ESP_OK || value < 0) {
+        value = DEFAULT_IFACE_FREQ;
+    }
+
+    *frequency = (uint32_t)value;
+    return err;
+}
@@ -14,3 +14,6 @@ esp_err_t nvs_config_get_hostname(mstring_t* hostname);
 
 esp_err_t nvs_config_set_pins(int32_t swdio, int32_t swclk, int32_t tdi, int32_t tdo, int32_t trst);
 esp_err_t nvs_config_get_pins(int32_t *swdio, int32_t *swclk, int32_t *tdi, int32_t *tdo, int32_t *trst);
+
+esp_err_t nvs_config_set_frequency(uint32_t frequency);
+esp_err_t nvs_config_get_frequency(uint32_t *frequency);
@@ -0,0 +1,149 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/param.h>
+#include "target.h"
+
+/* DP registers */
+#define ADIV5_DP_REG(x) (x)
+#define ADIV5_DP_DPIDR ADIV5_DP_REG(0x0U)
+#define ADIV5_DP_ABORT ADIV5_DP_REG(0x0U)
+#define ADIV5_DP_CTRLSTAT ADIV5_DP_REG(0x4U)
+#define ADIV5_DP_SELECT ADIV5_DP_REG(0x8U)
+#define ADIV5_DP_RDBUFF ADIV5_DP_REG(0xcU)
+
+/* AP registers */
+#define ADIV5_APnDP 0x100U
+#define ADIV5_AP_REG(x) (ADIV5_APnDP | (x))
+#define ADIV5_AP_CSW ADIV5_AP_REG(0x00U)
+#define ADIV5_AP_TAR ADIV5_AP_REG(0x04U)
+#define ADIV5_AP_DRW ADIV5_AP_REG(0x0cU)
+#define ADIV5_AP_IDR ADIV5_AP_REG(0xfcU)
+
+/* ABORT */
+#define ADIV5_DP_ABORT_ORUNERRCLR (1U << 4U)
+#define ADIV5_DP_ABORT_WDERRCLR (1U << 3U)
+#define ADIV5_DP_ABORT_STKERRCLR (1U << 2U)
+#define ADIV5_DP_ABORT_STKCMPCLR (1U << 1U)
+#define ADIV5_DP_ABORT_DAPABORT (1U << 0U)
+
+/* CTRL/STAT */
+#define ADIV5_DP_CTRLSTAT_CSYSPWRUPACK (1U << 31U)
+#define ADIV5_DP_CTRLSTAT_CSYSPWRUPREQ (1U << 30U)
+#define ADIV5_DP_CTRLSTAT_CDBGPWRUPACK (1U << 29U)
+#define ADIV5_DP_CTRLSTAT_CDBGPWRUPREQ (1U << 28U)
+#define ADIV5_DP_CTRLSTAT_WDATAERR (1U << 7U)
+#define ADIV5_DP_CTRLSTAT_STICKYERR (1U << 5U)
+#define ADIV5_DP_CTRLSTAT_STICKYCMP (1U << 4U)
+#define ADIV5_DP_CTRLSTAT_STICKYORUN (1U << 1U)
+
+/* CSW */
+#define ADIV5_AP_CSW_DBGSWENABLE (1U << 31U)
+#define ADIV5_AP_CSW_DEVICEEN (1U << 6U)
+#define ADIV5_AP_CSW_ADDRINC_MASK (3U << 4U)
+#define ADIV5_AP_CSW_ADDRINC_NONE (0U << 4U)
+#define ADIV5_AP_CSW_ADDRINC_SINGLE (1U << 4U)
+#define ADIV5_AP_CSW_SIZE_MASK (7U << 0U)
+#define ADIV5_AP_CSW_SIZE_BYTE (0U << 0U)
+#define ADIV5_AP_CSW_SIZE_HALFWORD (1U << 0U)
+#define ADIV5_AP_CSW_SIZE_WORD (2U << 0U)
+
+#define ADIV5_LOW_WRITE 0U
+#define ADIV5_LOW_READ 1U
+
+#define SWDP_ACK_OK 0x01U
+#define SWDP_ACK_WAIT 0x02U
+#define SWDP_ACK_FAULT 0x04U
+#define SWDP_ACK_NO_RESPONSE 0x07U
+
+typedef enum align
+{
+    ALIGN_8BIT,
+    ALIGN_16BIT,
+    ALIGN_32BIT,
+    ALIGN_64BIT,
+} align_e;
+
+#define ALIGNOF(x) (((x)&3U) == 0 ? ALIGN_32BIT : (((x)&1U) == 0 ? ALIGN_16BIT : ALIGN_8BIT))
+/* Returns the minimum alignment of two addresses */
+#define MIN_ALIGN(x, y) MIN(ALIGNOF(x), ALIGNOF(y))
+
+typedef struct adiv5_debug_port adiv5_debug_port_s;
+typedef struct adiv5_access_port adiv5_access_port_s;
+
+struct adiv5_debug_port
+{
+    int refcnt;
+    uint32_t fault;
+    uint32_t debug_port_id;
+    uint32_t select;
+
+    uint32_t (*dp_read)(adiv5_debug_port_s *dp, uint16_t addr);
+    uint32_t (*error)(adiv5_debug_port_s *dp, bool protocol_recovery);
+    uint32_t (*low_access)(adiv5_debug_port_s *dp, uint8_t rnw, uint16_t addr, uint32_t value);
+    void (*abort)(adiv5_debug_port_s *dp, uint32_t abort);
+
+    uint32_t (*ap_read)(adiv5_access_port_s *ap, uint16_t addr);
+    void (*ap_write)(adiv5_access_port_s *ap, uint16_t addr, uint32_t value);
+    void (*mem_read)(adiv5_access_port_s *ap, void *dest, target_addr_t src, size_t len);
+    void (*mem_write)(adiv5_access_port_s *ap, target_addr_t dest, const void *src, size_t len, align_e align);
+};
+
+struct adiv5_access_port
+{
+    int refcnt;
+    adiv5_debug_port_s *dp;
+    uint8_t apsel;
+    uint32_t idr;
+    uint32_t base;
+    uint32_t csw;
+};
+
+static inline uint32_t adiv5_dp_read(adiv5_debug_port_s *dp, uint16_t addr)
+{
+    return dp->dp_read(dp, addr);
+}
+
+static inline void adiv5_dp_write(adiv5_debug_port_s *dp, uint16_t addr, uint32_t value)
+{
+    dp->low_access(dp, ADIV5_LOW_WRITE, addr, value);
+}
+
+static inline uint32_t adiv5_ap_read(adiv5_access_port_s *ap, uint16_t addr)
+{
+    return ap->dp->ap_read(ap, addr);
+}
+
+static inline void adiv5_ap_write(adiv5_access_port_s *ap, uint16_t addr, uint32_t value)
+{
+    ap->dp->ap_write(ap, addr, value);
+}
+
+static inline uint32_t adiv5_dp_error(adiv5_debug_port_s *dp)
+{
+    return dp->error(dp, false);
+}
+
+static inline void adiv5_mem_read(adiv5_access_port_s *ap, void *dest, target_addr_t src, size_t len)
+{
+    ap->dp->mem_read(ap, dest, src, len);
+}
+
+static inline void adiv5_mem_write(adiv5_access_port_s *ap, target_addr_t dest, const void *src, size_t len)
+{
+    ap->dp->mem_write(ap, dest, src, len, MIN_ALIGN(dest, len));
+}
+
+/**
+ * Set up an SWD DP with the stock accessors of adiv5_swd.c and its AP
+ * @param dp
+ * @param ap
+ * @return bool false if DPIDR could not be read
+ */
+bool adiv5_swd_dp_init(adiv5_debug_port_s *dp, adiv5_access_port_s *ap);
+
+/**
+ * Line reset and JTAG-to-SWD switch, as adiv5_swd_scan() starts
+ */
+void adiv5_swd_line_reset(void);
@@ -0,0 +1,336 @@
+#include <stdlib.h>
+#include "general.h"
+#include "exception.h"
+#include "swd.h"
+#include "target.h"
+#include "target_internal.h"
+#include "adiv5.h"
+
+/*
+ * SW-DP and MEM-AP access as upstream adiv5_swd.c and adiv5.c do it on
+ * firmware probes: every transfer goes through low_access(), which retries
+ * WAIT for 250 ms, records FAULT and NO_RESPONSE in dp->fault, raises on an
+ * invalid ACK or a read parity error and clocks 8 idle cycles after each
+ * write. AP accesses write SELECT first. These are the "stock accessors"
+ * that adiv5-queue.c batches and falls back to.
+ */
+
+#define ADIV5_SWD_WAIT_TIMEOUT_MS 250U
+#define ADIV5_SWD_TO_JTAG_SELECT 0xe79eU
+#define ADIV5_SWD_POWER_UP_TRIES 100U
+
+swd_proc_s swd_proc;
+
+void cortexm_probe(adiv5_access_port_s *ap);
+
+static inline uint32_t adiv5_swd_parity(uint32_t value)
+{
+    value ^= value >> 16U;
+    value ^= value >> 8U;
+    value ^= value >> 4U;
+    return (0x6996U >> (value & 0xfU)) & 1U;
+}
+
+/* Start, APnDP, RnW, A[3:2], parity, stop, park */
+static uint8_t adiv5_swd_request(uint8_t rnw, uint16_t addr)
+{
+    uint8_t request = 0x81U;
+    if (addr & ADIV5_APnDP)
+        request |= 0x02U;
+    if (rnw)
+        request |= 0x04U;
+    request |= (uint8_t)((addr & 0x0cU) << 1U);
+    return request | (uint8_t)(adiv5_swd_parity(request & 0x1eU) << 5U);
+}
+
+void adiv5_swd_line_reset(void)
+{
+    /* Line reset, JTAG-to-SWD select, line reset and idle cycles */
+    swd_proc.seq_out(0xffffffffU, 32U);
+    swd_proc.seq_out(0xffffffffU, 28U);
+    swd_proc.seq_out(ADIV5_SWD_TO_JTAG_SELECT, 16U);
+    swd_proc.seq_out(0xffffffffU, 32U);
+    swd_proc.seq_out(0x0fffffffU, 32U);
+}
+
+static uint32_t adiv5_swd_low_access(adiv5_debug_port_s *dp, uint8_t rnw, uint16_t addr, uint32_t value)
+{
+    if ((addr & ADIV5_APnDP) && dp->fault)
+        return 0;
+
+    const uint8_t request = adiv5_swd_request(rnw, addr);
+    uint32_t response = 0;
+    uint8_t ack;
+    platform_timeout_s timeout;
+    platform_timeout_set(&timeout, ADIV5_SWD_WAIT_TIMEOUT_MS);
+    do
+    {
+        swd_proc.seq_out(request, 8U);
+        ack = (uint8_t)swd_proc.seq_in(3U);
+    } while (ack == SWDP_ACK_WAIT && !platform_timeout_is_expired(&timeout));
+
+    if (ack == SWDP_ACK_WAIT)
+    {
+        dp->abort(dp, ADIV5_DP_ABORT_DAPABORT);
+        dp->fault = ack;
+        return 0;
+    }
+    if (ack == SWDP_ACK_FAULT || ack == SWDP_ACK_NO_RESPONSE)
+    {
+        dp->fault = ack;
+        return 0;
+    }
+    if (ack != SWDP_ACK_OK)
+        raise_exception(EXCEPTION_ERROR, "SWD invalid ACK");
+
+    if (rnw)
+    {
+        if (swd_proc.seq_in_parity(&response, 32U))
+        {
+            dp->fault = 1U;
+            raise_exception(EXCEPTION_ERROR, "SWD parity error");
+        }
+    }
+    else
+    {
+        swd_proc.seq_out_parity(value, 32U);
+        swd_proc.seq_out(0, 8U);
+    }
+    return response;
+}
+
+static uint32_t adiv5_swd_dp_read(adiv5_debug_port_s *dp, uint16_t addr)
+{
+    if (addr & ADIV5_APnDP)
+    {
+        adiv5_swd_low_access(dp, ADIV5_LOW_READ, addr, 0);
+        return adiv5_swd_low_access(dp, ADIV5_LOW_READ, ADIV5_DP_RDBUFF, 0);
+    }
+    return adiv5_swd_low_access(dp, ADIV5_LOW_READ, addr, 0);
+}
+
+static void adiv5_swd_abort(adiv5_debug_port_s *dp, uint32_t abort)
+{
+    (void)dp;
+    /* Written whatever the ACK, the DP may be stuck in WAIT */
+    swd_proc.seq_out(adiv5_swd_request(ADIV5_LOW_WRITE, ADIV5_DP_ABORT), 8U);
+    swd_proc.seq_in(3U);
+    swd_proc.seq_out_parity(abort, 32U);
+}
+
+static uint32_t adiv5_swd_error(adiv5_debug_port_s *dp, bool protocol_recovery)
+{
+    if (protocol_recovery)
+    {
+        adiv5_swd_line_reset();
+        adiv5_dp_read(dp, ADIV5_DP_DPIDR);
+    }
+    const uint32_t fault = dp->fault;
+    dp->fault = 0;
+    const uint32_t err = adiv5_dp_read(dp, ADIV5_DP_CTRLSTAT) &
+        (ADIV5_DP_CTRLSTAT_STICKYORUN | ADIV5_DP_CTRLSTAT_STICKYCMP | ADIV5_DP_CTRLSTAT_STICKYERR |
+            ADIV5_DP_CTRLSTAT_WDATAERR);
+    uint32_t clr = 0;
+    if (err & ADIV5_DP_CTRLSTAT_STICKYORUN)
+        clr |= ADIV5_DP_ABORT_ORUNERRCLR;
+    if (err & ADIV5_DP_CTRLSTAT_STICKYCMP)
+        clr |= ADIV5_DP_ABORT_STKCMPCLR;
+    if (err & ADIV5_DP_CTRLSTAT_STICKYERR)
+        clr |= ADIV5_DP_ABORT_STKERRCLR;
+    if (err & ADIV5_DP_CTRLSTAT_WDATAERR)
+        clr |= ADIV5_DP_ABORT_WDERRCLR;
+    if (clr)
+        adiv5_dp_write(dp, ADIV5_DP_ABORT, clr);
+    dp->fault = 0;
+    return err | fault;
+}
+
+static void adiv5_swd_select(adiv5_access_port_s *ap, uint16_t addr)
+{
+    adiv5_dp_write(ap->dp, ADIV5_DP_SELECT, ((uint32_t)ap->apsel << 24U) | (addr & 0xf0U));
+}
+
+static uint32_t adiv5_swd_ap_read(adiv5_access_port_s *ap, uint16_t addr)
+{
+    adiv5_swd_select(ap, addr);
+    return adiv5_dp_read(ap->dp, addr);
+}
+
+static void adiv5_swd_ap_write(adiv5_access_port_s *ap, uint16_t addr, uint32_t value)
+{
+    adiv5_swd_select(ap, addr);
+    adiv5_dp_write(ap->dp, addr, value);
+}
+
+static void adiv5_swd_mem_access_setup(adiv5_access_port_s *ap, target_addr_t addr, align_e align)
+{
+    uint32_t csw = ap->csw | ADIV5_AP_CSW_ADDRINC_SINGLE;
+    switch (align)
+    {
+    case ALIGN_8BIT:
+        csw |= ADIV5_AP_CSW_SIZE_BYTE;
+        break;
+    case ALIGN_16BIT:
+        csw |= ADIV5_AP_CSW_SIZE_HALFWORD;
+        break;
+    default:
+        csw |= ADIV5_AP_CSW_SIZE_WORD;
+        break;
+    }
+    adiv5_ap_write(ap, ADIV5_AP_CSW, csw);
+    adiv5_dp_write(ap->dp, ADIV5_AP_TAR, addr);
+}
+
+/* Byte lanes of a read follow the low address bits */
+static uint8_t *adiv5_swd_extract(uint8_t *dest, target_addr_t src, uint32_t value, align_e align)
+{
+    switch (align)
+    {
+    case ALIGN_8BIT:
+        *dest = (uint8_t)(value >> ((src & 3U) << 3U));
+        return dest + 1U;
+    case ALIGN_16BIT:
+    {
+        const uint16_t half = (uint16_t)(value >> ((src & 2U) << 3U));
+        memcpy(dest, &half, sizeof(half));
+        return dest + 2U;
+    }
+    default:
+        memcpy(dest, &value, sizeof(value));
+        return dest + 4U;
+    }
+}
+
+static const uint8_t *adiv5_swd_pack(target_addr_t dest, const uint8_t *src, uint32_t *value, align_e align)
+{
+    switch (align)
+    {
+    case ALIGN_8BIT:
+        *value = (uint32_t)*src << ((dest & 3U) << 3U);
+        return src + 1U;
+    case ALIGN_16BIT:
+    {
+        uint16_t half;
+        memcpy(&half, src, sizeof(half));
+        *value = (uint32_t)half << ((dest & 2U) << 3U);
+        return src + 2U;
+    }
+    default:
+        memcpy(value, src, sizeof(*value));
+        return src + 4U;
+    }
+}
+
+static void adiv5_swd_mem_read(adiv5_access_port_s *ap, void *dest, target_addr_t src, size_t len)
+{
+    if (len == 0)
+        return;
+    const align_e align = MIN_ALIGN(src, len);
+    uint8_t *data = dest;
+    target_addr_t osrc = src;
+    len >>= align;
+
+    adiv5_swd_mem_access_setup(ap, src, align);
+    adiv5_swd_low_access(ap->dp, ADIV5_LOW_READ, ADIV5_AP_DRW, 0);
+    while (--len)
+    {
+        const uint32_t value = adiv5_swd_low_access(ap->dp, ADIV5_LOW_READ, ADIV5_AP_DRW, 0);
+        data = adiv5_swd_extract(data, src, value, align);
+        src += 1U << align;
+        /* TAR only auto-increments inside 1 KiB */
+        if ((src ^ osrc) & 0xfffffc00U)
+        {
+            osrc = src;
+            adiv5_swd_low_access(ap->dp, ADIV5_LOW_WRITE, ADIV5_AP_TAR, src);
+            adiv5_swd_low_access(ap->dp, ADIV5_LOW_READ, ADIV5_AP_DRW, 0);
+        }
+    }
+    const uint32_t value = adiv5_swd_low_access(ap->dp, ADIV5_LOW_READ, ADIV5_DP_RDBUFF, 0);
+    adiv5_swd_extract(data, src, value, align);
+}
+
+static void adiv5_swd_mem_write(adiv5_access_port_s *ap, target_addr_t dest, const void *src, size_t len, align_e align)
+{
+    const uint8_t *data = src;
+    target_addr_t odest = dest;
+    len >>= align;
+
+    adiv5_swd_mem_access_setup(ap, dest, align);
+    while (len--)
+    {
+        uint32_t value = 0;
+        data = adiv5_swd_pack(dest, data, &value, align);
+        adiv5_dp_write(ap->dp, ADIV5_AP_DRW, value);
+        dest += 1U << align;
+        if ((dest ^ odest) & 0xfffffc00U)
+        {
+            odest = dest;
+            adiv5_dp_write(ap->dp, ADIV5_AP_TAR, dest);
+        }
+    }
+    /* Make sure the last write completed */
+    adiv5_dp_read(ap->dp, ADIV5_DP_RDBUFF);
+}
+
+bool adiv5_swd_dp_init(adiv5_debug_port_s *dp, adiv5_access_port_s *ap)
+{
+    dp->dp_read = adiv5_swd_dp_read;
+    dp->error = adiv5_swd_error;
+    dp->low_access = adiv5_swd_low_access;
+    dp->abort = adiv5_swd_abort;
+    dp->ap_read = adiv5_swd_ap_read;
+    dp->ap_write = adiv5_swd_ap_write;
+    dp->mem_read = adiv5_swd_mem_read;
+    dp->mem_write = adiv5_swd_mem_write;
+    dp->fault = 0;
+    ap->dp = dp;
+    ap->apsel = 0;
+
+    bool ok = false;
+    TRY (EXCEPTION_ALL)
+    {
+        dp->debug_port_id = adiv5_dp_read(dp, ADIV5_DP_DPIDR);
+        if (dp->fault == 0)
+        {
+            adiv5_dp_write(dp, ADIV5_DP_CTRLSTAT, ADIV5_DP_CTRLSTAT_CDBGPWRUPREQ | ADIV5_DP_CTRLSTAT_CSYSPWRUPREQ);
+            for (size_t tries = 0; tries < ADIV5_SWD_POWER_UP_TRIES && !ok; tries++)
+            {
+                const uint32_t ctrlstat = adiv5_dp_read(dp, ADIV5_DP_CTRLSTAT);
+                ok = (ctrlstat & (ADIV5_DP_CTRLSTAT_CDBGPWRUPACK | ADIV5_DP_CTRLSTAT_CSYSPWRUPACK)) ==
+                    (ADIV5_DP_CTRLSTAT_CDBGPWRUPACK | ADIV5_DP_CTRLSTAT_CSYSPWRUPACK);
+            }
+        }
+        if (ok)
+        {
+            ap->idr = adiv5_ap_read(ap, ADIV5_AP_IDR);
+            ap->csw = adiv5_ap_read(ap, ADIV5_AP_CSW) & ~(ADIV5_AP_CSW_SIZE_MASK | ADIV5_AP_CSW_ADDRINC_MASK);
+            ok = ap->idr != 0 && dp->fault == 0;
+        }
+    }
+    CATCH ()
+    {
+    default:
+        ok = false;
+    }
+    return ok;
+}
+
+bool adiv5_swd_scan(void)
+{
+    target_list_free();
+    swdptap_init();
+    adiv5_swd_line_reset();
+
+    adiv5_debug_port_s *dp = calloc(1, sizeof(*dp));
+    adiv5_access_port_s *ap = calloc(1, sizeof(*ap));
+    if (dp == NULL || ap == NULL || !adiv5_swd_dp_init(dp, ap))
+    {
+        free(dp);
+        free(ap);
+        return false;
+    }
+    dp->refcnt = 1;
+    ap->refcnt = 1;
+    cortexm_probe(ap);
+    return target_list != NULL;
+}
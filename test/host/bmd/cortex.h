@@ -0,0 +1,28 @@
+#pragma once
+#include "adiv5.h"
+#include "target.h"
+
+#define CORTEXM_DHCSR 0xe000edf0U
+#define CORTEXM_DCRSR 0xe000edf4U
+#define CORTEXM_DCRDR 0xe000edf8U
+#define CORTEXM_DEMCR 0xe000edfcU
+#define CORTEXM_DFSR 0xe000ed30U
+#define CORTEXM_AIRCR 0xe000ed0cU
+
+#define CORTEXM_DHCSR_DBGKEY 0xa05f0000U
+#define CORTEXM_DHCSR_C_DEBUGEN (1U << 0U)
+#define CORTEXM_DHCSR_C_HALT (1U << 1U)
+#define CORTEXM_DHCSR_C_STEP (1U << 2U)
+#define CORTEXM_DHCSR_S_REGRDY (1U << 16U)
+#define CORTEXM_DHCSR_S_HALT (1U << 17U)
+#define CORTEXM_DHCSR_S_RESET_ST (1U << 25U)
+#define CORTEXM_DCRSR_REGWnR (1U << 16U)
+#define CORTEXM_DFSR_HALTED (1U << 0U)
+#define CORTEXM_DFSR_BKPT (1U << 1U)
+#define CORTEXM_AIRCR_VECTKEY (0x05faU << 16U)
+#define CORTEXM_AIRCR_SYSRESETREQ (1U << 2U)
+
+/* r0-r12, sp, lr, pc, xpsr */
+#define CORTEXM_GENERAL_REG_COUNT 17U
+
+adiv5_access_port_s *cortex_ap(target_s *target);
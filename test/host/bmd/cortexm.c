@@ -0,0 +1,240 @@
+#include <stdlib.h>
+#include "general.h"
+#include "exception.h"
+#include "target.h"
+#include "target_internal.h"
+#include "adiv5.h"
+#include "cortex.h"
+#include "swd-sim.h"
+
+/*
+ * Cortex-M target behind a MEM-AP, as upstream cortexm.c: memory through
+ * the AP, core registers through DCRSR/DCRDR, run control through DHCSR
+ * and DFSR, reset through AIRCR. Probing always finds the simulated part:
+ * its RAM, and flash driven through the controller in swd-sim.h.
+ */
+
+typedef struct
+{
+    adiv5_access_port_s *ap;
+    bool stepping;
+    target_flash_s flash;
+} cortexm_priv_s;
+
+adiv5_access_port_s *cortex_ap(target_s *target)
+{
+    return target->priv != NULL ? ((cortexm_priv_s *)target->priv)->ap : NULL;
+}
+
+static void cortexm_mem_read(target_s *target, void *dest, target_addr_t src, size_t len)
+{
+    adiv5_mem_read(cortex_ap(target), dest, src, len);
+}
+
+static void cortexm_mem_write(target_s *target, target_addr_t dest, const void *src, size_t len)
+{
+    adiv5_mem_write(cortex_ap(target), dest, src, len);
+}
+
+static bool cortexm_check_error(target_s *target)
+{
+    return adiv5_dp_error(cortex_ap(target)->dp) != 0;
+}
+
+static uint32_t cortexm_read32(target_s *target, target_addr_t addr)
+{
+    uint32_t value = 0;
+    cortexm_mem_read(target, &value, addr, sizeof(value));
+    return value;
+}
+
+static void cortexm_write32(target_s *target, target_addr_t addr, uint32_t value)
+{
+    cortexm_mem_write(target, addr, &value, sizeof(value));
+}
+
+static void cortexm_priv_free(void *priv)
+{
+    adiv5_access_port_s *ap = ((cortexm_priv_s *)priv)->ap;
+    if (--ap->dp->refcnt == 0)
+        free(ap->dp);
+    if (--ap->refcnt == 0)
+        free(ap);
+    free(priv);
+}
+
+static size_t cortexm_reg_read(target_s *target, uint32_t reg, void *data, size_t max)
+{
+    if (reg >= CORTEXM_GENERAL_REG_COUNT || max < 4U)
+        return 0;
+    cortexm_write32(target, CORTEXM_DCRSR, reg);
+    const uint32_t value = cortexm_read32(target, CORTEXM_DCRDR);
+    memcpy(data, &value, sizeof(value));
+    return sizeof(value);
+}
+
+static size_t cortexm_reg_write(target_s *target, uint32_t reg, const void *data, size_t size)
+{
+    if (reg >= CORTEXM_GENERAL_REG_COUNT || size < 4U)
+        return 0;
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    cortexm_write32(target, CORTEXM_DCRDR, value);
+    cortexm_write32(target, CORTEXM_DCRSR, CORTEXM_DCRSR_REGWnR | reg);
+    return sizeof(value);
+}
+
+static void cortexm_regs_read(target_s *target, void *data)
+{
+    uint8_t *regs = data;
+    for (uint32_t reg = 0; reg < CORTEXM_GENERAL_REG_COUNT; reg++)
+        cortexm_reg_read(target, reg, regs + reg * 4U, 4U);
+}
+
+static void cortexm_regs_write(target_s *target, const void *data)
+{
+    const uint8_t *regs = data;
+    for (uint32_t reg = 0; reg < CORTEXM_GENERAL_REG_COUNT; reg++)
+        cortexm_reg_write(target, reg, regs + reg * 4U, 4U);
+}
+
+/* The M-profile core registers, in the order of the 'g' packet */
+static const char *cortexm_regs_description(target_s *target)
+{
+    (void)target;
+    static const char *const names[CORTEXM_GENERAL_REG_COUNT] = {
+        "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7", "r8", "r9", "r10", "r11", "r12", "sp", "lr", "pc", "xpsr"};
+    const size_t size = 1024U;
+    char *description = malloc(size);
+    if (description == NULL)
+        return NULL;
+
+    size_t offset = (size_t)snprintf(description, size,
+                                     "<?xml version=\"1.0\"?><!DOCTYPE target SYSTEM \"gdb-target.dtd\"><target>"
+                                     "<architecture>arm</architecture><feature name=\"org.gnu.gdb.arm.m-profile\">");
+    for (size_t reg = 0; reg < CORTEXM_GENERAL_REG_COUNT; reg++)
+        offset += (size_t)snprintf(description + offset, size - offset, "<reg name=\"%s\" bitsize=\"32\"/>", names[reg]);
+    snprintf(description + offset, size - offset, "</feature></target>");
+    return description;
+}
+
+static void cortexm_reset(target_s *target)
+{
+    cortexm_write32(target, CORTEXM_AIRCR, CORTEXM_AIRCR_VECTKEY | CORTEXM_AIRCR_SYSRESETREQ);
+    target_check_error(target);
+}
+
+static void cortexm_halt_request(target_s *target)
+{
+    cortexm_write32(target, CORTEXM_DHCSR, CORTEXM_DHCSR_DBGKEY | CORTEXM_DHCSR_C_HALT | CORTEXM_DHCSR_C_DEBUGEN);
+    target_check_error(target);
+}
+
+static target_halt_reason_e cortexm_halt_poll(target_s *target, target_addr_t *watch)
+{
+    (void)watch;
+    cortexm_priv_s *priv = target->priv;
+    const uint32_t dhcsr = cortexm_read32(target, CORTEXM_DHCSR);
+    if (target_check_error(target))
+        return TARGET_HALT_ERROR;
+    if (!(dhcsr & CORTEXM_DHCSR_S_HALT))
+        return TARGET_HALT_RUNNING;
+
+    const uint32_t dfsr = cortexm_read32(target, CORTEXM_DFSR);
+    cortexm_write32(target, CORTEXM_DFSR, dfsr);
+    if (dfsr & CORTEXM_DFSR_BKPT)
+        return TARGET_HALT_BREAKPOINT;
+    if (priv->stepping)
+        return TARGET_HALT_STEPPING;
+    return TARGET_HALT_REQUEST;
+}
+
+static void cortexm_halt_resume(target_s *target, bool step)
+{
+    cortexm_priv_s *priv = target->priv;
+    priv->stepping = step;
+    cortexm_write32(target, CORTEXM_DHCSR,
+        CORTEXM_DHCSR_DBGKEY | CORTEXM_DHCSR_C_DEBUGEN | (step ? CORTEXM_DHCSR_C_STEP : 0U));
+    target_check_error(target);
+}
+
+static bool cortexm_flash_unlock(target_flash_s *flash)
+{
+    target_s *target = flash->t;
+    cortexm_write32(target, SWD_SIM_FLASH_KEYR, SWD_SIM_FLASH_KEY1);
+    cortexm_write32(target, SWD_SIM_FLASH_KEYR, SWD_SIM_FLASH_KEY2);
+    return !target_check_error(target) && !(cortexm_read32(target, SWD_SIM_FLASH_CR) & SWD_SIM_FLASH_CR_LOCK);
+}
+
+static bool cortexm_flash_erase(target_flash_s *flash, target_addr_t addr, size_t len)
+{
+    target_s *target = flash->t;
+    for (target_addr_t page = addr; page < addr + len; page += flash->blocksize)
+    {
+        cortexm_write32(target, SWD_SIM_FLASH_CR, SWD_SIM_FLASH_CR_PER);
+        cortexm_write32(target, SWD_SIM_FLASH_AR, page);
+        cortexm_write32(target, SWD_SIM_FLASH_CR, SWD_SIM_FLASH_CR_PER | SWD_SIM_FLASH_CR_STRT);
+        if (!(cortexm_read32(target, SWD_SIM_FLASH_SR) & SWD_SIM_FLASH_SR_EOP))
+            return false;
+        cortexm_write32(target, SWD_SIM_FLASH_SR, SWD_SIM_FLASH_SR_EOP);
+    }
+    return !target_check_error(target);
+}
+
+static bool cortexm_flash_write(target_flash_s *flash, target_addr_t dest, const void *src, size_t len)
+{
+    target_s *target = flash->t;
+    cortexm_write32(target, SWD_SIM_FLASH_CR, SWD_SIM_FLASH_CR_PG);
+    cortexm_mem_write(target, dest, src, len);
+    cortexm_write32(target, SWD_SIM_FLASH_CR, 0);
+    return !target_check_error(target);
+}
+
+static bool cortexm_flash_done(target_flash_s *flash)
+{
+    cortexm_write32(flash->t, SWD_SIM_FLASH_CR, SWD_SIM_FLASH_CR_LOCK);
+    return !target_check_error(flash->t);
+}
+
+void cortexm_probe(adiv5_access_port_s *ap)
+{
+    target_s *target = target_new();
+    cortexm_priv_s *priv = calloc(1, sizeof(*priv));
+    if (target == NULL || priv == NULL)
+    {
+        free(priv);
+        return;
+    }
+
+    priv->ap = ap;
+    target->priv = priv;
+    target->priv_free = cortexm_priv_free;
+    target->driver = "Simulated Cortex-M";
+    target->regs_size = CORTEXM_GENERAL_REG_COUNT * 4U;
+    target->mem_read = cortexm_mem_read;
+    target->mem_write = cortexm_mem_write;
+    target->check_error = cortexm_check_error;
+    target->regs_read = cortexm_regs_read;
+    target->regs_write = cortexm_regs_write;
+    target->reg_read = cortexm_reg_read;
+    target->reg_write = cortexm_reg_write;
+    target->regs_description = cortexm_regs_description;
+    target->reset = cortexm_reset;
+    target->halt_request = cortexm_halt_request;
+    target->halt_poll = cortexm_halt_poll;
+    target->halt_resume = cortexm_halt_resume;
+
+    target_add_ram32(target, SWD_SIM_RAM_BASE, SWD_SIM_RAM_SIZE);
+
+    target_flash_s *flash = &priv->flash;
+    flash->start = SWD_SIM_FLASH_BASE;
+    flash->length = SWD_SIM_FLASH_SIZE;
+    flash->blocksize = SWD_SIM_FLASH_PAGE;
+    flash->writesize = 4U;
+    flash->erased = 0xffU;
+    flash->prepare = cortexm_flash_unlock;
+    flash->erase = cortexm_flash_erase;
+    flash->write = cortexm_flash_write;
+    flash->done = cortexm_flash_done;
+    target_add_flash(target, flash);
+}
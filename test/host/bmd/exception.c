@@ -0,0 +1,22 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "general.h"
+#include "exception.h"
+
+exception_s *innermost_exception;
+
+void raise_exception(uint32_t type, const char *msg)
+{
+    for (exception_s *exception = innermost_exception; exception != NULL; exception = exception->outer)
+    {
+        if (exception->mask & type)
+        {
+            exception->type = type;
+            exception->msg = msg;
+            innermost_exception = exception->outer;
+            longjmp(exception->jmpbuf, (int)type);
+        }
+    }
+    fprintf(stderr, "Unhandled exception: %s\n", msg);
+    abort();
+}
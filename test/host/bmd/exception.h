@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+#include <setjmp.h>
+
+/* Exception frames as in upstream exception.h */
+
+#define EXCEPTION_ERROR 0x01U
+#define EXCEPTION_TIMEOUT 0x02U
+#define EXCEPTION_ALL (-1)
+
+typedef struct exception exception_s;
+
+struct exception
+{
+    uint32_t type;
+    const char *msg;
+    /* private */
+    uint32_t mask;
+    jmp_buf jmpbuf;
+    exception_s *outer;
+};
+
+extern exception_s *innermost_exception;
+
+void raise_exception(uint32_t type, const char *msg) __attribute__((noreturn));
+
+#define TRY(type_mask)                                                      \
+    exception_s exception_frame;                                        \
+    exception_frame.type = 0;                                           \
+    exception_frame.mask = (type_mask);                                    \
+    exception_frame.outer = innermost_exception;                        \
+    innermost_exception = &exception_frame;                             \
+    if (setjmp(exception_frame.jmpbuf) == 0)                            \
+        for (; innermost_exception == &exception_frame; innermost_exception = exception_frame.outer)
+
+#define CATCH()                  \
+    if (exception_frame.type)    \
+        switch (exception_frame.type)
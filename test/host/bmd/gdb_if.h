@@ -0,0 +1,6 @@
+#pragma once
+
+int gdb_if_init(void);
+unsigned char gdb_if_getchar(void);
+unsigned char gdb_if_getchar_to(int timeout);
+void gdb_if_putchar(unsigned char c, int flush);
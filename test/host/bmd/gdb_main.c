@@ -0,0 +1,345 @@
+#include <alloca.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "general.h"
+#include "target.h"
+#include "target_internal.h"
+#include "gdb_main.h"
+#include "gdb_packet.h"
+#include "hex_utils.h"
+
+/*
+ * The packet handlers of upstream gdb_main.c that the platform code and
+ * the host tests exercise, with the same replies and the same buffers: m
+ * and g hexify through hexify(), M unhexifies into an alloca() buffer of
+ * half the packet, run control leaves gdb_target_running set until
+ * gdb_poll_target() reports the stop. Monitor commands: "swd_scan".
+ */
+
+#define GDB_SIGINT 2
+#define GDB_SIGTRAP 5
+#define GDB_SIGLOST 29
+
+bool gdb_target_running = false;
+target_s *cur_target = NULL;
+
+static void gdb_main_hex_reply(const void *data, size_t size)
+{
+    gdb_putpacket(NULL, 0, data, size, true);
+}
+
+static void gdb_main_read_memory(const char *packet)
+{
+    uint32_t addr;
+    uint32_t len;
+    if (sscanf(packet, "m%" SCNx32 ",%" SCNx32, &addr, &len) != 2)
+    {
+        gdb_putpacket_str("EFF");
+        return;
+    }
+    if (len > GDB_PACKET_BUFFER_SIZE / 2U)
+    {
+        gdb_putpacket_str("E02");
+        return;
+    }
+    uint8_t *mem = alloca(len);
+    if (cur_target == NULL || target_mem32_read(cur_target, mem, addr, len))
+        gdb_putpacket_str("E01");
+    else
+        gdb_main_hex_reply(mem, len);
+}
+
+static void gdb_main_write_memory(const char *packet, size_t size)
+{
+    uint32_t addr;
+    uint32_t len;
+    int offset = 0;
+    if (sscanf(packet, "M%" SCNx32 ",%" SCNx32 ":%n", &addr, &len, &offset) != 2 || offset == 0 ||
+        len > (size - (size_t)offset) / 2U)
+    {
+        gdb_putpacket_str("EFF");
+        return;
+    }
+    uint8_t *mem = alloca(len);
+    unhexify(mem, packet + offset, len);
+    if (cur_target == NULL || target_mem32_write(cur_target, addr, mem, len))
+        gdb_putpacket_str("E01");
+    else
+        gdb_putpacket_str("OK");
+}
+
+static void gdb_main_write_binary(const char *packet, size_t size)
+{
+    uint32_t addr;
+    uint32_t len;
+    int offset = 0;
+    if (sscanf(packet, "X%" SCNx32 ",%" SCNx32 ":%n", &addr, &len, &offset) != 2 || offset == 0 ||
+        len > size - (size_t)offset)
+    {
+        gdb_putpacket_str("EFF");
+        return;
+    }
+    if (cur_target == NULL || (len > 0 && target_mem32_write(cur_target, addr, packet + offset, len)))
+        gdb_putpacket_str("E01");
+    else
+        gdb_putpacket_str("OK");
+}
+
+static void gdb_main_registers(const char *packet, size_t size)
+{
+    if (cur_target == NULL)
+    {
+        gdb_putpacket_str("EFF");
+        return;
+    }
+    const size_t regs_size = target_regs_size(cur_target);
+    uint8_t *regs = alloca(regs_size);
+    if (packet[0] == 'g')
+    {
+        target_regs_read(cur_target, regs);
+        gdb_main_hex_reply(regs, regs_size);
+        return;
+    }
+    if (size - 1U < regs_size * 2U)
+    {
+        gdb_putpacket_str("EFF");
+        return;
+    }
+    unhexify(regs, packet + 1, regs_size);
+    target_regs_write(cur_target, regs);
+    gdb_putpacket_str("OK");
+}
+
+static void gdb_main_register(const char *packet)
+{
+    uint32_t reg;
+    uint8_t value[8];
+    if (cur_target == NULL)
+    {
+        gdb_putpacket_str("EFF");
+        return;
+    }
+    if (packet[0] == 'p')
+    {
+        const size_t size = sscanf(packet, "p%" SCNx32, &reg) == 1 ?
+            target_reg_read(cur_target, reg, value, sizeof(value)) :
+            0;
+        if (size == 0)
+            gdb_putpacket_str("EFF");
+        else
+            gdb_main_hex_reply(value, size);
+        return;
+    }
+    int offset = 0;
+    if (sscanf(packet, "P%" SCNx32 "=%n", &reg, &offset) != 1 || offset == 0 || strlen(packet + offset) != 8U)
+    {
+        gdb_putpacket_str("EFF");
+        return;
+    }
+    unhexify(value, packet + offset, 4U);
+    gdb_putpacket_str(target_reg_write(cur_target, reg, value, 4U) ? "OK" : "EFF");
+}
+
+static void gdb_main_resume(bool step)
+{
+    if (cur_target == NULL)
+    {
+        gdb_putpacket_str("X1D");
+        return;
+    }
+    target_halt_resume(cur_target, step);
+    gdb_target_running = true;
+}
+
+static void gdb_main_detach(void)
+{
+    if (cur_target != NULL)
+        target_detach(cur_target);
+    cur_target = NULL;
+    gdb_target_running = false;
+}
+
+static void gdb_main_monitor(const char *packet)
+{
+    char command[64];
+    const size_t hex_len = strlen(packet);
+    if (hex_len / 2U >= sizeof(command))
+    {
+        gdb_putpacket_str("EFF");
+        return;
+    }
+    unhexify(command, packet, hex_len / 2U);
+    command[hex_len / 2U] = '\0';
+
+    if (strcmp(command, "swd_scan") == 0)
+    {
+        gdb_main_detach();
+        if (!adiv5_swd_scan())
+        {
+            gdb_out("SWD scan failed!\n");
+            gdb_putpacket_str("EFF");
+            return;
+        }
+        gdb_outf("Available Targets:\n1 %s\n", target_driver_name(target_list));
+        gdb_putpacket_str("OK");
+        return;
+    }
+    gdb_putpacket_str("");
+}
+
+static void gdb_main_query(const char *packet)
+{
+    if (strncmp(packet, "qSupported", 10) == 0)
+        gdb_putpacket_f("PacketSize=%X;vContSupported+", GDB_PACKET_BUFFER_SIZE);
+    else if (strcmp(packet, "QStartNoAckMode") == 0)
+    {
+        gdb_putpacket_str("OK");
+        gdb_set_noackmode(true);
+    }
+    else if (strcmp(packet, "qC") == 0)
+        gdb_putpacket_str("QC1");
+    else if (strcmp(packet, "qAttached") == 0)
+        gdb_putpacket_str("1");
+    else if (strcmp(packet, "qfThreadInfo") == 0)
+        gdb_putpacket_str(cur_target != NULL ? "m1" : "l");
+    else if (strcmp(packet, "qsThreadInfo") == 0)
+        gdb_putpacket_str("l");
+    else if (strncmp(packet, "qRcmd,", 6) == 0)
+        gdb_main_monitor(packet + 6);
+    else
+        gdb_putpacket_str("");
+}
+
+static void gdb_main_v(const char *packet, size_t size)
+{
+    uint32_t addr;
+    uint32_t len;
+    int offset = 0;
+
+    if (strncmp(packet, "vAttach;", 8) == 0)
+    {
+        gdb_main_detach();
+        cur_target = target_attach_n(strtoul(packet + 8, NULL, 16), NULL);
+        gdb_putpacket_str(cur_target != NULL ? "T05thread:1;" : "E01");
+    }
+    else if (strcmp(packet, "vCont?") == 0)
+        gdb_putpacket_str("vCont;c;C;s;S;t");
+    else if (strncmp(packet, "vCont;c", 7) == 0 || strncmp(packet, "vCont;C", 7) == 0)
+        gdb_main_resume(false);
+    else if (strncmp(packet, "vCont;s", 7) == 0 || strncmp(packet, "vCont;S", 7) == 0)
+        gdb_main_resume(true);
+    else if (strcmp(packet, "vKill;1") == 0)
+    {
+        if (cur_target != NULL)
+            target_reset(cur_target);
+        gdb_main_detach();
+        gdb_putpacket_str("OK");
+    }
+    else if (sscanf(packet, "vFlashErase:%" SCNx32 ",%" SCNx32, &addr, &len) == 2)
+        gdb_putpacket_str(cur_target != NULL && !target_flash_erase(cur_target, addr, len) ? "OK" : "EFF");
+    else if (sscanf(packet, "vFlashWrite:%" SCNx32 ":%n", &addr, &offset) == 1 && offset > 0)
+    {
+        const size_t count = size - (size_t)offset;
+        gdb_putpacket_str(
+            cur_target != NULL && !target_flash_write(cur_target, addr, packet + offset, count) ? "OK" : "EFF");
+    }
+    else if (strcmp(packet, "vFlashDone") == 0)
+        gdb_putpacket_str(cur_target != NULL && !target_flash_complete(cur_target) ? "OK" : "EFF");
+    else
+        gdb_putpacket_str("");
+}
+
+void gdb_main(const gdb_packet_s *packet)
+{
+    const char *data = packet->data;
+    const size_t size = packet->size;
+
+    switch (data[0])
+    {
+    case '?':
+        gdb_putpacket_str(cur_target != NULL ? "S05" : "W00");
+        break;
+    case 'H':
+    case 'T':
+        gdb_putpacket_str("OK");
+        break;
+    case 'm':
+        gdb_main_read_memory(data);
+        break;
+    case 'M':
+        gdb_main_write_memory(data, size);
+        break;
+    case 'X':
+        gdb_main_write_binary(data, size);
+        break;
+    case 'g':
+    case 'G':
+        gdb_main_registers(data, size);
+        break;
+    case 'p':
+    case 'P':
+        gdb_main_register(data);
+        break;
+    case 'c':
+    case 'C':
+        gdb_main_resume(false);
+        break;
+    case 's':
+    case 'S':
+        gdb_main_resume(true);
+        break;
+    case 'D':
+        gdb_main_detach();
+        gdb_putpacket_str("OK");
+        break;
+    case '\x04':
+        gdb_main_detach();
+        break;
+    case 'k':
+        if (cur_target != NULL)
+            target_reset(cur_target);
+        gdb_main_detach();
+        break;
+    case 'q':
+    case 'Q':
+        gdb_main_query(data);
+        break;
+    case 'v':
+        gdb_main_v(data, size);
+        break;
+    case '\x03':
+        break;
+    default:
+        gdb_putpacket_str("");
+        break;
+    }
+}
+
+void gdb_poll_target(void)
+{
+    if (cur_target == NULL)
+    {
+        gdb_target_running = false;
+        return;
+    }
+
+    target_addr_t watch;
+    const target_halt_reason_e reason = target_halt_poll(cur_target, &watch);
+    if (reason == TARGET_HALT_RUNNING)
+        return;
+
+    gdb_target_running = false;
+    switch (reason)
+    {
+    case TARGET_HALT_ERROR:
+        gdb_putpacket_f("X%02X", GDB_SIGLOST);
+        gdb_main_detach();
+        break;
+    case TARGET_HALT_REQUEST:
+        gdb_putpacket_f("T%02Xthread:1;", GDB_SIGINT);
+        break;
+    default:
+        gdb_putpacket_f("T%02Xthread:1;", GDB_SIGTRAP);
+        break;
+    }
+}
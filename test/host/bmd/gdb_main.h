@@ -0,0 +1,9 @@
+#pragma once
+#include "target.h"
+#include "gdb_packet.h"
+
+extern bool gdb_target_running;
+extern target_s *cur_target;
+
+void gdb_main(const gdb_packet_s *packet);
+void gdb_poll_target(void);
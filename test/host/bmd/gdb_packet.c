@@ -0,0 +1,206 @@
+#include <stdarg.h>
+#include "general.h"
+#include "gdb_if.h"
+#include "gdb_packet.h"
+#include "hex_utils.h"
+
+/*
+ * Byte-wise RSP framing as in upstream gdb_packet.c: the receiver the
+ * platform framer falls back to, and the sender that gdb_main() replies
+ * through, one gdb_if_putchar() per byte with escapes and a checksum.
+ */
+
+#define GDB_PACKET_START '$'
+#define GDB_PACKET_END '#'
+#define GDB_PACKET_ACK '+'
+#define GDB_PACKET_NACK '-'
+#define GDB_PACKET_ESCAPE '}'
+#define GDB_PACKET_ESCAPE_XOR 0x20U
+#define GDB_PACKET_INTERRUPT '\x03'
+#define GDB_PACKET_EOT '\x04'
+#define GDB_PACKET_RETRIES 3U
+#define GDB_PACKET_ACK_TIMEOUT_MS 2000
+
+typedef enum
+{
+    PACKET_IDLE,
+    PACKET_CAPTURE,
+    PACKET_ESCAPE,
+    PACKET_CHECKSUM_UPPER,
+    PACKET_CHECKSUM_LOWER,
+} packet_state_e;
+
+static bool noackmode;
+static gdb_packet_s packet_buffer;
+
+void gdb_set_noackmode(bool enable)
+{
+    noackmode = enable;
+}
+
+gdb_packet_s *gdb_packet_receive(void)
+{
+    packet_state_e state = PACKET_IDLE;
+    gdb_packet_s *const packet = &packet_buffer;
+    uint8_t checksum = 0;
+    uint8_t expected = 0;
+
+    while (true)
+    {
+        const char c = (char)gdb_if_getchar();
+
+        switch (state)
+        {
+        case PACKET_IDLE:
+            if (c == GDB_PACKET_START)
+            {
+                packet->size = 0;
+                checksum = 0;
+                state = PACKET_CAPTURE;
+            }
+            else if (c == GDB_PACKET_INTERRUPT || c == GDB_PACKET_EOT)
+            {
+                packet->data[0] = c;
+                packet->data[1] = '\0';
+                packet->size = 1;
+                packet->notification = false;
+                return packet;
+            }
+            break;
+        case PACKET_CAPTURE:
+        case PACKET_ESCAPE:
+            if (c == GDB_PACKET_START)
+            {
+                packet->size = 0;
+                checksum = 0;
+                state = PACKET_CAPTURE;
+                break;
+            }
+            checksum += (uint8_t)c;
+            if (state == PACKET_CAPTURE && c == GDB_PACKET_END)
+            {
+                checksum -= (uint8_t)c;
+                state = PACKET_CHECKSUM_UPPER;
+                break;
+            }
+            if (state == PACKET_CAPTURE && c == GDB_PACKET_ESCAPE)
+            {
+                state = PACKET_ESCAPE;
+                break;
+            }
+            if (packet->size == GDB_PACKET_BUFFER_SIZE)
+            {
+                /* Overflow, drop the packet */
+                state = PACKET_IDLE;
+                break;
+            }
+            packet->data[packet->size++] = state == PACKET_ESCAPE ? (char)(c ^ GDB_PACKET_ESCAPE_XOR) : c;
+            state = PACKET_CAPTURE;
+            break;
+        case PACKET_CHECKSUM_UPPER:
+            expected = unhex_digit(c) << 4U;
+            state = PACKET_CHECKSUM_LOWER;
+            break;
+        case PACKET_CHECKSUM_LOWER:
+            expected |= unhex_digit(c);
+            if (noackmode || expected == checksum)
+            {
+                if (!noackmode)
+                    gdb_if_putchar(GDB_PACKET_ACK, 1);
+                packet->data[packet->size] = '\0';
+                packet->notification = false;
+                return packet;
+            }
+            gdb_if_putchar(GDB_PACKET_NACK, 1);
+            state = PACKET_IDLE;
+            break;
+        }
+    }
+}
+
+static uint8_t gdb_packet_put_escaped(const char *data, size_t size)
+{
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        const char c = data[i];
+        if (c == '$' || c == '#' || c == '}' || c == '*')
+        {
+            gdb_if_putchar(GDB_PACKET_ESCAPE, 0);
+            gdb_if_putchar((char)(c ^ GDB_PACKET_ESCAPE_XOR), 0);
+            checksum += GDB_PACKET_ESCAPE + (uint8_t)(c ^ GDB_PACKET_ESCAPE_XOR);
+        }
+        else
+        {
+            gdb_if_putchar(c, 0);
+            checksum += (uint8_t)c;
+        }
+    }
+    return checksum;
+}
+
+void gdb_putpacket(const char *preamble, size_t preamble_size, const char *data, size_t size, bool hexify_data)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    for (size_t tries = 0; tries < GDB_PACKET_RETRIES; ++tries)
+    {
+        gdb_if_putchar(GDB_PACKET_START, 0);
+        uint8_t checksum = 0;
+        if (preamble != NULL)
+            checksum += gdb_packet_put_escaped(preamble, preamble_size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            if (hexify_data)
+            {
+                const uint8_t byte = (uint8_t)data[i];
+                gdb_if_putchar(digits[byte >> 4U], 0);
+                gdb_if_putchar(digits[byte & 0xfU], 0);
+                checksum += digits[byte >> 4U] + digits[byte & 0xfU];
+            }
+            else
+                checksum += gdb_packet_put_escaped(data + i, 1);
+        }
+        gdb_if_putchar(GDB_PACKET_END, 0);
+        gdb_if_putchar(digits[checksum >> 4U], 0);
+        gdb_if_putchar(digits[checksum & 0xfU], 1);
+
+        if (noackmode || gdb_if_getchar_to(GDB_PACKET_ACK_TIMEOUT_MS) == GDB_PACKET_ACK)
+            return;
+    }
+}
+
+void gdb_putpacket_str(const char *str)
+{
+    gdb_putpacket(NULL, 0, str, strlen(str), false);
+}
+
+void gdb_putpacket_f(const char *fmt, ...)
+{
+    char buf[1024];
+    va_list ap;
+    va_start(ap, fmt);
+    const int size = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    gdb_putpacket(NULL, 0, buf, MIN((size_t)size, sizeof(buf) - 1U), false);
+}
+
+void gdb_out(const char *buf)
+{
+    gdb_putpacket("O", 1, buf, strlen(buf), true);
+}
+
+void gdb_voutf(const char *fmt, va_list ap)
+{
+    char buf[512];
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    gdb_out(buf);
+}
+
+void gdb_outf(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    gdb_voutf(fmt, ap);
+    va_end(ap);
+}
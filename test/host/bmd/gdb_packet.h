@@ -0,0 +1,25 @@
+#pragma once
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include "general.h"
+
+#ifndef GDB_PACKET_BUFFER_SIZE
+#define GDB_PACKET_BUFFER_SIZE 1024U
+#endif
+
+typedef struct gdb_packet
+{
+    char data[GDB_PACKET_BUFFER_SIZE + 1U];
+    size_t size;
+    bool notification;
+} gdb_packet_s;
+
+gdb_packet_s *gdb_packet_receive(void);
+void gdb_set_noackmode(bool enable);
+void gdb_putpacket(const char *preamble, size_t preamble_size, const char *data, size_t size, bool hexify);
+void gdb_putpacket_str(const char *str);
+void gdb_putpacket_f(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+void gdb_out(const char *buf);
+void gdb_voutf(const char *fmt, va_list ap);
+void gdb_outf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
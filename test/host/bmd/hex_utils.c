@@ -0,0 +1,43 @@
+#include "general.h"
+#include "hex_utils.h"
+
+/*
+ * Byte-wise conversions as in upstream hex_utils.c. The host build links
+ * them with --wrap like the firmware, so they are the __real_ side of
+ * hex-fast.c and the reference of its equivalence test.
+ */
+
+static const char hexdigits[] = "0123456789abcdef";
+
+char *hexify(char *const hex, const void *const buf, const size_t size)
+{
+    char *dst = hex;
+    const uint8_t *const src = buf;
+
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        *dst++ = hexdigits[src[idx] >> 4U];
+        *dst++ = hexdigits[src[idx] & 0xfU];
+    }
+    *dst = 0;
+    return hex;
+}
+
+uint8_t unhex_digit(const char hex)
+{
+    uint8_t tmp = hex - '0';
+    if (tmp > 9U)
+        tmp -= 'A' - '0' - 10U;
+    if (tmp > 16U)
+        tmp -= 'a' - 'A';
+    return tmp;
+}
+
+char *unhexify(void *const buf, const char *hex, const size_t size)
+{
+    uint8_t *const dst = buf;
+
+    for (size_t idx = 0; idx < size; ++idx, hex += 2U)
+        dst[idx] = (unhex_digit(hex[0]) << 4U) | unhex_digit(hex[1]);
+    return buf;
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+char *hexify(char *hex, const void *buf, size_t size);
+char *unhexify(void *buf, const char *hex, size_t size);
+uint8_t unhex_digit(char hex);
@@ -0,0 +1,279 @@
+#include "general.h"
+#include "timing.h"
+#include "jtagtap.h"
+
+/*
+ * The bit-bang JTAG tap as upstream jtagtap.c has it for firmware probes:
+ * TMS and TDI set through gpio_set_val() while TCK is low, TDO sampled
+ * while TCK is high, one platform GPIO call per pin and edge. This is the
+ * reference that jtag-gpio-tap.c replaces.
+ */
+
+jtag_proc_s jtag_proc;
+
+static void jtagtap_reset(void);
+static bool jtagtap_next(bool tms, bool tdi);
+static void jtagtap_tms_seq(uint32_t tms_states, size_t clock_cycles);
+static void jtagtap_tdi_tdo_seq(uint8_t *data_out, bool final_tms, const uint8_t *data_in, size_t clock_cycles);
+static void jtagtap_tdi_seq(bool final_tms, const uint8_t *data_in, size_t clock_cycles);
+static void jtagtap_cycle(bool tms, bool tdi, size_t clock_cycles);
+
+void jtagtap_init(void)
+{
+    TMS_SET_MODE();
+
+    jtag_proc.jtagtap_reset = jtagtap_reset;
+    jtag_proc.jtagtap_next = jtagtap_next;
+    jtag_proc.jtagtap_tms_seq = jtagtap_tms_seq;
+    jtag_proc.jtagtap_tdi_tdo_seq = jtagtap_tdi_tdo_seq;
+    jtag_proc.jtagtap_tdi_seq = jtagtap_tdi_seq;
+    jtag_proc.jtagtap_cycle = jtagtap_cycle;
+    jtag_proc.tap_idle_cycles = 1;
+
+    /* Ensure we're in JTAG mode */
+    for (size_t i = 0; i <= 50U; ++i)
+        jtagtap_next(true, false); /* 50 + 1 idle cycles for SWD reset */
+    jtagtap_tms_seq(0xe73cU, 16U); /* SWD to JTAG sequence */
+}
+
+/* jtagtap_soft_reset(): five TMS high cycles reach Test-Logic-Reset from any state */
+static void jtagtap_reset(void)
+{
+    jtag_proc.jtagtap_tms_seq(0x1fU, 6U);
+}
+
+static bool jtagtap_next_clk_delay(void)
+{
+    gpio_set(TCK_PORT, TCK_PIN);
+    for (volatile uint32_t counter = target_clk_divider; counter > 0; --counter)
+        continue;
+    const uint16_t result = gpio_get(TDO_PORT, TDO_PIN);
+    gpio_clear(TCK_PORT, TCK_PIN);
+    for (volatile uint32_t counter = target_clk_divider; counter > 0; --counter)
+        continue;
+    return result != 0;
+}
+
+static bool jtagtap_next_no_delay(void)
+{
+    gpio_set(TCK_PORT, TCK_PIN);
+    const uint16_t result = gpio_get(TDO_PORT, TDO_PIN);
+    gpio_clear(TCK_PORT, TCK_PIN);
+    return result != 0;
+}
+
+static bool jtagtap_next(const bool tms, const bool tdi)
+{
+    gpio_set_val(TMS_PORT, TMS_PIN, tms);
+    gpio_set_val(TDI_PORT, TDI_PIN, tdi);
+    if (target_clk_divider != UINT32_MAX)
+        return jtagtap_next_clk_delay();
+    return jtagtap_next_no_delay();
+}
+
+static void jtagtap_tms_seq_clk_delay(uint32_t tms_states, const size_t clock_cycles)
+{
+    for (size_t cycle = 0; cycle < clock_cycles; ++cycle)
+    {
+        const bool state = tms_states & 1U;
+        gpio_set_val(TMS_PORT, TMS_PIN, state);
+        gpio_set(TCK_PORT, TCK_PIN);
+        for (volatile uint32_t counter = target_clk_divider; counter > 0; --counter)
+            continue;
+        tms_states >>= 1U;
+        gpio_clear(TCK_PORT, TCK_PIN);
+        for (volatile uint32_t counter = target_clk_divider; counter > 0; --counter)
+            continue;
+    }
+}
+
+static void jtagtap_tms_seq_no_delay(uint32_t tms_states, const size_t clock_cycles)
+{
+    bool state = tms_states & 1U;
+    for (size_t cycle = 0; cycle < clock_cycles; ++cycle)
+    {
+        gpio_set_val(TMS_PORT, TMS_PIN, state);
+        gpio_set(TCK_PORT, TCK_PIN);
+        /* Block the compiler from re-ordering the TMS states calculation to preserve timings */
+        __asm__ volatile("" ::: "memory");
+        tms_states >>= 1U;
+        state = tms_states & 1U;
+        gpio_clear(TCK_PORT, TCK_PIN);
+    }
+}
+
+static void jtagtap_tms_seq(const uint32_t tms_states, const size_t clock_cycles)
+{
+    gpio_set(TDI_PORT, TDI_PIN);
+    if (target_clk_divider != UINT32_MAX)
+        jtagtap_tms_seq_clk_delay(tms_states, clock_cycles);
+    else
+        jtagtap_tms_seq_no_delay(tms_states, clock_cycles);
+}
+
+static void jtagtap_tdi_tdo_seq_clk_delay(
+    const uint8_t *const data_in, uint8_t *const data_out, const bool final_tms, const size_t clock_cycles)
+{
+    uint8_t value = 0;
+    for (size_t cycle = 0; cycle < clock_cycles;)
+    {
+        /* Calculate the next bit and byte to consume data from */
+        const uint8_t bit = cycle & 7U;
+        const size_t byte = cycle >> 3U;
+        /* On the last cycle, assert final_tms to TMS_PIN */
+        gpio_set_val(TMS_PORT, TMS_PIN, cycle + 1U >= clock_cycles && final_tms);
+        /* Set up the TDI pin and start the clock cycle */
+        gpio_set_val(TDI_PORT, TDI_PIN, data_in[byte] & (1U << bit));
+        gpio_set(TCK_PORT, TCK_PIN);
+        for (volatile uint32_t counter = target_clk_divider; counter > 0; --counter)
+            continue;
+        /* If TDO is high, store a 1 in the appropriate position in the value being accumulated */
+        if (gpio_get(TDO_PORT, TDO_PIN))
+            value |= 1U << bit;
+        if (bit == 7U)
+        {
+            data_out[byte] = value;
+            value = 0;
+        }
+        /* Finish the clock cycle */
+        gpio_clear(TCK_PORT, TCK_PIN);
+        for (volatile uint32_t counter = target_clk_divider; counter > 0; --counter)
+            continue;
+        ++cycle;
+    }
+    /* If clock_cycles is not divisible by 8, we have some extra data to write back here. */
+    if (clock_cycles & 7U)
+    {
+        const size_t byte = (clock_cycles - 1U) >> 3U;
+        data_out[byte] = value;
+    }
+}
+
+static void jtagtap_tdi_tdo_seq_no_delay(
+    const uint8_t *const data_in, uint8_t *const data_out, const bool final_tms, const size_t clock_cycles)
+{
+    uint8_t value = 0;
+    for (size_t cycle = 0; cycle < clock_cycles;)
+    {
+        /* Calculate the next bit and byte to consume data from */
+        const uint8_t bit = cycle & 7U;
+        const size_t byte = cycle >> 3U;
+        /* On the last cycle, assert final_tms to TMS_PIN */
+        gpio_set_val(TMS_PORT, TMS_PIN, cycle + 1U >= clock_cycles && final_tms);
+        /* Set up the TDI pin and start the clock cycle */
+        gpio_set_val(TDI_PORT, TDI_PIN, data_in[byte] & (1U << bit));
+        gpio_set(TCK_PORT, TCK_PIN);
+        /* Block the compiler from re-ordering the calculations to preserve timings */
+        __asm__ volatile("" ::: "memory");
+        /* If TDO is high, store a 1 in the appropriate position in the value being accumulated */
+        if (gpio_get(TDO_PORT, TDO_PIN))
+            value |= 1U << bit;
+        if (bit == 7U)
+        {
+            data_out[byte] = value;
+            value = 0;
+        }
+        ++cycle;
+        /* Finish the clock cycle */
+        gpio_clear(TCK_PORT, TCK_PIN);
+    }
+    /* If clock_cycles is not divisible by 8, we have some extra data to write back here. */
+    if (clock_cycles & 7U)
+    {
+        const size_t byte = (clock_cycles - 1U) >> 3U;
+        data_out[byte] = value;
+    }
+}
+
+static void jtagtap_tdi_tdo_seq(
+    uint8_t *const data_out, const bool final_tms, const uint8_t *const data_in, size_t clock_cycles)
+{
+    gpio_clear(TMS_PORT, TMS_PIN);
+    gpio_clear(TDI_PORT, TDI_PIN);
+    if (target_clk_divider != UINT32_MAX)
+        jtagtap_tdi_tdo_seq_clk_delay(data_in, data_out, final_tms, clock_cycles);
+    else
+        jtagtap_tdi_tdo_seq_no_delay(data_in, data_out, final_tms, clock_cycles);
+}
+
+static void jtagtap_tdi_seq_clk_delay(const uint8_t *const data_in, const bool final_tms, size_t clock_cycles)
+{
+    for (size_t cycle = 0; cycle < clock_cycles;)
+    {
+        /* Calculate the next bit and byte to consume data from */
+        const uint8_t bit = cycle & 7U;
+        const size_t byte = cycle >> 3U;
+        /* On the last cycle, assert final_tms to TMS_PIN */
+        gpio_set_val(TMS_PORT, TMS_PIN, cycle + 1U >= clock_cycles && final_tms);
+        /* Set up the TDI pin and start the clock cycle */
+        gpio_set_val(TDI_PORT, TDI_PIN, data_in[byte] & (1U << bit));
+        gpio_set(TCK_PORT, TCK_PIN);
+        for (volatile uint32_t counter = target_clk_divider; counter > 0; --counter)
+            continue;
+        ++cycle;
+        /* Finish the clock cycle */
+        gpio_clear(TCK_PORT, TCK_PIN);
+        for (volatile uint32_t counter = target_clk_divider; counter > 0; --counter)
+            continue;
+    }
+}
+
+static void jtagtap_tdi_seq_no_delay(const uint8_t *const data_in, const bool final_tms, size_t clock_cycles)
+{
+    for (size_t cycle = 0; cycle < clock_cycles;)
+    {
+        /* Calculate the next bit and byte to consume data from */
+        const uint8_t bit = cycle & 7U;
+        const size_t byte = cycle >> 3U;
+        /* On the last cycle, assert final_tms to TMS_PIN */
+        gpio_set_val(TMS_PORT, TMS_PIN, cycle + 1U >= clock_cycles && final_tms);
+        /* Set up the TDI pin and start the clock cycle */
+        gpio_set_val(TDI_PORT, TDI_PIN, data_in[byte] & (1U << bit));
+        gpio_set(TCK_PORT, TCK_PIN);
+        /* Block the compiler from re-ordering the calculations to preserve timings */
+        __asm__ volatile("" ::: "memory");
+        ++cycle;
+        /* Finish the clock cycle */
+        gpio_clear(TCK_PORT, TCK_PIN);
+    }
+}
+
+static void jtagtap_tdi_seq(const bool final_tms, const uint8_t *const data_in, const size_t clock_cycles)
+{
+    gpio_clear(TMS_PORT, TMS_PIN);
+    if (target_clk_divider != UINT32_MAX)
+        jtagtap_tdi_seq_clk_delay(data_in, final_tms, clock_cycles);
+    else
+        jtagtap_tdi_seq_no_delay(data_in, final_tms, clock_cycles);
+}
+
+static void jtagtap_cycle_clk_delay(const size_t clock_cycles)
+{
+    for (size_t cycle = 0; cycle < clock_cycles; ++cycle)
+    {
+        gpio_set(TCK_PORT, TCK_PIN);
+        for (volatile uint32_t counter = target_clk_divider; counter > 0; --counter)
+            continue;
+        gpio_clear(TCK_PORT, TCK_PIN);
+        for (volatile uint32_t counter = target_clk_divider; counter > 0; --counter)
+            continue;
+    }
+}
+
+static void jtagtap_cycle_no_delay(const size_t clock_cycles)
+{
+    for (size_t cycle = 0; cycle < clock_cycles; ++cycle)
+    {
+        gpio_set(TCK_PORT, TCK_PIN);
+        gpio_clear(TCK_PORT, TCK_PIN);
+    }
+}
+
+static void jtagtap_cycle(const bool tms, const bool tdi, const size_t clock_cycles)
+{
+    jtagtap_next(tms, tdi);
+    if (target_clk_divider != UINT32_MAX)
+        jtagtap_cycle_clk_delay(clock_cycles - 1U);
+    else
+        jtagtap_cycle_no_delay(clock_cycles - 1U);
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct jtag_proc
+{
+    void (*jtagtap_reset)(void);
+    bool (*jtagtap_next)(bool tms, bool tdi);
+    void (*jtagtap_tms_seq)(uint32_t tms_states, size_t clock_cycles);
+    void (*jtagtap_tdi_tdo_seq)(uint8_t *data_out, bool final_tms, const uint8_t *data_in, size_t clock_cycles);
+    void (*jtagtap_tdi_seq)(bool final_tms, const uint8_t *data_in, size_t clock_cycles);
+    void (*jtagtap_cycle)(bool tms, bool tdi, size_t clock_cycles);
+    uint8_t tap_idle_cycles;
+} jtag_proc_s;
+
+extern jtag_proc_s jtag_proc;
+
+void jtagtap_init(void);
@@ -0,0 +1,9 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "timing.h"
+
+uint32_t platform_time_ms(void);
+void platform_delay(uint32_t ms);
+void platform_max_frequency_set(uint32_t frequency);
+uint32_t platform_max_frequency_get(void);
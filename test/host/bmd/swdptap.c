@@ -0,0 +1,166 @@
+#include "general.h"
+#include "timing.h"
+#include "swd.h"
+
+/*
+ * The bit-bang SWD tap as upstream swdptap.c has it for firmware probes:
+ * one gpio_set()/gpio_clear()/gpio_get() per pin edge through the
+ * platform GPIO layer, turnaround on a change of direction only. This is
+ * the "bitbang" backend that swd-dedic-tap.c replaces.
+ */
+
+typedef enum
+{
+    SWDIO_STATUS_FLOAT = 0,
+    SWDIO_STATUS_DRIVE,
+} swdio_status_e;
+
+static swdio_status_e swdptap_dir = SWDIO_STATUS_FLOAT;
+
+static inline bool swdptap_parity(uint32_t value)
+{
+    value ^= value >> 16U;
+    value ^= value >> 8U;
+    value ^= value >> 4U;
+    return (0x6996U >> (value & 0xfU)) & 1U;
+}
+
+static void swdptap_turnaround(const swdio_status_e dir)
+{
+    /* Don't turnaround if direction not changing */
+    if (dir == swdptap_dir)
+        return;
+    swdptap_dir = dir;
+
+    if (dir == SWDIO_STATUS_FLOAT)
+        SWDIO_MODE_FLOAT();
+    else
+        gpio_clear(SWCLK_PORT, SWCLK_PIN);
+
+    for (volatile uint32_t counter = target_clk_divider + 1U; counter > 0; --counter)
+        continue;
+
+    gpio_set(SWCLK_PORT, SWCLK_PIN);
+    for (volatile uint32_t counter = target_clk_divider + 1U; counter > 0; --counter)
+        continue;
+
+    if (dir == SWDIO_STATUS_DRIVE)
+    {
+        gpio_clear(SWCLK_PORT, SWCLK_PIN);
+        SWDIO_MODE_DRIVE();
+    }
+}
+
+static uint32_t swdptap_seq_in_clk_delay(const size_t clock_cycles)
+{
+    uint32_t value = 0;
+    for (size_t cycle = 0; cycle < clock_cycles; ++cycle)
+    {
+        gpio_clear(SWCLK_PORT, SWCLK_PIN);
+        value |= gpio_get(SWDIO_PORT, SWDIO_PIN) ? 1U << cycle : 0U;
+        for (volatile uint32_t counter = target_clk_divider; counter > 0; --counter)
+            continue;
+        gpio_set(SWCLK_PORT, SWCLK_PIN);
+        for (volatile uint32_t counter = target_clk_divider; counter > 0; --counter)
+            continue;
+    }
+    gpio_clear(SWCLK_PORT, SWCLK_PIN);
+    return value;
+}
+
+static uint32_t swdptap_seq_in_no_delay(const size_t clock_cycles)
+{
+    uint32_t value = 0;
+    for (size_t cycle = 0; cycle < clock_cycles; ++cycle)
+    {
+        gpio_clear(SWCLK_PORT, SWCLK_PIN);
+        value |= gpio_get(SWDIO_PORT, SWDIO_PIN) ? 1U << cycle : 0U;
+        gpio_set(SWCLK_PORT, SWCLK_PIN);
+    }
+    gpio_clear(SWCLK_PORT, SWCLK_PIN);
+    return value;
+}
+
+static uint32_t swdptap_seq_in(size_t clock_cycles)
+{
+    swdptap_turnaround(SWDIO_STATUS_FLOAT);
+    if (target_clk_divider != UINT32_MAX)
+        return swdptap_seq_in_clk_delay(clock_cycles);
+    return swdptap_seq_in_no_delay(clock_cycles);
+}
+
+static bool swdptap_seq_in_parity(uint32_t *ret, size_t clock_cycles)
+{
+    const uint32_t result = swdptap_seq_in(clock_cycles);
+    for (volatile uint32_t counter = target_clk_divider + 1U; counter > 0; --counter)
+        continue;
+
+    const bool parity = swdptap_parity(result);
+    const bool bit = gpio_get(SWDIO_PORT, SWDIO_PIN);
+
+    gpio_set(SWCLK_PORT, SWCLK_PIN);
+    for (volatile uint32_t counter = target_clk_divider + 1U; counter > 0; --counter)
+        continue;
+
+    *ret = result;
+    /* Terminate the read cycle now */
+    swdptap_turnaround(SWDIO_STATUS_DRIVE);
+    return parity != bit;
+}
+
+static void swdptap_seq_out_clk_delay(const uint32_t tms_states, const size_t clock_cycles)
+{
+    for (size_t cycle = 0; cycle < clock_cycles; ++cycle)
+    {
+        gpio_clear(SWCLK_PORT, SWCLK_PIN);
+        gpio_set_val(SWDIO_PORT, SWDIO_PIN, tms_states & (1U << cycle));
+        for (volatile uint32_t counter = target_clk_divider; counter > 0; --counter)
+            continue;
+        gpio_set(SWCLK_PORT, SWCLK_PIN);
+        for (volatile uint32_t counter = target_clk_divider; counter > 0; --counter)
+            continue;
+    }
+    gpio_clear(SWCLK_PORT, SWCLK_PIN);
+}
+
+static void swdptap_seq_out_no_delay(const uint32_t tms_states, const size_t clock_cycles)
+{
+    for (size_t cycle = 0; cycle < clock_cycles; ++cycle)
+    {
+        gpio_clear(SWCLK_PORT, SWCLK_PIN);
+        gpio_set_val(SWDIO_PORT, SWDIO_PIN, tms_states & (1U << cycle));
+        gpio_set(SWCLK_PORT, SWCLK_PIN);
+    }
+    gpio_clear(SWCLK_PORT, SWCLK_PIN);
+}
+
+static void swdptap_seq_out(uint32_t tms_states, size_t clock_cycles)
+{
+    swdptap_turnaround(SWDIO_STATUS_DRIVE);
+    if (target_clk_divider != UINT32_MAX)
+        swdptap_seq_out_clk_delay(tms_states, clock_cycles);
+    else
+        swdptap_seq_out_no_delay(tms_states, clock_cycles);
+}
+
+static void swdptap_seq_out_parity(uint32_t tms_states, size_t clock_cycles)
+{
+    const bool parity = swdptap_parity(tms_states);
+    swdptap_seq_out(tms_states, clock_cycles);
+    gpio_set_val(SWDIO_PORT, SWDIO_PIN, parity);
+    gpio_clear(SWCLK_PORT, SWCLK_PIN);
+    for (volatile uint32_t counter = target_clk_divider + 1U; counter > 0; --counter)
+        continue;
+    gpio_set(SWCLK_PORT, SWCLK_PIN);
+    for (volatile uint32_t counter = target_clk_divider + 1U; counter > 0; --counter)
+        continue;
+    gpio_clear(SWCLK_PORT, SWCLK_PIN);
+}
+
+void swdptap_init(void)
+{
+    swd_proc.seq_in = swdptap_seq_in;
+    swd_proc.seq_in_parity = swdptap_seq_in_parity;
+    swd_proc.seq_out = swdptap_seq_out;
+    swd_proc.seq_out_parity = swdptap_seq_out_parity;
+}
@@ -0,0 +1,267 @@
+#include <stdlib.h>
+#include "general.h"
+#include "target.h"
+#include "target_internal.h"
+
+/* Generic target API as in upstream target.c and target_flash.c */
+
+target_s *target_list = NULL;
+
+target_s *target_new(void)
+{
+    target_s *target = calloc(1, sizeof(*target));
+    if (target == NULL)
+        return NULL;
+
+    /* Append, so targets keep scan order */
+    target_s **tail = &target_list;
+    while (*tail != NULL)
+        tail = &(*tail)->next;
+    *tail = target;
+    return target;
+}
+
+void target_add_ram32(target_s *target, target_addr_t start, uint32_t len)
+{
+    target_ram_s *ram = calloc(1, sizeof(*ram));
+    if (ram == NULL)
+        return;
+    ram->start = start;
+    ram->length = len;
+    ram->next = target->ram;
+    target->ram = ram;
+}
+
+void target_add_flash(target_s *target, target_flash_s *flash)
+{
+    flash->t = target;
+    flash->next = target->flash;
+    target->flash = flash;
+}
+
+void target_list_free(void)
+{
+    while (target_list != NULL)
+    {
+        target_s *target = target_list;
+        target_list = target->next;
+        while (target->ram != NULL)
+        {
+            target_ram_s *ram = target->ram;
+            target->ram = ram->next;
+            free(ram);
+        }
+        /* Flash regions live in priv */
+        if (target->priv_free != NULL)
+            target->priv_free(target->priv);
+        free(target);
+    }
+}
+
+target_s *target_attach_n(size_t n, target_controller_s *tc)
+{
+    target_s *target = target_list;
+    for (size_t i = 1; target != NULL && i < n; i++)
+        target = target->next;
+    if (target == NULL)
+        return NULL;
+    target->tc = tc;
+    target->attached = true;
+    target_halt_request(target);
+    return target;
+}
+
+void target_detach(target_s *target)
+{
+    target_halt_resume(target, false);
+    target->attached = false;
+}
+
+bool target_attached(target_s *target)
+{
+    return target->attached;
+}
+
+const char *target_driver_name(target_s *target)
+{
+    return target->driver;
+}
+
+bool target_mem32_read(target_s *target, void *dest, target_addr_t src, size_t len)
+{
+    target->mem_read(target, dest, src, len);
+    return target_check_error(target);
+}
+
+bool target_mem32_write(target_s *target, target_addr_t dest, const void *src, size_t len)
+{
+    target->mem_write(target, dest, src, len);
+    return target_check_error(target);
+}
+
+bool target_check_error(target_s *target)
+{
+    return target != NULL && target->check_error(target);
+}
+
+size_t target_regs_size(target_s *target)
+{
+    return target->regs_size;
+}
+
+void target_regs_read(target_s *target, void *data)
+{
+    target->regs_read(target, data);
+}
+
+void target_regs_write(target_s *target, const void *data)
+{
+    target->regs_write(target, data);
+}
+
+size_t target_reg_read(target_s *target, uint32_t reg, void *data, size_t max)
+{
+    return target->reg_read(target, reg, data, max);
+}
+
+size_t target_reg_write(target_s *target, uint32_t reg, const void *data, size_t size)
+{
+    return target->reg_write(target, reg, data, size);
+}
+
+const char *target_regs_description(target_s *target)
+{
+    if (target->regs_description != NULL)
+        return target->regs_description(target);
+    return NULL;
+}
+
+static size_t map_ram(char *buf, size_t len, const target_ram_s *ram)
+{
+    return (size_t)snprintf(buf, len, "<memory type=\"ram\" start=\"0x%08" PRIx32 "\" length=\"0x%" PRIx32 "\"/>",
+                            ram->start, (uint32_t)ram->length);
+}
+
+static size_t map_flash(char *buf, size_t len, const target_flash_s *flash)
+{
+    return (size_t)snprintf(buf, len,
+                            "<memory type=\"flash\" start=\"0x%08" PRIx32 "\" length=\"0x%" PRIx32
+                            "\"><property name=\"blocksize\">0x%" PRIx32 "</property></memory>",
+                            flash->start, (uint32_t)flash->length, (uint32_t)flash->blocksize);
+}
+
+bool target_mem_map(target_s *target, char *buf, size_t len)
+{
+    size_t offset = (size_t)snprintf(buf, len, "<memory-map>");
+    for (const target_ram_s *ram = target->ram; ram != NULL; ram = ram->next)
+        offset += map_ram(buf + MIN(offset, len), len - MIN(offset, len), ram);
+    for (const target_flash_s *flash = target->flash; flash != NULL; flash = flash->next)
+        offset += map_flash(buf + MIN(offset, len), len - MIN(offset, len), flash);
+    offset += (size_t)snprintf(buf + MIN(offset, len), len - MIN(offset, len), "</memory-map>");
+    return offset < len;
+}
+
+void target_reset(target_s *target)
+{
+    target->reset(target);
+}
+
+void target_halt_request(target_s *target)
+{
+    target->halt_request(target);
+}
+
+target_halt_reason_e target_halt_poll(target_s *target, target_addr_t *watch)
+{
+    return target->halt_poll(target, watch);
+}
+
+void target_halt_resume(target_s *target, bool step)
+{
+    target->halt_resume(target, step);
+}
+
+static target_flash_s *target_flash_for_addr(target_s *target, target_addr_t addr)
+{
+    for (target_flash_s *flash = target->flash; flash != NULL; flash = flash->next)
+    {
+        if (addr >= flash->start && addr - flash->start < flash->length)
+            return flash;
+    }
+    return NULL;
+}
+
+static bool target_flash_prepare(target_flash_s *flash)
+{
+    if (flash->operation != 0)
+        return true;
+    flash->operation = 1U;
+    return flash->prepare == NULL || flash->prepare(flash);
+}
+
+bool target_flash_erase(target_s *target, target_addr_t addr, size_t len)
+{
+    while (len > 0)
+    {
+        target_flash_s *flash = target_flash_for_addr(target, addr);
+        if (flash == NULL || !target_flash_prepare(flash))
+            return true;
+        const target_addr_t block = addr & ~(flash->blocksize - 1U);
+        if (!flash->erase(flash, block, flash->blocksize))
+            return true;
+        const size_t done = MIN(len, block + flash->blocksize - addr);
+        addr += done;
+        len -= done;
+    }
+    return false;
+}
+
+bool target_flash_write(target_s *target, target_addr_t dest, const void *src, size_t len)
+{
+    const uint8_t *data = src;
+    while (len > 0)
+    {
+        target_flash_s *flash = target_flash_for_addr(target, dest);
+        if (flash == NULL || !target_flash_prepare(flash))
+            return true;
+
+        /* Whole aligned units go out in one write */
+        const size_t flash_left = flash->start + flash->length - dest;
+        if ((dest & (flash->writesize - 1U)) == 0 && MIN(len, flash_left) >= flash->writesize)
+        {
+            const size_t chunk = MIN(len, flash_left) & ~(flash->writesize - 1U);
+            if (!flash->write(flash, dest, data, chunk))
+                return true;
+            dest += chunk;
+            data += chunk;
+            len -= chunk;
+            continue;
+        }
+
+        /* Pad to the write size with the erased value, programming only clears bits */
+        uint8_t buffer[8];
+        const target_addr_t base = dest & ~(flash->writesize - 1U);
+        const size_t offset = dest - base;
+        const size_t chunk = MIN(len, flash->writesize - offset);
+        memset(buffer, flash->erased, sizeof(buffer));
+        memcpy(buffer + offset, data, chunk);
+        if (!flash->write(flash, base, buffer, flash->writesize))
+            return true;
+        dest += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+    return false;
+}
+
+bool target_flash_complete(target_s *target)
+{
+    bool result = false;
+    for (target_flash_s *flash = target->flash; flash != NULL; flash = flash->next)
+    {
+        if (flash->operation != 0 && flash->done != NULL && !flash->done(flash))
+            result = true;
+        flash->operation = 0;
+    }
+    return result;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef uint32_t target_addr_t;
+typedef uint32_t target_addr32_t;
+typedef uint64_t target_addr64_t;
+
+typedef struct target target_s;
+typedef struct target_controller target_controller_s;
+
+typedef enum target_halt_reason
+{
+    TARGET_HALT_RUNNING = 0,
+    TARGET_HALT_ERROR,
+    TARGET_HALT_REQUEST,
+    TARGET_HALT_STEPPING,
+    TARGET_HALT_BREAKPOINT,
+    TARGET_HALT_WATCHPOINT,
+    TARGET_HALT_FAULT,
+} target_halt_reason_e;
+
+bool adiv5_swd_scan(void);
+bool jtag_scan(void);
+
+target_s *target_attach_n(size_t n, target_controller_s *tc);
+void target_detach(target_s *target);
+bool target_attached(target_s *target);
+const char *target_driver_name(target_s *target);
+
+/* Memory access, true on error */
+bool target_mem32_read(target_s *target, void *dest, target_addr_t src, size_t len);
+bool target_mem32_write(target_s *target, target_addr_t dest, const void *src, size_t len);
+bool target_check_error(target_s *target);
+
+/* Register access */
+size_t target_regs_size(target_s *target);
+void target_regs_read(target_s *target, void *data);
+void target_regs_write(target_s *target, const void *data);
+size_t target_reg_read(target_s *target, uint32_t reg, void *data, size_t max);
+size_t target_reg_write(target_s *target, uint32_t reg, const void *data, size_t size);
+
+/* Target description XML, allocated, the caller frees it; NULL if none */
+const char *target_regs_description(target_s *target);
+/* Memory map XML, false if it did not fit */
+bool target_mem_map(target_s *target, char *buf, size_t len);
+
+/* Halt/resume */
+void target_reset(target_s *target);
+void target_halt_request(target_s *target);
+target_halt_reason_e target_halt_poll(target_s *target, target_addr_t *watch);
+void target_halt_resume(target_s *target, bool step);
+
+/* Flash, true on error */
+bool target_flash_erase(target_s *target, target_addr_t addr, size_t len);
+bool target_flash_write(target_s *target, target_addr_t dest, const void *src, size_t len);
+bool target_flash_complete(target_s *target);
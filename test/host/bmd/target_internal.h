@@ -0,0 +1,78 @@
+#pragma once
+#include "target.h"
+
+typedef struct target_ram target_ram_s;
+typedef struct target_flash target_flash_s;
+
+typedef bool (*flash_prepare_func)(target_flash_s *flash);
+typedef bool (*flash_erase_func)(target_flash_s *flash, target_addr_t addr, size_t len);
+typedef bool (*flash_write_func)(target_flash_s *flash, target_addr_t dest, const void *src, size_t len);
+typedef bool (*flash_done_func)(target_flash_s *flash);
+
+struct target_ram
+{
+    target_addr_t start;
+    size_t length;
+    target_ram_s *next;
+};
+
+struct target_flash
+{
+    target_s *t;
+    target_addr_t start;
+    size_t length;
+    size_t blocksize;
+    size_t writesize;
+    size_t writebufsize;
+    uint8_t erased;
+    uint8_t operation;
+    flash_prepare_func prepare;
+    flash_erase_func erase;
+    flash_write_func write;
+    flash_done_func done;
+    void *buf;
+    target_addr_t buf_addr_base;
+    target_addr_t buf_addr_low;
+    target_addr_t buf_addr_high;
+    target_flash_s *next;
+};
+
+struct target
+{
+    target_controller_s *tc;
+    bool attached;
+    const char *driver;
+    size_t regs_size;
+
+    /* Memory access */
+    void (*mem_read)(target_s *target, void *dest, target_addr_t src, size_t len);
+    void (*mem_write)(target_s *target, target_addr_t dest, const void *src, size_t len);
+    bool (*check_error)(target_s *target);
+
+    /* Register access */
+    void (*regs_read)(target_s *target, void *data);
+    void (*regs_write)(target_s *target, const void *data);
+    size_t (*reg_read)(target_s *target, uint32_t reg, void *data, size_t max);
+    size_t (*reg_write)(target_s *target, uint32_t reg, const void *data, size_t size);
+    const char *(*regs_description)(target_s *target);
+
+    /* Halt/resume */
+    void (*reset)(target_s *target);
+    void (*halt_request)(target_s *target);
+    target_halt_reason_e (*halt_poll)(target_s *target, target_addr_t *watch);
+    void (*halt_resume)(target_s *target, bool step);
+
+    target_ram_s *ram;
+    target_flash_s *flash;
+
+    void *priv;
+    void (*priv_free)(void *priv);
+    target_s *next;
+};
+
+extern target_s *target_list;
+
+target_s *target_new(void);
+void target_add_ram32(target_s *target, target_addr_t start, uint32_t len);
+void target_add_flash(target_s *target, target_flash_s *flash);
+void target_list_free(void);
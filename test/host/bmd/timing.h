@@ -0,0 +1,14 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct platform_timeout
+{
+    uint32_t time;
+} platform_timeout_s;
+
+/* Delay loop count per SWCLK half period, UINT32_MAX for no delay */
+extern uint32_t target_clk_divider;
+
+void platform_timeout_set(platform_timeout_s *target, uint32_t ms);
+bool platform_timeout_is_expired(const platform_timeout_s *target);
@@ -0,0 +1,30 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/*
+ * Dedicated GPIO bundle on the host: the bundle channels are wired to the
+ * simulated SWD target (test/host/sim), channel 0 to SWCLK and channel 1
+ * to SWDIO.
+ */
+
+typedef struct host_dedic_bundle *dedic_gpio_bundle_handle_t;
+
+typedef struct
+{
+    const int *gpio_array;
+    size_t array_size;
+    struct
+    {
+        unsigned int in_en : 1;
+        unsigned int in_invert : 1;
+        unsigned int out_en : 1;
+        unsigned int out_invert : 1;
+    } flags;
+} dedic_gpio_bundle_config_t;
+
+esp_err_t dedic_gpio_new_bundle(const dedic_gpio_bundle_config_t *config, dedic_gpio_bundle_handle_t *ret_bundle);
+esp_err_t dedic_gpio_del_bundle(dedic_gpio_bundle_handle_t bundle);
+esp_err_t dedic_gpio_get_out_offset(dedic_gpio_bundle_handle_t bundle, uint32_t *offset);
+esp_err_t dedic_gpio_get_in_offset(dedic_gpio_bundle_handle_t bundle, uint32_t *offset);
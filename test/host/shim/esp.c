@@ -0,0 +1,61 @@
+#include <stdlib.h>
+#include <time.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_cpu.h>
+#include <esp_private/esp_clk.h>
+
+static uint64_t host_monotonic_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000U + (uint64_t)now.tv_nsec;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return (int64_t)(host_monotonic_ns() / 1000U);
+}
+
+uint32_t esp_cpu_get_cycle_count(void)
+{
+    return (uint32_t)host_monotonic_ns();
+}
+
+int esp_clk_cpu_freq(void)
+{
+    return 1000000000;
+}
+
+esp_log_level_t host_log_level(void)
+{
+    static int level = -1;
+    if (level < 0)
+    {
+        const char *env = getenv("BMP_HOST_LOG");
+        level = env != NULL ? atoi(env) : ESP_LOG_WARN;
+    }
+    return (esp_log_level_t)level;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * Host stand-in for the CPU cycle counter, counts nanoseconds of
+ * monotonic time so that esp_clk_cpu_freq() is 1 GHz
+ * @return uint32_t
+ */
+uint32_t esp_cpu_get_cycle_count(void);
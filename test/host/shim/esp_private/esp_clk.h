@@ -0,0 +1,6 @@
+#pragma once
+
+/**
+ * @return int CPU clock of the host cycle counter in Hz
+ */
+int esp_clk_cpu_freq(void);
@@ -0,0 +1,7 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * @return int64_t monotonic host time in us
+ */
+int64_t esp_timer_get_time(void);
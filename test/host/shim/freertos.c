@@ -0,0 +1,304 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/param.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <freertos/stream_buffer.h>
+
+struct host_task
+{
+    pthread_t thread;
+    TaskFunction_t code;
+    void *parameters;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+};
+
+struct host_semaphore
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t count;
+};
+
+struct host_stream_buffer
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint8_t *data;
+    size_t size;
+    size_t trigger;
+    size_t head;
+    size_t used;
+};
+
+static _Thread_local struct host_task *host_current_task;
+
+static void host_cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static struct timespec host_deadline(TickType_t ticks)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    const uint64_t ms = (uint64_t)ticks * portTICK_PERIOD_MS;
+    deadline.tv_sec += (time_t)(ms / 1000U);
+    deadline.tv_nsec += (long)(ms % 1000U) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    return deadline;
+}
+
+/* Wait on cond until woken or past the deadline, false on timeout */
+static bool host_wait(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks, const struct timespec *deadline)
+{
+    if (ticks == 0)
+        return false;
+    if (ticks == portMAX_DELAY)
+        return pthread_cond_wait(cond, lock) == 0;
+    return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+static struct host_task *host_task_new(void)
+{
+    struct host_task *task = calloc(1, sizeof(*task));
+    if (task == NULL)
+        abort();
+    pthread_mutex_init(&task->lock, NULL);
+    host_cond_init(&task->cond);
+    return task;
+}
+
+static void *host_task_entry(void *arg)
+{
+    struct host_task *task = arg;
+    host_current_task = task;
+    task->code(task->parameters);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t stack_depth, void *parameters,
+                       UBaseType_t priority, TaskHandle_t *created)
+{
+    (void)name;
+    (void)priority;
+    struct host_task *task = host_task_new();
+    task->code = code;
+    task->parameters = parameters;
+
+    /* Same stack as on the probe, plus room for the host C library */
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, stack_depth + 65536U);
+    const int err = pthread_create(&task->thread, &attr, host_task_entry, task);
+    pthread_attr_destroy(&attr);
+    if (err != 0)
+    {
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    if (created != NULL)
+        *created = task;
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    const uint64_t ms = (uint64_t)ticks * portTICK_PERIOD_MS;
+    struct timespec delay = {.tv_sec = (time_t)(ms / 1000U), .tv_nsec = (long)(ms % 1000U) * 1000000L};
+    while (nanosleep(&delay, &delay) != 0 && errno == EINTR)
+        continue;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (TickType_t)((uint64_t)now.tv_sec * configTICK_RATE_HZ + (uint64_t)now.tv_nsec / (1000000000U / configTICK_RATE_HZ));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    /* Threads not started through xTaskCreate() get a handle on first use */
+    if (host_current_task == NULL)
+        host_current_task = host_task_new();
+    return host_current_task;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    struct host_task *task = xTaskGetCurrentTaskHandle();
+    const struct timespec deadline = host_deadline(ticks);
+
+    pthread_mutex_lock(&task->lock);
+    while (task->notify == 0 && host_wait(&task->cond, &task->lock, ticks, &deadline))
+        continue;
+    const uint32_t value = task->notify;
+    if (value > 0)
+        task->notify = clear_on_exit ? 0 : value - 1U;
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_broadcast(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+static SemaphoreHandle_t host_semaphore_new(uint32_t count)
+{
+    struct host_semaphore *semaphore = calloc(1, sizeof(*semaphore));
+    if (semaphore == NULL)
+        return NULL;
+    pthread_mutex_init(&semaphore->lock, NULL);
+    host_cond_init(&semaphore->cond);
+    semaphore->count = count;
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return host_semaphore_new(1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return host_semaphore_new(0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+    const struct timespec deadline = host_deadline(ticks);
+    pthread_mutex_lock(&semaphore->lock);
+    while (semaphore->count == 0 && host_wait(&semaphore->cond, &semaphore->lock, ticks, &deadline))
+        continue;
+    const bool taken = semaphore->count > 0;
+    if (taken)
+        semaphore->count--;
+    pthread_mutex_unlock(&semaphore->lock);
+    return taken ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    pthread_mutex_lock(&semaphore->lock);
+    const bool given = semaphore->count == 0;
+    if (given)
+    {
+        semaphore->count = 1;
+        pthread_cond_broadcast(&semaphore->cond);
+    }
+    pthread_mutex_unlock(&semaphore->lock);
+    return given ? pdTRUE : pdFALSE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+    pthread_mutex_destroy(&semaphore->lock);
+    pthread_cond_destroy(&semaphore->cond);
+    free(semaphore);
+}
+
+StreamBufferHandle_t xStreamBufferCreate(size_t size, size_t trigger_level)
+{
+    struct host_stream_buffer *stream = calloc(1, sizeof(*stream));
+    if (stream == NULL)
+        return NULL;
+    stream->data = malloc(size);
+    if (stream->data == NULL)
+    {
+        free(stream);
+        return NULL;
+    }
+    pthread_mutex_init(&stream->lock, NULL);
+    host_cond_init(&stream->cond);
+    stream->size = size;
+    stream->trigger = trigger_level > 0 ? trigger_level : 1U;
+    return stream;
+}
+
+/* As FreeRTOS: wait until all of it fits, then write what fits */
+size_t xStreamBufferSend(StreamBufferHandle_t stream, const void *data, size_t size, TickType_t ticks)
+{
+    const struct timespec deadline = host_deadline(ticks);
+    const size_t want = MIN(size, stream->size);
+    pthread_mutex_lock(&stream->lock);
+    while (stream->size - stream->used < want && host_wait(&stream->cond, &stream->lock, ticks, &deadline))
+        continue;
+
+    const size_t count = MIN(size, stream->size - stream->used);
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < count; i++)
+        stream->data[(stream->head + stream->used + i) % stream->size] = bytes[i];
+    stream->used += count;
+    if (count > 0)
+        pthread_cond_broadcast(&stream->cond);
+    pthread_mutex_unlock(&stream->lock);
+    return count;
+}
+
+size_t xStreamBufferReceive(StreamBufferHandle_t stream, void *data, size_t size, TickType_t ticks)
+{
+    const struct timespec deadline = host_deadline(ticks);
+    pthread_mutex_lock(&stream->lock);
+    while (stream->used < MIN(stream->trigger, size) &&
+           host_wait(&stream->cond, &stream->lock, ticks, &deadline))
+        continue;
+
+    const size_t count = MIN(size, stream->used);
+    uint8_t *bytes = data;
+    for (size_t i = 0; i < count; i++)
+        bytes[i] = stream->data[(stream->head + i) % stream->size];
+    stream->head = (stream->head + count) % stream->size;
+    stream->used -= count;
+    if (count > 0)
+        pthread_cond_broadcast(&stream->cond);
+    pthread_mutex_unlock(&stream->lock);
+    return count;
+}
+
+size_t xStreamBufferSpacesAvailable(StreamBufferHandle_t stream)
+{
+    pthread_mutex_lock(&stream->lock);
+    const size_t space = stream->size - stream->used;
+    pthread_mutex_unlock(&stream->lock);
+    return space;
+}
+
+size_t xStreamBufferBytesAvailable(StreamBufferHandle_t stream)
+{
+    pthread_mutex_lock(&stream->lock);
+    const size_t used = stream->used;
+    pthread_mutex_unlock(&stream->lock);
+    return used;
+}
+
+BaseType_t xStreamBufferReset(StreamBufferHandle_t stream)
+{
+    pthread_mutex_lock(&stream->lock);
+    stream->head = 0;
+    stream->used = 0;
+    pthread_cond_broadcast(&stream->cond);
+    pthread_mutex_unlock(&stream->lock);
+    return pdPASS;
+}
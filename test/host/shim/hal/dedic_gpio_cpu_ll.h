@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * Dedicated GPIO CPU channels, driven into the simulated SWD target. Each
+ * call is one CSR access and counts in host_dedic_accesses().
+ */
+void swd_sim_pins_write(uint32_t mask, uint32_t value);
+uint32_t swd_sim_pins_read(void);
+
+extern uint64_t host_dedic_access_count;
+
+static inline void dedic_gpio_cpu_ll_write_mask(uint32_t mask, uint32_t value)
+{
+    host_dedic_access_count++;
+    swd_sim_pins_write(mask, value);
+}
+
+static inline uint32_t dedic_gpio_cpu_ll_read_in(void)
+{
+    host_dedic_access_count++;
+    return swd_sim_pins_read();
+}
@@ -0,0 +1,2 @@
+#pragma once
+/* Nothing the host build uses */
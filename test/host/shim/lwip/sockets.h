@@ -0,0 +1,41 @@
+#pragma once
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+/*
+ * lwIP socket API on the host stack. lwIP maps these names to lwip_*()
+ * with macros; here bind() is mapped as well, so services can be moved to
+ * free ports (host_net_set_ephemeral()) and tests can run in parallel.
+ */
+
+#define bind(sock, addr, len) host_net_bind(sock, addr, len)
+
+/**
+ * bind(), on an ephemeral port instead of a fixed one when enabled
+ */
+int host_net_bind(int sock, const struct sockaddr *addr, socklen_t len);
+
+/**
+ * Bind listeners to ephemeral ports from now on
+ * @param enable
+ */
+void host_net_set_ephemeral(int enable);
+
+/**
+ * Get the port a listener for a fixed port was bound to
+ * @param port port the service asked for
+ * @param timeout_ms wait for the listener to come up
+ * @return int bound port, 0 if there is none
+ */
+int host_net_port(int port, int timeout_ms);
+
+static inline char *inet_ntoa_r(struct in_addr addr, char *buf, int size)
+{
+    return (char *)inet_ntop(AF_INET, &addr, buf, (socklen_t)size);
+}
@@ -0,0 +1,95 @@
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <lwip/sockets.h>
+
+#undef bind
+
+#define HOST_NET_PORTS_MAX 8
+
+typedef struct
+{
+    int requested;
+    int bound;
+} HostNetPort;
+
+static struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool ephemeral;
+    HostNetPort ports[HOST_NET_PORTS_MAX];
+    size_t count;
+} host_net = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+void host_net_set_ephemeral(int enable)
+{
+    pthread_mutex_lock(&host_net.lock);
+    host_net.ephemeral = enable;
+    pthread_mutex_unlock(&host_net.lock);
+}
+
+int host_net_bind(int sock, const struct sockaddr *addr, socklen_t len)
+{
+    if (addr->sa_family != AF_INET || len < sizeof(struct sockaddr_in))
+        return bind(sock, addr, len);
+
+    struct sockaddr_in local = *(const struct sockaddr_in *)addr;
+    const int requested = ntohs(local.sin_port);
+    pthread_mutex_lock(&host_net.lock);
+    const bool ephemeral = host_net.ephemeral;
+    pthread_mutex_unlock(&host_net.lock);
+
+    /* Tests talk over loopback only */
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (ephemeral)
+        local.sin_port = 0;
+    const int result = bind(sock, (const struct sockaddr *)&local, sizeof(local));
+    if (result != 0)
+        return result;
+
+    socklen_t local_len = sizeof(local);
+    getsockname(sock, (struct sockaddr *)&local, &local_len);
+    pthread_mutex_lock(&host_net.lock);
+    if (host_net.count < HOST_NET_PORTS_MAX)
+    {
+        host_net.ports[host_net.count].requested = requested;
+        host_net.ports[host_net.count].bound = ntohs(local.sin_port);
+        host_net.count++;
+        pthread_cond_broadcast(&host_net.cond);
+    }
+    pthread_mutex_unlock(&host_net.lock);
+    return 0;
+}
+
+int host_net_port(int port, int timeout_ms)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    int bound = 0;
+    pthread_mutex_lock(&host_net.lock);
+    while (bound == 0)
+    {
+        for (size_t i = 0; i < host_net.count; i++)
+        {
+            if (host_net.ports[i].requested == port)
+                bound = host_net.ports[i].bound;
+        }
+        if (bound == 0 && pthread_cond_timedwait(&host_net.cond, &host_net.lock, &deadline) == ETIMEDOUT)
+            break;
+    }
+    pthread_mutex_unlock(&host_net.lock);
+    return bound;
+}
@@ -0,0 +1,32 @@
+#pragma once
+/*
+ * Host build configuration: the Kconfig defaults of the options the
+ * firmware sources read, so every source sees the same set as a default
+ * probe build. The diagnostic options (tap, GDB statistics and trace) are
+ * on so the tests can read their counters.
+ */
+#define CONFIG_FREERTOS_HZ 1000
+
+#define CONFIG_BMP_SWD_TAP_DEDIC 1
+#define CONFIG_BMP_INTERFACE_FREQ_KHZ 4000
+#define CONFIG_BMP_JTAG_SPI 1
+#define CONFIG_BMP_JTAG_SPI_MIN_BITS 64
+#define CONFIG_BMP_AUTO_SPEED_MARGIN 20
+#define CONFIG_BMP_ADIV5_QUEUE 1
+#define CONFIG_BMP_LP_OFFLOAD_POLL_US 1000
+#define CONFIG_BMP_LP_OFFLOAD_CHECK_MS 10
+#define CONFIG_BMP_GDB_OBSERVERS 2
+#define CONFIG_BMP_NET_SEND_STALL_MS 5000
+#define CONFIG_BMP_POLL_FAST_MS 20
+#define CONFIG_BMP_POLL_MAX_MS 20
+#define CONFIG_BMP_IRAM_HOT_PATH 1
+#define CONFIG_BMP_TAP_STATS 1
+#define CONFIG_BMP_GDB_STATS 1
+#define CONFIG_BMP_GDB_TRACE 1
+#define CONFIG_BMP_GDB_TRACE_SIZE 16
+#define CONFIG_BMP_GDB_RLE 1
+#define CONFIG_BMP_TARGET_CACHE 1
+#define CONFIG_BMP_TARGET_CACHE_BLOCKS 16
+#define CONFIG_BMP_TARGET_READ_AHEAD 1024
+#define CONFIG_BMP_GDB_LARGE_PACKETS 1
+#define CONFIG_BMP_GDB_PACKET_SIZE 16384
@@ -0,0 +1,54 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * GPIO matrix registers. Every use of GPIO is one register access: it
+ * counts in host_gpio_accesses(), applies the set/clear store of the
+ * previous access to the pin model and refreshes the input register, so
+ * firmware that stores and loads through GPIO runs unchanged. The default
+ * model wires SWCLK_PIN and SWDIO_PIN to the simulated SWD target; output
+ * enable writes only count, the target decides who drives SWDIO from the
+ * protocol state.
+ */
+typedef struct
+{
+    struct
+    {
+        uint32_t val;
+    } out_w1ts, out_w1tc, enable_w1ts, enable_w1tc, in;
+} gpio_dev_t;
+
+/**
+ * Pins on the far side of the GPIO registers
+ */
+typedef struct
+{
+    void (*write)(uint32_t mask, uint32_t levels); /* levels of the pins in mask changed */
+    uint32_t (*read)(void);                        /* levels of all input pins */
+} host_gpio_model_t;
+
+/**
+ * Count one register access and bring the registers up to date
+ * @return gpio_dev_t*
+ */
+gpio_dev_t *host_gpio_access(void);
+
+/**
+ * Apply a pending store without counting an access
+ */
+void host_gpio_flush(void);
+
+/**
+ * Route the pins to another model, NULL for the simulated SWD target
+ * @param model
+ */
+void host_gpio_set_model(const host_gpio_model_t *model);
+
+/**
+ * @return uint64_t register accesses since the last reset
+ */
+uint64_t host_gpio_accesses(void);
+
+void host_gpio_reset_accesses(void);
+
+#define GPIO (*host_gpio_access())
@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+#include <hal/dedic_gpio_cpu_ll.h>
+
+/*
+ * LP IO of the LP core program, wired to the simulated SWD target: LP IO
+ * n is bundle channel n, so SWCLK is LP IO 0 and SWDIO is LP IO 1. The
+ * simulated target follows the protocol for the direction of SWDIO, so
+ * enabling and disabling outputs is not modelled.
+ */
+
+typedef enum
+{
+    LP_IO_NUM_0,
+    LP_IO_NUM_1,
+    LP_IO_NUM_2,
+    LP_IO_NUM_3,
+    LP_IO_NUM_4,
+    LP_IO_NUM_5,
+    LP_IO_NUM_6,
+    LP_IO_NUM_7,
+} lp_io_num_t;
+
+static inline void ulp_lp_core_gpio_set_level(lp_io_num_t lp_io_num, uint8_t level)
+{
+    swd_sim_pins_write(1U << lp_io_num, (uint32_t)(level & 1U) << lp_io_num);
+}
+
+static inline int ulp_lp_core_gpio_get_level(lp_io_num_t lp_io_num)
+{
+    return (swd_sim_pins_read() >> lp_io_num) & 1U;
+}
+
+static inline void ulp_lp_core_gpio_output_enable(lp_io_num_t lp_io_num)
+{
+    (void)lp_io_num;
+}
+
+static inline void ulp_lp_core_gpio_output_disable(lp_io_num_t lp_io_num)
+{
+    (void)lp_io_num;
+}
+
+static inline void ulp_lp_core_gpio_input_enable(lp_io_num_t lp_io_num)
+{
+    (void)lp_io_num;
+}
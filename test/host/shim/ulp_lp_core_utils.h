@@ -0,0 +1,11 @@
+#pragma once
+#include <stdint.h>
+#include <unistd.h>
+
+static inline void ulp_lp_core_delay_us(uint32_t us)
+{
+    usleep(us);
+}
+
+/* Provided by whoever plays the HP core */
+void ulp_lp_core_wakeup_main_processor(void);
@@ -0,0 +1,715 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <driver/dedic_gpio.h>
+#include "swd-sim.h"
+
+/*
+ * The model is clocked from the pin writes of the dedicated GPIO bundle:
+ * channel 0 is SWCLK, channel 1 SWDIO. On each SWCLK rising edge the
+ * target samples SWDIO while the host drives it and moves its own output
+ * to the next bit while it drives, so the host reads a bit in the low
+ * phase after the edge that put it there, as with swdptap.c on a real
+ * target. Output enable writes cannot be seen on the host, so who drives
+ * the line follows from the protocol state.
+ *
+ * AP reads are posted like on silicon: each DRW read returns the previous
+ * result and RDBUFF the last one. TAR auto-increment wraps inside 1 KiB.
+ */
+
+#define SWD_SIM_LINE_RESET 50U
+#define SWD_SIM_CORE_REGS 21U
+#define SWD_SIM_SCS_BASE 0xe000e000U
+#define SWD_SIM_SCS_SIZE 0x1000U
+
+typedef enum
+{
+    SWD_SIM_IDLE,
+    SWD_SIM_REQUEST,
+    SWD_SIM_TRN_TARGET, /* turnaround before the ACK */
+    SWD_SIM_ACK,
+    SWD_SIM_READ,
+    SWD_SIM_TRN_HOST,   /* turnaround after a read or a non-OK ACK */
+    SWD_SIM_TRN_WRITE,  /* turnaround between ACK and write data */
+    SWD_SIM_WRITE,
+    SWD_SIM_LOCKOUT,    /* protocol error, silent until a line reset */
+} swd_sim_state_e;
+
+typedef struct
+{
+    /* Pins */
+    uint32_t pins;
+    bool output;    /* level the target drives, valid while driving */
+    bool driving;
+
+    /* Wire protocol */
+    swd_sim_state_e state;
+    uint32_t ones;
+    bool packet_end;
+    bool selected;  /* a valid packet since the last line reset */
+    uint32_t shift;
+    uint32_t bit;
+    uint8_t request;
+    uint8_t ack;
+    uint32_t data;
+
+    /* SW-DP */
+    uint32_t ctrlstat;
+    uint32_t select;
+    uint32_t rdbuff;
+
+    /* MEM-AP */
+    uint32_t csw;
+    uint32_t tar;
+
+    /* Memory and core */
+    uint8_t flash[SWD_SIM_FLASH_SIZE];
+    uint8_t ram[SWD_SIM_RAM_SIZE];
+    uint16_t ram_writes[SWD_SIM_RAM_SIZE / 4U];
+    uint32_t flash_keys;
+    uint32_t flash_cr;
+    uint32_t flash_sr;
+    uint32_t flash_ar;
+    uint32_t counter;
+    uint32_t dhcsr;
+    uint32_t dcrdr;
+    uint32_t demcr;
+    uint32_t dfsr;
+    uint32_t core[SWD_SIM_CORE_REGS];
+    atomic_bool running;
+
+    /* Fault injection */
+    uint32_t inject_wait_after;
+    uint32_t inject_wait;
+    int64_t inject_fault;
+    int64_t inject_parity;
+
+    SWDSimStats stats;
+} SWDSim;
+
+static SWDSim swd_sim;
+
+static inline uint32_t swd_sim_parity(uint32_t value)
+{
+    value ^= value >> 16U;
+    value ^= value >> 8U;
+    value ^= value >> 4U;
+    return (0x6996U >> (value & 0xfU)) & 1U;
+}
+
+void swd_sim_reset(void)
+{
+    memset(&swd_sim, 0, sizeof(swd_sim));
+    memset(swd_sim.flash, 0xff, sizeof(swd_sim.flash));
+    swd_sim.state = SWD_SIM_LOCKOUT;
+    swd_sim.flash_cr = SWD_SIM_FLASH_CR_LOCK;
+    swd_sim.dhcsr = (1U << 17U);
+    swd_sim.inject_fault = -1;
+    swd_sim.inject_parity = -1;
+    swd_sim.csw = 0x23000040U;
+}
+
+void swd_sim_get_stats(SWDSimStats *stats)
+{
+    *stats = swd_sim.stats;
+}
+
+void swd_sim_reset_stats(void)
+{
+    memset(&swd_sim.stats, 0, sizeof(swd_sim.stats));
+    memset(swd_sim.ram_writes, 0, sizeof(swd_sim.ram_writes));
+}
+
+uint32_t swd_sim_ram_writes(uint32_t addr)
+{
+    if (addr < SWD_SIM_RAM_BASE || addr >= SWD_SIM_RAM_BASE + SWD_SIM_RAM_SIZE)
+        return 0;
+    return swd_sim.ram_writes[(addr - SWD_SIM_RAM_BASE) / 4U];
+}
+
+uint64_t swd_sim_cycles_to_ns(uint64_t cycles, uint32_t frequency)
+{
+    return cycles * 1000000000ULL / frequency;
+}
+
+void swd_sim_inject_wait(uint32_t after, uint32_t count)
+{
+    swd_sim.inject_wait_after = after;
+    swd_sim.inject_wait = count;
+}
+
+void swd_sim_inject_fault(uint32_t after)
+{
+    swd_sim.inject_fault = after;
+}
+
+void swd_sim_inject_parity(uint32_t after)
+{
+    swd_sim.inject_parity = after;
+}
+
+uint8_t *swd_sim_memory(uint32_t addr, size_t len)
+{
+    if (addr >= SWD_SIM_FLASH_BASE && len <= SWD_SIM_FLASH_SIZE && addr - SWD_SIM_FLASH_BASE <= SWD_SIM_FLASH_SIZE - len)
+        return swd_sim.flash + (addr - SWD_SIM_FLASH_BASE);
+    if (addr >= SWD_SIM_RAM_BASE && len <= SWD_SIM_RAM_SIZE && addr - SWD_SIM_RAM_BASE <= SWD_SIM_RAM_SIZE - len)
+        return swd_sim.ram + (addr - SWD_SIM_RAM_BASE);
+    return NULL;
+}
+
+void swd_sim_set_running(bool running)
+{
+    /* Stopping from outside looks like a breakpoint */
+    if (!running && atomic_exchange(&swd_sim.running, false))
+        swd_sim.dfsr |= 1U << 1U;
+    atomic_store(&swd_sim.running, running);
+}
+
+bool swd_sim_halted(void)
+{
+    return !atomic_load(&swd_sim.running);
+}
+
+uint32_t *swd_sim_core_reg(uint32_t reg)
+{
+    return reg < SWD_SIM_CORE_REGS ? &swd_sim.core[reg] : NULL;
+}
+
+/* Debug registers of the System Control Space, false on a bus error */
+static bool swd_sim_scs_read(uint32_t addr, uint32_t *value)
+{
+    switch (addr)
+    {
+    case 0xe000ed00U: /* CPUID */
+        *value = 0x410fc241U;
+        return true;
+    case 0xe000ed30U:
+        *value = swd_sim.dfsr;
+        return true;
+    case 0xe000edf0U:
+    {
+        const bool halted = swd_sim_halted();
+        *value = (swd_sim.dhcsr & 0xfU) | (1U << 16U) | (halted ? 1U << 17U : 0U);
+        return true;
+    }
+    case 0xe000edf8U:
+        *value = swd_sim.dcrdr;
+        return true;
+    case 0xe000edfcU:
+        *value = swd_sim.demcr;
+        return true;
+    default:
+        *value = 0;
+        return addr >= SWD_SIM_SCS_BASE && addr < SWD_SIM_SCS_BASE + SWD_SIM_SCS_SIZE;
+    }
+}
+
+static bool swd_sim_scs_write(uint32_t addr, uint32_t value)
+{
+    switch (addr)
+    {
+    case 0xe000ed0cU: /* AIRCR */
+        if ((value >> 16U) == 0x05faU && (value & (1U << 2U)))
+        {
+            memset(swd_sim.core, 0, sizeof(swd_sim.core));
+            memcpy(&swd_sim.core[13], swd_sim.flash, 4U);
+            memcpy(&swd_sim.core[15], swd_sim.flash + 4U, 4U);
+            swd_sim.core[16] = 1U << 24U;
+        }
+        return true;
+    case 0xe000ed30U:
+        swd_sim.dfsr &= ~value;
+        return true;
+    case 0xe000edf0U:
+        if ((value >> 16U) != 0xa05fU)
+            return true;
+        swd_sim.dhcsr = value & 0xfU;
+        if (value & (1U << 1U))
+        {
+            /* A debugger halt sets HALTED, not BKPT as swd_sim_set_running() does */
+            if (atomic_exchange(&swd_sim.running, false))
+                swd_sim.dfsr |= 1U;
+        }
+        else if ((value & 5U) == 5U)
+        {
+            /* A step retires one 16-bit instruction */
+            swd_sim.core[15] += 2U;
+            swd_sim.dfsr |= 1U;
+        }
+        else if (value & 1U)
+            swd_sim_set_running(true);
+        return true;
+    case 0xe000edf4U:
+    {
+        const uint32_t reg = value & 0x7fU;
+        if (reg >= SWD_SIM_CORE_REGS)
+            return true;
+        if (value & (1U << 16U))
+            swd_sim.core[reg] = swd_sim.dcrdr;
+        else
+            swd_sim.dcrdr = swd_sim.core[reg];
+        return true;
+    }
+    case 0xe000edf8U:
+        swd_sim.dcrdr = value;
+        return true;
+    case 0xe000edfcU:
+        swd_sim.demcr = value;
+        return true;
+    default:
+        return addr >= SWD_SIM_SCS_BASE && addr < SWD_SIM_SCS_BASE + SWD_SIM_SCS_SIZE;
+    }
+}
+
+static bool swd_sim_flash_write(uint32_t addr, uint32_t value)
+{
+    switch (addr)
+    {
+    case SWD_SIM_FLASH_KEYR:
+        if (swd_sim.flash_keys == 0 && value == SWD_SIM_FLASH_KEY1)
+            swd_sim.flash_keys = 1;
+        else if (swd_sim.flash_keys == 1 && value == SWD_SIM_FLASH_KEY2)
+            swd_sim.flash_cr &= ~SWD_SIM_FLASH_CR_LOCK;
+        else
+            swd_sim.flash_keys = 0;
+        return true;
+    case SWD_SIM_FLASH_SR:
+        swd_sim.flash_sr &= ~value;
+        return true;
+    case SWD_SIM_FLASH_CR:
+        if (swd_sim.flash_cr & SWD_SIM_FLASH_CR_LOCK)
+            return true;
+        swd_sim.flash_cr = value & (SWD_SIM_FLASH_CR_PG | SWD_SIM_FLASH_CR_PER | SWD_SIM_FLASH_CR_LOCK);
+        if (value & SWD_SIM_FLASH_CR_LOCK)
+            swd_sim.flash_keys = 0;
+        if ((value & (SWD_SIM_FLASH_CR_PER | SWD_SIM_FLASH_CR_STRT)) ==
+            (SWD_SIM_FLASH_CR_PER | SWD_SIM_FLASH_CR_STRT))
+        {
+            uint8_t *page = swd_sim_memory(swd_sim.flash_ar & ~(SWD_SIM_FLASH_PAGE - 1U), SWD_SIM_FLASH_PAGE);
+            if (page != NULL)
+                memset(page, 0xff, SWD_SIM_FLASH_PAGE);
+            swd_sim.flash_sr |= SWD_SIM_FLASH_SR_EOP;
+        }
+        return true;
+    case SWD_SIM_FLASH_AR:
+        swd_sim.flash_ar = value;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool swd_sim_bus_read(uint32_t addr, uint32_t *value)
+{
+    const uint8_t *mem = swd_sim_memory(addr, 4U);
+    if (mem != NULL)
+    {
+        memcpy(value, mem, 4U);
+        return true;
+    }
+    switch (addr)
+    {
+    case SWD_SIM_COUNTER:
+        *value = swd_sim.counter++;
+        return true;
+    case SWD_SIM_FLASH_SR:
+        *value = swd_sim.flash_sr;
+        return true;
+    case SWD_SIM_FLASH_CR:
+        *value = swd_sim.flash_cr;
+        return true;
+    case SWD_SIM_FLASH_AR:
+        *value = swd_sim.flash_ar;
+        return true;
+    default:
+        return swd_sim_scs_read(addr, value);
+    }
+}
+
+/* Byte lanes of a write follow the low address bits, as on AHB */
+static bool swd_sim_bus_write(uint32_t addr, uint32_t value, uint32_t size)
+{
+    const uint32_t bytes = 1U << size;
+    const uint32_t lane = addr & 3U & ~(bytes - 1U);
+    uint8_t data[4];
+    memcpy(data, &value, sizeof(data));
+
+    if (addr >= SWD_SIM_RAM_BASE && addr < SWD_SIM_RAM_BASE + SWD_SIM_RAM_SIZE)
+    {
+        memcpy(swd_sim_memory(addr & ~(bytes - 1U), bytes), data + lane, bytes);
+        swd_sim.ram_writes[(addr - SWD_SIM_RAM_BASE) / 4U]++;
+        return true;
+    }
+    if (addr >= SWD_SIM_FLASH_BASE && addr < SWD_SIM_FLASH_BASE + SWD_SIM_FLASH_SIZE)
+    {
+        /* NOR programming clears bits only, and needs PG */
+        if (!(swd_sim.flash_cr & SWD_SIM_FLASH_CR_PG))
+            return false;
+        uint8_t *mem = swd_sim_memory(addr & ~(bytes - 1U), bytes);
+        for (uint32_t i = 0; i < bytes; i++)
+            mem[i] &= data[lane + i];
+        swd_sim.flash_sr |= SWD_SIM_FLASH_SR_EOP;
+        return true;
+    }
+    if (size != 2U)
+        return false;
+    return swd_sim_flash_write(addr, value) || swd_sim_scs_write(addr, value);
+}
+
+/* A MEM-AP transfer, false on a bus error */
+static bool swd_sim_mem_ap(bool read, uint32_t *value)
+{
+    const uint32_t size = swd_sim.csw & 7U;
+    if (size > 2U)
+        return false;
+
+    bool ok;
+    if (read)
+    {
+        uint32_t word = 0;
+        ok = swd_sim_bus_read(swd_sim.tar & ~3U, &word);
+        *value = word;
+    }
+    else
+        ok = swd_sim_bus_write(swd_sim.tar, *value, size);
+
+    if (ok && (swd_sim.csw & 0x30U) == 0x10U)
+        swd_sim.tar = (swd_sim.tar & ~0x3ffU) | ((swd_sim.tar + (1U << size)) & 0x3ffU);
+    return ok;
+}
+
+static uint32_t swd_sim_ap_read(uint8_t reg)
+{
+    switch ((swd_sim.select & 0xf0U) | reg)
+    {
+    case 0x00U:
+        return swd_sim.csw;
+    case 0x04U:
+        return swd_sim.tar;
+    case 0x0cU:
+    {
+        uint32_t value = 0;
+        if (!swd_sim_mem_ap(true, &value))
+            swd_sim.ctrlstat |= 1U << 5U;
+        return value;
+    }
+    case 0xfcU:
+        return SWD_SIM_AP_IDR;
+    default:
+        return 0;
+    }
+}
+
+static void swd_sim_ap_write(uint8_t reg, uint32_t value)
+{
+    switch ((swd_sim.select & 0xf0U) | reg)
+    {
+    case 0x00U:
+        swd_sim.csw = (value & 0x00ff0037U) | 0x23000040U;
+        break;
+    case 0x04U:
+        swd_sim.tar = value;
+        break;
+    case 0x0cU:
+        if (!swd_sim_mem_ap(false, &value))
+            swd_sim.ctrlstat |= 1U << 5U;
+        break;
+    default:
+        break;
+    }
+}
+
+/* Decide the ACK of a valid request, and read the data a read returns */
+static void swd_sim_respond(void)
+{
+    const bool ap = swd_sim.request & 0x02U;
+    const bool read = swd_sim.request & 0x04U;
+    const uint8_t reg = (swd_sim.request >> 1U) & 0x0cU;
+    const bool sticky = swd_sim.ctrlstat & ((1U << 5U) | (1U << 7U));
+
+    swd_sim.stats.packets++;
+    swd_sim.ack = 1U;
+
+    /* With a sticky error only DPIDR, CTRL/STAT and ABORT are answered */
+    if (sticky && (ap || (read && reg == 0x0cU) || (!read && reg != 0x00U)))
+    {
+        swd_sim.ack = 4U;
+        swd_sim.stats.acks_fault++;
+        return;
+    }
+
+    if ((ap || (read && reg == 0x0cU)) && swd_sim.inject_wait > 0 && swd_sim.inject_wait_after-- == 0)
+    {
+        swd_sim.inject_wait_after = 0;
+        swd_sim.inject_wait--;
+        swd_sim.ack = 2U;
+        swd_sim.stats.acks_wait++;
+        return;
+    }
+
+    if (ap && swd_sim.inject_fault >= 0 && swd_sim.inject_fault-- == 0)
+    {
+        swd_sim.ctrlstat |= 1U << 5U;
+        swd_sim.ack = 4U;
+        swd_sim.stats.acks_fault++;
+        return;
+    }
+
+    if (!read)
+        return;
+
+    if (ap)
+    {
+        swd_sim.stats.ap_reads++;
+        swd_sim.data = swd_sim.rdbuff;
+        swd_sim.rdbuff = swd_sim_ap_read(reg);
+        return;
+    }
+
+    swd_sim.stats.dp_reads++;
+    switch (reg)
+    {
+    case 0x0U:
+        swd_sim.data = SWD_SIM_DPIDR;
+        break;
+    case 0x4U:
+        /* Power-up requests are acknowledged at once */
+        swd_sim.data = swd_sim.ctrlstat | ((swd_sim.ctrlstat & 0x50000000U) << 1U);
+        break;
+    case 0x8U:
+        swd_sim.data = 0;
+        break;
+    default:
+        swd_sim.data = swd_sim.rdbuff;
+        break;
+    }
+}
+
+static void swd_sim_write_done(void)
+{
+    const bool ap = swd_sim.request & 0x02U;
+    const uint8_t reg = (swd_sim.request >> 1U) & 0x0cU;
+
+    if (swd_sim_parity(swd_sim.shift) != (swd_sim.bit & 1U))
+    {
+        swd_sim.stats.parity_errors++;
+        swd_sim.ctrlstat |= 1U << 7U;
+        return;
+    }
+
+    if (ap)
+    {
+        swd_sim.stats.ap_writes++;
+        swd_sim_ap_write(reg, swd_sim.shift);
+        return;
+    }
+
+    swd_sim.stats.dp_writes++;
+    switch (reg)
+    {
+    case 0x0U:
+        /* ABORT: STKERRCLR, WDERRCLR, ORUNERRCLR */
+        if (swd_sim.shift & (1U << 2U))
+            swd_sim.ctrlstat &= ~(1U << 5U);
+        if (swd_sim.shift & (1U << 3U))
+            swd_sim.ctrlstat &= ~(1U << 7U);
+        if (swd_sim.shift & (1U << 4U))
+            swd_sim.ctrlstat &= ~(1U << 1U);
+        break;
+    case 0x4U:
+        swd_sim.ctrlstat = (swd_sim.ctrlstat & 0xa2U) | (swd_sim.shift & 0x50000f00U);
+        break;
+    case 0x8U:
+        swd_sim.select = swd_sim.shift;
+        break;
+    default:
+        break;
+    }
+}
+
+static void swd_sim_drive(bool driving)
+{
+    if (driving != swd_sim.driving)
+        swd_sim.stats.turnarounds++;
+    swd_sim.driving = driving;
+}
+
+/* One SWCLK rising edge */
+static void swd_sim_edge(bool swdio)
+{
+    swd_sim.stats.cycles++;
+
+    if (!swd_sim.driving)
+    {
+        swd_sim.ones = swdio ? swd_sim.ones + 1U : 0;
+        if (swd_sim.ones == SWD_SIM_LINE_RESET)
+        {
+            swd_sim.stats.line_resets++;
+            swd_sim.state = SWD_SIM_IDLE;
+            swd_sim.packet_end = false;
+            swd_sim.selected = false;
+        }
+    }
+
+    switch (swd_sim.state)
+    {
+    case SWD_SIM_LOCKOUT:
+        break;
+    case SWD_SIM_IDLE:
+        /* A start bit right after a packet, or after at least one idle low */
+        if (swdio && (swd_sim.packet_end || swd_sim.ones == 1U))
+        {
+            swd_sim.state = SWD_SIM_REQUEST;
+            swd_sim.request = 1U;
+            swd_sim.bit = 1U;
+        }
+        else
+            swd_sim.stats.idle_cycles++;
+        swd_sim.packet_end = false;
+        break;
+    case SWD_SIM_REQUEST:
+        swd_sim.request |= (uint8_t)(swdio << swd_sim.bit);
+        if (++swd_sim.bit < 8U)
+            break;
+        /* Stop bit low, park bit high, parity over APnDP, RnW, A[3:2] */
+        if ((swd_sim.request & 0xc0U) != 0x80U ||
+            swd_sim_parity((swd_sim.request >> 1U) & 0xfU) != ((swd_sim.request >> 5U) & 1U))
+        {
+            /*
+             * Before the first packet this is a switching sequence such as
+             * JTAG-to-SWD, and eight ones are the start of a line reset
+             */
+            if (swd_sim.selected && swd_sim.request != 0xffU)
+                swd_sim.stats.protocol_errors++;
+            swd_sim.state = SWD_SIM_LOCKOUT;
+            break;
+        }
+        swd_sim.selected = true;
+        swd_sim_respond();
+        swd_sim.state = SWD_SIM_TRN_TARGET;
+        break;
+    case SWD_SIM_TRN_TARGET:
+        swd_sim_drive(true);
+        swd_sim.output = swd_sim.ack & 1U;
+        swd_sim.bit = 1U;
+        swd_sim.state = SWD_SIM_ACK;
+        break;
+    case SWD_SIM_ACK:
+        if (swd_sim.bit < 3U)
+        {
+            swd_sim.output = (swd_sim.ack >> swd_sim.bit++) & 1U;
+            break;
+        }
+        if (swd_sim.ack != 1U)
+        {
+            swd_sim.state = SWD_SIM_TRN_HOST;
+            swd_sim_drive(false);
+        }
+        else if (swd_sim.request & 0x04U)
+        {
+            swd_sim.shift = swd_sim.data;
+            swd_sim.output = swd_sim.shift & 1U;
+            swd_sim.bit = 1U;
+            swd_sim.state = SWD_SIM_READ;
+        }
+        else
+        {
+            swd_sim_drive(false);
+            swd_sim.state = SWD_SIM_TRN_WRITE;
+        }
+        break;
+    case SWD_SIM_READ:
+        if (swd_sim.bit < 32U)
+            swd_sim.output = (swd_sim.shift >> swd_sim.bit) & 1U;
+        else if (swd_sim.bit == 32U)
+        {
+            const bool corrupt = swd_sim.inject_parity >= 0 && swd_sim.inject_parity-- == 0;
+            swd_sim.output = swd_sim_parity(swd_sim.shift) ^ corrupt;
+        }
+        else
+        {
+            swd_sim_drive(false);
+            swd_sim.state = SWD_SIM_TRN_HOST;
+        }
+        swd_sim.bit++;
+        break;
+    case SWD_SIM_TRN_HOST:
+        swd_sim.state = SWD_SIM_IDLE;
+        swd_sim.packet_end = true;
+        swd_sim.ones = 0;
+        break;
+    case SWD_SIM_TRN_WRITE:
+        swd_sim.shift = 0;
+        swd_sim.bit = 0;
+        swd_sim.state = SWD_SIM_WRITE;
+        swd_sim.ones = 0;
+        break;
+    case SWD_SIM_WRITE:
+        if (swd_sim.bit < 32U)
+            swd_sim.shift |= (uint32_t)swdio << swd_sim.bit++;
+        else
+        {
+            swd_sim.bit = swdio;
+            swd_sim_write_done();
+            swd_sim.state = SWD_SIM_IDLE;
+            swd_sim.packet_end = true;
+            swd_sim.ones = 0;
+        }
+        break;
+    }
+}
+
+void swd_sim_pins_write(uint32_t mask, uint32_t value)
+{
+    const uint32_t pins = (swd_sim.pins & ~mask) | (value & mask);
+    const bool rising = (pins & 1U) && !(swd_sim.pins & 1U);
+    swd_sim.pins = pins;
+    if (rising)
+        swd_sim_edge((pins >> 1U) & 1U);
+}
+
+uint32_t swd_sim_pins_read(void)
+{
+    /* SWDIO is pulled up while neither side drives it */
+    const bool swdio = swd_sim.driving ? swd_sim.output : (swd_sim.pins >> 1U) & 1U;
+    return (uint32_t)swdio << 1U;
+}
+
+struct host_dedic_bundle
+{
+    int unused;
+};
+
+static struct host_dedic_bundle swd_sim_bundle;
+
+esp_err_t dedic_gpio_new_bundle(const dedic_gpio_bundle_config_t *config, dedic_gpio_bundle_handle_t *ret_bundle)
+{
+    if (config->array_size != 2U)
+        return ESP_ERR_INVALID_ARG;
+    *ret_bundle = &swd_sim_bundle;
+    return ESP_OK;
+}
+
+esp_err_t dedic_gpio_del_bundle(dedic_gpio_bundle_handle_t bundle)
+{
+    (void)bundle;
+    return ESP_OK;
+}
+
+esp_err_t dedic_gpio_get_out_offset(dedic_gpio_bundle_handle_t bundle, uint32_t *offset)
+{
+    (void)bundle;
+    *offset = 0;
+    return ESP_OK;
+}
+
+esp_err_t dedic_gpio_get_in_offset(dedic_gpio_bundle_handle_t bundle, uint32_t *offset)
+{
+    (void)bundle;
+    *offset = 0;
+    return ESP_OK;
+}
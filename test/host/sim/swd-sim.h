@@ -0,0 +1,130 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Cycle-level model of an SWD target: SW-DP, one MEM-AP and a Cortex-M
+ * memory map behind it, clocked by the dedicated GPIO bundle pins of the
+ * host build. Every SWCLK rising edge is one protocol cycle, so the
+ * counters below are exact for whatever tap, ADI and GDB code drives it.
+ */
+
+#define SWD_SIM_FLASH_BASE 0x08000000U
+#define SWD_SIM_FLASH_SIZE (512U * 1024U)
+#define SWD_SIM_FLASH_PAGE 2048U
+#define SWD_SIM_RAM_BASE 0x20000000U
+#define SWD_SIM_RAM_SIZE (128U * 1024U)
+
+/* Flash controller, unlock with the two keys, then PG for word writes or PER/STRT for a page erase */
+#define SWD_SIM_FLASH_KEYR 0x40022004U
+#define SWD_SIM_FLASH_SR 0x4002200cU
+#define SWD_SIM_FLASH_CR 0x40022010U
+#define SWD_SIM_FLASH_AR 0x40022014U
+#define SWD_SIM_FLASH_KEY1 0x45670123U
+#define SWD_SIM_FLASH_KEY2 0xcdef89abU
+#define SWD_SIM_FLASH_CR_PG (1U << 0U)
+#define SWD_SIM_FLASH_CR_PER (1U << 1U)
+#define SWD_SIM_FLASH_CR_STRT (1U << 6U)
+#define SWD_SIM_FLASH_CR_LOCK (1U << 7U)
+#define SWD_SIM_FLASH_SR_EOP (1U << 5U)
+
+/* Free running counter, a register that changes on every read */
+#define SWD_SIM_COUNTER 0x40000024U
+
+#define SWD_SIM_DPIDR 0x2ba01477U
+#define SWD_SIM_AP_IDR 0x24770011U
+
+typedef struct
+{
+    uint64_t cycles;          /* SWCLK rising edges */
+    uint64_t idle_cycles;     /* host driven cycles outside a packet */
+    uint64_t turnarounds;     /* SWDIO direction changes */
+    uint32_t line_resets;
+    uint32_t packets;         /* requests with a valid header */
+    uint32_t ap_reads;
+    uint32_t ap_writes;
+    uint32_t dp_reads;
+    uint32_t dp_writes;
+    uint32_t acks_wait;
+    uint32_t acks_fault;
+    uint32_t protocol_errors; /* bad request header, target stays silent until a line reset */
+    uint32_t parity_errors;   /* write data with bad parity */
+} SWDSimStats;
+
+/**
+ * Power up the target: erased flash, zeroed RAM, core halted, counters cleared
+ */
+void swd_sim_reset(void);
+
+/**
+ * Get protocol counters
+ * @param stats
+ */
+void swd_sim_get_stats(SWDSimStats *stats);
+
+/**
+ * Clear protocol counters and RAM write counts
+ */
+void swd_sim_reset_stats(void);
+
+/**
+ * MEM-AP writes that reached a RAM word since the counters were cleared
+ * @param addr
+ * @return uint32_t
+ */
+uint32_t swd_sim_ram_writes(uint32_t addr);
+
+/**
+ * Wall time of a number of cycles at an SWCLK frequency
+ * @param cycles
+ * @param frequency Hz
+ * @return uint64_t ns
+ */
+uint64_t swd_sim_cycles_to_ns(uint64_t cycles, uint32_t frequency);
+
+/**
+ * Answer WAIT to AP accesses or RDBUFF reads
+ * @param after accesses that still go through, counted from now
+ * @param count accesses answered with WAIT after those
+ */
+void swd_sim_inject_wait(uint32_t after, uint32_t count);
+
+/**
+ * Make an AP access fail with a bus error, answered with FAULT from then on
+ * until STICKYERR is cleared through ABORT
+ * @param after AP accesses that still succeed, counted from now
+ */
+void swd_sim_inject_fault(uint32_t after);
+
+/**
+ * Send a read with wrong data parity
+ * @param after reads that still go out right, counted from now
+ */
+void swd_sim_inject_parity(uint32_t after);
+
+/**
+ * Direct access to simulated RAM or flash, bypassing SWD
+ * @param addr
+ * @param len
+ * @return uint8_t* NULL unless the whole range is RAM or flash
+ */
+uint8_t *swd_sim_memory(uint32_t addr, size_t len);
+
+/**
+ * Let the core run or stop it as if it hit a breakpoint
+ * @param running
+ */
+void swd_sim_set_running(bool running);
+
+/**
+ * @return bool core halted
+ */
+bool swd_sim_halted(void);
+
+/**
+ * Direct access to a core register
+ * @param reg DCRSR register number
+ * @return uint32_t* NULL for unknown registers
+ */
+uint32_t *swd_sim_core_reg(uint32_t reg);
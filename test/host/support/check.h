@@ -0,0 +1,28 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Host test assertions, a failed check ends the test binary with status 1 */
+
+#define CHECK(cond)                                                                  \
+    do                                                                               \
+    {                                                                                \
+        if (!(cond))                                                                 \
+        {                                                                            \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                                 \
+        }                                                                            \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                            \
+    do                                                                                        \
+    {                                                                                         \
+        const long long check_actual = (long long)(actual);                                   \
+        const long long check_expected = (long long)(expected);                               \
+        if (check_actual != check_expected)                                                   \
+        {                                                                                     \
+            fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, \
+                    #actual, #expected, check_actual, check_expected);                        \
+            exit(1);                                                                          \
+        }                                                                                     \
+    } while (0)
@@ -0,0 +1,227 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "general.h"
+#include "platform.h"
+#include "timing.h"
+#include "swd.h"
+#include "jtagtap.h"
+#include "swd-tap.h"
+#include "tap-stats.h"
+#include "adiv5-queue.h"
+#include "swd-sim.h"
+#include "host-platform.h"
+#include <soc/gpio_struct.h>
+#include <hal/dedic_gpio_cpu_ll.h>
+
+/*
+ * Platform layer of the host build, in place of platform.c, swd-tap.c and
+ * auto-speed.c: the pins are the dedicated GPIO bundle wired to the
+ * simulated target, or the GPIO registers for the bit-bang tap, the tap
+ * runs without delays, and scans attach the batched ADIv5 engine as on the
+ * probe.
+ */
+
+int32_t g_pin_swdio = 24;
+int32_t g_pin_swclk = 23;
+int32_t g_pin_tdi = 25;
+int32_t g_pin_tdo = 26;
+int32_t g_pin_trst = -1;
+
+uint32_t swd_delay_cnt = 0;
+uint32_t target_clk_divider = UINT32_MAX;
+
+static uint32_t host_frequency = 0;
+static bool host_dedic = true;
+
+uint64_t host_dedic_access_count = 0;
+
+static void host_gpio_swd_write(uint32_t mask, uint32_t levels);
+static uint32_t host_gpio_swd_read(void);
+
+static const host_gpio_model_t host_gpio_swd = {
+    .write = host_gpio_swd_write,
+    .read = host_gpio_swd_read,
+};
+
+static struct
+{
+    gpio_dev_t regs;
+    const host_gpio_model_t *model;
+    uint64_t accesses;
+} host_gpio = {
+    .model = &host_gpio_swd,
+};
+
+/* SWCLK_PIN and SWDIO_PIN are bundle channels 0 and 1 of the simulated target */
+static void host_gpio_swd_write(uint32_t mask, uint32_t levels)
+{
+    uint32_t channels = 0;
+    uint32_t values = 0;
+    if (mask & (1U << SWCLK_PIN))
+    {
+        channels |= 1U;
+        values |= (levels >> SWCLK_PIN) & 1U;
+    }
+    if (mask & (1U << SWDIO_PIN))
+    {
+        channels |= 2U;
+        values |= ((levels >> SWDIO_PIN) & 1U) << 1U;
+    }
+    if (channels != 0U)
+        swd_sim_pins_write(channels, values);
+}
+
+static uint32_t host_gpio_swd_read(void)
+{
+    return ((swd_sim_pins_read() >> 1U) & 1U) << SWDIO_PIN;
+}
+
+void host_gpio_flush(void)
+{
+    /* One access stores to one register, so at most one of these is set */
+    if (host_gpio.regs.out_w1ts.val != 0U)
+        host_gpio.model->write(host_gpio.regs.out_w1ts.val, UINT32_MAX);
+    if (host_gpio.regs.out_w1tc.val != 0U)
+        host_gpio.model->write(host_gpio.regs.out_w1tc.val, 0);
+    host_gpio.regs.out_w1ts.val = 0;
+    host_gpio.regs.out_w1tc.val = 0;
+    host_gpio.regs.enable_w1ts.val = 0;
+    host_gpio.regs.enable_w1tc.val = 0;
+    host_gpio.regs.in.val = host_gpio.model->read();
+}
+
+gpio_dev_t *host_gpio_access(void)
+{
+    host_gpio.accesses++;
+    host_gpio_flush();
+    return &host_gpio.regs;
+}
+
+void host_gpio_set_model(const host_gpio_model_t *model)
+{
+    host_gpio_flush();
+    host_gpio.model = model != NULL ? model : &host_gpio_swd;
+}
+
+uint64_t host_gpio_accesses(void)
+{
+    return host_gpio.accesses;
+}
+
+void host_gpio_reset_accesses(void)
+{
+    host_gpio.accesses = 0;
+}
+
+uint64_t host_dedic_accesses(void)
+{
+    return host_dedic_access_count;
+}
+
+void host_dedic_reset_accesses(void)
+{
+    host_dedic_access_count = 0;
+}
+
+uint32_t platform_time_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000U + (uint64_t)now.tv_nsec / 1000000U);
+}
+
+void platform_delay(uint32_t ms)
+{
+    struct timespec delay = {.tv_sec = ms / 1000U, .tv_nsec = (long)(ms % 1000U) * 1000000L};
+    nanosleep(&delay, NULL);
+}
+
+void platform_timeout_set(platform_timeout_s *target, uint32_t ms)
+{
+    target->time = platform_time_ms() + ms;
+}
+
+bool platform_timeout_is_expired(const platform_timeout_s *target)
+{
+    return (int32_t)(platform_time_ms() - target->time) > 0;
+}
+
+void platform_max_frequency_set(uint32_t frequency)
+{
+    host_frequency = frequency;
+}
+
+uint32_t platform_max_frequency_get(void)
+{
+    return host_frequency;
+}
+
+/* One output enable store for the three outputs, platform.c also routes the pads */
+void platform_jtag_pins_init(void)
+{
+    GPIO.enable_w1ts.val = (1U << TMS_PIN) | (1U << TDI_PIN) | (1U << TCK_PIN);
+}
+
+/* One output enable store each, platform.c also routes the pad */
+void platform_swdio_mode_float(void)
+{
+    GPIO.enable_w1tc.val = 1U << SWDIO_PIN;
+}
+
+void platform_swdio_mode_drive(void)
+{
+    GPIO.enable_w1ts.val = 1U << SWDIO_PIN;
+}
+
+void platform_gpio_set_level(int32_t gpio_num, uint32_t value)
+{
+    if (value)
+        GPIO.out_w1ts.val = 1U << gpio_num;
+    else
+        GPIO.out_w1tc.val = 1U << gpio_num;
+}
+
+void platform_gpio_set(int32_t gpio_num)
+{
+    GPIO.out_w1ts.val = 1U << gpio_num;
+}
+
+void platform_gpio_clear(int32_t gpio_num)
+{
+    GPIO.out_w1tc.val = 1U << gpio_num;
+}
+
+int platform_gpio_get_level(int32_t gpio_num)
+{
+    return (GPIO.in.val >> gpio_num) & 1U;
+}
+
+void host_platform_set_dedic(bool enable)
+{
+    host_dedic = enable;
+}
+
+void __real_swdptap_init(void);
+
+/* As swd-tap.c: the stock procs first, then the dedicated bundle if selected */
+void __wrap_swdptap_init(void)
+{
+    __real_swdptap_init();
+    swd_dedic_tap_deinit();
+    if (host_dedic)
+        swd_dedic_tap_init();
+    else
+        platform_swdio_mode_drive();
+    tap_stats_install_swd();
+}
+
+bool __real_adiv5_swd_scan(void);
+
+bool __wrap_adiv5_swd_scan(void)
+{
+    const bool result = __real_adiv5_swd_scan();
+    if (result)
+        adiv5_queue_attach();
+    return result;
+}
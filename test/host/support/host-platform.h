@@ -0,0 +1,20 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Knobs of the host platform layer (host-platform.c) for the tests.
+ */
+
+/**
+ * Select the SWD backend installed by the next scan, applied like swd_tap_set()
+ * @param enable true for the dedicated GPIO bundle, false for swdptap.c
+ */
+void host_platform_set_dedic(bool enable);
+
+/**
+ * @return uint64_t dedicated GPIO channel accesses since the last reset
+ */
+uint64_t host_dedic_accesses(void);
+
+void host_dedic_reset_accesses(void);
@@ -0,0 +1,98 @@
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <lwip/sockets.h>
+#include "general.h"
+#include "exception.h"
+#include "gdb_main.h"
+#include "gdb_packet.h"
+#include "target_internal.h"
+#include "gdb-glue.h"
+#include "poll-sched.h"
+#include "network-gdb.h"
+#include "network-reactor.h"
+#include "swd-sim.h"
+#include "host-server.h"
+
+#define HOST_SERVER_GDB_PORT 2345
+#define HOST_SERVER_STACK 4096
+
+/* gdb_application_thread() of main.c without RTT and LP offload */
+static void host_server_gdb_thread(void *parameters)
+{
+    (void)parameters;
+    while (1)
+    {
+        if (gdb_target_running && cur_target)
+            poll_sched_resume();
+        while (gdb_target_running && cur_target)
+        {
+            gdb_glue_target_lock(portMAX_DELAY);
+            gdb_poll_target();
+            if (!gdb_target_running || !cur_target)
+            {
+                gdb_glue_target_unlock();
+                poll_sched_halted();
+                break;
+            }
+            gdb_glue_target_unlock();
+
+            char c = poll_sched_getchar();
+
+            gdb_glue_target_lock(portMAX_DELAY);
+            if (c == '\x03' || c == '\x04')
+                target_halt_request(cur_target);
+            gdb_glue_target_unlock();
+        }
+
+        const gdb_packet_s *const packet = gdb_packet_receive();
+        gdb_glue_target_lock(portMAX_DELAY);
+        /* As upstream main.c: a lost target ends the command, not the probe */
+        TRY (EXCEPTION_ALL)
+        {
+            gdb_main(packet);
+        }
+        CATCH ()
+        {
+        default:
+            gdb_putpacket_str("EFF");
+            target_list_free();
+            cur_target = NULL;
+            gdb_target_running = false;
+        }
+        gdb_glue_target_unlock();
+    }
+}
+
+int host_server_start(void)
+{
+    signal(SIGPIPE, SIG_IGN);
+    host_net_set_ephemeral(1);
+    swd_sim_reset();
+
+    gdb_glue_init();
+    network_gdb_server_init();
+    network_reactor_start();
+    xTaskCreate(host_server_gdb_thread, "gdb_thread", HOST_SERVER_STACK, NULL, 5, NULL);
+
+    const int port = host_net_port(HOST_SERVER_GDB_PORT, 2000);
+    if (port == 0)
+    {
+        fprintf(stderr, "GDB service did not come up\n");
+        exit(1);
+    }
+    return port;
+}
+
+bool host_server_wait_idle(int timeout_ms)
+{
+    for (int waited = 0; network_gdb_connected(); waited++)
+    {
+        if (waited >= timeout_ms)
+            return false;
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * The probe side of the host tests: simulated target, gdb-glue, the
+ * network reactor with the GDB service, and the gdb thread of main.c,
+ * listening on an ephemeral loopback port.
+ */
+
+/**
+ * Start the server, once per process
+ * @return int TCP port of the GDB service
+ */
+int host_server_start(void);
+
+/**
+ * Wait until the GDB service has seen the owner session close
+ * @param timeout_ms
+ * @return bool false if a session is still open
+ */
+bool host_server_wait_idle(int timeout_ms);
@@ -0,0 +1,206 @@
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "rsp-client.h"
+
+bool rsp_connect(RspClient *client, int port)
+{
+    memset(client, 0, sizeof(*client));
+    client->sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (client->sock < 0)
+        return false;
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons((uint16_t)port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    if (connect(client->sock, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        close(client->sock);
+        client->sock = -1;
+        return false;
+    }
+    const int nodelay = 1;
+    setsockopt(client->sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    return true;
+}
+
+void rsp_close(RspClient *client)
+{
+    if (client->sock >= 0)
+        close(client->sock);
+    client->sock = -1;
+}
+
+bool rsp_readable(RspClient *client, int timeout_ms)
+{
+    if (client->start < client->end)
+        return true;
+    struct pollfd fd = {.fd = client->sock, .events = POLLIN};
+    return poll(&fd, 1, timeout_ms) > 0;
+}
+
+/* Next byte from the socket, -1 on timeout or a closed connection */
+static int rsp_getc(RspClient *client, int timeout_ms)
+{
+    if (client->start == client->end)
+    {
+        if (!rsp_readable(client, timeout_ms))
+            return -1;
+        const ssize_t got = recv(client->sock, client->buffer, sizeof(client->buffer), 0);
+        if (got <= 0)
+            return -1;
+        client->start = 0;
+        client->end = (size_t)got;
+        client->rx_wire_bytes += (uint64_t)got;
+    }
+    return client->buffer[client->start++];
+}
+
+bool rsp_send_raw(RspClient *client, const void *data, size_t size)
+{
+    const uint8_t *bytes = data;
+    while (size > 0)
+    {
+        const ssize_t sent = send(client->sock, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return false;
+        client->tx_wire_bytes += (uint64_t)sent;
+        bytes += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+bool rsp_send(RspClient *client, const void *payload, size_t size)
+{
+    static const char hex[] = "0123456789abcdef";
+    const uint8_t *bytes = payload;
+    uint8_t frame[2 * RSP_CLIENT_BUFFER_SIZE + 4];
+    size_t used = 0;
+    uint8_t checksum = 0;
+
+    if (size > RSP_CLIENT_BUFFER_SIZE)
+        return false;
+    frame[used++] = '$';
+    for (size_t i = 0; i < size; i++)
+    {
+        uint8_t byte = bytes[i];
+        if (byte == '$' || byte == '#' || byte == '}' || byte == '*')
+        {
+            frame[used++] = '}';
+            checksum += '}';
+            byte ^= 0x20U;
+        }
+        frame[used++] = byte;
+        checksum += byte;
+    }
+    frame[used++] = '#';
+    frame[used++] = (uint8_t)hex[checksum >> 4];
+    frame[used++] = (uint8_t)hex[checksum & 0xfU];
+    if (!rsp_send_raw(client, frame, used))
+        return false;
+    if (client->noack)
+        return true;
+
+    const int ack = rsp_getc(client, 2000);
+    return ack == '+';
+}
+
+static int rsp_hex_value(int c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+ssize_t rsp_recv(RspClient *client, char *payload, size_t max, int timeout_ms)
+{
+    int c;
+    do
+    {
+        c = rsp_getc(client, timeout_ms);
+        if (c < 0)
+            return -1;
+    } while (c != '$');
+
+    size_t size = 0;
+    uint8_t checksum = 0;
+    bool escape = false;
+    int previous = -1;
+    for (;;)
+    {
+        c = rsp_getc(client, timeout_ms);
+        if (c < 0)
+            return -1;
+        if (c == '#' && !escape)
+            break;
+        checksum += (uint8_t)c;
+
+        if (escape)
+        {
+            escape = false;
+            c ^= 0x20;
+        }
+        else if (c == '}')
+        {
+            escape = true;
+            continue;
+        }
+        else if (c == '*' && previous >= 0)
+        {
+            /* Run length: the count character is the repeat count plus 29 */
+            const int count = rsp_getc(client, timeout_ms);
+            if (count < 0)
+                return -1;
+            checksum += (uint8_t)count;
+            for (int i = 0; i < count - 29; i++)
+            {
+                if (size + 1U >= max)
+                    return -1;
+                payload[size++] = (char)previous;
+            }
+            previous = -1;
+            continue;
+        }
+        if (size + 1U >= max)
+            return -1;
+        payload[size++] = (char)c;
+        previous = c;
+    }
+    payload[size] = '\0';
+
+    const int high = rsp_hex_value(rsp_getc(client, timeout_ms));
+    const int low = rsp_hex_value(rsp_getc(client, timeout_ms));
+    const bool valid = high >= 0 && low >= 0 && (uint8_t)(high << 4 | low) == checksum;
+    if (!client->noack && !rsp_send_raw(client, valid ? "+" : "-", 1))
+        return -1;
+    return valid ? (ssize_t)size : -1;
+}
+
+ssize_t rsp_transact(RspClient *client, const char *request, char *reply, size_t max)
+{
+    if (!rsp_send(client, request, strlen(request)))
+        return -1;
+    for (;;)
+    {
+        const ssize_t size = rsp_recv(client, reply, max, 5000);
+        /* Console output is O followed by hex, unlike the OK reply */
+        if (size > 1 && reply[0] == 'O' && isxdigit((unsigned char)reply[1]))
+            continue;
+        return size;
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+/*
+ * Minimal GDB client for the host tests: frames and escapes packets,
+ * handles acks, and decodes replies the way gdb does (escapes and
+ * run-length encoding), counting the bytes seen on the wire.
+ */
+
+#define RSP_CLIENT_BUFFER_SIZE 65536U
+
+typedef struct
+{
+    int sock;
+    bool noack;
+    uint8_t buffer[RSP_CLIENT_BUFFER_SIZE];
+    size_t start;
+    size_t end;
+    uint64_t rx_wire_bytes;
+    uint64_t tx_wire_bytes;
+} RspClient;
+
+/**
+ * Connect to a loopback port
+ * @param client
+ * @param port
+ * @return bool
+ */
+bool rsp_connect(RspClient *client, int port);
+
+/**
+ * Close the connection
+ * @param client
+ */
+void rsp_close(RspClient *client);
+
+/**
+ * Send bytes unframed, as gdb sends ^C
+ * @param client
+ * @param data
+ * @param size
+ * @return bool
+ */
+bool rsp_send_raw(RspClient *client, const void *data, size_t size);
+
+/**
+ * Send one packet, escaping the payload, and wait for the ack unless in no-ack mode
+ * @param client
+ * @param payload
+ * @param size
+ * @return bool false on a missing ack or a closed connection
+ */
+bool rsp_send(RspClient *client, const void *payload, size_t size);
+
+/**
+ * Receive one packet and ack it unless in no-ack mode
+ * @param client
+ * @param payload decoded payload, NUL terminated
+ * @param max payload buffer size
+ * @param timeout_ms
+ * @return ssize_t payload size, -1 on timeout, bad checksum or a closed connection
+ */
+ssize_t rsp_recv(RspClient *client, char *payload, size_t max, int timeout_ms);
+
+/**
+ * Send a packet and receive its reply, skipping console output packets
+ * @param client
+ * @param request NUL terminated payload
+ * @param reply
+ * @param max
+ * @return ssize_t reply size, -1 on error
+ */
+ssize_t rsp_transact(RspClient *client, const char *request, char *reply, size_t max);
+
+/**
+ * Whether a byte is available within a time
+ * @param client
+ * @param timeout_ms
+ * @return bool
+ */
+bool rsp_readable(RspClient *client, int timeout_ms);
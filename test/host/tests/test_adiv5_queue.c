@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <string.h>
+#include "general.h"
+#include "target.h"
+#include "adiv5-queue.h"
+#include "swd-sim.h"
+#include "check.h"
+
+/*
+ * The batched ADIv5 engine against the stock accessors: same data and same
+ * error result for random ranges, including ranges running into unmapped
+ * memory, and recovery from WAIT, FAULT and read parity errors in the
+ * middle of a batch without writing any word twice.
+ */
+
+#define SPAN 8192U
+#define UNMAPPED_GAP 0x20020000U /* first address past the simulated RAM */
+
+static uint8_t stock[SPAN];
+static uint8_t queued[SPAN];
+static uint32_t seed = 0x12345678U;
+
+static uint32_t next_random(void)
+{
+    seed = seed * 1103515245U + 12345U;
+    return seed >> 8U;
+}
+
+static void fill_ram(void)
+{
+    uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, SWD_SIM_RAM_SIZE);
+    for (size_t i = 0; i < SWD_SIM_RAM_SIZE; i++)
+        ram[i] = (uint8_t)(i ^ (i >> 7U) ^ (i >> 13U));
+}
+
+static bool read_with(target_s *target, bool queue, uint8_t *dest, uint32_t addr, size_t len)
+{
+    adiv5_queue_set_enabled(queue);
+    memset(dest, 0xa5, SPAN);
+    return target_mem32_read(target, dest, addr, len);
+}
+
+static void test_read_equivalence(target_s *target)
+{
+    for (int round = 0; round < 300; round++)
+    {
+        /* Mostly aligned, so the batched path does the work */
+        const bool aligned = next_random() % 4U != 0;
+        size_t len = next_random() % SPAN + 1U;
+        uint32_t addr = SWD_SIM_RAM_BASE + next_random() % (SWD_SIM_RAM_SIZE - SPAN);
+        if (aligned)
+        {
+            addr &= ~3U;
+            len = (len + 3U) & ~3U;
+        }
+        /* Every tenth range runs off the end of RAM into a bus error */
+        if (round % 10 == 9)
+            addr = UNMAPPED_GAP - (uint32_t)(len / 2U & ~3U);
+
+        const bool stock_error = read_with(target, false, stock, addr, len);
+        const bool queued_error = read_with(target, true, queued, addr, len);
+        CHECK_EQ(queued_error, stock_error);
+        CHECK_EQ(stock_error, round % 10 == 9);
+        if (!stock_error)
+            CHECK(memcmp(stock, queued, len) == 0);
+    }
+}
+
+static void test_write_equivalence(target_s *target)
+{
+    uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, SWD_SIM_RAM_SIZE);
+    uint8_t data[SPAN];
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = (uint8_t)next_random();
+
+    for (int round = 0; round < 100; round++)
+    {
+        const size_t len = (next_random() % SPAN + 4U) & ~3U;
+        const uint32_t offset = next_random() % (SWD_SIM_RAM_SIZE - SPAN) & ~3U;
+
+        fill_ram();
+        adiv5_queue_set_enabled(false);
+        CHECK(!target_mem32_write(target, SWD_SIM_RAM_BASE + offset, data, len));
+        memcpy(stock, ram + offset, SPAN);
+
+        fill_ram();
+        adiv5_queue_set_enabled(true);
+        CHECK(!target_mem32_write(target, SWD_SIM_RAM_BASE + offset, data, len));
+        CHECK(memcmp(stock, ram + offset, SPAN) == 0);
+        CHECK(memcmp(ram + offset, data, len) == 0);
+    }
+
+    /* A write running into unmapped memory fails on both paths */
+    adiv5_queue_set_enabled(false);
+    const bool stock_error = target_mem32_write(target, UNMAPPED_GAP - 1024U, data, 4096U);
+    adiv5_queue_set_enabled(true);
+    CHECK_EQ(target_mem32_write(target, UNMAPPED_GAP - 1024U, data, 4096U), stock_error);
+    CHECK(stock_error);
+}
+
+static uint32_t fallbacks_since(uint32_t before)
+{
+    uint32_t batches;
+    uint32_t fallbacks;
+    adiv5_queue_get_stats(&batches, &fallbacks);
+    return fallbacks - before;
+}
+
+/*
+ * An injected error in the middle of a 4 KiB transfer. WAIT is retried
+ * inside the batch, FAULT and parity errors hand the rest of the block to
+ * the stock path, and either way every word is written exactly once. A
+ * read fallback repeats at most the two reads in flight: the word whose
+ * data was lost and the one posted behind it.
+ */
+static void check_recovery(target_s *target, const char *name, void (*inject)(uint32_t), uint32_t arg,
+    uint32_t read_fallbacks, uint32_t write_fallbacks)
+{
+    uint32_t batches;
+    uint32_t before;
+    SWDSimStats stats;
+    const uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, 4096U);
+
+    fill_ram();
+    adiv5_queue_set_enabled(true);
+    adiv5_queue_get_stats(&batches, &before);
+    swd_sim_reset_stats();
+    inject(arg);
+    memset(queued, 0, sizeof(queued));
+    CHECK(!target_mem32_read(target, queued, SWD_SIM_RAM_BASE, 4096U));
+    CHECK(memcmp(queued, ram, 4096U) == 0);
+    swd_sim_get_stats(&stats);
+    printf("%-8s read recovered, %u fallback(s), %u AP reads\n", name, fallbacks_since(before), stats.ap_reads);
+    CHECK_EQ(fallbacks_since(before), read_fallbacks);
+    CHECK(stats.ap_reads <= 1024U + 2U * read_fallbacks);
+
+    /* The same for a write */
+    uint8_t data[4096];
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = (uint8_t)~i;
+    adiv5_queue_get_stats(&batches, &before);
+    swd_sim_reset_stats();
+    inject(arg);
+    CHECK(!target_mem32_write(target, SWD_SIM_RAM_BASE, data, sizeof(data)));
+    CHECK(memcmp(ram, data, sizeof(data)) == 0);
+    printf("%-8s write recovered, %u fallback(s)\n", name, fallbacks_since(before));
+    CHECK_EQ(fallbacks_since(before), write_fallbacks);
+    for (uint32_t offset = 0; offset < sizeof(data); offset += 4U)
+        CHECK_EQ(swd_sim_ram_writes(SWD_SIM_RAM_BASE + offset), 1);
+}
+
+static void inject_wait(uint32_t after)
+{
+    swd_sim_inject_wait(after, 3U);
+}
+
+int main(void)
+{
+    swd_sim_reset();
+    CHECK(adiv5_swd_scan());
+    target_s *target = target_attach_n(1, NULL);
+    CHECK(target != NULL);
+
+    fill_ram();
+    test_read_equivalence(target);
+    test_write_equivalence(target);
+
+    /* Stats of the write, the last transfer of each check */
+    SWDSimStats stats;
+    check_recovery(target, "WAIT", inject_wait, 300U, 0, 0);
+    swd_sim_get_stats(&stats);
+    CHECK_EQ(stats.acks_wait, 3);
+    CHECK_EQ(stats.protocol_errors, 0);
+
+    check_recovery(target, "FAULT", swd_sim_inject_fault, 300U, 1, 1);
+    swd_sim_get_stats(&stats);
+    CHECK(stats.acks_fault >= 1U);
+    CHECK_EQ(stats.protocol_errors, 0);
+
+    check_recovery(target, "parity", swd_sim_inject_parity, 300U, 1, 0);
+    swd_sim_get_stats(&stats);
+    CHECK_EQ(stats.protocol_errors, 0);
+    target_detach(target);
+    return 0;
+}
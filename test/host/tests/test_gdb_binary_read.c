@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "general.h"
+#include "hex_utils.h"
+#include "swd-sim.h"
+#include "host-server.h"
+#include "rsp-client.h"
+#include "check.h"
+
+/*
+ * Binary 'x' reads against hex 'm' reads of the same memory over loopback:
+ * both return the same bytes, and the wire bytes and time of each for
+ * code-like RAM and for zeroed RAM, where run-length encoded hex wins.
+ */
+
+#define READ_CHUNK 4096U
+#define READ_SIZE (64U * 1024U)
+
+static char reply[RSP_CLIENT_BUFFER_SIZE];
+static uint8_t data[READ_CHUNK];
+static uint32_t seed = 0x600dd00dU;
+
+typedef struct
+{
+    uint64_t wire_bytes;
+    double ms;
+} ReadCost;
+
+static uint32_t next_random(void)
+{
+    seed = seed * 1103515245U + 12345U;
+    return seed >> 8U;
+}
+
+static ReadCost read_range(RspClient *client, uint32_t base, bool binary)
+{
+    struct timespec start;
+    struct timespec end;
+    const uint64_t before = client->rx_wire_bytes;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t offset = 0; offset < READ_SIZE; offset += READ_CHUNK)
+    {
+        char request[32];
+        snprintf(request, sizeof(request), "%c%x,%x", binary ? 'x' : 'm', base + offset, READ_CHUNK);
+        const ssize_t size = rsp_transact(client, request, reply, sizeof(reply));
+        if (binary)
+        {
+            CHECK_EQ(size, (ssize_t)READ_CHUNK + 1);
+            CHECK(reply[0] == 'b');
+            memcpy(data, reply + 1, READ_CHUNK);
+        }
+        else
+        {
+            CHECK_EQ(size, 2 * (ssize_t)READ_CHUNK);
+            unhexify(data, reply, READ_CHUNK);
+        }
+        CHECK(memcmp(data, swd_sim_memory(base + offset, READ_CHUNK), READ_CHUNK) == 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    const ReadCost cost = {
+        .wire_bytes = client->rx_wire_bytes - before,
+        .ms = (double)(end.tv_sec - start.tv_sec) * 1e3 + (double)(end.tv_nsec - start.tv_nsec) / 1e6,
+    };
+    return cost;
+}
+
+static void compare(RspClient *client, const char *name, uint32_t base, bool binary_smaller)
+{
+    const ReadCost hex = read_range(client, base, false);
+    const ReadCost binary = read_range(client, base, true);
+    printf("%-10s m: %7llu wire bytes %6.1f ms   x: %7llu wire bytes %6.1f ms   x/m wire %.2f\n", name,
+           (unsigned long long)hex.wire_bytes, hex.ms, (unsigned long long)binary.wire_bytes, binary.ms,
+           (double)binary.wire_bytes / (double)hex.wire_bytes);
+    CHECK_EQ(binary.wire_bytes < hex.wire_bytes, binary_smaller);
+}
+
+int main(void)
+{
+    const int port = host_server_start();
+
+    /* After the server start has reset the target: code, then zeroes */
+    uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, 2U * READ_SIZE);
+    for (size_t i = 0; i < READ_SIZE; i++)
+        ram[i] = (uint8_t)next_random();
+    memset(ram + READ_SIZE, 0, READ_SIZE);
+
+    RspClient client;
+    CHECK(rsp_connect(&client, port));
+    CHECK(rsp_transact(&client, "qSupported:multiprocess+", reply, sizeof(reply)) >= 0);
+    CHECK(strstr(reply, "binary-upload+") != NULL);
+    CHECK(rsp_transact(&client, "QStartNoAckMode", reply, sizeof(reply)) >= 0);
+    client.noack = true;
+    CHECK(rsp_transact(&client, "qRcmd,7377645f7363616e", reply, sizeof(reply)) >= 0);
+    CHECK(rsp_transact(&client, "vAttach;1", reply, sizeof(reply)) >= 0);
+
+    compare(&client, "code", SWD_SIM_RAM_BASE, true);
+    compare(&client, "zeroes", SWD_SIM_RAM_BASE + READ_SIZE, false);
+
+    CHECK(rsp_transact(&client, "D", reply, sizeof(reply)) >= 0);
+    rsp_close(&client);
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "general.h"
+#include "swd-sim.h"
+#include "host-server.h"
+#include "rsp-client.h"
+#include "check.h"
+
+/*
+ * A gdb "load" of a 512 KiB image over loopback into the simulated flash,
+ * with the per-packet latency and the throughput, then binary writes
+ * pipelined far past the glue rx stream, so the network task has to stop
+ * reading until the gdb thread has drained it.
+ */
+
+#define IMAGE_SIZE SWD_SIM_FLASH_SIZE
+#define LOAD_CHUNK 8192U
+#define PIPELINE_CHUNK 4096U
+
+static char reply[RSP_CLIENT_BUFFER_SIZE];
+static char request[LOAD_CHUNK + 64U];
+static uint8_t image[IMAGE_SIZE];
+static uint32_t seed = 0x13579bdU;
+
+static uint32_t next_random(void)
+{
+    seed = seed * 1103515245U + 12345U;
+    return seed >> 8U;
+}
+
+static double now_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1e3 + (double)now.tv_nsec / 1e6;
+}
+
+static void attach(RspClient *client)
+{
+    CHECK(rsp_transact(client, "QStartNoAckMode", reply, sizeof(reply)) >= 0);
+    client->noack = true;
+    CHECK(rsp_transact(client, "qRcmd,7377645f7363616e", reply, sizeof(reply)) >= 0);
+    CHECK(rsp_transact(client, "vAttach;1", reply, sizeof(reply)) >= 0);
+    CHECK(strcmp(reply, "T05thread:1;") == 0);
+}
+
+/* Binary packet with a text header, escaped by rsp_send() */
+static size_t binary_request(const char *header, const uint8_t *data, size_t size)
+{
+    const size_t header_size = strlen(header);
+    memcpy(request, header, header_size);
+    memcpy(request + header_size, data, size);
+    return header_size + size;
+}
+
+static void test_load(RspClient *client)
+{
+    /* Code-like image: mostly random, with erased gaps gdb still sends */
+    for (size_t i = 0; i < IMAGE_SIZE; i++)
+        image[i] = (i / 4096U) % 8U == 7U ? 0xffU : (uint8_t)next_random();
+
+    const double start = now_ms();
+    snprintf(request, sizeof(request), "vFlashErase:%x,%x", SWD_SIM_FLASH_BASE, IMAGE_SIZE);
+    CHECK(rsp_transact(client, request, reply, sizeof(reply)) >= 0);
+    CHECK(strcmp(reply, "OK") == 0);
+    const double erased = now_ms();
+
+    double worst = 0;
+    for (uint32_t offset = 0; offset < IMAGE_SIZE; offset += LOAD_CHUNK)
+    {
+        char header[32];
+        snprintf(header, sizeof(header), "vFlashWrite:%x:", SWD_SIM_FLASH_BASE + offset);
+        const size_t size = binary_request(header, image + offset, LOAD_CHUNK);
+
+        const double sent = now_ms();
+        CHECK(rsp_send(client, request, size));
+        CHECK(rsp_recv(client, reply, sizeof(reply), 5000) >= 0);
+        CHECK(strcmp(reply, "OK") == 0);
+        const double latency = now_ms() - sent;
+        if (latency > worst)
+            worst = latency;
+    }
+    CHECK(rsp_transact(client, "vFlashDone", reply, sizeof(reply)) >= 0);
+    CHECK(strcmp(reply, "OK") == 0);
+    const double end = now_ms();
+
+    CHECK(memcmp(swd_sim_memory(SWD_SIM_FLASH_BASE, IMAGE_SIZE), image, IMAGE_SIZE) == 0);
+    const uint32_t packets = IMAGE_SIZE / LOAD_CHUNK;
+    printf("load %u KiB: erase %.1f ms, %u writes, %.2f ms average, %.2f ms worst, %.1f KiB/s\n", IMAGE_SIZE / 1024U,
+           erased - start, packets, (end - erased) / packets, worst, IMAGE_SIZE / 1024.0 / ((end - start) / 1e3));
+}
+
+static void test_pipelined(RspClient *client)
+{
+    uint8_t data[PIPELINE_CHUNK];
+    const uint32_t packets = SWD_SIM_RAM_SIZE / PIPELINE_CHUNK;
+
+    /* Every packet goes out before the first reply is read */
+    const double start = now_ms();
+    for (uint32_t i = 0; i < packets; i++)
+    {
+        char header[32];
+        for (size_t n = 0; n < sizeof(data); n++)
+            data[n] = (uint8_t)(i * 31U + n);
+        snprintf(header, sizeof(header), "X%x,%x:", SWD_SIM_RAM_BASE + i * PIPELINE_CHUNK, PIPELINE_CHUNK);
+        CHECK(rsp_send(client, request, binary_request(header, data, sizeof(data))));
+    }
+    for (uint32_t i = 0; i < packets; i++)
+    {
+        CHECK(rsp_recv(client, reply, sizeof(reply), 5000) >= 0);
+        CHECK(strcmp(reply, "OK") == 0);
+    }
+    const double end = now_ms();
+
+    const uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, SWD_SIM_RAM_SIZE);
+    for (uint32_t i = 0; i < packets; i++)
+    {
+        for (size_t n = 0; n < PIPELINE_CHUNK; n++)
+            CHECK_EQ(ram[i * PIPELINE_CHUNK + n], (uint8_t)(i * 31U + n));
+    }
+    printf("pipelined %u KiB in %u X packets: %.1f ms\n", SWD_SIM_RAM_SIZE / 1024U, packets, end - start);
+}
+
+int main(void)
+{
+    const int port = host_server_start();
+    RspClient client;
+    CHECK(rsp_connect(&client, port));
+    attach(&client);
+
+    test_load(&client);
+    test_pipelined(&client);
+
+    /* The session is still in step afterwards */
+    CHECK(rsp_transact(&client, "?", reply, sizeof(reply)) >= 0);
+    CHECK(strcmp(reply, "S05") == 0);
+    CHECK(rsp_transact(&client, "D", reply, sizeof(reply)) >= 0);
+    rsp_close(&client);
+    return 0;
+}
@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sdkconfig.h>
+#include "general.h"
+#include "target.h"
+#include "target_internal.h"
+#include "swd-sim.h"
+#include "host-server.h"
+#include "rsp-client.h"
+#include "check.h"
+
+/*
+ * Several clients over loopback: the first owns the session, the next
+ * CONFIG_BMP_GDB_OBSERVERS read the owner's target, anything past that is
+ * turned away. While the owner runs the target, observers read live memory
+ * but no registers and no stop reply. The target description and memory
+ * map come through qXfer in windows. Once the owner leaves, the next
+ * client to connect owns the session.
+ */
+
+static char reply[RSP_CLIENT_BUFFER_SIZE];
+
+static const char *transact(RspClient *client, const char *request)
+{
+    CHECK(rsp_transact(client, request, reply, sizeof(reply)) >= 0);
+    return reply;
+}
+
+static void connect_noack(RspClient *client, int port)
+{
+    CHECK(rsp_connect(client, port));
+    CHECK(strcmp(transact(client, "QStartNoAckMode"), "OK") == 0);
+    client->noack = true;
+}
+
+static void attach(RspClient *owner)
+{
+    /* "monitor swd_scan" */
+    CHECK(strcmp(transact(owner, "qRcmd,7377645f7363616e"), "OK") == 0);
+    CHECK(strcmp(transact(owner, "vAttach;1"), "T05thread:1;") == 0);
+}
+
+/* A qXfer document read in small windows, 'm' until the last, 'l' */
+static void xfer(RspClient *observer, const char *object, char *document, size_t size)
+{
+    static const size_t window = 0x100U;
+    char request[96];
+    size_t offset = 0;
+    for (;;)
+    {
+        snprintf(request, sizeof(request), "qXfer:%s:%zx,%zx", object, offset, window);
+        const int length = rsp_transact(observer, request, reply, sizeof(reply));
+        CHECK(length >= 1 && (reply[0] == 'm' || reply[0] == 'l'));
+        CHECK((size_t)length - 1U <= window && offset + (size_t)length - 1U < size);
+        memcpy(document + offset, reply + 1, (size_t)length - 1U);
+        offset += (size_t)length - 1U;
+        if (reply[0] == 'l')
+            break;
+        CHECK_EQ((size_t)length - 1U, window);
+    }
+    document[offset] = '\0';
+}
+
+static void test_xfer(RspClient *observer)
+{
+    static char document[4096];
+    static char expected[4096];
+
+    CHECK(strstr(transact(observer, "qSupported:multiprocess+"), "qXfer:memory-map:read+") != NULL);
+    CHECK(strstr(reply, "qXfer:features:read+") != NULL);
+
+    xfer(observer, "features:read:target.xml", document, sizeof(document));
+    const char *description = target_regs_description(target_list);
+    CHECK(description != NULL && strcmp(document, description) == 0);
+    free((void *)description);
+    CHECK(strlen(document) > 0x100U);
+
+    xfer(observer, "memory-map:read:", document, sizeof(document));
+    CHECK(target_mem_map(target_list, expected, sizeof(expected)));
+    CHECK(strcmp(document, expected) == 0);
+    CHECK(strstr(document, "<memory type=\"flash\"") != NULL);
+
+    /* Past the end of the document */
+    CHECK(strcmp(transact(observer, "qXfer:memory-map:read::10000,100"), "E01") == 0);
+}
+
+static void test_halted(RspClient *owner, RspClient *observers, size_t count)
+{
+    *swd_sim_core_reg(15U) = 0x08000200U;
+    for (size_t i = 0; i < count; i++)
+    {
+        RspClient *observer = &observers[i];
+        CHECK(strcmp(transact(observer, "?"), "S05") == 0);
+        transact(observer, "m20000000,10");
+        CHECK(strcmp(reply, "000102030405060708090a0b0c0d0e0f") == 0);
+        CHECK(rsp_transact(observer, "x20000000,4", reply, sizeof(reply)) == 5);
+        CHECK(reply[0] == 'b' && reply[1] == 0 && reply[4] == 3);
+        transact(observer, "g");
+        CHECK(strncmp(reply + 15 * 8, "00020008", 8) == 0);
+        CHECK(strcmp(transact(observer, "p0f"), "00020008") == 0);
+        test_xfer(observer);
+
+        /* Nothing that changes the target */
+        CHECK(strcmp(transact(observer, "M20000000,1:ff"), "E01") == 0);
+        CHECK(strcmp(transact(observer, "c"), "E01") == 0);
+        CHECK(strcmp(transact(observer, "vCont;c"), "E01") == 0);
+        CHECK(strcmp(transact(observer, "qRcmd,7377645f7363616e"), "E01") == 0);
+        CHECK(swd_sim_halted());
+    }
+    /* The owner is served as before */
+    transact(owner, "m20000000,4");
+    CHECK(strcmp(reply, "00010203") == 0);
+}
+
+static void test_running(RspClient *owner, RspClient *observer)
+{
+    uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, 16U);
+
+    CHECK(rsp_send(owner, "vCont;c", 7));
+    CHECK(!rsp_readable(owner, 100));
+    CHECK(!swd_sim_halted());
+
+    CHECK(strcmp(transact(observer, "?"), "OK") == 0);
+    CHECK(strcmp(transact(observer, "g"), "E01") == 0);
+    CHECK(transact(observer, "p0f")[0] == 'E');
+    ram[0] = 0x5aU;
+    transact(observer, "m20000000,4");
+    CHECK(strcmp(reply, "5a010203") == 0);
+    test_xfer(observer);
+
+    CHECK(rsp_send_raw(owner, "\x03", 1));
+    CHECK(rsp_recv(owner, reply, sizeof(reply), 5000) >= 0);
+    CHECK(strcmp(reply, "T02thread:1;") == 0);
+    CHECK(strcmp(transact(observer, "?"), "S05") == 0);
+    transact(observer, "g");
+    CHECK(strlen(reply) > 16U * 8U);
+}
+
+int main(void)
+{
+    const int port = host_server_start();
+    uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, 256U);
+    for (size_t i = 0; i < 256U; i++)
+        ram[i] = (uint8_t)i;
+
+    RspClient owner;
+    RspClient observers[CONFIG_BMP_GDB_OBSERVERS];
+    connect_noack(&owner, port);
+    for (size_t i = 0; i < CONFIG_BMP_GDB_OBSERVERS; i++)
+    {
+        connect_noack(&observers[i], port);
+        /* No target yet */
+        CHECK(strcmp(transact(&observers[i], "?"), "W00") == 0);
+        CHECK(strcmp(transact(&observers[i], "m20000000,4"), "EFF") == 0);
+        CHECK(strcmp(transact(&observers[i], "vAttach;1"), "E01") == 0);
+        CHECK(strcmp(transact(&observers[i], "qXfer:memory-map:read::0,100"), "EFF") == 0);
+    }
+
+    /* One client too many is closed straight away */
+    RspClient extra;
+    CHECK(rsp_connect(&extra, port));
+    CHECK(rsp_readable(&extra, 2000));
+    CHECK(rsp_recv(&extra, reply, sizeof(reply), 2000) < 0);
+    rsp_close(&extra);
+
+    attach(&owner);
+    test_halted(&owner, observers, CONFIG_BMP_GDB_OBSERVERS);
+    test_running(&owner, &observers[0]);
+
+    /* The owner leaves, the observers stay and the next client takes over */
+    CHECK(strcmp(transact(&owner, "D"), "OK") == 0);
+    rsp_close(&owner);
+    CHECK(host_server_wait_idle(2000));
+    CHECK(rsp_transact(&observers[1], "?", reply, sizeof(reply)) >= 0);
+
+    connect_noack(&owner, port);
+    attach(&owner);
+    CHECK(strcmp(transact(&owner, "M20000000,1:ff"), "OK") == 0);
+    CHECK_EQ(ram[0], 0xff);
+    transact(&observers[1], "m20000000,2");
+    CHECK(strcmp(reply, "ff01") == 0);
+
+    for (size_t i = 0; i < CONFIG_BMP_GDB_OBSERVERS; i++)
+        rsp_close(&observers[i]);
+    CHECK(strcmp(transact(&owner, "D"), "OK") == 0);
+    rsp_close(&owner);
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <string.h>
+#include <esp_cpu.h>
+#include "general.h"
+#include "gdb_packet.h"
+#include "gdb-glue.h"
+#include "gdb-packet-rx.h"
+#include "check.h"
+
+/*
+ * The packet framer of gdb-packet-rx.c against the stock byte-wise
+ * gdb_packet_receive() over the same stream, fed through gdb-glue as the
+ * network task does: reads, register accesses, hex and binary writes with
+ * escapes, and an interrupt, as gdb sends them in no-ack mode. Both have to
+ * return the packet that was framed, then the receive cost of each in
+ * cycles per wire byte. The cycles are host nanoseconds (esp_cpu.h), so
+ * the numbers say nothing about the probe's RISC-V core.
+ */
+
+#define FRAMES 96U
+#define FRAME_MAX 1100U
+#define PASSES 300U
+
+gdb_packet_s *__real_gdb_packet_receive(void);
+gdb_packet_s *__wrap_gdb_packet_receive(void);
+
+typedef struct
+{
+    char wire[FRAME_MAX];
+    size_t wire_size;
+    char payload[GDB_PACKET_BUFFER_SIZE + 1U];
+    size_t payload_size;
+} Frame;
+
+static Frame frames[FRAMES];
+static uint32_t seed = 0x5eed1234U;
+
+static uint32_t next_random(void)
+{
+    seed = seed * 1103515245U + 12345U;
+    return seed >> 8U;
+}
+
+/* Frame a payload the way gdb does, escaping what RSP reserves */
+static void frame(Frame *out, const char *payload, size_t size)
+{
+    uint8_t checksum = 0;
+    size_t wire = 0;
+    out->wire[wire++] = '$';
+    for (size_t i = 0; i < size; i++)
+    {
+        const char c = payload[i];
+        if (c == '$' || c == '#' || c == '}' || c == '*')
+        {
+            out->wire[wire++] = '}';
+            checksum += '}';
+            out->wire[wire++] = (char)(c ^ 0x20);
+            checksum += (uint8_t)(c ^ 0x20);
+        }
+        else
+        {
+            out->wire[wire++] = c;
+            checksum += (uint8_t)c;
+        }
+        CHECK(wire + 3U < FRAME_MAX);
+    }
+    wire += (size_t)snprintf(out->wire + wire, 4, "#%02x", checksum);
+    out->wire_size = wire;
+    memcpy(out->payload, payload, size);
+    out->payload[size] = '\0';
+    out->payload_size = size;
+}
+
+static void build_stream(void)
+{
+    static const char *const queries[] = {"g", "p0f", "vCont;c", "qXfer:memory-map:read::0,400", "m20000000,400"};
+    static const char reserved[] = {'$', '#', '}', '*'};
+    char payload[GDB_PACKET_BUFFER_SIZE];
+
+    for (size_t i = 0; i < FRAMES; i++)
+    {
+        const uint32_t addr = 0x20000000U + (next_random() & 0xfffcU);
+        int size;
+        switch (i % 6U)
+        {
+        case 0:
+        case 1:
+            size = snprintf(payload, sizeof(payload), "%c%x,%x", i % 2U ? 'x' : 'm', addr, next_random() % 0x400U + 1U);
+            break;
+        case 2:
+        {
+            /* Hex write */
+            const size_t bytes = next_random() % 480U + 1U;
+            size = snprintf(payload, sizeof(payload), "M%x,%zx:", addr, bytes);
+            for (size_t b = 0; b < bytes; b++)
+                size += snprintf(payload + size, 3, "%02x", next_random() & 0xffU);
+            break;
+        }
+        case 3:
+        {
+            /* Binary write, some bytes needing an escape */
+            const size_t bytes = next_random() % 800U + 1U;
+            size = snprintf(payload, sizeof(payload), "X%x,%zx:", addr, bytes);
+            for (size_t b = 0; b < bytes; b++)
+            {
+                const uint32_t r = next_random();
+                payload[size++] = r % 16U == 0 ? reserved[(r >> 4U) % 4U] : (char)(r >> 8U);
+            }
+            break;
+        }
+        default:
+            size = snprintf(payload, sizeof(payload), "%s", queries[next_random() % ARRAY_LENGTH(queries)]);
+            break;
+        }
+        frame(&frames[i], payload, (size_t)size);
+    }
+
+    /* An interrupt, passed through as a one byte packet */
+    frames[FRAMES / 2U].wire[0] = '\x03';
+    frames[FRAMES / 2U].wire_size = 1;
+    frames[FRAMES / 2U].payload[0] = '\x03';
+    frames[FRAMES / 2U].payload[1] = '\0';
+    frames[FRAMES / 2U].payload_size = 1;
+}
+
+/* Cycles spent receiving the whole stream PASSES times */
+static uint64_t receive_all(const char *name, gdb_packet_s *(*receive)(void))
+{
+    uint64_t cycles = 0;
+    uint64_t bytes = 0;
+    for (size_t pass = 0; pass < PASSES; pass++)
+    {
+        for (size_t i = 0; i < FRAMES; i++)
+        {
+            const Frame *expected = &frames[i];
+            gdb_glue_receive((uint8_t *)expected->wire, expected->wire_size);
+            const uint32_t start = esp_cpu_get_cycle_count();
+            const gdb_packet_s *packet = receive();
+            cycles += esp_cpu_get_cycle_count() - start;
+            bytes += expected->wire_size;
+
+            CHECK_EQ(packet->size, expected->payload_size);
+            CHECK(memcmp(packet->data, expected->payload, expected->payload_size) == 0);
+        }
+    }
+    printf("%-8s %8llu bytes %6.2f cycles/byte\n", name, (unsigned long long)bytes, (double)cycles / (double)bytes);
+    return cycles;
+}
+
+int main(void)
+{
+    gdb_glue_init();
+    gdb_set_noackmode(true);
+    build_stream();
+
+    const uint64_t stock = receive_all("stock", __real_gdb_packet_receive);
+    gdb_packet_rx_reset_stats();
+    const uint64_t framer = receive_all("framer", __wrap_gdb_packet_receive);
+    printf("framer/stock %.2f\n", (double)framer / (double)stock);
+
+    /* Everything but the interrupt was framed in place */
+    GDBPacketRxStats stats;
+    gdb_packet_rx_get_stats(&stats);
+    CHECK_EQ(stats.fast_packets, (FRAMES - 1U) * PASSES);
+    CHECK_EQ(stats.fallback_packets, PASSES);
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "general.h"
+#include "hex_utils.h"
+#include "swd-sim.h"
+#include "host-server.h"
+#include "rsp-client.h"
+#include "check.h"
+
+/*
+ * Replies sent by gdb_packet_tx_send() over loopback: binary 'x' replies
+ * dense enough in escaped bytes to take several iovec lists, and 'm'
+ * reads of the whole simulated RAM for the wire throughput.
+ */
+
+#define THROUGHPUT_CHUNK 4096U
+#define THROUGHPUT_PASSES 4U
+#define ESCAPE_BLOCK 4096U
+
+static char reply[RSP_CLIENT_BUFFER_SIZE];
+static uint8_t decoded[THROUGHPUT_CHUNK];
+static uint32_t seed = 0x2468aceU;
+
+static uint32_t next_random(void)
+{
+    seed = seed * 1103515245U + 12345U;
+    return seed >> 8U;
+}
+
+static void attach(RspClient *client)
+{
+    CHECK(rsp_transact(client, "QStartNoAckMode", reply, sizeof(reply)) >= 0);
+    CHECK(strcmp(reply, "OK") == 0);
+    client->noack = true;
+    CHECK(rsp_transact(client, "qRcmd,7377645f7363616e", reply, sizeof(reply)) >= 0);
+    CHECK(rsp_transact(client, "vAttach;1", reply, sizeof(reply)) >= 0);
+    CHECK(strcmp(reply, "T05thread:1;") == 0);
+}
+
+/*
+ * RAM is filled once: the reads are served from the halted-target cache,
+ * which does not see changes made behind the probe's back.
+ */
+static void fill_ram(void)
+{
+    static const uint8_t escaped[] = {'$', '#', '}', '*'};
+    uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, SWD_SIM_RAM_SIZE);
+
+    /* Every byte escaped in the first block, then one in two and one in eight, then random */
+    for (size_t i = 0; i < SWD_SIM_RAM_SIZE; i++)
+    {
+        const uint32_t r = next_random();
+        const size_t block = i / ESCAPE_BLOCK;
+        const bool escape = block == 0 || (block == 1 && r % 2U == 0) || (block == 2 && r % 8U == 0);
+        ram[i] = escape ? escaped[r % 4U] : (uint8_t)(r >> 4U);
+    }
+}
+
+static void test_escapes(RspClient *client)
+{
+    static const size_t lengths[] = {1U, 2U, 15U, 16U, 17U, 33U, 100U, 1000U, 4000U};
+    const uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, SWD_SIM_RAM_SIZE);
+
+    for (uint32_t block = 0; block < 3U; block++)
+    {
+        for (size_t n = 0; n < sizeof(lengths) / sizeof(lengths[0]); n++)
+        {
+            char request[32];
+            const uint32_t offset = block * ESCAPE_BLOCK + next_random() % 64U;
+            const size_t len = lengths[n];
+            snprintf(request, sizeof(request), "x%x,%zx", SWD_SIM_RAM_BASE + offset, len);
+            CHECK_EQ(rsp_transact(client, request, reply, sizeof(reply)), (ssize_t)len + 1);
+            CHECK(reply[0] == 'b');
+            CHECK(memcmp(reply + 1, ram + offset, len) == 0);
+        }
+    }
+}
+
+static void test_throughput(RspClient *client)
+{
+    const uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, SWD_SIM_RAM_SIZE);
+    const uint64_t wire_before = client->rx_wire_bytes;
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t pass = 0; pass < THROUGHPUT_PASSES; pass++)
+    {
+        for (uint32_t offset = 0; offset < SWD_SIM_RAM_SIZE; offset += THROUGHPUT_CHUNK)
+        {
+            char request[32];
+            snprintf(request, sizeof(request), "m%x,%x", SWD_SIM_RAM_BASE + offset, THROUGHPUT_CHUNK);
+            CHECK_EQ(rsp_transact(client, request, reply, sizeof(reply)), 2 * THROUGHPUT_CHUNK);
+            unhexify(decoded, reply, THROUGHPUT_CHUNK);
+            CHECK(memcmp(decoded, ram + offset, THROUGHPUT_CHUNK) == 0);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    const double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    const double bytes = (double)THROUGHPUT_PASSES * SWD_SIM_RAM_SIZE;
+    printf("m reads: %.0f KiB in %.3f s, %.1f KiB/s, %.2f wire bytes per byte\n", bytes / 1024.0, seconds,
+           bytes / 1024.0 / seconds, (double)(client->rx_wire_bytes - wire_before) / bytes);
+}
+
+int main(void)
+{
+    const int port = host_server_start();
+    RspClient client;
+    CHECK(rsp_connect(&client, port));
+    fill_ram();
+    attach(&client);
+
+    test_escapes(&client);
+    test_throughput(&client);
+
+    CHECK(rsp_transact(&client, "D", reply, sizeof(reply)) >= 0);
+    rsp_close(&client);
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <string.h>
+#include "general.h"
+#include "hex_utils.h"
+#include "gdb-rle.h"
+#include "swd-sim.h"
+#include "host-server.h"
+#include "rsp-client.h"
+#include "check.h"
+
+/*
+ * Run-length encoding of replies: the encoder output decoded the way gdb
+ * does (remote.c read_frame) against the raw payload for random payloads,
+ * then the wire bytes of 'm' reads of representative images over
+ * loopback with and without encoding.
+ */
+
+#define PAYLOAD_MAX 4096U
+#define IMAGE_CHUNK 4096U
+#define IMAGE_SIZE (4U * IMAGE_CHUNK)
+
+static uint8_t raw[PAYLOAD_MAX];
+static uint8_t encoded[PAYLOAD_MAX];
+static uint8_t streamed[PAYLOAD_MAX];
+static uint8_t decoded[PAYLOAD_MAX * 4U];
+static char reply[RSP_CLIENT_BUFFER_SIZE];
+static uint8_t image[IMAGE_CHUNK];
+static uint32_t seed = 0xfeedf00dU;
+
+static uint32_t next_random(void)
+{
+    seed = seed * 1103515245U + 12345U;
+    return seed >> 8U;
+}
+
+/* gdb's view: '*' repeats the previous payload character count - 29 times */
+static size_t rle_decode(const uint8_t *data, size_t size, uint8_t *out)
+{
+    size_t written = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        if (data[i] == '*')
+        {
+            CHECK(written > 0 && i + 1U < size);
+            const int repeat = data[++i] - 29;
+            CHECK(repeat >= 3 && repeat != 6 && repeat != 7 && repeat <= 97);
+            for (int n = 0; n < repeat; n++, written++)
+                out[written] = out[written - 1U];
+        }
+        else
+            out[written++] = data[i];
+    }
+    return written;
+}
+
+/* Escaped payload as gdb_packet.c hands it on: runs of hex digits, binary and escapes */
+static size_t random_payload(void)
+{
+    static const uint8_t special[] = {'0', 'f', ' ', '}', '*', '#', '$', 0x7eU};
+    const size_t size = next_random() % PAYLOAD_MAX + 1U;
+    size_t written = 0;
+    while (written < size)
+    {
+        const uint32_t r = next_random();
+        uint8_t c = r % 3U == 0 ? special[(r >> 2U) % sizeof(special)] : (uint8_t)(r >> 4U);
+        size_t run = r % 5U == 0 ? (r >> 8U) % 300U + 1U : (r >> 8U) % 3U + 1U;
+        for (; run > 0 && written < size; run--)
+        {
+            if (c == '}' || c == '*' || c == '#' || c == '$')
+            {
+                if (written + 2U > size)
+                    break;
+                raw[written++] = '}';
+                raw[written++] = c ^ 0x20U;
+            }
+            else
+                raw[written++] = c;
+        }
+        /* No room left for an escape pair */
+        if (run > 0 && written < size)
+            raw[written++] = 'a';
+    }
+    return written;
+}
+
+static void test_decode_equivalence(void)
+{
+    uint64_t raw_total = 0;
+    uint64_t encoded_total = 0;
+
+    for (int round = 0; round < 2000; round++)
+    {
+        const size_t size = random_payload();
+
+        /* In place, as the platform replies use it */
+        memcpy(encoded, raw, size);
+        const size_t encoded_size = gdb_rle_encode(encoded, size);
+        CHECK(encoded_size <= size);
+
+        /* Byte by byte, as gdb-glue.c rewrites stock replies */
+        GDBRle rle;
+        size_t streamed_size = 0;
+        uint8_t out[GDB_RLE_OUT_MAX];
+        gdb_rle_init(&rle);
+        for (size_t i = 0; i < size; i++)
+        {
+            const size_t n = gdb_rle_push(&rle, raw[i], out);
+            CHECK(n <= GDB_RLE_OUT_MAX);
+            memcpy(streamed + streamed_size, out, n);
+            streamed_size += n;
+        }
+        const size_t n = gdb_rle_flush(&rle, out);
+        memcpy(streamed + streamed_size, out, n);
+        streamed_size += n;
+        CHECK_EQ(streamed_size, encoded_size);
+        CHECK(memcmp(streamed, encoded, encoded_size) == 0);
+
+        /* Never a bare '#' or '$' in the packet, and the same bytes back */
+        for (size_t i = 0; i < encoded_size; i++)
+        {
+            const bool escaped = i > 0 && encoded[i - 1U] == '}';
+            CHECK(escaped || (encoded[i] != '#' && encoded[i] != '$'));
+        }
+        CHECK_EQ(rle_decode(encoded, encoded_size, decoded), size);
+        CHECK(memcmp(decoded, raw, size) == 0);
+
+        raw_total += size;
+        encoded_total += encoded_size;
+    }
+    printf("random payloads: %llu bytes encoded to %llu\n", (unsigned long long)raw_total,
+           (unsigned long long)encoded_total);
+}
+
+static uint64_t read_image(RspClient *client, uint32_t base)
+{
+    const uint64_t before = client->rx_wire_bytes;
+    for (uint32_t offset = 0; offset < IMAGE_SIZE; offset += IMAGE_CHUNK)
+    {
+        char request[32];
+        snprintf(request, sizeof(request), "m%x,%x", base + offset, IMAGE_CHUNK);
+        CHECK_EQ(rsp_transact(client, request, reply, sizeof(reply)), 2 * IMAGE_CHUNK);
+        unhexify(image, reply, IMAGE_CHUNK);
+        CHECK(memcmp(image, swd_sim_memory(base + offset, IMAGE_CHUNK), IMAGE_CHUNK) == 0);
+    }
+    return client->rx_wire_bytes - before;
+}
+
+/* Wire bytes of one image without and with encoding, as a fraction */
+static double image_savings(RspClient *client, const char *name, uint32_t base)
+{
+    gdb_rle_set_enabled(false);
+    const uint64_t plain = read_image(client, base);
+    gdb_rle_set_enabled(true);
+    const uint64_t rle = read_image(client, base);
+    const double saved = 1.0 - (double)rle / (double)plain;
+    printf("%-18s %7llu wire bytes hex, %7llu with RLE, %5.1f%% saved\n", name, (unsigned long long)plain,
+           (unsigned long long)rle, saved * 100.0);
+    CHECK(rle <= plain);
+    return saved;
+}
+
+int main(void)
+{
+    test_decode_equivalence();
+
+    const int port = host_server_start();
+
+    /* Images, after the server start has reset the target: erased flash, zeroed RAM, code, and code with zero and erased padding */
+    uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, 3U * IMAGE_SIZE);
+    memset(ram, 0, IMAGE_SIZE);
+    for (size_t i = 0; i < IMAGE_SIZE; i++)
+        ram[IMAGE_SIZE + i] = (uint8_t)next_random();
+    for (size_t i = 0; i < IMAGE_SIZE; i++)
+    {
+        const size_t block = i / 512U;
+        ram[2U * IMAGE_SIZE + i] = block % 4U == 1U ? 0 : block % 4U == 3U ? 0xffU : (uint8_t)next_random();
+    }
+
+    RspClient client;
+    CHECK(rsp_connect(&client, port));
+    CHECK(rsp_transact(&client, "QStartNoAckMode", reply, sizeof(reply)) >= 0);
+    client.noack = true;
+    CHECK(rsp_transact(&client, "qRcmd,7377645f7363616e", reply, sizeof(reply)) >= 0);
+    CHECK(rsp_transact(&client, "vAttach;1", reply, sizeof(reply)) >= 0);
+
+    CHECK(image_savings(&client, "erased flash", SWD_SIM_FLASH_BASE) > 0.9);
+    CHECK(image_savings(&client, "zeroed RAM", SWD_SIM_RAM_BASE) > 0.9);
+    image_savings(&client, "code", SWD_SIM_RAM_BASE + IMAGE_SIZE);
+    CHECK(image_savings(&client, "code with padding", SWD_SIM_RAM_BASE + 2U * IMAGE_SIZE) > 0.3);
+
+    CHECK(rsp_transact(&client, "D", reply, sizeof(reply)) >= 0);
+    rsp_close(&client);
+    return 0;
+}
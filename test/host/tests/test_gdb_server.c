@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <string.h>
+#include "general.h"
+#include "swd-sim.h"
+#include "host-server.h"
+#include "rsp-client.h"
+#include "check.h"
+
+/*
+ * A gdb session over loopback against the whole probe stack: network
+ * reactor, GDB service, gdb-glue, the platform packet layers and
+ * gdb_main() on the simulated target.
+ */
+
+static char reply[RSP_CLIENT_BUFFER_SIZE];
+
+static const char *transact(RspClient *client, const char *request)
+{
+    CHECK(rsp_transact(client, request, reply, sizeof(reply)) >= 0);
+    return reply;
+}
+
+static void test_session(int port, bool noack)
+{
+    RspClient client;
+    CHECK(rsp_connect(&client, port));
+
+    CHECK(strstr(transact(&client, "qSupported:multiprocess+"), "PacketSize=") != NULL);
+    if (noack)
+    {
+        CHECK(strcmp(transact(&client, "QStartNoAckMode"), "OK") == 0);
+        client.noack = true;
+    }
+    CHECK(strcmp(transact(&client, "?"), "W00") == 0);
+
+    /* "monitor swd_scan" */
+    CHECK(strcmp(transact(&client, "qRcmd,7377645f7363616e"), "OK") == 0);
+    CHECK(strcmp(transact(&client, "vAttach;1"), "T05thread:1;") == 0);
+    CHECK(strcmp(transact(&client, "?"), "S05") == 0);
+
+    /* Memory in both directions, hex and binary */
+    uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, 0x1000U + 7000U);
+    for (size_t i = 0; i < 256U; i++)
+        ram[i] = (uint8_t)i;
+    transact(&client, "m20000000,100");
+    CHECK_EQ(strlen(reply), 512);
+    CHECK(strncmp(reply, "000102030405", 12) == 0);
+    CHECK(strncmp(reply + 500, "fafbfcfdfeff", 12) == 0);
+
+    CHECK(strcmp(transact(&client, "M20000010,4:deadbeef"), "OK") == 0);
+    CHECK(ram[0x10] == 0xde && ram[0x13] == 0xef);
+
+    /* A write of almost a full packet, larger than the gdb thread stack */
+    static char large[32 + 2U * 7000U];
+    const int header = snprintf(large, sizeof(large), "M20001000,%x:", 7000U);
+    for (size_t i = 0; i < 7000U; i++)
+        snprintf(large + header + 2U * i, 3, "%02x", (unsigned)(i * 13U) & 0xffU);
+    CHECK(strcmp(transact(&client, large), "OK") == 0);
+    for (size_t i = 0; i < 7000U; i++)
+        CHECK_EQ(ram[0x1000 + i], (uint8_t)(i * 13U));
+
+    const char binary[] = "X20000020,4:\x01}\x03\x04";
+    CHECK(rsp_send(&client, binary, sizeof(binary) - 1U));
+    CHECK(rsp_recv(&client, reply, sizeof(reply), 5000) >= 0);
+    CHECK(strcmp(reply, "OK") == 0);
+    CHECK(ram[0x20] == 0x01 && ram[0x21] == '}' && ram[0x22] == 0x03 && ram[0x23] == 0x04);
+
+    /* Registers */
+    *swd_sim_core_reg(15U) = 0x08000200U;
+    transact(&client, "g");
+    CHECK(strncmp(reply + 15 * 8, "00020008", 8) == 0);
+    CHECK(strcmp(transact(&client, "p0f"), "00020008") == 0);
+
+    /* Run, interrupt, stop reply */
+    CHECK(rsp_send(&client, "vCont;c", 7));
+    CHECK(!rsp_readable(&client, 100));
+    CHECK(!swd_sim_halted());
+    CHECK(rsp_send_raw(&client, "\x03", 1));
+    CHECK(rsp_recv(&client, reply, sizeof(reply), 5000) >= 0);
+    CHECK(strcmp(reply, "T02thread:1;") == 0);
+    CHECK(swd_sim_halted());
+
+    /* Breakpoint while running */
+    CHECK(rsp_send(&client, "c", 1));
+    CHECK(!rsp_readable(&client, 50));
+    swd_sim_set_running(false);
+    CHECK(rsp_recv(&client, reply, sizeof(reply), 5000) >= 0);
+    CHECK(strcmp(reply, "T05thread:1;") == 0);
+
+    CHECK(strcmp(transact(&client, "D"), "OK") == 0);
+    CHECK(!swd_sim_halted());
+    rsp_close(&client);
+}
+
+int main(void)
+{
+    const int port = host_server_start();
+    test_session(port, false);
+    /* A new session after the previous one closed, no-ack this time */
+    CHECK(host_server_wait_idle(2000));
+    test_session(port, true);
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "general.h"
+#include "swd-sim.h"
+#include "gdb-stats.h"
+#include "host-server.h"
+#include "rsp-client.h"
+#include "check.h"
+
+/*
+ * Receive time of the packet statistics over loopback: a packet that
+ * arrives in two pieces counts from its first piece, on the fast framer
+ * and on the stock parser alike, and an idle gap before a packet does not
+ * count.
+ */
+
+#define GAP_US 30000U
+
+static char reply[RSP_CLIENT_BUFFER_SIZE];
+
+static const char *transact(RspClient *client, const char *request)
+{
+    CHECK(rsp_transact(client, request, reply, sizeof(reply)) >= 0);
+    return reply;
+}
+
+static GDBStatsType stats_of(char name)
+{
+    GDBStatsType stats;
+    for (size_t i = 0; i < gdb_stats_types(); i++)
+    {
+        if (gdb_stats_get(i, &stats)[0] == name)
+            return stats;
+    }
+    CHECK(false);
+    return stats;
+}
+
+/* One framed packet, sent as two writes GAP_US apart, after an optional stray byte */
+static void send_split(RspClient *client, const char *payload, const char *prefix)
+{
+    char frame[64];
+    uint8_t checksum = 0;
+    for (const char *c = payload; *c != '\0'; c++)
+        checksum += (uint8_t)*c;
+    const int size = snprintf(frame, sizeof(frame), "%s$%s#%02x", prefix, payload, checksum);
+    CHECK(rsp_send_raw(client, frame, (size_t)size / 2U));
+    usleep(GAP_US);
+    CHECK(rsp_send_raw(client, frame + size / 2, (size_t)size - (size_t)size / 2U));
+    CHECK(rsp_recv(client, reply, sizeof(reply), 5000) >= 0);
+}
+
+static void check_receive(const char *name, const char *prefix, RspClient *client)
+{
+    gdb_stats_reset();
+    /* Idle before the packet, not part of the receive time */
+    usleep(2U * GAP_US);
+    send_split(client, "m20000000,4", prefix);
+    CHECK(strcmp(reply, "00010203") == 0);
+
+    /* Recorded once gdb_main() returns, just after the reply went out */
+    GDBStatsType stats = stats_of('m');
+    for (int waited = 0; stats.count == 0 && waited < 1000; waited++)
+    {
+        usleep(1000U);
+        stats = stats_of('m');
+    }
+    const uint64_t receive_us = stats.total_us[GDB_STATS_RECEIVE];
+    printf("%-8s receive %llu us\n", name, (unsigned long long)receive_us);
+    CHECK_EQ(stats.count, 1);
+    /* The probe may see the first piece a little after it was sent */
+    CHECK(receive_us >= GAP_US * 9U / 10U);
+    CHECK(receive_us < 2U * GAP_US);
+}
+
+int main(void)
+{
+    const int port = host_server_start();
+    uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, 4U);
+    for (size_t i = 0; i < 4U; i++)
+        ram[i] = (uint8_t)i;
+
+    RspClient client;
+    CHECK(rsp_connect(&client, port));
+    CHECK(strcmp(transact(&client, "QStartNoAckMode"), "OK") == 0);
+    client.noack = true;
+    /* "monitor swd_scan" */
+    CHECK(strcmp(transact(&client, "qRcmd,7377645f7363616e"), "OK") == 0);
+    CHECK(strcmp(transact(&client, "vAttach;1"), "T05thread:1;") == 0);
+    CHECK(gdb_stats_enabled());
+
+    check_receive("framer", "", &client);
+    /* A stray byte in front sends the packet through gdb_packet.c */
+    check_receive("stock", "+", &client);
+
+    CHECK(strcmp(transact(&client, "D"), "OK") == 0);
+    rsp_close(&client);
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "general.h"
+#include "hex_utils.h"
+#include "check.h"
+
+/*
+ * hex-fast.c against the byte-wise upstream conversions it wraps: every
+ * digit pair, then random buffers of random size and alignment, with
+ * uppercase and invalid digits on the decode side. The timing at the end
+ * is for this host only, it says nothing about the probe's RISC-V core.
+ */
+
+#define FUZZ_ROUNDS 200000
+#define FUZZ_MAX 300U
+#define GUARD 16U
+#define BENCH_SIZE 4096U
+#define BENCH_ROUNDS 20000
+
+char *__real_hexify(char *hex, const void *buf, size_t size);
+char *__real_unhexify(void *buf, const char *hex, size_t size);
+char *__wrap_hexify(char *hex, const void *buf, size_t size);
+char *__wrap_unhexify(void *buf, const char *hex, size_t size);
+
+static uint8_t bytes[FUZZ_MAX + 8U];
+static char hex[2U * FUZZ_MAX + 8U];
+static char stock_out[2U * FUZZ_MAX + 8U + GUARD];
+static char fast_out[2U * FUZZ_MAX + 8U + GUARD];
+static uint32_t seed = 0x0badcafeU;
+
+static uint32_t next_random(void)
+{
+    seed = seed * 1103515245U + 12345U;
+    return seed >> 8U;
+}
+
+static void test_pairs(void)
+{
+    for (uint32_t pair = 0; pair < 0x10000U; pair++)
+    {
+        const char digits[2] = {(char)(pair >> 8U), (char)pair};
+        uint8_t stock;
+        uint8_t fast;
+        __real_unhexify(&stock, digits, 1U);
+        __wrap_unhexify(&fast, digits, 1U);
+        CHECK_EQ(fast, stock);
+    }
+}
+
+static void test_fuzz(void)
+{
+    static const char digits[] = "0123456789abcdefABCDEF";
+
+    for (int round = 0; round < FUZZ_ROUNDS; round++)
+    {
+        const size_t size = next_random() % (FUZZ_MAX + 1U);
+        const size_t in_offset = next_random() % 8U;
+        const size_t out_offset = next_random() % 8U;
+
+        for (size_t i = 0; i < size; i++)
+            bytes[in_offset + i] = (uint8_t)next_random();
+        memset(stock_out, 0x5a, sizeof(stock_out));
+        memset(fast_out, 0x5a, sizeof(fast_out));
+        __real_hexify(stock_out + out_offset, bytes + in_offset, size);
+        __wrap_hexify(fast_out + out_offset, bytes + in_offset, size);
+        CHECK(memcmp(stock_out, fast_out, sizeof(stock_out)) == 0);
+
+        /* Mostly valid digits, one in sixteen anything at all */
+        for (size_t i = 0; i < 2U * size; i++)
+        {
+            const uint32_t r = next_random();
+            hex[in_offset + i] = r % 16U == 0 ? (char)(r >> 4U) : digits[(r >> 4U) % (sizeof(digits) - 1U)];
+        }
+        memset(stock_out, 0x5a, sizeof(stock_out));
+        memset(fast_out, 0x5a, sizeof(fast_out));
+        __real_unhexify(stock_out + out_offset, hex + in_offset, size);
+        __wrap_unhexify(fast_out + out_offset, hex + in_offset, size);
+        CHECK(memcmp(stock_out, fast_out, sizeof(stock_out)) == 0);
+    }
+}
+
+static double bench(char *(*convert)(void *, const void *, size_t), void *out, const void *in)
+{
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        convert(out, in, BENCH_SIZE);
+        __asm__ volatile("" : : "r"(out) : "memory");
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    const double ns = (double)(end.tv_sec - start.tv_sec) * 1e9 + (double)(end.tv_nsec - start.tv_nsec);
+    return ns / ((double)BENCH_ROUNDS * BENCH_SIZE);
+}
+
+static char *stock_encode(void *out, const void *in, size_t size)
+{
+    return __real_hexify(out, in, size);
+}
+
+static char *fast_encode(void *out, const void *in, size_t size)
+{
+    return __wrap_hexify(out, in, size);
+}
+
+static char *stock_decode(void *out, const void *in, size_t size)
+{
+    return __real_unhexify(out, in, size);
+}
+
+static char *fast_decode(void *out, const void *in, size_t size)
+{
+    return __wrap_unhexify(out, in, size);
+}
+
+static void benchmark(void)
+{
+    static uint8_t data[BENCH_SIZE];
+    static char text[2U * BENCH_SIZE + 1U];
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = (uint8_t)next_random();
+    __real_hexify(text, data, sizeof(data));
+
+    const double stock_enc = bench(stock_encode, text, data);
+    const double fast_enc = bench(fast_encode, text, data);
+    const double stock_dec = bench(stock_decode, data, text);
+    const double fast_dec = bench(fast_decode, data, text);
+    printf("host only: hexify %.2f -> %.2f ns/byte (%.1fx), unhexify %.2f -> %.2f ns/byte (%.1fx)\n", stock_enc,
+           fast_enc, stock_enc / fast_enc, stock_dec, fast_dec, stock_dec / fast_dec);
+}
+
+int main(void)
+{
+    test_pairs();
+    test_fuzz();
+    benchmark();
+    return 0;
+}
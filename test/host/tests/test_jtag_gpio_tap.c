@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <soc/gpio_struct.h>
+#include "general.h"
+#include "timing.h"
+#include "jtagtap.h"
+#include "jtag-tap.h"
+#include "check.h"
+
+/*
+ * The word-at-a-time JTAG kernels of jtag-gpio-tap.c against the stock
+ * jtagtap.c on the GPIO registers: a pin model records TMS and TDI on
+ * every TCK rising edge and shifts a pattern out on TDO, and both taps have
+ * to produce the same streams and capture the same TDO bits for every
+ * proc, every length around the 8 and 32 bit boundaries (the final TMS bit
+ * alone in its word when clock_cycles % 32 == 1) and with and without
+ * delays. Then the register accesses per bit and the host throughput of
+ * long scans.
+ */
+
+#define MAX_CYCLES 4096U
+#define SCAN_BITS 4096U
+#define SCAN_ROUNDS 200U
+
+typedef struct
+{
+    uint32_t levels;
+    size_t edges;
+    uint8_t tms[MAX_CYCLES];
+    uint8_t tdi[MAX_CYCLES];
+} JTAGModel;
+
+typedef struct
+{
+    size_t edges;
+    uint8_t tms[MAX_CYCLES];
+    uint8_t tdi[MAX_CYCLES];
+    uint8_t tdo[MAX_CYCLES / 8U];
+    bool next;
+} JTAGStreams;
+
+static JTAGModel model;
+static jtag_proc_s stock;
+static jtag_proc_s kernels;
+static uint8_t data_in[MAX_CYCLES / 8U];
+
+static inline bool tdo_pattern(size_t edge)
+{
+    return ((edge * 0x9e3779b1U) >> 13U) & 1U;
+}
+
+static void model_write(uint32_t mask, uint32_t levels)
+{
+    const uint32_t before = model.levels;
+    model.levels = (before & ~mask) | (levels & mask);
+    const uint32_t tck = 1U << TCK_PIN;
+    if ((model.levels & tck) && !(before & tck) && model.edges < MAX_CYCLES)
+    {
+        model.tms[model.edges] = (model.levels >> TMS_PIN) & 1U;
+        model.tdi[model.edges] = (model.levels >> TDI_PIN) & 1U;
+        model.edges++;
+    }
+}
+
+/* TDO changes on the falling edge, so bit n is there for the high phase of edge n */
+static uint32_t model_read(void)
+{
+    const bool high = model.levels & (1U << TCK_PIN);
+    const size_t bit = high && model.edges > 0 ? model.edges - 1U : model.edges;
+    return (uint32_t)tdo_pattern(bit) << TDO_PIN;
+}
+
+static const host_gpio_model_t jtag_model = {
+    .write = model_write,
+    .read = model_read,
+};
+
+typedef enum
+{
+    PROC_TDI_TDO,
+    PROC_TDI,
+    PROC_TMS,
+    PROC_NEXT,
+    PROC_CYCLE,
+} jtag_proc_e;
+
+static void run(const jtag_proc_s *proc, jtag_proc_e which, size_t cycles, bool final_tms, JTAGStreams *out)
+{
+    memset(out, 0, sizeof(*out));
+    host_gpio_flush();
+    model.edges = 0;
+    switch (which)
+    {
+    case PROC_TDI_TDO:
+        proc->jtagtap_tdi_tdo_seq(out->tdo, final_tms, data_in, cycles);
+        break;
+    case PROC_TDI:
+        proc->jtagtap_tdi_seq(final_tms, data_in, cycles);
+        break;
+    case PROC_TMS:
+        proc->jtagtap_tms_seq(0x5a3c96e1U ^ (uint32_t)cycles, cycles);
+        break;
+    case PROC_NEXT:
+        out->next = proc->jtagtap_next(final_tms, cycles & 1U);
+        break;
+    case PROC_CYCLE:
+        proc->jtagtap_cycle(final_tms, cycles & 1U, cycles);
+        break;
+    }
+    host_gpio_flush();
+    out->edges = model.edges;
+    memcpy(out->tms, model.tms, model.edges);
+    memcpy(out->tdi, model.tdi, model.edges);
+}
+
+static void check_same(jtag_proc_e which, size_t cycles, bool final_tms)
+{
+    static JTAGStreams expected;
+    static JTAGStreams actual;
+    run(&stock, which, cycles, final_tms, &expected);
+    run(&kernels, which, cycles, final_tms, &actual);
+
+    CHECK_EQ(actual.edges, expected.edges);
+    CHECK(memcmp(actual.tms, expected.tms, expected.edges) == 0);
+    CHECK(memcmp(actual.tdi, expected.tdi, expected.edges) == 0);
+    CHECK(memcmp(actual.tdo, expected.tdo, sizeof(expected.tdo)) == 0);
+    CHECK_EQ(actual.next, expected.next);
+    if (which == PROC_TDI_TDO || which == PROC_TDI)
+    {
+        CHECK_EQ(expected.edges, cycles);
+        CHECK_EQ(expected.tms[cycles - 1U], final_tms);
+    }
+}
+
+static void test_equivalence(void)
+{
+    static const size_t lengths[] = {1, 2, 7, 8, 9, 31, 32, 33, 63, 64, 65, 97, 100, 129, 1000, 1025};
+    for (size_t i = 0; i < ARRAY_LENGTH(lengths); i++)
+    {
+        const size_t cycles = lengths[i];
+        for (int final_tms = 0; final_tms < 2; final_tms++)
+        {
+            check_same(PROC_TDI_TDO, cycles, final_tms);
+            check_same(PROC_TDI, cycles, final_tms);
+            check_same(PROC_NEXT, cycles, final_tms);
+            check_same(PROC_CYCLE, cycles, final_tms);
+        }
+        if (cycles <= 32U)
+            check_same(PROC_TMS, cycles, false);
+    }
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000U + (uint64_t)now.tv_nsec;
+}
+
+/* Register accesses per bit and host ns per bit of a long TDI/TDO scan */
+static void scan_cost(const char *name, const jtag_proc_s *proc, double *ops, double *ns)
+{
+    static uint8_t tdo[SCAN_BITS / 8U];
+    host_gpio_reset_accesses();
+    const uint64_t start = now_ns();
+    for (size_t round = 0; round < SCAN_ROUNDS; round++)
+        proc->jtagtap_tdi_tdo_seq(tdo, true, data_in, SCAN_BITS);
+    const uint64_t elapsed = now_ns() - start;
+    *ops = (double)host_gpio_accesses() / (SCAN_BITS * SCAN_ROUNDS);
+    *ns = (double)elapsed / (SCAN_BITS * SCAN_ROUNDS);
+    printf("%-8s %5.2f ops/bit %6.1f ns/bit\n", name, *ops, *ns);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < sizeof(data_in); i++)
+        data_in[i] = (uint8_t)(i * 0x3bU + 0x5cU);
+
+    host_gpio_set_model(&jtag_model);
+    jtagtap_init();
+    stock = jtag_proc;
+    CHECK(jtag_gpio_tap_init());
+    kernels = jtag_proc;
+
+    test_equivalence();
+    const uint32_t divider = target_clk_divider;
+    target_clk_divider = 1;
+    test_equivalence();
+    target_clk_divider = divider;
+
+    double stock_ops;
+    double stock_ns;
+    double kernel_ops;
+    double kernel_ns;
+    scan_cost("jtagtap", &stock, &stock_ops, &stock_ns);
+    scan_cost("kernels", &kernels, &kernel_ops, &kernel_ns);
+    printf("throughput kernels/jtagtap %.2fx, register accesses %.2fx\n", stock_ns / kernel_ns,
+           kernel_ops / stock_ops);
+    CHECK(kernel_ops < stock_ops);
+
+    host_gpio_set_model(NULL);
+    return 0;
+}
@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "general.h"
+#include "target.h"
+#include "adiv5.h"
+#include "cortex.h"
+#include "lp-mailbox.h"
+#include "ulp_lp_core_gpio.h"
+#include "swd-sim.h"
+#include "check.h"
+
+/*
+ * The LP core program (lp_core/lp_swd.c, built here with main() renamed)
+ * in a thread of its own against the simulated target, with this file
+ * playing the HP core side of the mailbox: DHCSR polling and the halt
+ * event, RTT draining into the ring including wrap-around, STOP, and the
+ * error event on a FAULT.
+ */
+
+#define RTT_DESC 0x20000100U
+#define RTT_BUFFER 0x20000200U
+#define RTT_SIZE 256U
+#define LP_TIMEOUT_MS 2000
+
+extern volatile LPMailbox mailbox;
+int lp_swd_main(void);
+
+static atomic_uint wakeups;
+static pthread_t lp_thread;
+
+void ulp_lp_core_wakeup_main_processor(void)
+{
+    atomic_fetch_add(&wakeups, 1U);
+}
+
+static void *lp_core_run(void *arg)
+{
+    (void)arg;
+    lp_swd_main();
+    return NULL;
+}
+
+/* What lp_offload_start() does before it starts the LP core */
+static void lp_start(target_s *target, bool rtt)
+{
+    adiv5_access_port_s *ap = cortex_ap(target);
+    CHECK(ap != NULL);
+
+    lp_mailbox_reset(&mailbox);
+    mailbox.swclk = LP_IO_NUM_0;
+    mailbox.swdio = LP_IO_NUM_1;
+    mailbox.apsel = ap->apsel;
+    mailbox.csw = ap->csw;
+    mailbox.poll_interval_us = 100U;
+    if (rtt)
+    {
+        mailbox.rtt_enabled = 1U;
+        mailbox.rtt_desc = RTT_DESC;
+        mailbox.rtt_buffer = RTT_BUFFER;
+        mailbox.rtt_size = RTT_SIZE;
+    }
+    atomic_store(&wakeups, 0U);
+    __sync_synchronize();
+    mailbox.command = LP_MAILBOX_CMD_RUN;
+    CHECK(pthread_create(&lp_thread, NULL, lp_core_run, NULL) == 0);
+}
+
+static bool lp_wait(bool (*done)(void))
+{
+    for (int waited = 0; waited < LP_TIMEOUT_MS; waited++)
+    {
+        if (done())
+            return true;
+        usleep(1000);
+    }
+    return done();
+}
+
+static bool lp_stopped(void)
+{
+    return mailbox.state == LP_MAILBOX_STATE_STOPPED;
+}
+
+static bool lp_polled(void)
+{
+    return mailbox.polls >= 10U;
+}
+
+static void lp_join(void)
+{
+    CHECK(lp_wait(lp_stopped));
+    CHECK(pthread_join(lp_thread, NULL) == 0);
+}
+
+static uint32_t *rtt_desc(void)
+{
+    return (uint32_t *)swd_sim_memory(RTT_DESC, 6U * 4U);
+}
+
+static void test_halt(target_s *target)
+{
+    target_halt_resume(target, false);
+    CHECK(!swd_sim_halted());
+    lp_start(target, false);
+
+    CHECK(lp_wait(lp_polled));
+    CHECK_EQ(mailbox.state, LP_MAILBOX_STATE_RUNNING);
+    CHECK_EQ(mailbox.events, 0);
+
+    /* Breakpoint: the LP core stops on its own and wakes the HP core */
+    swd_sim_set_running(false);
+    lp_join();
+    CHECK_EQ(mailbox.events, LP_MAILBOX_EVENT_HALT);
+    CHECK(mailbox.dhcsr & (1U << 17U));
+    CHECK_EQ(atomic_load(&wakeups), 1);
+    printf("halt seen after %u polls\n", mailbox.polls);
+
+    /* The HP tap picks the bus up where the LP core left it */
+    target_addr_t watch;
+    CHECK_EQ(target_halt_poll(target, &watch), TARGET_HALT_BREAKPOINT);
+}
+
+static size_t rtt_pop(uint8_t *data, size_t size)
+{
+    size_t taken = 0;
+    for (int waited = 0; taken < size && waited < LP_TIMEOUT_MS; waited++)
+    {
+        taken += lp_mailbox_ring_pop(&mailbox, data + taken, size - taken);
+        if (taken < size)
+            usleep(1000);
+    }
+    return taken;
+}
+
+static bool rtt_read_offset_at(uint32_t offset)
+{
+    for (int waited = 0; waited < LP_TIMEOUT_MS; waited++)
+    {
+        if (__atomic_load_n(&rtt_desc()[4], __ATOMIC_ACQUIRE) == offset)
+            return true;
+        usleep(1000);
+    }
+    return false;
+}
+
+static void test_rtt(target_s *target)
+{
+    static const char text[] = "0123456789";
+    uint8_t *buffer = swd_sim_memory(RTT_BUFFER, RTT_SIZE);
+    uint32_t *desc = rtt_desc();
+    uint8_t data[16];
+
+    /* Ten bytes wrapping around the end of the buffer */
+    memcpy(buffer + RTT_SIZE - 6U, text, 6U);
+    memcpy(buffer, text + 6, 4U);
+    desc[0] = 0;
+    desc[1] = RTT_BUFFER;
+    desc[2] = RTT_SIZE;
+    desc[3] = 4U;
+    desc[4] = RTT_SIZE - 6U;
+
+    target_halt_resume(target, false);
+    lp_start(target, true);
+    CHECK_EQ(rtt_pop(data, 10U), 10);
+    CHECK(memcmp(data, text, 10U) == 0);
+    CHECK(rtt_read_offset_at(4U));
+
+    /* More output while the LP core watches */
+    memcpy(buffer + 4U, "abc", 3U);
+    __atomic_store_n(&desc[3], 7U, __ATOMIC_RELEASE);
+    CHECK_EQ(rtt_pop(data, 3U), 3);
+    CHECK(memcmp(data, "abc", 3U) == 0);
+    CHECK(rtt_read_offset_at(7U));
+    CHECK_EQ(lp_mailbox_ring_used(&mailbox), 0);
+
+    /* HP takes the pins back, for example on gdb input: no event, no wake-up */
+    mailbox.command = LP_MAILBOX_CMD_STOP;
+    lp_join();
+    CHECK_EQ(mailbox.events, 0);
+    CHECK_EQ(atomic_load(&wakeups), 0);
+    CHECK(!swd_sim_halted());
+    target_halt_request(target);
+    CHECK(swd_sim_halted());
+}
+
+static void test_error(target_s *target)
+{
+    target_halt_resume(target, false);
+    /* CSW, TAR and DRW per poll, the third poll faults on DRW */
+    swd_sim_inject_fault(8U);
+    lp_start(target, false);
+    lp_join();
+    CHECK_EQ(mailbox.events, LP_MAILBOX_EVENT_ERROR);
+    CHECK_EQ(mailbox.polls, 2);
+    CHECK_EQ(mailbox.last_ack, 4);
+    CHECK_EQ(atomic_load(&wakeups), 1);
+}
+
+int main(void)
+{
+    swd_sim_reset();
+    CHECK(adiv5_swd_scan());
+    target_s *target = target_attach_n(1, NULL);
+    CHECK(target != NULL);
+
+    test_halt(target);
+    test_rtt(target);
+    test_error(target);
+
+    SWDSimStats stats;
+    swd_sim_get_stats(&stats);
+    CHECK_EQ(stats.protocol_errors, 0);
+    return 0;
+}
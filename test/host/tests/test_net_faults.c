@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sdkconfig.h>
+#include "general.h"
+#include "swd-sim.h"
+#include "network-gdb.h"
+#include "host-server.h"
+#include "rsp-client.h"
+#include "check.h"
+
+/*
+ * Clients that stop reading, over loopback. An observer that stops reading
+ * is dropped after CONFIG_BMP_NET_SEND_STALL_MS and the owner carries on,
+ * and while it is stuck the owner's ^C is answered at once.
+ * An owner that stops reading loses the session the same way and the next
+ * client becomes the owner, without seeing any of the old owner's input.
+ */
+
+/* Longest a flood may take before the probe counts as stuck */
+#define FLOOD_LIMIT_MS (4U * CONFIG_BMP_NET_SEND_STALL_MS)
+
+static char reply[RSP_CLIENT_BUFFER_SIZE];
+
+static const char *transact(RspClient *client, const char *request)
+{
+    CHECK(rsp_transact(client, request, reply, sizeof(reply)) >= 0);
+    return reply;
+}
+
+static uint64_t now_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000U + (uint64_t)now.tv_nsec / 1000000U;
+}
+
+static void connect_owner(RspClient *owner, int port)
+{
+    CHECK(rsp_connect(owner, port));
+    CHECK(strcmp(transact(owner, "QStartNoAckMode"), "OK") == 0);
+    owner->noack = true;
+    /* "monitor swd_scan" */
+    CHECK(strcmp(transact(owner, "qRcmd,7377645f7363616e"), "OK") == 0);
+    CHECK(strcmp(transact(owner, "vAttach;1"), "T05thread:1;") == 0);
+}
+
+/*
+ * Requests with 1 KiB replies without reading any, until the probe drops
+ * the connection and the sends fail. Returns how long that took.
+ */
+static uint64_t flood(RspClient *client)
+{
+    const uint64_t start = now_ms();
+    size_t sent = 0;
+    bool dropped = false;
+    while (!dropped && now_ms() - start < FLOOD_LIMIT_MS)
+    {
+        dropped = !rsp_send(client, "m20000000,200", 13);
+        sent++;
+    }
+    const uint64_t elapsed = now_ms() - start;
+    printf("dropped after %zu requests, %llu ms\n", sent, (unsigned long long)elapsed);
+    CHECK(dropped);
+    CHECK(elapsed >= CONFIG_BMP_NET_SEND_STALL_MS);
+    CHECK(elapsed < 2U * CONFIG_BMP_NET_SEND_STALL_MS + 2000U);
+    return elapsed;
+}
+
+static void test_observer_stall(RspClient *owner, int port)
+{
+    RspClient observer;
+    CHECK(rsp_connect(&observer, port));
+    CHECK(strcmp(transact(&observer, "QStartNoAckMode"), "OK") == 0);
+    observer.noack = true;
+    CHECK_EQ(network_gdb_observers(), 1);
+
+    flood(&observer);
+    rsp_close(&observer);
+
+    transact(owner, "m20000000,4");
+    CHECK(strcmp(reply, "00010203") == 0);
+    CHECK_EQ(network_gdb_observers(), 0);
+    CHECK(network_gdb_connected());
+}
+
+/*
+ * Requests with 1 KiB replies from an observer that reads none, sent
+ * without blocking until the probe stops taking them: its reply queue and
+ * the socket buffers are full.
+ */
+static void stall_observer(RspClient *observer)
+{
+    static const char request[] = "m20000000,200";
+    char frame[32];
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < sizeof(request) - 1U; i++)
+        checksum += (uint8_t)request[i];
+    const int size = snprintf(frame, sizeof(frame), "$%s#%02x", request, checksum);
+
+    const int rcvbuf = 4096;
+    setsockopt(observer->sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    const uint64_t start = now_ms();
+    bool stalled = false;
+    while (!stalled && now_ms() - start < FLOOD_LIMIT_MS)
+    {
+        /* A request cut short stays incomplete, the probe is not reading anyway */
+        const ssize_t sent = send(observer->sock, frame, (size_t)size, MSG_DONTWAIT);
+        CHECK(sent >= 0 || errno == EAGAIN || errno == EWOULDBLOCK);
+        stalled = sent < size;
+    }
+    CHECK(stalled);
+}
+
+static void test_interrupt_with_stalled_observer(RspClient *owner, int port)
+{
+    RspClient observer;
+    CHECK(rsp_connect(&observer, port));
+    CHECK(strcmp(transact(&observer, "QStartNoAckMode"), "OK") == 0);
+    observer.noack = true;
+
+    CHECK(rsp_send(owner, "vCont;c", 7));
+    CHECK(!rsp_readable(owner, 100));
+    stall_observer(&observer);
+
+    const uint64_t start = now_ms();
+    CHECK(rsp_send_raw(owner, "\x03", 1));
+    CHECK(rsp_recv(owner, reply, sizeof(reply), 1000) >= 0);
+    const uint64_t elapsed = now_ms() - start;
+    printf("interrupt answered in %llu ms with an observer stalled\n", (unsigned long long)elapsed);
+    CHECK(strcmp(reply, "T02thread:1;") == 0);
+    CHECK(elapsed < CONFIG_BMP_NET_SEND_STALL_MS / 5U);
+    transact(owner, "m20000000,4");
+    CHECK(strcmp(reply, "00010203") == 0);
+    CHECK_EQ(network_gdb_observers(), 1);
+
+    /* Gone for good, the probe notices on its next flush */
+    rsp_close(&observer);
+    const uint64_t closed = now_ms();
+    while (network_gdb_observers() > 0 && now_ms() - closed < FLOOD_LIMIT_MS)
+        CHECK(strcmp(transact(owner, "m20000000,4"), "00010203") == 0);
+    CHECK_EQ(network_gdb_observers(), 0);
+}
+
+static void test_owner_stall(RspClient *owner, int port)
+{
+    flood(owner);
+    rsp_close(owner);
+    CHECK(host_server_wait_idle(2000));
+
+    connect_owner(owner, port);
+    transact(owner, "m20000000,4");
+    CHECK(strcmp(reply, "00010203") == 0);
+}
+
+int main(void)
+{
+    const int port = host_server_start();
+    uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, 512U);
+    for (size_t i = 0; i < 512U; i++)
+        ram[i] = (uint8_t)i;
+
+    RspClient owner;
+    connect_owner(&owner, port);
+    test_observer_stall(&owner, port);
+    test_interrupt_with_stalled_observer(&owner, port);
+    test_owner_stall(&owner, port);
+
+    CHECK(strcmp(transact(&owner, "D"), "OK") == 0);
+    rsp_close(&owner);
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include "general.h"
+#include "swd-sim.h"
+#include "gdb-trace.h"
+#include "host-server.h"
+#include "rsp-client.h"
+#include "check.h"
+
+/*
+ * tools/rsp_replay.py against gdb_main() on the simulated target: record a
+ * session with the probe's trace, save it the way GET /trace serves it and
+ * replay it over loopback. The replay gets every reply it waits for, its
+ * writes reach the target again, and the one write too large for the
+ * trace ring is skipped instead of being sent cut short.
+ */
+
+#define TRACE_FILE "rsp_replay.trace"
+#define LARGE_SIZE 7000U
+
+static char reply[RSP_CLIENT_BUFFER_SIZE];
+
+static const char *transact(RspClient *client, const char *request)
+{
+    CHECK(rsp_transact(client, request, reply, sizeof(reply)) >= 0);
+    return reply;
+}
+
+static void record_session(int port)
+{
+    RspClient client;
+    CHECK(rsp_connect(&client, port));
+    CHECK(strstr(transact(&client, "qSupported:multiprocess+"), "PacketSize=") != NULL);
+    CHECK(strcmp(transact(&client, "QStartNoAckMode"), "OK") == 0);
+    client.noack = true;
+    /* "monitor swd_scan" */
+    CHECK(strcmp(transact(&client, "qRcmd,7377645f7363616e"), "OK") == 0);
+    CHECK(strcmp(transact(&client, "vAttach;1"), "T05thread:1;") == 0);
+
+    for (int i = 0; i < 20; i++)
+        transact(&client, i % 2 ? "m20000000,100" : "x20000100,200");
+    transact(&client, "g");
+    CHECK(strcmp(transact(&client, "M20000010,4:deadbeef"), "OK") == 0);
+
+    /* Larger than a quarter of the trace ring, kept only in part */
+    static char large[32 + 2U * LARGE_SIZE];
+    const int header = snprintf(large, sizeof(large), "M20001000,%x:", LARGE_SIZE);
+    for (size_t i = 0; i < LARGE_SIZE; i++)
+        snprintf(large + header + 2U * i, 3, "%02x", (unsigned)(i * 13U) & 0xffU);
+    CHECK(strcmp(transact(&client, large), "OK") == 0);
+
+    CHECK(strcmp(transact(&client, "D"), "OK") == 0);
+    rsp_close(&client);
+    CHECK(host_server_wait_idle(2000));
+}
+
+/* The trace as GET /trace serves it */
+static void save_trace(void)
+{
+    uint32_t records;
+    size_t used;
+    size_t capacity;
+    uint32_t dropped;
+    gdb_trace_freeze(true);
+    gdb_trace_get_stats(&records, &used, &capacity, &dropped);
+    CHECK_EQ(dropped, 0);
+
+    const GDBTraceHeader header = {
+        .magic = GDB_TRACE_MAGIC,
+        .version = GDB_TRACE_VERSION,
+        .records = records,
+        .dropped = dropped,
+    };
+    FILE *file = fopen(TRACE_FILE, "wb");
+    CHECK(file != NULL);
+    CHECK(fwrite(&header, sizeof(header), 1, file) == 1);
+
+    char chunk[512];
+    size_t offset = 0;
+    size_t size;
+    while ((size = gdb_trace_read(offset, chunk, sizeof(chunk))) > 0)
+    {
+        CHECK(fwrite(chunk, size, 1, file) == 1);
+        offset += size;
+    }
+    CHECK(fclose(file) == 0);
+    gdb_trace_freeze(false);
+    printf("%u records, %zu bytes\n", records, used);
+}
+
+int main(void)
+{
+    const int port = host_server_start();
+    CHECK(gdb_trace_set_enabled(true));
+    gdb_trace_clear();
+
+    uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, 0x1000U + LARGE_SIZE);
+    for (size_t i = 0; i < 0x300U; i++)
+        ram[i] = (uint8_t)i;
+    record_session(port);
+    CHECK(ram[0x10] == 0xde && ram[0x1000] == 0);
+    gdb_trace_set_enabled(false);
+    save_trace();
+
+    /* Undo both writes, the replay makes the small one again */
+    memset(ram + 0x10, 0, 4U);
+    memset(ram + 0x1000, 0, LARGE_SIZE);
+
+    char command[1024];
+    snprintf(command, sizeof(command), "%s %s replay %s --host 127.0.0.1 --port %d --timeout 5", PYTHON, RSP_REPLAY,
+        TRACE_FILE, port);
+    FILE *output = popen(command, "r");
+    CHECK(output != NULL);
+    bool summary = false;
+    char line[256];
+    while (fgets(line, sizeof(line), output) != NULL)
+    {
+        fputs(line, stdout);
+        if (strncmp(line, "run 1:", 6) == 0)
+            summary = strstr(line, " 0 timeouts, 1 truncated skipped") != NULL;
+    }
+    const int status = pclose(output);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    CHECK(summary);
+
+    CHECK(ram[0x10] == 0xde && ram[0x13] == 0xef);
+    for (size_t i = 0; i < LARGE_SIZE; i++)
+        CHECK_EQ(ram[0x1000 + i], 0);
+    CHECK(host_server_wait_idle(2000));
+    remove(TRACE_FILE);
+    return 0;
+}
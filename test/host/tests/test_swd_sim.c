@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <string.h>
+#include "general.h"
+#include "target.h"
+#include "adiv5-queue.h"
+#include "tap-stats.h"
+#include "swd-sim.h"
+#include "check.h"
+
+/*
+ * Scan, memory and flash traffic against the simulated target through the
+ * stock ADIv5 accessors and the batched engine, with the bus cost of each
+ * at the default 4 MHz SWCLK.
+ */
+
+#define SWCLK_HZ 4000000U
+#define BLOCK_SIZE 4096U
+
+static uint8_t pattern[BLOCK_SIZE];
+static uint8_t buffer[BLOCK_SIZE];
+
+static uint64_t report(const char *name, size_t bytes)
+{
+    SWDSimStats sim;
+    TapStats tap;
+    swd_sim_get_stats(&sim);
+    tap_stats_get(&tap);
+    const uint64_t ns = swd_sim_cycles_to_ns(sim.cycles, SWCLK_HZ);
+    printf("%-24s %6zu B %8llu cycles %6llu turnarounds %5u packets %8llu us %7.1f KiB/s\n", name, bytes,
+           (unsigned long long)sim.cycles, (unsigned long long)sim.turnarounds, sim.packets,
+           (unsigned long long)(ns / 1000U), ns > 0 ? (double)bytes * 1e9 / (double)ns / 1024.0 : 0.0);
+    CHECK_EQ(sim.protocol_errors, 0);
+    CHECK(tap.swd_bits_out + tap.swd_bits_in <= sim.cycles);
+    return sim.cycles;
+}
+
+static void start(void)
+{
+    swd_sim_reset_stats();
+    tap_stats_reset();
+}
+
+/* Bus cycles of the aligned block read and write */
+static uint64_t test_ram(target_s *target, bool queued)
+{
+    adiv5_queue_set_enabled(queued);
+    uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, BLOCK_SIZE);
+
+    memcpy(ram, pattern, BLOCK_SIZE);
+    memset(buffer, 0, sizeof(buffer));
+    start();
+    CHECK(!target_mem32_read(target, buffer, SWD_SIM_RAM_BASE, BLOCK_SIZE));
+    uint64_t cycles = report(queued ? "ram read (queue)" : "ram read (stock)", BLOCK_SIZE);
+    CHECK(memcmp(buffer, pattern, BLOCK_SIZE) == 0);
+
+    /* Unaligned head and tail go through the stock accessors either way */
+    memset(buffer, 0, sizeof(buffer));
+    CHECK(!target_mem32_read(target, buffer, SWD_SIM_RAM_BASE + 3U, 1021U));
+    CHECK(memcmp(buffer, pattern + 3, 1021U) == 0);
+
+    memset(ram, 0, BLOCK_SIZE);
+    start();
+    CHECK(!target_mem32_write(target, SWD_SIM_RAM_BASE, pattern, BLOCK_SIZE));
+    cycles += report(queued ? "ram write (queue)" : "ram write (stock)", BLOCK_SIZE);
+    CHECK(memcmp(ram, pattern, BLOCK_SIZE) == 0);
+
+    memset(ram, 0, BLOCK_SIZE);
+    CHECK(!target_mem32_write(target, SWD_SIM_RAM_BASE + 1U, pattern, 1022U));
+    CHECK(ram[0] == 0 && ram[1023] == 0);
+    CHECK(memcmp(ram + 1, pattern, 1022U) == 0);
+    return cycles;
+}
+
+static void test_flash(target_s *target)
+{
+    const uint8_t *flash = swd_sim_memory(SWD_SIM_FLASH_BASE, 2U * SWD_SIM_FLASH_PAGE);
+
+    start();
+    CHECK(!target_flash_erase(target, SWD_SIM_FLASH_BASE, 2U * SWD_SIM_FLASH_PAGE));
+    CHECK(!target_flash_write(target, SWD_SIM_FLASH_BASE, pattern, BLOCK_SIZE));
+    CHECK(!target_flash_complete(target));
+    report("flash erase+write", BLOCK_SIZE);
+    CHECK(memcmp(flash, pattern, BLOCK_SIZE) == 0);
+
+    memset(buffer, 0, sizeof(buffer));
+    start();
+    CHECK(!target_mem32_read(target, buffer, SWD_SIM_FLASH_BASE, BLOCK_SIZE));
+    report("flash read", BLOCK_SIZE);
+    CHECK(memcmp(buffer, pattern, BLOCK_SIZE) == 0);
+
+    /* Programming an erased page again only clears bits */
+    CHECK(!target_flash_erase(target, SWD_SIM_FLASH_BASE + 7U, 1U));
+    CHECK(flash[0] == 0xff && flash[SWD_SIM_FLASH_PAGE - 1U] == 0xff);
+    CHECK(memcmp(flash + SWD_SIM_FLASH_PAGE, pattern + SWD_SIM_FLASH_PAGE, SWD_SIM_FLASH_PAGE) == 0);
+}
+
+static void test_registers(target_s *target)
+{
+    uint8_t regs[128];
+    const size_t size = target_regs_size(target);
+    CHECK(size > 0 && size <= sizeof(regs));
+
+    *swd_sim_core_reg(15U) = 0x08000123U;
+    target_regs_read(target, regs);
+    uint32_t pc;
+    memcpy(&pc, regs + 15U * 4U, sizeof(pc));
+    CHECK_EQ(pc, 0x08000123U);
+
+    target_halt_resume(target, false);
+    CHECK(!swd_sim_halted());
+    target_addr_t watch;
+    CHECK_EQ(target_halt_poll(target, &watch), TARGET_HALT_RUNNING);
+    target_halt_request(target);
+    CHECK(swd_sim_halted());
+    CHECK_EQ(target_halt_poll(target, &watch), TARGET_HALT_REQUEST);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < sizeof(pattern); i++)
+        pattern[i] = (uint8_t)(i * 7U + (i >> 8U));
+
+    swd_sim_reset();
+    tap_stats_set_enabled(true);
+    start();
+    CHECK(adiv5_swd_scan());
+    report("scan", 0);
+
+    target_s *target = target_attach_n(1, NULL);
+    CHECK(target != NULL);
+    CHECK(swd_sim_halted());
+
+    const uint64_t stock = test_ram(target, false);
+    const uint64_t queued = test_ram(target, true);
+    CHECK(queued <= stock);
+
+    uint32_t batches;
+    uint32_t fallbacks;
+    adiv5_queue_get_stats(&batches, &fallbacks);
+    CHECK(batches > 0);
+    CHECK_EQ(fallbacks, 0);
+
+    test_flash(target);
+    test_registers(target);
+
+    target_detach(target);
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <string.h>
+#include <soc/gpio_struct.h>
+#include "general.h"
+#include "target.h"
+#include "swd-sim.h"
+#include "host-platform.h"
+#include "check.h"
+
+/*
+ * Register operations per SWD bit of the two SWD backends: the same scan,
+ * block read and block write through swdptap.c on the GPIO set/clear/input
+ * registers and through the dedicated GPIO bundle, counting every GPIO
+ * register access and every dedicated channel CSR access against the bus
+ * cycles the simulated target saw. The bundle needs fewer per bit.
+ */
+
+#define BLOCK_SIZE 1024U
+
+static uint8_t pattern[BLOCK_SIZE];
+static uint8_t buffer[BLOCK_SIZE];
+
+static void start(void)
+{
+    swd_sim_reset_stats();
+    host_gpio_reset_accesses();
+    host_dedic_reset_accesses();
+}
+
+/* Ops of one step, added into the backend's total */
+static void report(const char *name, const char *step, uint64_t *ops, uint64_t *bits)
+{
+    host_gpio_flush();
+    SWDSimStats sim;
+    swd_sim_get_stats(&sim);
+    const uint64_t gpio = host_gpio_accesses();
+    const uint64_t dedic = host_dedic_accesses();
+    printf("%-8s %-6s %8llu bits %8llu gpio %8llu dedic %5.2f ops/bit\n", name, step,
+           (unsigned long long)sim.cycles, (unsigned long long)gpio, (unsigned long long)dedic,
+           (double)(gpio + dedic) / (double)sim.cycles);
+    CHECK(sim.cycles > 0);
+    CHECK_EQ(sim.protocol_errors, 0);
+    *ops += gpio + dedic;
+    *bits += sim.cycles;
+}
+
+/* Ops per bit of a backend over scan, read and write */
+static double run(const char *name, bool dedic)
+{
+    uint64_t ops = 0;
+    uint64_t bits = 0;
+    swd_sim_reset();
+    host_platform_set_dedic(dedic);
+    uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, BLOCK_SIZE);
+    memcpy(ram, pattern, BLOCK_SIZE);
+
+    start();
+    CHECK(adiv5_swd_scan());
+    report(name, "scan", &ops, &bits);
+    target_s *target = target_attach_n(1, NULL);
+    CHECK(target != NULL);
+
+    memset(buffer, 0, sizeof(buffer));
+    start();
+    CHECK(!target_mem32_read(target, buffer, SWD_SIM_RAM_BASE, BLOCK_SIZE));
+    report(name, "read", &ops, &bits);
+    CHECK(memcmp(buffer, pattern, BLOCK_SIZE) == 0);
+
+    memset(ram, 0, BLOCK_SIZE);
+    start();
+    CHECK(!target_mem32_write(target, SWD_SIM_RAM_BASE, pattern, BLOCK_SIZE));
+    report(name, "write", &ops, &bits);
+    CHECK(memcmp(ram, pattern, BLOCK_SIZE) == 0);
+
+    target_detach(target);
+    const double per_bit = (double)ops / (double)bits;
+    printf("%-8s total  %5.2f ops/bit\n", name, per_bit);
+    return per_bit;
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < sizeof(pattern); i++)
+        pattern[i] = (uint8_t)(i * 13U + (i >> 8U));
+
+    const double bitbang = run("bitbang", false);
+    const double dedic = run("dedic", true);
+    printf("dedic/bitbang %.2f\n", dedic / bitbang);
+    CHECK(dedic < bitbang);
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <string.h>
+#include "general.h"
+#include "target.h"
+#include "target-cache.h"
+#include "swd-sim.h"
+#include "check.h"
+
+/*
+ * The halted-target cache on the simulated target's memory map: RAM and
+ * flash are cached, a peripheral register outside the map is read live,
+ * read-ahead fills its window with one transfer and stops at the end of
+ * RAM, and a volatile region inside RAM is read live as well.
+ */
+
+#define BLOCK 256U
+#define RAM_END (SWD_SIM_RAM_BASE + SWD_SIM_RAM_SIZE)
+
+static uint8_t buffer[1024];
+
+static TargetCacheStats stats(void)
+{
+    TargetCacheStats current;
+    target_cache_get_stats(&current);
+    return current;
+}
+
+static void start(void)
+{
+    target_cache_invalidate();
+    target_cache_reset_stats();
+}
+
+static void test_mapped(target_s *target)
+{
+    const uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, sizeof(buffer));
+    const uint8_t *flash = swd_sim_memory(SWD_SIM_FLASH_BASE, sizeof(buffer));
+
+    start();
+    CHECK(!target_cache_mem_read(target, buffer, SWD_SIM_RAM_BASE, sizeof(buffer)));
+    CHECK(memcmp(buffer, ram, sizeof(buffer)) == 0);
+    CHECK(!target_cache_mem_read(target, buffer, SWD_SIM_RAM_BASE, sizeof(buffer)));
+    CHECK_EQ(stats().mem_misses, 4);
+    CHECK_EQ(stats().mem_hits, 4);
+
+    CHECK(!target_cache_mem_read(target, buffer, SWD_SIM_FLASH_BASE + 8U, 16U));
+    CHECK(!target_cache_mem_read(target, buffer, SWD_SIM_FLASH_BASE, 16U));
+    CHECK(memcmp(buffer, flash, 16U) == 0);
+    CHECK_EQ(stats().mem_misses, 5);
+    CHECK_EQ(stats().mem_hits, 5);
+}
+
+static void test_peripheral(target_s *target)
+{
+    uint32_t first;
+    uint32_t second;
+
+    start();
+    CHECK(!target_cache_mem_read(target, &first, SWD_SIM_COUNTER, sizeof(first)));
+    CHECK(!target_cache_mem_read(target, &second, SWD_SIM_COUNTER, sizeof(second)));
+    CHECK(first != second);
+    CHECK_EQ(stats().fills, 0);
+    CHECK_EQ(stats().mem_hits, 0);
+}
+
+static void test_read_ahead(target_s *target)
+{
+    start();
+    target_cache_set_read_ahead(1024U);
+    CHECK(!target_cache_mem_read(target, buffer, RAM_END - 4U * BLOCK, BLOCK));
+    CHECK(!target_cache_mem_read(target, buffer, RAM_END - 3U * BLOCK, BLOCK));
+    /* The SWD traffic of one 512-byte read */
+    SWDSimStats bus;
+    swd_sim_reset_stats();
+    CHECK(!target_mem32_read(target, buffer, RAM_END - 2U * BLOCK, 2U * BLOCK));
+    swd_sim_get_stats(&bus);
+    const uint32_t one_read = bus.packets;
+
+    swd_sim_reset_stats();
+    target_cache_read_ahead(target);
+    swd_sim_get_stats(&bus);
+    /* Two blocks left in RAM, in one transfer, and the unmapped gap after it is not touched */
+    CHECK_EQ(stats().read_ahead_blocks, 2);
+    CHECK_EQ(bus.packets, one_read);
+
+    CHECK(!target_cache_mem_read(target, buffer, RAM_END - 2U * BLOCK, 2U * BLOCK));
+    CHECK(memcmp(buffer, swd_sim_memory(RAM_END - 2U * BLOCK, 2U * BLOCK), 2U * BLOCK) == 0);
+    CHECK_EQ(stats().read_ahead_hits, 2);
+}
+
+static void test_volatile(target_s *target)
+{
+    uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE + 0x1000U, BLOCK);
+
+    start();
+    CHECK(target_cache_add_volatile(SWD_SIM_RAM_BASE + 0x1000U, SWD_SIM_RAM_BASE + 0x10ffU));
+    memset(ram, 0x11, BLOCK);
+    CHECK(!target_cache_mem_read(target, buffer, SWD_SIM_RAM_BASE + 0x1000U, 16U));
+    CHECK(buffer[0] == 0x11);
+    memset(ram, 0x22, BLOCK);
+    CHECK(!target_cache_mem_read(target, buffer, SWD_SIM_RAM_BASE + 0x1000U, 16U));
+    CHECK(buffer[0] == 0x22);
+    CHECK_EQ(stats().fills, 0);
+
+    /* The block next to it is still cached */
+    CHECK(!target_cache_mem_read(target, buffer, SWD_SIM_RAM_BASE + 0x1100U, 16U));
+    CHECK(!target_cache_mem_read(target, buffer, SWD_SIM_RAM_BASE + 0x1100U, 16U));
+    CHECK_EQ(stats().mem_hits, 1);
+    target_cache_clear_volatile();
+}
+
+int main(void)
+{
+    swd_sim_reset();
+    CHECK(adiv5_swd_scan());
+    target_s *target = target_attach_n(1, NULL);
+    CHECK(target != NULL);
+
+    uint8_t *ram = swd_sim_memory(SWD_SIM_RAM_BASE, SWD_SIM_RAM_SIZE);
+    for (size_t i = 0; i < SWD_SIM_RAM_SIZE; i++)
+        ram[i] = (uint8_t)(i * 7U + (i >> 9U));
+
+    target_cache_set_enabled(true);
+    test_mapped(target);
+    test_peripheral(target);
+    test_read_ahead(target);
+    test_volatile(target);
+
+    target_detach(target);
+    return 0;
+}
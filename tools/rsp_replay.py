@@ -0,0 +1,337 @@
+#!/usr/bin/env python3
+"""Analyse and replay GDB RSP traces recorded by the probe.
+
+Record with "monitor trace enable" (or CONFIG_BMP_GDB_TRACE), run the
+session to measure, then fetch GET /trace from the probe.
+
+  rsp_replay.py summary http://192.168.4.1/trace
+  rsp_replay.py replay rsp.trace --host 192.168.4.1 --repeat 3
+
+"summary" prints packet counts, bytes and the latency the probe saw per
+packet type. "replay" sends the recorded packets to a probe's GDB port,
+waits for as many reply packets as were recorded and compares the
+latency with the recording. The replay drives the real target, so replay
+traces against the same target and state they were recorded with. Writes
+(M, X, vFlashWrite) and run control (c, s, vCont) are sent as recorded
+unless skipped with --skip. Packets the probe only kept in part (larger
+than a quarter of the trace ring) cannot be replayed and are skipped.
+The exit status is 1 if any reply timed out.
+"""
+
+import argparse
+import socket
+import statistics
+import struct
+import sys
+import time
+import urllib.request
+
+MAGIC = b"RSPT"
+VERSION = 1
+HEADER = struct.Struct("<4sIII")
+RECORD = struct.Struct("<IIHBB")
+
+IN, OUT, INTERRUPT = 0, 1, 2
+
+
+class Record:
+    def __init__(self, time_us, size, direction, packets, data):
+        self.time_us = time_us
+        self.size = size
+        self.direction = direction
+        self.packets = packets
+        self.data = data
+
+
+class Exchange:
+    """A packet or interrupt sent to the probe and the replies it got"""
+
+    def __init__(self, record):
+        self.request = record
+        self.replies = 0
+        self.reply_bytes = 0
+        self.last_reply_us = None
+
+    @property
+    def name(self):
+        if self.request.direction == INTERRUPT:
+            return "^C"
+        return packet_name(self.request.data)
+
+    @property
+    def truncated(self):
+        """The probe kept only the start of the packet"""
+        return self.request.direction == IN and len(self.request.data) != self.request.size
+
+    @property
+    def latency_us(self):
+        if self.last_reply_us is None:
+            return None
+        return self.last_reply_us - self.request.time_us
+
+
+def packet_name(data):
+    if not data:
+        return "empty"
+    first = chr(data[0])
+    if first not in "qQv":
+        return first
+    end = 1
+    while end < len(data) and chr(data[end]).isalnum():
+        end += 1
+    return data[:end].decode("ascii", "replace")
+
+
+def load(source):
+    if source.startswith(("http://", "https://")):
+        with urllib.request.urlopen(source) as response:
+            raw = response.read()
+    else:
+        with open(source, "rb") as f:
+            raw = f.read()
+
+    if len(raw) < HEADER.size:
+        sys.exit("trace too short")
+    magic, version, count, dropped = HEADER.unpack_from(raw)
+    if magic != MAGIC or version != VERSION:
+        sys.exit("not an RSP trace version %d" % VERSION)
+
+    records = []
+    offset = HEADER.size
+    wraps = 0
+    last = 0
+    while offset + RECORD.size <= len(raw):
+        time_us, size, length, direction, packets = RECORD.unpack_from(raw, offset)
+        offset += RECORD.size
+        # The probe clock is 32 bit
+        if time_us < last:
+            wraps += 1
+        last = time_us
+        records.append(Record(time_us + (wraps << 32), size, direction, packets, raw[offset:offset + length]))
+        offset += length
+
+    if len(records) != count:
+        print("warning: header says %d records, found %d" % (count, len(records)), file=sys.stderr)
+    return records, dropped
+
+
+def exchanges(records):
+    """Pair each inbound record with the reply packets written until the next one"""
+    result = []
+    for record in records:
+        if record.direction in (IN, INTERRUPT):
+            result.append(Exchange(record))
+        elif result and record.packets:
+            result[-1].replies += record.packets
+            result[-1].reply_bytes += record.size
+            result[-1].last_reply_us = record.time_us
+    return result
+
+
+def percentile(values, percent):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, len(ordered) * percent // 100)]
+
+
+def print_table(title, rows):
+    print(title)
+    print("%-16s %7s %9s %9s %9s %9s %9s" % ("type", "count", "bytes", "avg us", "p50 us", "p90 us", "max us"))
+    for name in sorted(rows, key=lambda n: -sum(rows[n][1])):
+        count, latencies, size = rows[name]
+        if latencies:
+            print("%-16s %7d %9d %9d %9d %9d %9d" % (name, count, size, statistics.mean(latencies),
+                                                     percentile(latencies, 50), percentile(latencies, 90),
+                                                     max(latencies)))
+        else:
+            print("%-16s %7d %9d %9s %9s %9s %9s" % (name, count, size, "-", "-", "-", "-"))
+
+
+def summary(args):
+    records, dropped = load(args.trace)
+    pairs = exchanges(records)
+    if not records:
+        print("empty trace")
+        return
+
+    rows = {}
+    for pair in pairs:
+        row = rows.setdefault(pair.name, [0, [], 0])
+        row[0] += 1
+        row[2] += pair.reply_bytes
+        if pair.latency_us is not None:
+            row[1].append(pair.latency_us)
+
+    span_us = records[-1].time_us - records[0].time_us
+    out_bytes = sum(r.size for r in records if r.direction == OUT)
+    print("%d records over %.3f s, %d dropped before the first one" % (len(records), span_us / 1e6, dropped))
+    print("%d packets to the probe, %d bytes from the probe" % (len(pairs), out_bytes))
+    truncated = sum(1 for pair in pairs if pair.truncated)
+    if truncated:
+        print("%d packets to the probe truncated, replay skips them" % truncated)
+    print_table("latency from packet to last reply, as recorded:", rows)
+
+
+def escape(payload):
+    out = bytearray()
+    for byte in payload:
+        if byte in b"$#}*":
+            out += bytes((ord("}"), byte ^ 0x20))
+        else:
+            out.append(byte)
+    return bytes(out)
+
+
+def frame(payload):
+    body = escape(payload)
+    return b"$" + body + b"#%02x" % (sum(body) & 0xFF)
+
+
+class Connection:
+    def __init__(self, host, port, timeout):
+        self.sock = socket.create_connection((host, port), timeout=timeout)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.buffer = b""
+        self.noack = False
+
+    def read_byte(self):
+        if not self.buffer:
+            self.buffer = self.sock.recv(65536)
+            if not self.buffer:
+                raise ConnectionError("probe closed the connection")
+        byte = self.buffer[:1]
+        self.buffer = self.buffer[1:]
+        return byte
+
+    def read_packet(self):
+        """Read one reply packet, skipping acks, notifications count as well"""
+        while self.read_byte() not in (b"$", b"%"):
+            pass
+        body = bytearray()
+        while True:
+            byte = self.read_byte()
+            if byte == b"#":
+                break
+            body += byte
+        self.read_byte()
+        self.read_byte()
+        if not self.noack:
+            self.sock.sendall(b"+")
+        return bytes(body)
+
+    def send(self, data):
+        self.sock.sendall(data)
+
+
+def replay_once(args, pairs, conn):
+    rows = {}
+    start = time.monotonic()
+    base_us = pairs[0].request.time_us if pairs else 0
+    timeouts = 0
+    truncated = 0
+
+    for pair in pairs:
+        name = pair.name
+        if name in args.skip:
+            continue
+        if pair.truncated:
+            truncated += 1
+            continue
+
+        if args.realtime:
+            delay = (pair.request.time_us - base_us) / 1e6 - (time.monotonic() - start)
+            if delay > 0:
+                time.sleep(delay)
+
+        sent = time.monotonic()
+        if pair.request.direction == INTERRUPT:
+            conn.send(b"\x03")
+        else:
+            conn.send(frame(pair.request.data))
+
+        latency_us = None
+        try:
+            for _ in range(pair.replies):
+                conn.read_packet()
+            if pair.replies:
+                latency_us = int((time.monotonic() - sent) * 1e6)
+        except socket.timeout:
+            timeouts += 1
+            print("timeout waiting for the reply to %s" % name, file=sys.stderr)
+            conn.buffer = b""
+
+        if pair.request.data == b"QStartNoAckMode" and latency_us is not None:
+            conn.noack = True
+
+        row = rows.setdefault(name, [0, [], 0])
+        row[0] += 1
+        row[2] += pair.reply_bytes
+        if latency_us is not None:
+            row[1].append(latency_us)
+
+    return rows, time.monotonic() - start, timeouts, truncated
+
+
+def replay(args):
+    records, _ = load(args.trace)
+    pairs = exchanges(records)
+    if not pairs:
+        sys.exit("no packets to replay")
+
+    recorded = {}
+    for pair in pairs:
+        if pair.latency_us is not None and pair.name not in args.skip and not pair.truncated:
+            recorded.setdefault(pair.name, []).append(pair.latency_us)
+    recorded_us = (pairs[-1].last_reply_us or pairs[-1].request.time_us) - pairs[0].request.time_us
+
+    failed = False
+    for run in range(args.repeat):
+        conn = Connection(args.host, args.port, args.timeout)
+        rows, elapsed, timeouts, truncated = replay_once(args, pairs, conn)
+        conn.sock.close()
+        failed = failed or timeouts > 0
+
+        packets = sum(row[0] for row in rows.values())
+        reply_bytes = sum(row[2] for row in rows.values())
+        print("run %d: %d packets in %.3f s (recorded %.3f s), %.0f packets/s, %.1f KiB/s replies, %d timeouts, "
+              "%d truncated skipped" % (run + 1, packets, elapsed, recorded_us / 1e6, packets / elapsed,
+                                        reply_bytes / 1024 / elapsed, timeouts, truncated))
+        print_table("latency from packet to last reply, replayed:", rows)
+
+        print("%-16s %9s %9s %8s" % ("type", "rec p50", "now p50", "change"))
+        for name in sorted(rows):
+            if rows[name][1] and recorded.get(name):
+                before = percentile(recorded[name], 50)
+                after = percentile(rows[name][1], 50)
+                print("%-16s %9d %9d %+7.1f%%" % (name, before, after, (after - before) * 100.0 / max(before, 1)))
+        print()
+
+    if failed:
+        sys.exit(1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    parser_summary = commands.add_parser("summary", help="print recorded packet statistics")
+    parser_summary.add_argument("trace", help="trace file or http URL of the probe's /trace")
+    parser_summary.set_defaults(func=summary)
+
+    parser_replay = commands.add_parser("replay", help="replay the packets against a probe")
+    parser_replay.add_argument("trace", help="trace file or http URL of the probe's /trace")
+    parser_replay.add_argument("--host", default="192.168.4.1", help="probe address")
+    parser_replay.add_argument("--port", type=int, default=2345, help="GDB port")
+    parser_replay.add_argument("--repeat", type=int, default=1, help="number of runs")
+    parser_replay.add_argument("--realtime", action="store_true", help="keep the recorded gaps between packets")
+    parser_replay.add_argument("--timeout", type=float, default=10.0, help="reply timeout in s")
+    parser_replay.add_argument("--skip", default="", help="comma separated packet types not to send, e.g. X,M,vFlashWrite")
+    parser_replay.set_defaults(func=replay)
+
+    args = parser.parse_args()
+    if hasattr(args, "skip"):
+        args.skip = set(filter(None, args.skip.split(",")))
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()